@@ -47,6 +47,8 @@
 #define __CU_FONT_LOADER_H__
 #include <cugl/assets/CULoader.h>
 #include <cugl/render/CUFont.h>
+#include <unordered_map>
+#include <mutex>
 
 namespace cugl {
     
@@ -80,6 +82,10 @@ protected:
     int _fontsize;
     /** The default atlas character set ("" for ASCII) */
     std::string _charset;
+    /** The distance field fonts whose atlases are shared across font sizes */
+    std::unordered_map<std::string, std::shared_ptr<Font>> _distanceFonts;
+    /** Mutex guarding the shared distance field fonts */
+    std::mutex _distanceMutex;
     
 #pragma mark Asset Loading
     /**
@@ -113,12 +119,19 @@ protected:
      *      "size":         This font size (int)
      *      "charset":      The set of characters for the font atlas (string)
      *      "padding":      The atlas padding (to prevent blur bleedthrough)
+     *      "distance":     The distance field spread in pixels (0 for a bitmap atlas)
+     *      "lazy":         Whether to add glyphs to the atlas on first use (no prebuilt atlas)
      *      "hinting":		The rendering hints ("normal", "light", "mono", "none")
      *      "bold":      	Whether to make the font an (ad hoc) bold
      *      "italic":      	Whether to make the font an (ad hoc) italic
      *      "underline":    Whether to underline the font
      *      "strike":    	Whether to strikethrough the font
      *
+     * Distance field fonts do not get an atlas of their own. Instead, all
+     * entries with the same file, style, hinting, spread and character set
+     * share the atlases of a single font at a fixed base size, scaled to
+     * their own size. See {@link Font#setAtlasSource}.
+     *
      * @param json      The directory entry for the asset
      *
      * @return the font asset with no generated atlas
@@ -207,6 +220,8 @@ protected:
      *      "size":         This font size (int)
      *      "charset":      The set of characters for the font atlas (string)
      *      "padding":      The atlas padding (to prevent blur bleedthrough)
+     *      "distance":     The distance field spread in pixels (0 for a bitmap atlas)
+     *      "lazy":         Whether to add glyphs to the atlas on first use (no prebuilt atlas)
      *      "hinting":		The rendering hints ("normal", "light", "mono", "none")
      *      "bold":      	Whether to make the font an (ad hoc) bold
      *      "italic":      	Whether to make the font an (ad hoc) italic
@@ -246,6 +261,7 @@ public:
      */
     void dispose() override {
         _assets.clear();
+        _distanceFonts.clear();
         _loader = nullptr;
     }
 
@@ -47,6 +47,8 @@
 #define __CU_TEXTURE_LOADER_H__
 #include <cugl/assets/CULoader.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/math/CURect.h>
+#include <vector>
 
 namespace cugl {
 
@@ -66,6 +68,12 @@ namespace cugl {
  * remainder of asset loading using {@link Application#schedule}.  This is a
  * good template for asset loaders in general.
  *
+ * A directory entry may also pack several images into a single texture.
+ * Instead of a "file", such an entry has a "pack" object mapping asset keys
+ * to files. The images are packed into one or more shared pages when they
+ * are loaded, and each key is assigned a subtexture of its page. Sprites
+ * drawn from the same page can then share a single draw call.
+ *
  * As with all of our loaders, this loader is designed to be attached to an
  * asset manager. Use the method {@link getHook()} to get the appropriate
  * pointer for attaching the loader.
@@ -87,6 +95,25 @@ protected:
     /** The default support for mipmaps */
     bool _mipmaps;
     
+    /**
+     * The pixels and layout of a single page of a texture pack.
+     *
+     * Pages are assembled outside of the main thread, so they store an
+     * SDL_Surface and not a texture.
+     */
+    class PackedPage {
+    public:
+        /** The page pixels (owned by the page until materialized) */
+        SDL_Surface* surface;
+        /** The asset keys of the images on this page */
+        std::vector<std::string> keys;
+        /** The pixel bounds of each image, with origin in the top left */
+        std::vector<Rect> bounds;
+        
+        /** Creates an empty page */
+        PackedPage() : surface(nullptr) {}
+    };
+    
 #pragma mark Asset Loading
     /**
      * Extracts any subtextures specified in an atlas
@@ -96,11 +123,26 @@ protected:
      * the subtexture, respectively.  Each subtexture will have the key of the
      * main texture as the prefix (together with an underscore _) of its key.
      *
+     * The pixels are relative to the given texture, which may itself be a
+     * subtexture (e.g. an image in a texture pack).
+     *
      * @param json      The asset directory entry
      * @param texture   The texture loaded for this asset
      */
     void parseAtlas(const std::shared_ptr<JsonValue>& json, const std::shared_ptr<Texture>& texture);
     
+    /**
+     * Removes any subtextures specified in an atlas
+     *
+     * This method is the inverse of {@link parseAtlas}. It returns false if any
+     * of the subtextures in the atlas were missing.
+     *
+     * @param json      The asset directory entry
+     *
+     * @return true if all of the subtextures were removed
+     */
+    bool purgeAtlas(const std::shared_ptr<JsonValue>& json);
+    
     /**
      * Loads the portion of this asset that is safe to load outside the main thread.
      *
@@ -164,6 +206,55 @@ protected:
      */
     void materialize(const std::shared_ptr<JsonValue>& json, SDL_Surface* surface, LoaderCallback callback);
     
+    /**
+     * Loads and packs the images of a texture pack outside the main thread.
+     *
+     * A texture pack directory entry has a "pack" object in place of a file.
+     * Each member of this object is either the path to an image, or a
+     * directory entry with a "file" and an optional "atlas". In addition,
+     * the pack entry has the following values
+     *
+     *      "size":         The maximum width and height of a page (int)
+     *      "padding":      The pixels to pad around each image (int)
+     *
+     * The images are packed from tallest to shortest using an {@link AtlasPacker}.
+     * Any image that is too big for a page is given a page of its own. The
+     * border pixels of each image are extruded into its padding, so that
+     * filtering never samples a neighboring image.
+     *
+     * Images that fail to load are logged and skipped. If a page cannot be
+     * allocated, the error is logged and no pages are returned, so that the
+     * pack fails to load.
+     *
+     * @param json      The asset directory entry
+     *
+     * @return the packed pages of this texture pack
+     */
+    std::vector<PackedPage> preloadPack(const std::shared_ptr<JsonValue>& json);
+    
+    /**
+     * Creates the OpenGL textures for a texture pack according to the directory entry.
+     *
+     * This method finishes the asset loading started in {@link preloadPack}.
+     * This step is not safe to be done in a separate thread.  Instead, it
+     * takes place in the main CUGL thread via {@link Application#schedule}.
+     *
+     * The first page is assigned the key of the JSON directory entry. Any
+     * later pages have the same key with the suffix _1, _2, and so on. Each
+     * image in the pack is assigned a subtexture of its page, using the key
+     * of its member in the "pack" object. Every page shares the filter, wrap,
+     * and mipmap settings of the directory entry.
+     *
+     * This method supports an optional callback function which reports whether
+     * the asset was successfully materialized.
+     *
+     * @param json      The asset directory entry
+     * @param pages     The pages created by {@link preloadPack}
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void materializePack(const std::shared_ptr<JsonValue>& json, const std::vector<PackedPage>& pages,
+                         LoaderCallback callback);
+    
 
     /**
      * Internal method to support asset loading.
@@ -209,6 +300,9 @@ protected:
      *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
      *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
      *
+     * If the entry has a "pack" object instead of a "file", it is loaded as a
+     * texture pack. See {@link preloadPack} for the format.
+     *
      * @param json      The directory entry for the asset
      * @param callback  An optional callback for asynchronous loading
      * @param async     Whether the asset was loaded asynchronously
@@ -0,0 +1,222 @@
+//
+//  CUAtlasPacker.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a class for packing rectangles into a texture atlas
+//  page. It uses the skyline bottom-left heuristic, which is fast enough to
+//  run at load time and wastes little space on sprite-sized images. The
+//  class is purely geometric; it does not touch any pixels. That is up to
+//  the caller (e.g. the TextureLoader).
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#ifndef __CU_ATLAS_PACKER_H__
+#define __CU_ATLAS_PACKER_H__
+#include <cugl/math/CURect.h>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/**
+ * This class packs rectangles into a fixed size texture atlas page.
+ *
+ * The packer uses the skyline bottom-left heuristic. It tracks the top edge
+ * of the packed rectangles as a list of horizontal segments (the skyline),
+ * and places each new rectangle where its bottom edge is lowest. Rectangles
+ * are never rotated, as sprite batch texture coordinates cannot express that.
+ *
+ * Packing works best when rectangles are added from tallest to shortest.
+ *
+ * The coordinate system of the page has its origin in the top left corner,
+ * which agrees with the pixel layout of an SDL_Surface and with the atlas
+ * coordinates of a {@link TextureLoader}.
+ */
+class AtlasPacker {
+private:
+    /**
+     * A single horizontal segment of the skyline.
+     */
+    class Segment {
+    public:
+        /** The left edge of the segment */
+        int x;
+        /** The height of the skyline along this segment */
+        int y;
+        /** The width of the segment */
+        int width;
+    };
+    
+    /** The width of the page */
+    int _width;
+    /** The height of the page */
+    int _height;
+    /** The skyline, sorted left to right */
+    std::vector<Segment> _skyline;
+    /** The right edge of the packed rectangles */
+    int _usedWidth;
+    /** The bottom edge of the packed rectangles */
+    int _usedHeight;
+    /** The total area of the packed rectangles */
+    size_t _usedArea;
+
+    /**
+     * Returns the lowest position for a rectangle starting at a segment.
+     *
+     * The rectangle is placed with its left edge at the given segment. If it
+     * does not fit there, this method returns -1.
+     *
+     * @param index     The skyline segment
+     * @param width     The rectangle width
+     * @param height    The rectangle height
+     *
+     * @return the lowest position for a rectangle starting at a segment.
+     */
+    int fit(size_t index, int width, int height) const;
+    
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate packer with no page.
+     *
+     * You must initialize the packer before using it.
+     */
+    AtlasPacker() : _width(0), _height(0), _usedWidth(0), _usedHeight(0), _usedArea(0) {}
+    
+    /**
+     * Deletes this packer, disposing all resources
+     */
+    ~AtlasPacker() { dispose(); }
+    
+    /**
+     * Deletes the packer and resets all attributes.
+     *
+     * You must reinitialize the packer to use it.
+     */
+    void dispose();
+    
+    /**
+     * Initializes an empty packer for a page of the given size.
+     *
+     * @param width     The page width in pixels
+     * @param height    The page height in pixels
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(int width, int height);
+    
+    /**
+     * Returns a newly allocated packer for a page of the given size.
+     *
+     * @param width     The page width in pixels
+     * @param height    The page height in pixels
+     *
+     * @return a newly allocated packer for a page of the given size.
+     */
+    static std::shared_ptr<AtlasPacker> alloc(int width, int height) {
+        std::shared_ptr<AtlasPacker> result = std::make_shared<AtlasPacker>();
+        return (result->init(width,height) ? result : nullptr);
+    }
+    
+#pragma mark -
+#pragma mark Packing
+    /**
+     * Removes all rectangles from the page.
+     */
+    void reset();
+    
+    /**
+     * Returns true if a rectangle of the given size was added to the page.
+     *
+     * If the rectangle fits, its position on the page is stored in dst. The
+     * origin of dst is the top left corner of the rectangle. If it does not
+     * fit, dst is unchanged.
+     *
+     * @param width     The rectangle width in pixels
+     * @param height    The rectangle height in pixels
+     * @param dst       The rectangle to store the position
+     *
+     * @return true if a rectangle of the given size was added to the page.
+     */
+    bool pack(int width, int height, Rect* dst);
+    
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the width of the page.
+     *
+     * @return the width of the page.
+     */
+    int getWidth() const { return _width; }
+    
+    /**
+     * Returns the height of the page.
+     *
+     * @return the height of the page.
+     */
+    int getHeight() const { return _height; }
+    
+    /**
+     * Returns the right edge of the rectangles packed so far.
+     *
+     * A page can be cropped to this width without losing any rectangles.
+     *
+     * @return the right edge of the rectangles packed so far.
+     */
+    int getUsedWidth() const { return _usedWidth; }
+    
+    /**
+     * Returns the bottom edge of the rectangles packed so far.
+     *
+     * A page can be cropped to this height without losing any rectangles.
+     *
+     * @return the bottom edge of the rectangles packed so far.
+     */
+    int getUsedHeight() const { return _usedHeight; }
+    
+    /**
+     * Returns the fraction of the used page area covered by rectangles.
+     *
+     * The used page area is the area cropped to the used width and height.
+     *
+     * @return the fraction of the used page area covered by rectangles.
+     */
+    float getOccupancy() const {
+        size_t area = (size_t)_usedWidth*(size_t)_usedHeight;
+        return area == 0 ? 0.0f : (float)_usedArea/(float)area;
+    }
+};
+
+}
+#endif /* __CU_ATLAS_PACKER_H__ */
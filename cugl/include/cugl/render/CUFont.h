@@ -57,9 +57,13 @@
 #include <cugl/render/CUMesh.h>
 #include <cugl/render/CUGlyphRun.h>
 #include <SDL/SDL_ttf.h>
+#include <deque>
 
 namespace cugl {
 
+// Forward declaration
+class ThreadPool;
+
 /**
  * This class represents a true type font at a fixed size.
  *
@@ -196,6 +200,10 @@ protected:
         Size _size;
         /** A (temporary) SDL surface for computing the atlas textures */
         SDL_Surface* _surface;
+        /** Whether this atlas accepts new glyphs after it is materialized */
+        bool _growable;
+        /** The number of pixels used in each row of a growable atlas */
+        std::vector<float> _shelves;
         
         /**
          * Lays out the glyphs in reasonably efficient packing.
@@ -217,6 +225,36 @@ protected:
          */
         static SDL_Surface* allocSurface(int width, int height);
 
+        /**
+         * Rasterizes a single glyph into the atlas surface.
+         *
+         * The glyph must already be laid out in the glyph map, with the
+         * glyph border removed from its bounds. The glyph is rendered with
+         * the given font face, which need not be the face of the parent font.
+         * This method only writes to the pixels inside the glyph bounds, so
+         * it is safe to rasterize glyphs of the same atlas in parallel, as
+         * long as each thread has its own face.
+         *
+         * @param face      The font face to render the glyph
+         * @param thechar   The glyph to rasterize
+         *
+         * @return true if the glyph was successfully rasterized
+         */
+        bool blit(TTF_Font* face, Uint32 thechar);
+
+        /**
+         * Appends a textured quad to the given mesh
+         *
+         * The quad is given in font coordinates, while the texture region is
+         * given in the pixel coordinates of this atlas. The two need not have
+         * the same size.
+         *
+         * @param quad      The quad to append
+         * @param bounds    The texture region of the quad
+         * @param mesh      The mesh to store the vertices
+         */
+        void appendQuad(const Rect quad, const Rect bounds, Mesh<SpriteVertex2>& mesh) const;
+
     public:
         /** The texture (may be null if not materialized) */
         std::shared_ptr<Texture> texture;
@@ -295,6 +333,54 @@ protected:
             return (result->init(parent,glyphset) ? result : nullptr);
         }
         
+        /**
+         * Initializes an empty, growable atlas for the given font
+         *
+         * A growable atlas is a fixed size page that starts with no glyphs.
+         * Glyphs are added one at a time with {@link #reserve}, and are
+         * uploaded to the texture with {@link #upload}. The page never changes
+         * size, as that would invalidate the texture coordinates of existing
+         * glyph runs. Instead, the font starts a new page when it is full.
+         *
+         * This initializer creates the SDL surface for the page, but not the
+         * texture. The surface is kept after {@link #materialize} so that new
+         * glyphs can be rasterized into it.
+         *
+         * @param parent    The parent font of this atlas
+         *
+         * @return true if the atlas was successfully initialized
+         */
+        bool initGrowable(Font* parent);
+        
+        /**
+         * Returns a newly allocated empty, growable atlas for the given font
+         *
+         * A growable atlas is a fixed size page that starts with no glyphs.
+         * Glyphs are added one at a time with {@link #reserve}, and are
+         * uploaded to the texture with {@link #upload}. The page never changes
+         * size, as that would invalidate the texture coordinates of existing
+         * glyph runs. Instead, the font starts a new page when it is full.
+         *
+         * This allocator creates the SDL surface for the page, but not the
+         * texture. The surface is kept after {@link #materialize} so that new
+         * glyphs can be rasterized into it.
+         *
+         * @param parent    The parent font of this atlas
+         *
+         * @return a newly allocated empty, growable atlas for the given font
+         */
+        static std::shared_ptr<Atlas> allocGrowable(Font* parent) {
+            std::shared_ptr<Atlas> result = std::make_shared<Atlas>();
+            return (result->initGrowable(parent) ? result : nullptr);
+        }
+        
+        /**
+         * Returns true if this atlas accepts new glyphs
+         *
+         * @return true if this atlas accepts new glyphs
+         */
+        bool isGrowable() const { return _growable; }
+        
         /**
          * Returns true if this font has a glyph for the given (UNICODE) character.
          *
@@ -353,12 +439,17 @@ protected:
          * The quad is adjusted so that all of the vertices fit in the provided
          * rectangle.  This may mean that no quad is generated at all.
          *
+         * If the size differs from that of the font owning this atlas, the
+         * quad is scaled to match. This is how fonts share a distance field
+         * atlas (see {@link Font#setAtlasSource}).
+         *
          * @param thechar   The character to convert to render data
          * @param offset    The (unkerned) starting position of the quad
-         * @param rect      The bounding box for the quad
          * @param mesh      The mesh to store the vertices
+         * @param rect      The bounding box for the quad
+         * @param size      The point size of the font drawing the quad
          */
-        bool getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, const Rect rect) const;
+        bool getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, const Rect rect, Uint32 size) const;
 
         /**
          * Creates a single quad to render this character and stores it in mesh
@@ -369,11 +460,16 @@ protected:
          * character. This method will not generate anything if the character is
          * not supported by this atlas.
          *
+         * If the size differs from that of the font owning this atlas, the
+         * quad is scaled to match. This is how fonts share a distance field
+         * atlas (see {@link Font#setAtlasSource}).
+         *
          * @param thechar   The character to convert to render data
          * @param offset    The (unkerned) starting position of the quad
          * @param mesh      The mesh to store the vertices
+         * @param size      The point size of the font drawing the quad
          */
-        void getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh) const;
+        void getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, Uint32 size) const;
 
         /**
          * Builds the texture data for this given atlas.
@@ -397,6 +493,34 @@ protected:
          * @return true if texture creation was successful.
          */
         bool materialize();
+        
+        /**
+         * Adds a glyph to this growable atlas, rasterizing it immediately
+         *
+         * The glyph is placed in the first row with room for it, and then
+         * rendered into the atlas surface. It is not visible in the texture
+         * until it is uploaded with {@link #upload}. This method returns
+         * false if the atlas is not growable or if there is no room left
+         * for the glyph.
+         *
+         * @param thechar   The glyph to add
+         *
+         * @return true if the glyph was added to this atlas
+         */
+        bool reserve(Uint32 thechar);
+        
+        /**
+         * Uploads the rows of the atlas surface containing the given glyph
+         *
+         * This method only works on a growable atlas that has been
+         * materialized. It does not rebuild the texture mipmaps. This method
+         * must be called on the main thread.
+         *
+         * @param thechar   The glyph to upload
+         *
+         * @return true if the glyph was successfully uploaded
+         */
+        bool upload(Uint32 thechar);
     };
 
 #pragma mark -
@@ -440,8 +564,28 @@ protected:
     std::vector<std::shared_ptr<Atlas>> _atlases;
     /** The number of pixels to pad around each edge of a glyph.  Necessary to support font blurs. */
     Uint32 _atlasPadding;
+    /** The spread (in pixels) of a signed distance field atlas; 0 for a bitmap atlas */
+    Uint32 _distanceSpread;
+    /** The distance field font whose atlases this font shares (nullptr if none) */
+    std::shared_ptr<Font> _atlasSource;
     /** The atlas storing any particular character */
     std::unordered_map<Uint32, size_t> _atlasmap;
+    /** The path to the font file, for opening faces on other threads */
+    std::string _source;
+    /** The thread pool for rasterizing atlas glyphs (may be null) */
+    std::shared_ptr<ThreadPool> _rasterThreads;
+    
+    // Lazy atlas support
+    /** Whether to add missing glyphs to the atlases on first use */
+    bool _lazy;
+    /** The maximum number of lazy glyphs to upload each frame */
+    Uint32 _uploadLimit;
+    /** The lazy glyphs waiting to be uploaded to their atlas textures */
+    std::deque<Uint32> _uploads;
+    /** The identifier of the scheduled upload callback (if _uploading) */
+    Uint32 _uploadid;
+    /** Whether an upload callback is currently scheduled */
+    bool _uploading;
 
     // GlyphRun generation
     /** Whether to generate an impromptu atlas for missing glyphs */
@@ -778,6 +922,81 @@ public:
      */
     void setPadding(Uint32 padding);
     
+    /**
+     * Returns the spread of the signed distance field atlases
+     *
+     * If this value is 0 (the default), the atlases store bitmap glyphs,
+     * which only look crisp when drawn at their native size. Otherwise,
+     * the alpha of each atlas pixel is the distance to the nearest glyph
+     * edge, where 0.5 is on the edge and the spread is the distance (in
+     * pixels) to reach 0 or 1. A distance field atlas stays crisp at any
+     * scale, but it must be drawn with {@link SpriteBatch#setDistanceField}.
+     * The text drawing methods of {@link SpriteBatch} (and labels) do this
+     * automatically.
+     *
+     * @return the spread of the signed distance field atlases
+     */
+    Uint32 getDistanceSpread() const { return _distanceSpread; }
+    
+    /**
+     * Sets the spread of the signed distance field atlases
+     *
+     * If this value is 0 (the default), the atlases store bitmap glyphs,
+     * which only look crisp when drawn at their native size. Otherwise,
+     * the alpha of each atlas pixel is the distance to the nearest glyph
+     * edge, where 0.5 is on the edge and the spread is the distance (in
+     * pixels) to reach 0 or 1. A distance field atlas stays crisp at any
+     * scale, but it must be drawn with {@link SpriteBatch#setDistanceField}.
+     * The text drawing methods of {@link SpriteBatch} (and labels) do this
+     * automatically.
+     *
+     * The distance field is stored in the atlas padding, so the padding
+     * is raised to at least the spread. Reseting this value will clear any
+     * existing atlas collection.
+     *
+     * @param spread    The spread of the signed distance field atlases
+     */
+    void setDistanceSpread(Uint32 spread);
+    
+    /**
+     * Returns true if this font uses signed distance field atlases
+     *
+     * @return true if this font uses signed distance field atlases
+     */
+    bool isDistanceField() const { return _distanceSpread > 0; }
+    
+    /**
+     * Returns the distance field font whose atlases this font draws from.
+     *
+     * If this value is nullptr (the default), this font draws from atlases
+     * of its own. See {@link #setAtlasSource}.
+     *
+     * @return the distance field font whose atlases this font draws from.
+     */
+    const std::shared_ptr<Font>& getAtlasSource() const { return _atlasSource; }
+    
+    /**
+     * Sets the distance field font whose atlases this font draws from.
+     *
+     * A distance field atlas stays crisp at any scale, so fonts of the same
+     * face at different sizes do not each need an atlas. Once this value is
+     * set, this font draws its glyphs from the atlases of the source, scaled
+     * by the ratio of the two font sizes. The glyph metrics and kerning of
+     * the source are scaled the same way, so that the layout agrees with the
+     * glyphs. The source should have the same face and style as this font,
+     * and its atlases must already be built (or at least prepared with
+     * {@link #buildAtlasesAsync}).
+     *
+     * Setting this value clears any existing atlas collection of this font.
+     * Setting it to nullptr detaches this font, so that any atlases built
+     * afterwards measure its own glyphs.
+     *
+     * @param source    The distance field font whose atlases this font draws from
+     *
+     * @return true if the atlases of the source could be shared
+     */
+    bool setAtlasSource(const std::shared_ptr<Font>& source);
+    
     /**
      * Sets whether to generate a fallback atlas for glyph runs.
      *
@@ -818,6 +1037,109 @@ public:
      */
     bool hasAtlasFallback() const { return _fallback; }
     
+    /**
+     * Sets whether to add missing glyphs to the atlases on first use.
+     *
+     * A lazy font does not need to build its atlases ahead of time. When
+     * a glyph run method like {@link #getGlyphs} meets a glyph that is
+     * supported by the font, but missing from the atlases, the glyph is
+     * rasterized into a growable atlas page and stored for future use.
+     * So a lazy font only pays for the glyphs actually displayed.
+     *
+     * A new glyph is available to glyph runs immediately, but it is only
+     * uploaded to its atlas texture at the start of a later animation
+     * frame. At most {@link #getUploadLimit} glyphs are uploaded each
+     * frame, so a new glyph may be invisible for a frame or two. Like
+     * the fallback atlas, this means that the glyph generation methods
+     * are no longer safe to be used outside of the main thread (this is
+     * not an issue if this attribute is false).
+     *
+     * This value takes precedence over {@link #setAtlasFallback}, except
+     * for glyphs that are too big for an atlas page.
+     *
+     * @param lazy  Whether to add missing glyphs to the atlases on first use
+     */
+    void setLazyAtlas(bool lazy) { _lazy = lazy; }
+    
+    /**
+     * Returns true if this font adds missing glyphs to the atlases on first use.
+     *
+     * A lazy font does not need to build its atlases ahead of time. When
+     * a glyph run method like {@link #getGlyphs} meets a glyph that is
+     * supported by the font, but missing from the atlases, the glyph is
+     * rasterized into a growable atlas page and stored for future use.
+     * So a lazy font only pays for the glyphs actually displayed.
+     *
+     * A new glyph is available to glyph runs immediately, but it is only
+     * uploaded to its atlas texture at the start of a later animation
+     * frame. At most {@link #getUploadLimit} glyphs are uploaded each
+     * frame, so a new glyph may be invisible for a frame or two. Like
+     * the fallback atlas, this means that the glyph generation methods
+     * are no longer safe to be used outside of the main thread (this is
+     * not an issue if this attribute is false).
+     *
+     * This value takes precedence over {@link #setAtlasFallback}, except
+     * for glyphs that are too big for an atlas page.
+     *
+     * @return true if this font adds missing glyphs to the atlases on first use.
+     */
+    bool hasLazyAtlas() const { return _lazy; }
+    
+    /**
+     * Sets the maximum number of lazy glyphs to upload each frame.
+     *
+     * Each upload replaces the rows of the atlas texture holding the glyph,
+     * so this limit bounds the texture traffic of a lazy atlas in any one
+     * animation frame. A value of 0 means there is no limit. This value is
+     * only relevant if {@link #hasLazyAtlas} is true.
+     *
+     * @param limit The maximum number of lazy glyphs to upload each frame
+     */
+    void setUploadLimit(Uint32 limit) { _uploadLimit = limit; }
+    
+    /**
+     * Returns the maximum number of lazy glyphs to upload each frame.
+     *
+     * Each upload replaces the rows of the atlas texture holding the glyph,
+     * so this limit bounds the texture traffic of a lazy atlas in any one
+     * animation frame. A value of 0 means there is no limit. This value is
+     * only relevant if {@link #hasLazyAtlas} is true.
+     *
+     * @return the maximum number of lazy glyphs to upload each frame
+     */
+    Uint32 getUploadLimit() const { return _uploadLimit; }
+    
+    /**
+     * Sets the thread pool for rasterizing atlas glyphs.
+     *
+     * If this value is not null, {@link #buildAtlasesAsync} rasterizes the
+     * glyphs of each atlas on the worker threads of this pool, with a
+     * separate font face for each thread. Only the layout of the atlas
+     * and the texture upload remain serial. If this value is null (the
+     * default), all glyphs are rasterized on the calling thread.
+     *
+     * The atlas build blocks until the workers are done. So this pool must
+     * not be the one that calls {@link #buildAtlasesAsync}, such as the
+     * thread pool of an {@link AssetManager}. Otherwise the build can
+     * deadlock waiting for itself.
+     *
+     * @param threads   The thread pool for rasterizing atlas glyphs
+     */
+    void setRasterThreads(const std::shared_ptr<ThreadPool>& threads) { _rasterThreads = threads; }
+    
+    /**
+     * Returns the thread pool for rasterizing atlas glyphs.
+     *
+     * If this value is not null, {@link #buildAtlasesAsync} rasterizes the
+     * glyphs of each atlas on the worker threads of this pool, with a
+     * separate font face for each thread. Only the layout of the atlas
+     * and the texture upload remain serial. If this value is null (the
+     * default), all glyphs are rasterized on the calling thread.
+     *
+     * @return the thread pool for rasterizing atlas glyphs
+     */
+    const std::shared_ptr<ThreadPool>& getRasterThreads() const { return _rasterThreads; }
+    
     /**
      * Sets the limit for shrinking the advance during tracking
      *
@@ -1283,6 +1605,19 @@ public:
      * This method must be called on the main thread.
      */
     bool storeAtlases();
+    
+    /**
+     * Uploads the pending glyphs of a lazy atlas to their textures.
+     *
+     * This method uploads at most {@link #getUploadLimit} glyphs, in the
+     * order that they were added. It is called automatically at the start
+     * of each animation frame while there are glyphs pending, so it is
+     * rarely necessary to call it directly. This method must be called on
+     * the main thread.
+     *
+     * @return the number of glyphs still waiting to be uploaded
+     */
+    size_t updateAtlases();
 
     /**
      * Returns the OpenGL textures for the associated atlas collection.
@@ -2281,6 +2616,38 @@ private:
                            std::vector<std::shared_ptr<Atlas>>& atlases,
                            std::unordered_map<Uint32, size_t>& map);
     
+    /**
+     * Adds the missing glyphs of the character set to the lazy atlases.
+     *
+     * Each glyph supported by the font, but not yet in an atlas, is
+     * rasterized into the last growable atlas page, starting a new page
+     * when that one is full. The glyphs are queued for upload, and an
+     * upload callback is scheduled if necessary.
+     *
+     * The character set should be all UNICODE values.
+     *
+     * WARNING: This method is not thread safe. It generates an OpenGL texture,
+     * which means that it may only be called in the main thread.
+     *
+     * @param charset   The characters to add
+     */
+    void reserveGlyphs(const std::vector<Uint32>& charset);
+    
+    /**
+     * Returns a new font face matching the settings of this font.
+     *
+     * The face is opened from the same source file, with the same size,
+     * style, hinting, and kerning. It is used to rasterize glyphs on other
+     * threads, as a font face may only be used by one thread at a time.
+     * The caller must close the face with TTF_CloseFont.
+     *
+     * Opening and closing font faces is not thread safe. This method should
+     * only be called on the thread that builds the atlases.
+     *
+     * @return a new font face matching the settings of this font.
+     */
+    TTF_Font* openFace() const;
+    
     /**
      * Creates a quad outline of this character and stores it in mesh
      *
@@ -88,6 +88,17 @@ public:
         texture = nullptr;
     }
     
+    /**
+     * Removes all glyphs from this glyph run, but keeps the texture.
+     *
+     * The mesh keeps its capacity, so a glyph run can be refilled with
+     * new text of a similar length without allocating any memory.
+     */
+    void clear() {
+        contents.clear();
+        mesh.clear();
+    }
+    
     /**
      * Returns a newly allocated glyph run
      *
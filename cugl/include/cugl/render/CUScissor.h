@@ -391,6 +391,7 @@ public:
      * @return this scissor mask, returned for chaining
      */
     Scissor& operator=(Scissor&& mask)  {
+        _scissor   = mask._scissor;
         _inverse   = mask._inverse;
         _transform = mask._transform;
         _bounds  = mask._bounds;
@@ -823,6 +824,40 @@ public:
      */
     std::shared_ptr<Scissor> getIntersection(const std::shared_ptr<Scissor>& mask) const;
 
+#pragma mark -
+#pragma mark Comparisons
+    /**
+     * Returns true if this scissor mask is identical to the given one.
+     *
+     * Two scissor masks are identical if they produce the same shader data.
+     * That is, they have the same bounds, the same fringe, and the same
+     * final transform. This comparison is exact, and is intended to detect
+     * redundant changes to the scissor state.
+     *
+     * @param mask  The scissor mask to compare against
+     *
+     * @return true if this scissor mask is identical to the given one.
+     */
+    bool operator==(const Scissor& mask) const {
+        return _scissor == mask._scissor && _bounds == mask._bounds && _fringe == mask._fringe;
+    }
+    
+    /**
+     * Returns true if this scissor mask is not identical to the given one.
+     *
+     * Two scissor masks are identical if they produce the same shader data.
+     * That is, they have the same bounds, the same fringe, and the same
+     * final transform. This comparison is exact, and is intended to detect
+     * redundant changes to the scissor state.
+     *
+     * @param mask  The scissor mask to compare against
+     *
+     * @return true if this scissor mask is not identical to the given one.
+     */
+    bool operator!=(const Scissor& mask) const {
+        return !(*this == mask);
+    }
+    
 #pragma mark -
 #pragma mark Conversion
     /**
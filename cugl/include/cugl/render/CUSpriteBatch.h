@@ -51,12 +51,19 @@
 #include <vector>
 #include "CUSpriteVertex.h"
 #include "CUMesh.h"
+#include "CUScissor.h"
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
 #include <cugl/math/CUColor4.h>
 
 // Default memory sizes
 #define DEFAULT_CAPACITY  8192
+// The initial number of segments in a vertex stream
+#define STREAM_MIN_SEGMENTS 3
+// The maximum number of segments in a vertex stream
+#define STREAM_MAX_SEGMENTS 16
+// The number of frames of flushes a vertex stream should hold
+#define STREAM_FRAMES       2
 #undef CLIP_MASK
 
 namespace cugl {
@@ -69,7 +76,6 @@ class Shader;
 class Affine2;
 class Texture;
 class Gradient;
-class Scissor;
 class Font;
 class Rect;
 class Poly2;
@@ -783,6 +789,109 @@ enum StencilEffect {
     
 };
 
+#pragma mark -
+#pragma mark Static Batches
+/**
+ * This class is a retained copy of the geometry drawn by a {@link SpriteBatch}.
+ *
+ * A static batch is created by bracketing ordinary sprite batch drawing with
+ * {@link SpriteBatch#beginStatic} and {@link SpriteBatch#endStatic}. The
+ * vertices drawn in between are copied (fully transformed and tinted) into a
+ * {@link VertexBuffer} of their own, together with the texture and blend state
+ * of each draw call. Calling {@link SpriteBatch#drawStatic} replays all of this
+ * without touching the vertices on the CPU, which makes it ideal for large
+ * pieces of the scene that never change, like the floors of a level.
+ *
+ * Only plain textured and untextured drawing can be retained. Gradients,
+ * scissors, blurs and stencil effects all rely on per-pass state, so a
+ * recording that uses any of them is discarded by {@link SpriteBatch#endStatic}.
+ *
+ * A static batch may only be replayed with the sprite batch that created it.
+ */
+class StaticBatch {
+private:
+    /** Allow the sprite batch access to the internals */
+    friend class SpriteBatch;
+
+    /**
+     * A single draw call of a static batch.
+     *
+     * This is the subset of the sprite batch context that can be retained.
+     */
+    class Segment {
+    public:
+        /** The first vertex index position of this draw call */
+        GLuint first;
+        /** The number of indices in this draw call */
+        GLuint count;
+        /** The drawing type for the shader */
+        GLint type;
+        /** The drawing command */
+        GLenum command;
+        /** The blending equation */
+        GLenum blendEq;
+        /** The source RGB blending function */
+        GLenum srcRGB;
+        /** The source alpha blending function */
+        GLenum srcAlpha;
+        /** The destination RGB blending function */
+        GLenum dstRGB;
+        /** The destination alpha blending function */
+        GLenum dstAlpha;
+        /** The texture (or nullptr for solid shapes) */
+        std::shared_ptr<Texture> texture;
+    };
+
+    /** The retained vertex buffer (nullptr until the recording completes) */
+    std::shared_ptr<VertexBuffer> _vertbuff;
+    /** The draw calls to replay, in order */
+    std::vector<Segment> _segments;
+    /** The vertices recorded so far (released once uploaded) */
+    std::vector<SpriteVertex2> _vertices;
+    /** The indices recorded so far (released once uploaded) */
+    std::vector<GLuint> _indices;
+    /** The number of indices in the retained vertex buffer */
+    GLuint _indxSize;
+    /** The perspective matrix in effect during the recording */
+    Mat4 _perspective;
+    /** Whether the recording only used state that can be retained */
+    bool _valid;
+    /** The number of draw calls that later draw calls may not merge with */
+    size_t _sealed;
+    
+public:
+    /**
+     * Creates an empty static batch.
+     *
+     * Static batches are only created by {@link SpriteBatch#beginStatic}.
+     */
+    StaticBatch() : _indxSize(0), _valid(true), _sealed(0) {}
+    
+    /**
+     * Deletes this static batch, releasing all resources.
+     */
+    ~StaticBatch() { dispose(); }
+    
+    /**
+     * Deletes the static batch, releasing all resources.
+     */
+    void dispose();
+    
+    /**
+     * Returns the number of draw calls needed to replay this batch.
+     *
+     * @return the number of draw calls needed to replay this batch.
+     */
+    size_t getSegmentCount() const { return _segments.size(); }
+    
+    /**
+     * Returns the number of indices retained by this batch.
+     *
+     * @return the number of indices retained by this batch.
+     */
+    unsigned int getIndexCount() const { return _indxSize; }
+};
+
 #pragma mark -
 #pragma mark SpriteBatch
 /**
@@ -858,8 +967,10 @@ private:
     /** The vertex buffer for this sprite batch */
     std::shared_ptr<UniformBuffer> _unifbuff;
     
-    /** The sprite batch vertex mesh */
+    /** The sprite batch vertex mesh (possibly a mapped stream segment) */
     SpriteVertex2* _vertData;
+    /** The CPU vertex mesh, used whenever the vertex stream is not mapped */
+    SpriteVertex2* _vertLocal;
     /** The vertex capacity of the mesh */
     unsigned int _vertMax;
     /** The number of vertices in the current mesh */
@@ -884,8 +995,12 @@ private:
     
     /** The active gradient */
     std::shared_ptr<Gradient> _gradient;
-    /** The active scissor mask */
-    std::shared_ptr<Scissor>  _scissor;
+    /** The active scissor mask (only valid if _scissored is true) */
+    Scissor _scissor;
+    /** Whether there is an active scissor mask */
+    bool _scissored;
+    /** The scissor states saved by pushScissor (reused across frames) */
+    std::vector<std::pair<bool,Scissor>> _scissorStack;
 
     // Monitoring values
     /** The number of vertices drawn in this pass (so far) */
@@ -893,6 +1008,41 @@ private:
     /** The number of OpenGL calls in this pass (so far) */
     unsigned int _callTotal;
     
+    /** The static batch being recorded (nullptr if not recording) */
+    std::shared_ptr<StaticBatch> _recording;
+    
+    /** Whether draw calls are sorted and merged before each flush */
+    bool _deferred;
+    /** The sort key of each recorded context (deferred mode) */
+    std::vector<Uint64> _sortKeys;
+    /** The recorded contexts in sorted order (deferred mode) */
+    std::vector<Uint32> _sortOrder;
+    /** The scratch space for the radix sort (deferred mode) */
+    std::vector<Uint32> _sortScratch;
+    /** The distinct blend states of the current flush (deferred mode) */
+    std::vector<Context*> _sortBlends;
+    /** The indices rearranged in sorted order (deferred mode) */
+    std::vector<GLuint> _sortIndx;
+    
+    /** Whether vertices are written directly to a mapped vertex stream */
+    bool _streaming;
+    /** The number of stream segments flushed in the current pass */
+    GLuint _streamFlushes;
+    /** The number of segments the vertex stream should have */
+    GLuint _streamSegments;
+    
+    /** The shader for instanced sprites (created on first use) */
+    std::shared_ptr<Shader> _instShader;
+    /** The per-instance vertex buffer (created on first use) */
+    std::shared_ptr<VertexBuffer> _instBuffer;
+    
+    /** Whether this sprite batch only records commands (no OpenGL) */
+    bool _recorder;
+    /** The vertex buffer for replaying recorded commands (created on first use) */
+    std::shared_ptr<VertexBuffer> _cmdbuff;
+    /** The recording currently loaded in the replay buffer (this pass only) */
+    const StaticBatch* _cmdsource;
+    
 
 #pragma mark -
 #pragma mark Constructors
@@ -1118,6 +1268,59 @@ public:
         std::shared_ptr<SpriteBatch> result = std::make_shared<SpriteBatch>();
         return (result->init(capacity,shader) ? result : nullptr);
     }
+    
+    /**
+     * Initializes a command recorder with the given vertex capacity.
+     *
+     * A command recorder is a sprite batch that never touches OpenGL. It
+     * has no shader or buffers of its own. Instead, every flush appends the
+     * pending vertices and draw calls to a {@link StaticBatch} (see
+     * {@link #getRecording}), which is later replayed on the rendering
+     * thread with {@link #drawRecording}. Because of this, a recorder may
+     * be created and drawn to on any thread.
+     *
+     * A recorder has the same limitations as a static batch. If anything
+     * drawn in a pass uses a gradient, scissor, blur or stencil effect, the
+     * recording for that pass is discarded.
+     * In addition, a recorder may not draw text (see {@link #drawText}).
+     * In deferred mode (see {@link #setDeferred}), each flush is recorded in
+     * sorted order, so the replay merges draw calls just as a deferred
+     * sprite batch would. However, instanced sprites (see
+     * {@link #drawInstances}) are recorded as regular quads.
+     *
+     * @param capacity The vertex capacity of this recorder
+     *
+     * @return true if initialization was successful.
+     */
+    bool initRecorder(unsigned int capacity);
+    
+    /**
+     * Returns a newly allocated command recorder with the given vertex capacity.
+     *
+     * A command recorder is a sprite batch that never touches OpenGL. It
+     * has no shader or buffers of its own. Instead, every flush appends the
+     * pending vertices and draw calls to a {@link StaticBatch} (see
+     * {@link #getRecording}), which is later replayed on the rendering
+     * thread with {@link #drawRecording}. Because of this, a recorder may
+     * be created and drawn to on any thread.
+     *
+     * A recorder has the same limitations as a static batch. If anything
+     * drawn in a pass uses a gradient, scissor, blur or stencil effect, the
+     * recording for that pass is discarded.
+     * In addition, a recorder may not draw text (see {@link #drawText}).
+     * In deferred mode (see {@link #setDeferred}), each flush is recorded in
+     * sorted order, so the replay merges draw calls just as a deferred
+     * sprite batch would. However, instanced sprites (see
+     * {@link #drawInstances}) are recorded as regular quads.
+     *
+     * @param capacity The vertex capacity of this recorder
+     *
+     * @return a newly allocated command recorder with the given vertex capacity.
+     */
+    static std::shared_ptr<SpriteBatch> allocRecorder(unsigned int capacity=DEFAULT_CAPACITY) {
+        std::shared_ptr<SpriteBatch> result = std::make_shared<SpriteBatch>();
+        return (result->initRecorder(capacity) ? result : nullptr);
+    }
 
 #pragma mark -
 #pragma mark Attributes
@@ -1298,6 +1501,21 @@ public:
      * @param scissor   The active scissor mask for this sprite batch
      */
     void setScissor(const std::shared_ptr<Scissor>& scissor);
+    
+    /**
+     * Sets the active scissor mask of this sprite batch
+     *
+     * Scissor masks may be combined with all types of drawing (colors,
+     * textures, and gradients).  They are specified in the same coordinate
+     * system as {@link getPerspective}.
+     *
+     * This method acquires a copy of the scissor. Unlike the shared pointer
+     * version, it allows a scene graph to keep its masks by value, so that
+     * it does not allocate a scissor on the heap each frame.
+     *
+     * @param scissor   The active scissor mask for this sprite batch
+     */
+    void setScissor(const Scissor& scissor) { applyScissor(&scissor); }
      
     /**
      * Returns the active scissor mask of this sprite batch
@@ -1310,12 +1528,84 @@ public:
      * is nullptr by default.
      *
      * This method returns a copy of the internal scissor. Changes to this
-     * object have no effect on the sprite batch.
+     * object have no effect on the sprite batch. As the copy is allocated
+     * on the heap, render code should use {@link #getActiveScissor} instead.
      *
      * @return The active scissor mask for this sprite batch
      */
     std::shared_ptr<Scissor> getScissor() const;
     
+    /**
+     * Returns a pointer to the active scissor mask of this sprite batch
+     *
+     * If this value is nullptr, then no scissor mask is active. Otherwise,
+     * the pointer refers to the internal scissor, and is only valid until
+     * the next change to the scissor mask. Copy it to keep it longer.
+     *
+     * Unlike {@link #getScissor}, this method does not allocate, so it is
+     * safe to call every frame.
+     *
+     * @return a pointer to the active scissor mask of this sprite batch
+     */
+    const Scissor* getActiveScissor() const {
+        return _scissored ? &_scissor : nullptr;
+    }
+    
+    /**
+     * Pushes a scissor mask onto the scissor stack of this sprite batch
+     *
+     * The new active scissor mask is the given mask, transformed by the
+     * given matrix and intersected with the current scissor mask (if any).
+     * The previous mask is restored by a matching call to {@link #popScissor}.
+     * This is the preferred way for a scene graph to nest scissors, as it
+     * does not allocate any scissor objects on the heap. In addition, if
+     * the new mask is the same as the current one (such as when a child
+     * scissor contains its parent), the drawing state is left unchanged.
+     *
+     * Every call to this method must be matched by a call to
+     * {@link #popScissor} before the end of the drawing pass.
+     *
+     * @param mask      The scissor mask to push
+     * @param transform The transform to apply to the scissor mask
+     */
+    void pushScissor(const Scissor& mask, const Affine2& transform);
+    
+    /**
+     * Pushes a scissor mask onto the scissor stack of this sprite batch
+     *
+     * The new active scissor mask is the given mask, transformed by the
+     * given matrix and intersected with the current scissor mask (if any).
+     * The previous mask is restored by a matching call to {@link #popScissor}.
+     * This is the preferred way for a scene graph to nest scissors, as it
+     * does not allocate any scissor objects on the heap. In addition, if
+     * the new mask is the same as the current one (such as when a child
+     * scissor contains its parent), the drawing state is left unchanged.
+     *
+     * Every call to this method must be matched by a call to
+     * {@link #popScissor} before the end of the drawing pass.
+     *
+     * @param mask      The scissor mask to push
+     * @param transform The transform to apply to the scissor mask
+     */
+    void pushScissor(const std::shared_ptr<Scissor>& mask, const Affine2& transform) {
+        pushScissor(*mask, transform);
+    }
+    
+    /**
+     * Restores the scissor mask active before the last {@link #pushScissor}
+     *
+     * The drawing state is only changed if the restored mask differs from
+     * the current one.
+     */
+    void popScissor();
+    
+    /**
+     * Returns the number of scissor masks on the scissor stack
+     *
+     * @return the number of scissor masks on the scissor stack
+     */
+    size_t getScissorDepth() const { return _scissorStack.size(); }
+    
     /**
      * Sets the blending function for the source color
      *
@@ -1492,6 +1782,116 @@ public:
      */
     float getDepth() const;
 
+    /**
+     * Sets whether this sprite batch sorts its draw calls before flushing.
+     *
+     * In deferred mode, the shapes drawn since the last flush are not drawn
+     * in the order submitted. Instead, every change of drawing state gets a
+     * sort key built from the layer, texture, blend state and drawing type.
+     * These keys are radix sorted and all shapes with the same key are merged
+     * into a single draw call. So interleaving two textures no longer costs
+     * a draw call for every switch.
+     *
+     * Shapes on the same layer may be drawn in any order, so use
+     * {@link #setLayer} to keep overlapping shapes in order. Draw calls with
+     * a gradient, scissor, blur or stencil effect cannot be reordered. If
+     * any such call is pending, the flush happens in submission order.
+     *
+     * Changing this value will cause the sprite batch to flush. This mode
+     * is off by default.
+     *
+     * @param deferred  Whether this sprite batch sorts its draw calls
+     */
+    void setDeferred(bool deferred);
+    
+    /**
+     * Returns true if this sprite batch sorts its draw calls before flushing.
+     *
+     * In deferred mode, the shapes drawn since the last flush are not drawn
+     * in the order submitted. Instead, every change of drawing state gets a
+     * sort key built from the layer, texture, blend state and drawing type.
+     * These keys are radix sorted and all shapes with the same key are merged
+     * into a single draw call. So interleaving two textures no longer costs
+     * a draw call for every switch.
+     *
+     * @return true if this sprite batch sorts its draw calls before flushing.
+     */
+    bool isDeferred() const { return _deferred; }
+    
+    /**
+     * Sets the current layer of this sprite batch.
+     *
+     * The layer is only used in deferred mode (see {@link #setDeferred}).
+     * Shapes on a lower layer are always drawn before shapes on a higher
+     * layer. Shapes on the same layer are sorted to minimize draw calls.
+     * Only the lower 24 bits of the layer are used.
+     *
+     * The layer is reset to 0 at the end of each pass.
+     *
+     * @param layer The current layer of this sprite batch
+     */
+    void setLayer(Uint32 layer);
+    
+    /**
+     * Returns the current layer of this sprite batch.
+     *
+     * The layer is only used in deferred mode (see {@link #setDeferred}).
+     * Shapes on a lower layer are always drawn before shapes on a higher
+     * layer. Shapes on the same layer are sorted to minimize draw calls.
+     * Only the lower 24 bits of the layer are used.
+     *
+     * @return the current layer of this sprite batch
+     */
+    Uint32 getLayer() const;
+
+    /**
+     * Sets whether this sprite batch writes vertices directly to the GPU.
+     *
+     * By default, vertices are assembled in a CPU array and uploaded with
+     * glBufferData on every flush. That is an extra copy, and the driver
+     * may stall while it reallocates a buffer still in use. When streaming,
+     * the vertex buffer is a ring of segments (see {@link VertexBuffer#setupStream}),
+     * and the vertices are written straight into a mapped segment as they are
+     * drawn. A segment is only mapped once there is something to draw, and it
+     * is unmapped at the next flush. The ring starts with {@link STREAM_MIN_SEGMENTS}
+     * segments and grows at the end of a pass so that it can hold the flushes
+     * of {@link STREAM_FRAMES} frames, up to {@link STREAM_MAX_SEGMENTS}.
+     *
+     * If the stream cannot be set up or mapped, the sprite batch logs an
+     * error and falls back to the CPU array. Vertices are also assembled in
+     * the CPU array while recording a static batch, as the recording must
+     * read them back.
+     *
+     * Changing this value will cause the sprite batch to flush. This mode
+     * is off by default, and should stay off unless profiling shows that the
+     * uploads are a bottleneck.
+     *
+     * @param stream    Whether this sprite batch writes vertices directly to the GPU
+     */
+    void setStreaming(bool stream);
+    
+    /**
+     * Returns true if this sprite batch writes vertices directly to the GPU.
+     *
+     * By default, vertices are assembled in a CPU array and uploaded with
+     * glBufferData on every flush. When streaming, the vertices are written
+     * straight into a mapped segment of a vertex ring instead.
+     *
+     * @return true if this sprite batch writes vertices directly to the GPU.
+     */
+    bool isStreaming() const { return _streaming; }
+    
+    /**
+     * Returns the number of segments the vertex stream ring should have.
+     *
+     * The ring is resized to this value the next time a segment is mapped.
+     * It starts at {@link STREAM_MIN_SEGMENTS} and grows at the end of each
+     * pass to hold the flushes of {@link STREAM_FRAMES} frames.
+     *
+     * @return the number of segments the vertex stream ring should have.
+     */
+    GLuint getStreamSegments() const { return _streamSegments; }
+
     /**
      * Sets the blur radius in pixels (0 if there is no blurring).
      *
@@ -1536,6 +1936,42 @@ public:
      */
     GLfloat getBlur() const;
 
+    /**
+     * Sets whether the active texture is a signed distance field.
+     *
+     * A distance field texture stores the distance to the nearest edge
+     * in its alpha channel, with the edge at 0.5. The shader turns this
+     * into coverage with a smooth step one screen pixel wide, so that
+     * glyphs stay sharp at any scale or rotation. This is the format
+     * of a {@link Font} atlas when {@link Font#isDistanceField} is true,
+     * and the text drawing methods set this value automatically.
+     *
+     * This setting is compatible with {@link #setBlur}, which widens the
+     * smooth step instead of sampling the texture several times. This
+     * value is false by default.
+     *
+     * @param value Whether the active texture is a signed distance field
+     */
+    void setDistanceField(bool value);
+
+    /**
+     * Returns true if the active texture is a signed distance field.
+     *
+     * A distance field texture stores the distance to the nearest edge
+     * in its alpha channel, with the edge at 0.5. The shader turns this
+     * into coverage with a smooth step one screen pixel wide, so that
+     * glyphs stay sharp at any scale or rotation. This is the format
+     * of a {@link Font} atlas when {@link Font#isDistanceField} is true,
+     * and the text drawing methods set this value automatically.
+     *
+     * This setting is compatible with {@link #setBlur}, which widens the
+     * smooth step instead of sampling the texture several times. This
+     * value is false by default.
+     *
+     * @return true if the active texture is a signed distance field
+     */
+    bool isDistanceField() const;
+
     /**
      * Sets the current stencil effect
      *
@@ -1642,6 +2078,131 @@ public:
     void flush();
 
     
+#pragma mark -
+#pragma mark Static Batching
+    /**
+     * Starts recording a static batch.
+     *
+     * This method flushes the sprite batch. Everything drawn from now until
+     * the call to {@link #endStatic} is still drawn as normal, but it is also
+     * copied into a {@link StaticBatch}. That batch can be replayed in later
+     * passes with {@link #drawStatic} for the cost of one draw call per
+     * texture (or blend) change.
+     *
+     * Recordings cannot be nested, and this method may only be called while
+     * the sprite batch is drawing.
+     */
+    void beginStatic();
+    
+    /**
+     * Completes the recording of a static batch.
+     *
+     * This method flushes the sprite batch and uploads the recorded vertices
+     * to a retained {@link VertexBuffer}. If the recording was empty, or it
+     * used a gradient, scissor, blur or stencil effect, this method returns
+     * nullptr. The recorded shapes are drawn either way.
+     *
+     * @return the recorded static batch (or nullptr if it could not be retained)
+     */
+    std::shared_ptr<StaticBatch> endStatic();
+    
+    /**
+     * Returns true if this sprite batch is recording a static batch.
+     *
+     * @return true if this sprite batch is recording a static batch.
+     */
+    bool isRecording() const { return _recording != nullptr; }
+    
+    /**
+     * Draws a static batch with the given transform.
+     *
+     * The transform is applied on top of the transforms in effect when the
+     * batch was recorded. So the identity transform redraws the batch exactly
+     * where it was recorded. The batch is drawn with the current perspective
+     * matrix. Any other state of this sprite batch (such as color, gradient,
+     * or scissor) is ignored.
+     *
+     * This method flushes the sprite batch, and may only be called while
+     * the sprite batch is drawing.
+     *
+     * @param batch     The static batch to draw
+     * @param transform The transform to apply to the recorded vertices
+     */
+    void drawStatic(const std::shared_ptr<StaticBatch>& batch, const Affine2& transform);
+    
+#pragma mark -
+#pragma mark Command Recording
+    /**
+     * Returns true if this sprite batch is a command recorder.
+     *
+     * A command recorder never touches OpenGL, and so it may be used on any
+     * thread. See {@link #initRecorder}.
+     *
+     * @return true if this sprite batch is a command recorder.
+     */
+    bool isRecorder() const { return _recorder; }
+    
+    /**
+     * Returns the commands recorded in the last pass of this recorder.
+     *
+     * The recording is reused by the next pass, so it must be replayed
+     * (with {@link #drawRecording}) before this recorder begins again. This
+     * method returns nullptr if this sprite batch is not a recorder, or if
+     * the last pass used a gradient, scissor, blur or stencil effect.
+     *
+     * @return the commands recorded in the last pass of this recorder.
+     */
+    std::shared_ptr<StaticBatch> getRecording() const;
+    
+    /**
+     * Returns the number of draw calls recorded so far in this pass.
+     *
+     * This method flushes the recorder, and marks the current end of the
+     * recording. Draw calls recorded after the mark are never merged with
+     * those before it. So the recording can be replayed in pieces (with
+     * {@link #drawRecording}), and something else drawn in between.
+     *
+     * This method may only be called on a recorder that is drawing.
+     *
+     * @return the number of draw calls recorded so far in this pass.
+     */
+    size_t markRecording();
+    
+    /**
+     * Draws the commands recorded by a command recorder.
+     *
+     * The recorded vertices are uploaded to a vertex buffer shared by all
+     * recordings, and then drawn with one draw call per texture (or blend)
+     * change, just like {@link #drawStatic}. The recording is drawn with
+     * the current perspective matrix.
+     *
+     * This method flushes the sprite batch, and may only be called while
+     * the sprite batch is drawing. It may not be called on a recorder.
+     *
+     * @param recording The recorded commands to draw
+     */
+    void drawRecording(const std::shared_ptr<StaticBatch>& recording) {
+        drawRecording(recording, 0, recording == nullptr ? 0 : recording->getSegmentCount());
+    }
+    
+    /**
+     * Draws a range of the commands recorded by a command recorder.
+     *
+     * This method draws the draw calls in the range [first,last) of the
+     * recording. The range boundaries should come from {@link #markRecording},
+     * so that no draw call spans them. The recorded vertices are only
+     * uploaded the first time a recording is drawn in a pass, so drawing a
+     * recording in several pieces costs no more than drawing it at once.
+     *
+     * This method flushes the sprite batch, and may only be called while
+     * the sprite batch is drawing. It may not be called on a recorder.
+     *
+     * @param recording The recorded commands to draw
+     * @param first     The first draw call to replay
+     * @param last      The draw call after the last one to replay
+     */
+    void drawRecording(const std::shared_ptr<StaticBatch>& recording, size_t first, size_t last);
+    
 #pragma mark -
 #pragma mark Solid Shapes
     /**
@@ -2739,6 +3300,75 @@ public:
      */
     void drawMesh(const SpriteVertex2* vertices, size_t size, const Affine2& transform, bool tint = true);
     
+#pragma mark -
+#pragma mark Instanced Drawing
+    /**
+     * Draws many copies of a textured quad with a single draw call.
+     *
+     * This method is intended for large sets of identical sprites, such as
+     * projectiles or tiles. Each {@link SpriteInstance} has its own position,
+     * scale, rotation, color and texture region. The quads are built on the
+     * GPU by an instanced vertex shader, so the CPU only uploads 40 bytes per
+     * sprite instead of four full vertices and six indices.
+     *
+     * The texture regions are in the coordinates of the root texture (as with
+     * {@link Texture#getSubTexture}). Each quad is the size of its region
+     * times its scale, and is positioned and rotated about the given anchor.
+     * The anchor is relative to the size of the quad, so the default places
+     * each instance position at the center of its sprite.
+     *
+     * The instances use their own colors, and ignore the active color. They
+     * use the current perspective, blending and stencil state. However, the
+     * instanced shader does not support gradients, scissors or blurs. If any
+     * of these are active (or a static batch is being recorded), the sprites
+     * are drawn as regular quads instead. In that case the texture becomes
+     * the active texture, just as with the other draw methods.
+     *
+     * This method flushes the sprite batch, and may only be called while
+     * the sprite batch is drawing.
+     *
+     * @param texture   The texture for every sprite
+     * @param instances The sprite instances
+     * @param size      The number of sprite instances
+     * @param anchor    The anchor of each sprite, relative to its size
+     */
+    void drawInstances(const std::shared_ptr<Texture>& texture, const SpriteInstance* instances,
+                       size_t size, const Vec2 anchor = Vec2::ANCHOR_CENTER);
+    
+    /**
+     * Draws many copies of a textured quad with a single draw call.
+     *
+     * This method is intended for large sets of identical sprites, such as
+     * projectiles or tiles. Each {@link SpriteInstance} has its own position,
+     * scale, rotation, color and texture region. The quads are built on the
+     * GPU by an instanced vertex shader, so the CPU only uploads 40 bytes per
+     * sprite instead of four full vertices and six indices.
+     *
+     * The texture regions are in the coordinates of the root texture (as with
+     * {@link Texture#getSubTexture}). Each quad is the size of its region
+     * times its scale, and is positioned and rotated about the given anchor.
+     * The anchor is relative to the size of the quad, so the default places
+     * each instance position at the center of its sprite.
+     *
+     * The instances use their own colors, and ignore the active color. They
+     * use the current perspective, blending and stencil state. However, the
+     * instanced shader does not support gradients, scissors or blurs. If any
+     * of these are active (or a static batch is being recorded), the sprites
+     * are drawn as regular quads instead. In that case the texture becomes
+     * the active texture, just as with the other draw methods.
+     *
+     * This method flushes the sprite batch, and may only be called while
+     * the sprite batch is drawing.
+     *
+     * @param texture   The texture for every sprite
+     * @param instances The sprite instances
+     * @param anchor    The anchor of each sprite, relative to its size
+     */
+    void drawInstances(const std::shared_ptr<Texture>& texture, const std::vector<SpriteInstance>& instances,
+                       const Vec2 anchor = Vec2::ANCHOR_CENTER) {
+        drawInstances(texture, instances.data(), instances.size(), anchor);
+    }
+    
 #pragma mark -
 #pragma mark Text Drawing
     /**
@@ -2755,6 +3385,9 @@ public:
      * If depth testing is on, the font glyphs will use the current sprite
      * batch depth.
      *
+     * This method may not be called on a command recorder, as a font may
+     * need to add glyphs to its atlases (which creates OpenGL textures).
+     *
      * @param text      The text to display
      * @param font      The font to render the text
      * @param position  The left edge of the text baseline
@@ -2775,6 +3408,9 @@ public:
      * If depth testing is on, the font glyphs will use the current sprite
      * batch depth.
      *
+     * This method may not be called on a command recorder, as a font may
+     * need to add glyphs to its atlases (which creates OpenGL textures).
+     *
      * @param text      The text to display
      * @param font      The font to render the text
      * @param origin    The rotational origin relative to the baseline
@@ -2795,6 +3431,9 @@ public:
      * If depth testing is on, the font glyphs will use the current sprite
      * batch depth.
      *
+     * This method may not be called on a command recorder, as a font may
+     * need to add glyphs to its atlases (which creates OpenGL textures).
+     *
      * @param text      The text layout for the text to display
      * @param position  The left edge of the text baseline
      */
@@ -2812,6 +3451,9 @@ public:
      * If depth testing is on, the font glyphs will use the current sprite
      * batch depth.
      *
+     * This method may not be called on a command recorder, as a font may
+     * need to add glyphs to its atlases (which creates OpenGL textures).
+     *
      * @param text      The text layout for the text to display
      * @param transform The coordinate transform
      */
@@ -2854,6 +3496,110 @@ private:
      */
     void unwind();
     
+    /**
+     * Flushes the current mesh in sorted order, returning true on success.
+     *
+     * This method is called by {@link #flush} in deferred mode. It sorts the
+     * recorded contexts and merges all contexts with the same sort key into
+     * a single draw call. If any recorded context uses state that cannot be
+     * reordered, this method does nothing and returns false.
+     *
+     * @return true if the mesh was flushed
+     */
+    bool flushSorted();
+    
+    /**
+     * Sorts the recorded contexts, returning true on success.
+     *
+     * The contexts are sorted by layer, texture, blend state and command.
+     * The sorted order is stored in _sortOrder, with the keys in _sortKeys.
+     * If any recorded context uses state that cannot be reordered, this
+     * method returns false.
+     *
+     * @return true if the recorded contexts were sorted
+     */
+    bool sortHistory();
+    
+    /**
+     * Copies the vertices about to be flushed into the active recording.
+     *
+     * This method is called by {@link #flush} when a static batch is being
+     * recorded. It invalidates the recording if any of the pending draw calls
+     * use state that cannot be retained. In deferred mode, the draw calls
+     * are captured in sorted order, so that a command recorder merges them
+     * just as {@link #flushSorted} would.
+     */
+    void capture();
+    
+    /**
+     * Returns a vertex buffer for retained or recorded vertices.
+     *
+     * The vertex buffer has the same layout as the main one, and is
+     * attached to the shader of this sprite batch.
+     *
+     * @return a vertex buffer for retained or recorded vertices.
+     */
+    std::shared_ptr<VertexBuffer> allocSegmentBuffer();
+    
+    /**
+     * Draws the segments of a static batch from the given vertex buffer.
+     *
+     * Only the segments in the range [first,last) are drawn. The vertex
+     * buffer must already hold the vertices and indices of the static
+     * batch. This method restores the main vertex buffer when done.
+     *
+     * @param batch         The static batch to draw
+     * @param buffer        The vertex buffer with the batch data
+     * @param perspective   The perspective matrix for the segments
+     * @param first         The first segment to draw
+     * @param last          The segment after the last one to draw
+     */
+    void drawSegments(const StaticBatch* batch, const std::shared_ptr<VertexBuffer>& buffer,
+                      const Mat4& perspective, size_t first, size_t last);
+    
+    /**
+     * Points the vertex mesh at the next segment of the vertex stream.
+     *
+     * This method does nothing unless this sprite batch is streaming and the
+     * vertex mesh is empty and unmapped. Hence it is safe to call it before
+     * every write to the vertex mesh; only the first write after a flush will
+     * map a segment. If the ring is smaller than the size requested at the end
+     * of the last pass, it is reallocated first.
+     *
+     * Vertices are never streamed while recording a static batch, as the
+     * recording must read them back.
+     */
+    void mapVertices();
+    
+    /**
+     * Points the vertex mesh back at the CPU array.
+     *
+     * If a segment of the vertex stream is mapped, it is unmapped without
+     * flushing any vertices.
+     */
+    void unmapVertices();
+    
+    /**
+     * Returns true if the instanced sprite pipeline was created.
+     *
+     * The pipeline is created the first time {@link #drawInstances} is called,
+     * so sprite batches that never draw instances pay nothing for it.
+     *
+     * @return true if the instanced sprite pipeline was created.
+     */
+    bool initInstancing();
+    
+    /**
+     * Sets the active scissor mask, skipping redundant state changes.
+     *
+     * The mask is copied into the sprite batch. If it is the same as the
+     * active mask, then nothing happens. Otherwise, the drawing context is
+     * marked dirty so the next vertices use the new mask.
+     *
+     * @param mask  The new scissor mask (nullptr for none)
+     */
+    void applyScissor(const Scissor* mask);
+    
     /**
      * Sets the active uniform block to agree with the gradient and stroke.
      *
@@ -105,6 +105,43 @@ public:
     static const GLvoid* gradcoordOffset()  { return (GLvoid*)offsetof(SpriteVertex3, gradcoord);  }
 };
 
+/**
+ * This class/struct is rendering information for an instanced sprite.
+ *
+ * The class is intended to be used as a struct.  It is the per-instance data
+ * of {@link SpriteBatch#drawInstances}, which draws the same textured quad
+ * many times with a single draw call. Each instance is 40 bytes, compared to
+ * the 4 vertices and 6 indices (over 100 bytes) of a quad in the regular
+ * sprite batch pipeline. The quad itself is built on the GPU.
+ *
+ * The size of the quad is the size of its texture region times the scale.
+ * So a negative scale will flip the sprite.
+ */
+class SpriteInstance {
+public:
+    /** The position of the sprite anchor */
+    cugl::Vec2  position;
+    /** The scale of the sprite (relative to its texture region) */
+    cugl::Vec2  scale;
+    /** The counter-clockwise rotation of the sprite in radians */
+    GLfloat     angle;
+    /** The packed sprite color (see {@link Color4#getPacked}) */
+    GLuint      color;
+    /** The texture region as (minS, minT, maxS, maxT) */
+    cugl::Vec4  texrect;
+    
+    /** The memory offset of the instance position */
+    static const GLvoid* positionOffset()   { return (GLvoid*)offsetof(SpriteInstance, position); }
+    /** The memory offset of the instance scale */
+    static const GLvoid* scaleOffset()      { return (GLvoid*)offsetof(SpriteInstance, scale);    }
+    /** The memory offset of the instance angle */
+    static const GLvoid* angleOffset()      { return (GLvoid*)offsetof(SpriteInstance, angle);    }
+    /** The memory offset of the instance color */
+    static const GLvoid* colorOffset()      { return (GLvoid*)offsetof(SpriteInstance, color);    }
+    /** The memory offset of the instance texture region */
+    static const GLvoid* texrectOffset()    { return (GLvoid*)offsetof(SpriteInstance, texrect);  }
+};
+
 }
 
 #endif /* __CU_SPRITE_VERTEX_H__ */
@@ -356,7 +356,8 @@ public:
     /**
      * Sets the text associated with this layout.
      *
-     * Changing this value will {@link #invalidate} the layout.
+     * Changing this value will {@link #invalidate} the layout. Setting the
+     * text to its current value keeps the existing layout.
      *
      * @param text  The text associated with this layout.
      */
@@ -406,6 +406,26 @@ public:
      */
     const Texture& set(const void *data);
 
+    /**
+     * Sets a horizontal band of this texture to the contents of the given buffer.
+     *
+     * The band is the given number of rows, starting at the given row, and
+     * spans the entire width of the texture. The buffer must have the correct
+     * data format. In addition, the buffer must be size width*height*bytesize,
+     * where height is the number of rows in the band. See {@link #getByteSize}
+     * for a description of the latter.
+     *
+     * This method does not rebuild the mipmaps. It is only successful if the
+     * texture is currently active.
+     *
+     * @param data      The buffer to read into the texture
+     * @param row       The first row of the band
+     * @param height    The number of rows in the band
+     *
+     * @return a reference to this (modified) texture for chaining.
+     */
+    const Texture& set(const void *data, unsigned int row, unsigned int height);
+
     
 #pragma mark -
 #pragma mark Attributes
@@ -46,6 +46,7 @@
 #define __CU_VERTEX_BUFFER_H__
 
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
@@ -76,6 +77,12 @@ class Shader;
  * buffer has attributes lacking in the shader, they will be ignored. If it is missing
  * attributes that the shader expects, the shader will use the default value
  * for the type.
+ *
+ * A vertex buffer can also stream its vertex data through a ring of
+ * segments (see {@link setupStream}). Instead of reallocating the buffer
+ * with every load, each load maps the next segment of the ring, which the
+ * caller may write to directly. Fences keep the CPU from overwriting a
+ * segment that the GPU is still drawing from.
  */
 class VertexBuffer {
 private:
@@ -97,6 +104,8 @@ private:
         GLboolean norm;
         /** The offset of the attribute in the vertex buffer */
         GLsizeiptr offset;
+        /** The instance divisor of the attribute (0 if per-vertex) */
+        GLuint divisor;
     };
     
     /** The data stride of this buffer (0 if there is only one attribute) */
@@ -109,6 +118,17 @@ private:
     /** The index buffer for drawing a shape */
     GLuint _indxBuffer;
     
+    /** The vertex capacity of each segment in the streaming ring (0 if not streaming) */
+    GLsizei _streamSize;
+    /** The active segment of the streaming ring */
+    GLuint  _streamSegment;
+    /** The byte offset of the active segment (added to every attribute offset) */
+    GLsizeiptr _streamBase;
+    /** Whether the active segment is currently mapped */
+    bool _streamMapped;
+    /** The fences marking when the GPU is done with each segment */
+    std::vector<GLsync> _streamFences;
+    
     /** The shader currently attached to this vertex buffer */
     std::shared_ptr<Shader> _shader;
     
@@ -117,6 +137,14 @@ private:
     /** The settings for each attribute */
     std::unordered_map<std::string, AttribData> _attributes;
     
+    /**
+     * Resets the attribute pointers of the attached shader.
+     *
+     * This method is used to point the attributes at the active segment of
+     * the streaming ring. It assumes that this buffer is bound.
+     */
+    void rebaseAttributes();
+    
 public:
 #pragma mark Constructors
     /**
@@ -271,6 +299,10 @@ public:
      * can amortize the uniform changes.  For quads and other simple meshes, 
      * you should always choose GL_STREAM_DRAW.
      *
+     * If this buffer is streaming, the data is copied into the next segment
+     * of the ring and the usage is ignored. If the data does not fit in a
+     * segment, the ring is released first.
+     *
      * This method will only succeed if this buffer is actively bound.
      *
      * @param data  The data to load
@@ -362,6 +394,104 @@ public:
     void drawInstanced(GLenum mode, GLsizei count, GLsizei instances, GLsizei offset=0);
     
     
+#pragma mark -
+#pragma mark Streaming
+    /**
+     * Sets up a streaming ring for the vertex data of this buffer.
+     *
+     * The ring consists of the given number of segments, each of which can
+     * hold capacity vertices. The storage for the ring is allocated once.
+     * From then on, each call to {@link mapStream} (or {@link loadVertexData})
+     * moves to the next segment and maps it with glMapBufferRange. The map is
+     * unsynchronized, so it never stalls on the driver. Instead, a fence is
+     * placed after the draws from each segment, and mapping a segment only
+     * waits if the GPU is still using it. With three or more segments, this
+     * should almost never happen.
+     *
+     * If streaming is already set up, this method will reallocate the ring.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param capacity  The number of vertices in each segment
+     * @param segments  The number of segments in the ring
+     *
+     * @return true if the streaming ring was successfully allocated
+     */
+    bool setupStream(GLsizei capacity, GLuint segments=3);
+    
+    /**
+     * Releases the streaming ring of this buffer.
+     *
+     * Vertex data will once again be loaded with glBufferData. If a segment
+     * is currently mapped, it will be unmapped.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     */
+    void releaseStream();
+    
+    /**
+     * Returns true if this buffer streams its vertex data through a ring.
+     *
+     * @return true if this buffer streams its vertex data through a ring.
+     */
+    bool isStreaming() const { return _streamSize > 0; }
+    
+    /**
+     * Returns the number of vertices in each segment of the streaming ring.
+     *
+     * If this buffer is not streaming, this method returns 0.
+     *
+     * @return the number of vertices in each segment of the streaming ring.
+     */
+    GLsizei getStreamCapacity() const { return _streamSize; }
+    
+    /**
+     * Returns the number of segments in the streaming ring.
+     *
+     * If this buffer is not streaming, this method returns 0.
+     *
+     * @return the number of segments in the streaming ring.
+     */
+    GLuint getStreamSegments() const { return (GLuint)_streamFences.size(); }
+    
+    /**
+     * Returns a pointer to the next segment of the streaming ring.
+     *
+     * The previous segment is fenced (as all draws from it must have been
+     * issued by now), and the next segment is mapped for writing. The memory
+     * is write-only: reading from it is undefined and may be very slow. The
+     * attributes of this buffer are pointed at the new segment, so draw
+     * commands use vertex positions relative to the segment start.
+     *
+     * The segment must be unmapped with {@link unmapStream} before drawing.
+     * This method returns nullptr if the segment could not be mapped.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @return a pointer to the next segment of the streaming ring.
+     */
+    void* mapStream();
+    
+    /**
+     * Unmaps the active segment of the streaming ring.
+     *
+     * Only the first size vertices of the segment are flushed to the GPU.
+     * Once unmapped, the segment can be drawn from.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param size  The number of vertices written to the segment
+     */
+    void unmapStream(GLsizei size);
+    
+    /**
+     * Returns true if a segment of the streaming ring is currently mapped.
+     *
+     * @return true if a segment of the streaming ring is currently mapped.
+     */
+    bool isMapped() const { return _streamMapped; }
+    
+    
 #pragma mark -
 #pragma mark Attributes
     /** 
@@ -421,6 +551,22 @@ public:
      */
     void disableAttribute(const std::string name);
     
+    /**
+     * Sets the instance divisor of the given attribute
+     *
+     * By default, every attribute advances once per vertex (a divisor of 0).
+     * An attribute with a divisor of n instead advances once every n instances
+     * of a call to {@link drawInstanced}. A vertex buffer whose attributes all
+     * have divisor 1 holds per-instance data, not per-vertex data.
+     *
+     * Like all attribute settings, the divisor is cached and reapplied when
+     * a new shader is attached.
+     *
+     * @param name      The attribute to modify.
+     * @param divisor   The instance divisor of the attribute.
+     */
+    void setDivisor(const std::string name, GLuint divisor);
+    
 
 };
 
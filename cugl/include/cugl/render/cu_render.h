@@ -42,6 +42,7 @@
 #include "CURenderTarget.h"
 #include "CUSpriteBatch.h"
 #include "CUSpriteSheet.h"
+#include "CUAtlasPacker.h"
 #include "CUCamera.h"
 #include "CUOrthographicCamera.h"
 #include "CUPerspectiveCamera.h"
@@ -46,6 +46,8 @@
 #include <cugl/math/cu_math.h>
 #include <cugl/scene2/graph/CUSceneNode.h>
 #include <cugl/render/CUOrthographicCamera.h>
+#include <cugl/util/CUThreadPool.h>
+#include <atomic>
 
 namespace cugl {
     
@@ -68,6 +70,24 @@ namespace cugl {
  */
 class Scene2 {
 #pragma mark Values
+    /**
+     * A node skipped by a recording thread, to be drawn on the main thread.
+     */
+    class Deferral {
+    public:
+        /** The number of draw calls recorded before this node */
+        size_t mark;
+        /** The node to draw */
+        scene2::SceneNode* node;
+        /** The transform passed to the node */
+        Affine2 transform;
+        /** The tint passed to the node */
+        Color4 tint;
+        /** Whether to render the subtree, or only draw the node */
+        bool subtree;
+    };
+    
+
 protected:
     /** The name of this scene */
     std::string _name;
@@ -88,6 +108,22 @@ protected:
     /** Whether or note this scene is still active */
     bool _active;
 
+    /** Whether to skip subtrees that are outside of the camera view */
+    bool _culling;
+    /** The camera view in world coordinates for the current render pass */
+    Rect _cullRect;
+    /** The number of nodes visited in the last render pass */
+    std::atomic<Uint32> _nodesVisited;
+    /** The number of nodes drawn in the last render pass */
+    std::atomic<Uint32> _nodesDrawn;
+    
+    /** The worker threads for recording subtrees (nullptr if single threaded) */
+    std::shared_ptr<ThreadPool> _recordThreads;
+    /** The command recorder for each child, reused between passes */
+    std::vector<std::shared_ptr<SpriteBatch>> _recorders;
+    /** The nodes each recorder left for the main thread, in draw order */
+    std::vector<std::vector<Deferral>> _deferrals;
+
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -340,6 +376,128 @@ public:
     /** Cast from a Scene to a string. */
     operator std::string() const { return toString(); }
 
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this scene culls nodes outside of the camera view.
+     *
+     * When culling is active, each node compares the world space bounding
+     * box of its subtree to the camera view before rendering.  If the two do
+     * not overlap, the entire subtree is skipped.  Bounding boxes are cached
+     * in each node, and are only recomputed when a transform in the subtree
+     * changes.
+     *
+     * Culling assumes that every node draws inside of its content bounds.
+     * Nodes that draw outside of their bounds should opt out with
+     * {@link scene2::SceneNode#setCullable}.  Culling is off by default.
+     *
+     * @return true if this scene culls nodes outside of the camera view.
+     */
+    bool isCulling() const { return _culling; }
+
+    /**
+     * Sets whether this scene culls nodes outside of the camera view.
+     *
+     * When culling is active, each node compares the world space bounding
+     * box of its subtree to the camera view before rendering.  If the two do
+     * not overlap, the entire subtree is skipped.  Bounding boxes are cached
+     * in each node, and are only recomputed when a transform in the subtree
+     * changes.
+     *
+     * Culling assumes that every node draws inside of its content bounds.
+     * Nodes that draw outside of their bounds should opt out with
+     * {@link scene2::SceneNode#setCullable}.  Culling is off by default.
+     *
+     * @param value Whether this scene culls nodes outside of the camera view.
+     */
+    void setCulling(bool value) { _culling = value; }
+
+    /**
+     * Returns the camera view in world coordinates.
+     *
+     * This is the rectangle used for culling.  It is recomputed from the
+     * camera at the start of each call to {@link #render}.
+     *
+     * @return the camera view in world coordinates.
+     */
+    const Rect& getCullRect() const { return _cullRect; }
+
+    /**
+     * Returns the number of nodes visited in the last render pass.
+     *
+     * A node is visited if its render method is called and it is visible.
+     * This includes nodes that are culled, but not the descendants of a
+     * culled node.
+     *
+     * @return the number of nodes visited in the last render pass.
+     */
+    Uint32 getNodesVisited() const { return _nodesVisited; }
+
+    /**
+     * Returns the number of nodes drawn in the last render pass.
+     *
+     * A node is drawn if it was visited and not culled.
+     *
+     * @return the number of nodes drawn in the last render pass.
+     */
+    Uint32 getNodesDrawn() const { return _nodesDrawn; }
+
+#pragma mark -
+#pragma mark Parallel Recording
+    /**
+     * Returns the worker threads used to record this scene.
+     *
+     * If this value is not nullptr, each call to {@link #render} traverses
+     * the children of this scene on these worker threads. Each child is
+     * recorded into a separate command recorder (see
+     * {@link SpriteBatch#initRecorder}), and the recordings are then drawn
+     * in order on the calling thread. So the scene is drawn exactly as
+     * it is on a single thread.
+     *
+     * Static subtrees, and nodes that are not recordable (such as labels,
+     * or nodes with a gradient or scissor), are skipped by the workers.
+     * They are drawn on the calling thread between the recorded commands,
+     * so static subtrees keep their retained batches. See
+     * {@link scene2::SceneNode#isRecordable}. If a recording still fails
+     * (because a custom node used an effect that cannot be recorded), that
+     * child is rendered again on the calling thread. Custom nodes must not
+     * call OpenGL in their draw methods when this is active. This value is
+     * nullptr by default.
+     *
+     * @return the worker threads used to record this scene.
+     */
+    const std::shared_ptr<ThreadPool>& getRecordingThreads() const { return _recordThreads; }
+    
+    /**
+     * Sets the worker threads used to record this scene.
+     *
+     * If this value is not nullptr, each call to {@link #render} traverses
+     * the children of this scene on these worker threads. Each child is
+     * recorded into a separate command recorder (see
+     * {@link SpriteBatch#initRecorder}), and the recordings are then drawn
+     * in order on the calling thread. So the scene is drawn exactly as
+     * it is on a single thread.
+     *
+     * Static subtrees, and nodes that are not recordable (such as labels,
+     * or nodes with a gradient or scissor), are skipped by the workers.
+     * They are drawn on the calling thread between the recorded commands,
+     * so static subtrees keep their retained batches. See
+     * {@link scene2::SceneNode#isRecordable}. If a recording still fails
+     * (because a custom node used an effect that cannot be recorded), that
+     * child is rendered again on the calling thread. Custom nodes must not
+     * call OpenGL in their draw methods when this is active. This value is
+     * nullptr by default.
+     *
+     * @param threads   The worker threads used to record this scene.
+     */
+    void setRecordingThreads(const std::shared_ptr<ThreadPool>& threads) {
+        _recordThreads = threads;
+        if (threads == nullptr) {
+            _recorders.clear();
+            _deferrals.clear();
+        }
+    }
+
 #pragma mark -
 #pragma mark View Size
     /**
@@ -791,6 +949,9 @@ public:
      * To override this draw order, you should place an {@link scene2::OrderedNode}
      * in the scene graph to specify an alternative order.
      *
+     * If this scene has recording threads, the children are recorded in
+     * parallel first (see {@link #setRecordingThreads}).
+     *
      * @param batch     The SpriteBatch to draw with.
      */
     virtual void render(const std::shared_ptr<SpriteBatch>& batch);
@@ -798,6 +959,34 @@ public:
 private:
 #pragma mark -
 #pragma mark Internal Helpers
+    /**
+     * Records the children of this scene on the recording threads.
+     *
+     * Each child that can be recorded is traversed by a separate task into
+     * its own command recorder. This method blocks until all of the tasks
+     * are complete. Afterwards, the recorder of a child has a recording
+     * if and only if that child was successfully recorded.
+     *
+     * @param perspective   The perspective matrix for the recordings
+     */
+    void recordChildren(const Mat4& perspective);
+    
+    /**
+     * Defers a node skipped by a recorder to the main thread.
+     *
+     * The node is drawn after the commands recorded so far, and before any
+     * commands recorded later. This method is safe to call from a recording
+     * thread, as each recorder only touches its own list.
+     *
+     * @param recorder  The recorder that skipped the node
+     * @param node      The node to draw on the main thread
+     * @param transform The transform passed to the node
+     * @param tint      The tint passed to the node
+     * @param subtree   Whether to render the subtree, or only draw the node
+     */
+    void deferRender(SpriteBatch* recorder, scene2::SceneNode* node,
+                     const Affine2& transform, Color4 tint, bool subtree);
+    
     // Tightly couple with Node
     friend class scene2::SceneNode;
 };
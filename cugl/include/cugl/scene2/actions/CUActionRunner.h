@@ -0,0 +1,484 @@
+//
+//  CUActionRunner.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a data-oriented alternative to the action manager.
+//  The action manager is general, but every animation costs a heap allocated
+//  instance, a string key, a hash lookup, and several virtual calls per frame.
+//  That is fine for a few dozen animations, but not for thousands of sprites.
+//
+//  The action runner only supports the built-in actions (move, rotate, scale,
+//  fade and animate). It unpacks each action into a plain record when it is
+//  activated, and stores the records of each kind in their own contiguous
+//  array. The update then steps each array in a tight loop. Easing functions
+//  are sampled once into a table, and animations are identified by integer
+//  handles instead of strings.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#ifndef __CU_ACTION_RUNNER_H__
+#define __CU_ACTION_RUNNER_H__
+
+#include "CUAction.h"
+#include <cugl/math/CUEasingFunction.h>
+#include <SDL/SDL.h>
+#include <vector>
+
+/** The number of samples in a precomputed easing table */
+#define EASING_SAMPLES  256
+
+namespace cugl {
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+/** Forward references */
+class Animate;
+class SpriteNode;
+
+/**
+ * This class provides a data-oriented runner for the built-in actions.
+ *
+ * Like {@link ActionManager}, this class attaches actions to scene graph
+ * nodes and animates them each frame. However, it is designed for a large
+ * number of simultaneous animations, such as a crowd of animated sprites.
+ * It differs from the action manager in the following ways.
+ *
+ * First, it only supports the built-in actions: {@link MoveBy}, {@link MoveTo},
+ * {@link RotateBy}, {@link RotateTo}, {@link ScaleBy}, {@link ScaleTo},
+ * {@link FadeIn}, {@link FadeOut}, and {@link Animate}. The action is
+ * unpacked when it is activated, and it is never called again. Hence changing
+ * an action has no effect on animations that are already running. Custom
+ * actions must still use an action manager.
+ *
+ * Second, animations are identified by integer handles, which are returned
+ * on activation. A handle is never reused, so a stale handle is safe to use
+ * after its animation completes. The value 0 is never a valid handle.
+ *
+ * Third, easing is restricted to the types of {@link EasingFunction}. Each
+ * easing function is sampled into a table the first time it is used, and
+ * the update interpolates that table instead of calling the function.
+ *
+ * Finally, paused animations do not advance, and an animation never moves
+ * past the end of its duration, even on a long frame.
+ *
+ * A runner is not thread safe. It should be updated on the same thread that
+ * modifies the scene graph.
+ */
+class ActionRunner {
+public:
+    /** An identifier for an active animation (0 is never valid) */
+    typedef Uint64 Handle;
+
+#pragma mark Internal Records
+private:
+    /** The kind of record referenced by a handle */
+    enum class Kind : Uint8 {
+        /** The handle is not in use */
+        NONE,
+        /** A movement animation */
+        MOVE,
+        /** A rotation animation */
+        ROTATE,
+        /** A scaling animation (not SCALE, which the MP3 decoder defines) */
+        RESIZE,
+        /** A fade animation */
+        FADE,
+        /** A filmstrip animation */
+        ANIMATE
+    };
+
+    /**
+     * The state shared by all animation records.
+     *
+     * Records are plain structs so that they can be stored and moved in
+     * contiguous arrays. The target is a raw pointer; the slot keeps the
+     * node alive.
+     */
+    struct Tween {
+        /** The node being animated */
+        SceneNode* target;
+        /** The slot of this record in the handle table */
+        Uint32 slot;
+        /** The easing table (nullptr for linear easing) */
+        const float* easing;
+        /** The duration of this animation in seconds */
+        float duration;
+        /** The time elapsed since activation */
+        float elapsed;
+        /** The eased progress in [0,1] at the last update */
+        float progress;
+        /** Whether this animation is paused */
+        bool paused;
+    };
+
+    /** A movement record, for both {@link MoveBy} and {@link MoveTo} */
+    struct MoveTween : public Tween {
+        /** The total displacement of the animation */
+        Vec2 delta;
+    };
+
+    /** A rotation record, for both {@link RotateBy} and {@link RotateTo} */
+    struct RotateTween : public Tween {
+        /** The total change in angle of the animation */
+        float delta;
+    };
+
+    /** A scaling record, for both {@link ScaleBy} and {@link ScaleTo} */
+    struct ScaleTween : public Tween {
+        /** The total change in scale of the animation */
+        Vec2 delta;
+    };
+
+    /** A fade record, for both {@link FadeIn} and {@link FadeOut} */
+    struct FadeTween : public Tween {
+        /** The total change in alpha of the animation */
+        float delta;
+        /** The unclamped alpha value (clamping must not lose progress) */
+        float alpha;
+    };
+
+    /** A filmstrip record, for {@link Animate} */
+    struct AnimateTween : public Tween {
+        /** The film strip being animated */
+        SpriteNode* strip;
+        /** The animation sequence (the slot keeps it alive) */
+        const Animate* action;
+    };
+
+    /**
+     * An entry in the handle table.
+     *
+     * A slot maps a handle to the position of its record. It also holds the
+     * references that keep the target and action alive, so that the records
+     * themselves can stay plain data.
+     */
+    struct Slot {
+        /** The kind of record for this slot */
+        Kind kind;
+        /** The position of the record in its array */
+        Uint32 index;
+        /** The generation of this slot, to detect stale handles */
+        Uint32 generation;
+        /** The node being animated */
+        std::shared_ptr<SceneNode> target;
+        /** The action being animated */
+        std::shared_ptr<Action> action;
+    };
+
+#pragma mark Values
+    /** The active movement animations */
+    std::vector<MoveTween> _moves;
+    /** The active rotation animations */
+    std::vector<RotateTween> _rotates;
+    /** The active scaling animations */
+    std::vector<ScaleTween> _scales;
+    /** The active fade animations */
+    std::vector<FadeTween> _fades;
+    /** The active filmstrip animations */
+    std::vector<AnimateTween> _animates;
+
+    /** The handle table */
+    std::vector<Slot> _slots;
+    /** The unused entries of the handle table */
+    std::vector<Uint32> _free;
+
+    /** The sampled easing functions, indexed by type (empty if unused) */
+    std::vector<float> _easings[(int)EasingFunction::Type::ELASTIC_IN_OUT+1];
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates a new degenerate ActionRunner on the stack.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    ActionRunner() {}
+
+    /**
+     * Deletes this action runner, disposing all resources
+     */
+    ~ActionRunner() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this action runner.
+     *
+     * A disposed action runner can be safely reinitialized. Any animations
+     * owned by this action runner will immediately stop and be released.
+     */
+    void dispose();
+
+    /**
+     * Initializes an action runner.
+     *
+     * @return true if initialization was successful.
+     */
+    bool init() { return true; }
+
+    /**
+     * Initializes an action runner with space for the given animations.
+     *
+     * The capacity is a hint, and is split evenly across the animation
+     * kinds. The runner will grow as necessary.
+     *
+     * @param capacity  The expected number of simultaneous animations
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t capacity);
+
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated action runner.
+     *
+     * @return a newly allocated action runner.
+     */
+    static std::shared_ptr<ActionRunner> alloc() {
+        std::shared_ptr<ActionRunner> result = std::make_shared<ActionRunner>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated action runner with space for the given animations.
+     *
+     * The capacity is a hint, and is split evenly across the animation
+     * kinds. The runner will grow as necessary.
+     *
+     * @param capacity  The expected number of simultaneous animations
+     *
+     * @return a newly allocated action runner with space for the given animations.
+     */
+    static std::shared_ptr<ActionRunner> alloc(size_t capacity) {
+        std::shared_ptr<ActionRunner> result = std::make_shared<ActionRunner>();
+        return (result->init(capacity) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Action Management
+    /**
+     * Returns a handle for a new animation of the target with the action.
+     *
+     * The action must be one of the built-in actions. Any state of the
+     * target needed by the action (such as its original position) is read
+     * immediately. If the action is not supported, or an {@link Animate}
+     * action is applied to a node that is not a {@link SpriteNode}, this
+     * method returns 0.
+     *
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing (interpolation) function type
+     *
+     * @return a handle for a new animation of the target with the action.
+     */
+    Handle activate(const std::shared_ptr<Action>& action,
+                    const std::shared_ptr<SceneNode>& target,
+                    EasingFunction::Type easing = EasingFunction::Type::LINEAR);
+
+    /**
+     * Returns true if the given handle represents an active animation
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the given handle represents an active animation
+     */
+    bool isActive(Handle handle) const {
+        return lookup(handle) != nullptr;
+    }
+
+    /**
+     * Removes the animation for the given handle.
+     *
+     * This act will immediately stop the animation.  The animated node will
+     * continue to have whatever state it had when the animation stopped.
+     *
+     * If there is no animation for the give handle (e.g. the animation is
+     * complete) this method will return false.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation was successfully removed
+     */
+    bool remove(Handle handle);
+
+    /**
+     * Updates all non-paused animations by dt seconds
+     *
+     * Each animation is moved forward by dt second.  If this causes an
+     * animation to reach its duration, the animation is removed and its
+     * handle is no longer active.
+     *
+     * @param dt    The number of seconds to animate
+     */
+    void update(float dt);
+
+    /**
+     * Returns the number of active animations.
+     *
+     * @return the number of active animations.
+     */
+    size_t size() const {
+        return _moves.size()+_rotates.size()+_scales.size()+_fades.size()+_animates.size();
+    }
+
+#pragma mark -
+#pragma mark Pausing
+    /**
+     * Returns true if the animation for the given handle is paused
+     *
+     * This method will return false if there is no active animation with the
+     * given handle.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation for the given handle is paused
+     */
+    bool isPaused(Handle handle) const;
+
+    /**
+     * Pauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is
+     * already paused, this method does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void pause(Handle handle);
+
+    /**
+     * Unpauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is not
+     * currently paused, this method does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void unpause(Handle handle);
+
+#pragma mark -
+#pragma mark Node Management
+    /**
+     * Removes all animations for the given target.
+     *
+     * If the target has no associated animations, this method does nothing.
+     * This method searches every active animation, so it should not be
+     * called every frame.
+     *
+     * @param target    The node to stop animating
+     */
+    void clearAllActions(const std::shared_ptr<SceneNode>& target);
+
+private:
+#pragma mark -
+#pragma mark Internal Helpers
+    /**
+     * Returns the record for the given handle (or nullptr if not active)
+     *
+     * @param handle    The animation handle
+     *
+     * @return the record for the given handle (or nullptr if not active)
+     */
+    const Tween* lookup(Handle handle) const;
+
+    /**
+     * Returns the record for the given handle (or nullptr if not active)
+     *
+     * @param handle    The animation handle
+     *
+     * @return the record for the given handle (or nullptr if not active)
+     */
+    Tween* lookup(Handle handle) {
+        return const_cast<Tween*>(static_cast<const ActionRunner*>(this)->lookup(handle));
+    }
+
+    /**
+     * Returns the sampled table for the given easing function.
+     *
+     * The table has {@link EASING_SAMPLES}+1 entries, and is computed the
+     * first time it is requested. This method returns nullptr for linear
+     * easing, as no table is necessary.
+     *
+     * @param type  The easing function type
+     *
+     * @return the sampled table for the given easing function.
+     */
+    const float* easing(EasingFunction::Type type);
+
+    /**
+     * Returns a handle for a new record of the given kind.
+     *
+     * The record itself must be appended to its array by the caller. The
+     * tween is initialized with the common state of the record.
+     *
+     * @param kind      The kind of record
+     * @param index     The position of the record in its array
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param type      The easing (interpolation) function type
+     * @param tween     The common state to initialize
+     *
+     * @return a handle for a new record of the given kind.
+     */
+    Handle acquire(Kind kind, size_t index,
+                   const std::shared_ptr<Action>& action,
+                   const std::shared_ptr<SceneNode>& target,
+                   EasingFunction::Type type, Tween* tween);
+
+    /**
+     * Removes the record in the given slot from its array.
+     *
+     * The slot is returned to the free list, and any handle to it is no
+     * longer active.
+     *
+     * @param slot  The slot to release
+     */
+    void release(Uint32 slot);
+
+    /**
+     * Removes the record at the given position in the array.
+     *
+     * The last record is moved into its place, so the array stays packed.
+     *
+     * @param tweens    The array of records
+     * @param index     The position of the record to remove
+     */
+    template <typename T>
+    void erase(std::vector<T>& tweens, Uint32 index);
+};
+    }
+}
+#endif /* __CU_ACTION_RUNNER_H__ */
@@ -30,6 +30,7 @@
 
 #include "CUAction.h"
 #include "CUActionManager.h"
+#include "CUActionRunner.h"
 #include "CUMoveAction.h"
 #include "CURotateAction.h"
 #include "CUScaleAction.h"
@@ -38,6 +38,7 @@
 #include "graph/CUSpriteNode.h"
 #include "graph/CUOrderedNode.h"
 #include "graph/CUCanvasNode.h"
+#include "graph/CUInstancedSpriteNode.h"
 #include "ui/CUButton.h"
 #include "ui/CULabel.h"
 #include "ui/CUProgressBar.h"
@@ -45,6 +46,7 @@
 #include "ui/CUNinePatch.h"
 #include "ui/CUTextField.h"
 #include "ui/CUScrollPane.h"
+#include "ui/CUListPane.h"
 
 // And sublibraries
 #include "layout/cu_layout.h"
@@ -1089,12 +1089,27 @@ public:
      * This method only worries about drawing the current node.  It does not
      * attempt to render the children.
      *
+     * A page is compiled once it has been drawn a few times without changes.
+     * Adjacent simple fills and text with the same render state are merged
+     * into a single mesh, so that they are submitted with one state change.
+     * Editing the page discards the compiled form.
+     *
      * @param batch     The SpriteBatch to draw with.
      * @param transform The global transformation matrix.
      * @param tint      The tint to blend with the Node color.
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) override;
     
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A canvas may draw text, gradients and stencil effects at any time,
+     * so it is always drawn on the main thread.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override { return false; }
+    
 #pragma mark -
 #pragma mark Render State
     /**
@@ -0,0 +1,467 @@
+//
+//  CUInstancedSpriteNode.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for many sprites that share a
+//  sprite sheet, such as a wave of projectiles. A SpriteNode per sprite works,
+//  but every node recomputes its own frame polygon, is visited separately by
+//  render, and adds its own quad to the sprite batch. This node instead keeps
+//  the sprites as plain records. The texture region of every frame is computed
+//  once and shared by all of the sprites. Frame animation is advanced for all
+//  sprites in one pass, and all of the sprites are drawn with a single call to
+//  SpriteBatch::drawInstances.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#ifndef __CU_INSTANCED_SPRITE_NODE_H__
+#define __CU_INSTANCED_SPRITE_NODE_H__
+
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <cugl/render/CUTexture.h>
+#include <vector>
+
+namespace cugl {
+
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+#pragma mark -
+#pragma mark InstancedSpriteNode
+/**
+ * This class is a scene graph node for many sprites from one sprite sheet.
+ *
+ * The sprite sheet is broken into frames just as with {@link SpriteNode}.
+ * However, this node does not draw a single frame. Instead, it holds any
+ * number of sprites, each with its own position, scale, angle, color and
+ * frame. The sprites are not scene graph nodes. They are identified by the
+ * integer returned from {@link #addSprite}, and are positioned in the
+ * coordinate space of this node.
+ *
+ * The texture region of every frame is computed when the node is
+ * initialized, so changing the frame of a sprite is just an index change.
+ * A sprite may also be given a looping (or one-shot) frame animation with
+ * {@link #animateSprite}. The method {@link #update} advances all of these
+ * animations at once.
+ *
+ * All sprites are drawn in order of their identifiers with one call to
+ * {@link SpriteBatch#drawInstances}. Each sprite is centered on its position.
+ * As instances cannot be sheared, the node to world transform should be a
+ * combination of translation, rotation and (possibly non-uniform) scale. The
+ * scale is applied before the rotation of each sprite.
+ */
+class InstancedSpriteNode : public SceneNode {
+protected:
+    /**
+     * The state of a single sprite.
+     *
+     * Sprites are plain records stored in a contiguous array. A removed
+     * sprite is marked inactive, and its identifier is reused by the next
+     * call to {@link #addSprite}.
+     */
+    struct Sprite {
+        /** The position of the sprite center in node space */
+        Vec2 position;
+        /** The scale of the sprite */
+        Vec2 scale;
+        /** The counter-clockwise rotation of the sprite in radians */
+        float angle;
+        /** The color tint of the sprite */
+        Color4 color;
+        /** The active animation frame */
+        int frame;
+        /** The first frame of the animation */
+        int first;
+        /** The last frame of the animation (inclusive) */
+        int last;
+        /** The number of seconds per animation frame (0 if not animated) */
+        float rate;
+        /** The time spent on the active frame */
+        float time;
+        /** Whether the animation starts over after the last frame */
+        bool loop;
+        /** Whether this sprite is in use */
+        bool active;
+    };
+
+    /** The sprite sheet texture */
+    std::shared_ptr<Texture> _texture;
+    /** The number of columns in the sprite sheet */
+    int _cols;
+    /** The number of frames in the sprite sheet */
+    int _size;
+    /** The size of a single frame */
+    Size _frameSize;
+    /** The texture region of each frame, relative to the root texture */
+    std::vector<Vec4> _frames;
+    /** The sprites of this node (including inactive ones) */
+    std::vector<Sprite> _sprites;
+    /** The identifiers of the inactive sprites */
+    std::vector<size_t> _free;
+    /** The instances for the last draw (kept to avoid reallocation) */
+    std::vector<SpriteInstance> _instances;
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates an uninitialized node.
+     *
+     * You must initialize this object before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    InstancedSpriteNode();
+
+    /**
+     * Releases all resources allocated with this node.
+     *
+     * This will release, but not necessarily delete the associated texture.
+     */
+    ~InstancedSpriteNode() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this node.
+     *
+     * A disposed node can be safely reinitialized. Any children owned by this
+     * node will be released. They will be deleted if no other object owns them.
+     *
+     * It is unsafe to call this on a node that is still currently inside of
+     * a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Initializes the node with the given sprite sheet.
+     *
+     * This initializer assumes that the sprite sheet is rectangular, and that
+     * there are no unused frames. The node has no sprites.
+     *
+     * @param texture   The sprite sheet texture
+     * @param rows      The number of rows in the sprite sheet
+     * @param cols      The number of columns in the sprite sheet
+     *
+     * @return true if the node is initialized properly, false otherwise.
+     */
+    bool initWithSheet(const std::shared_ptr<Texture>& texture, int rows, int cols) {
+        return initWithSheet(texture,rows,cols,rows*cols);
+    }
+
+    /**
+     * Initializes the node with the given sprite sheet.
+     *
+     * The parameter size is to indicate that there are unused frames in the
+     * sprite sheet.  The value size must be less than or equal to rows*cols,
+     * or this initializer will raise an error. The node has no sprites.
+     *
+     * @param texture   The sprite sheet texture
+     * @param rows      The number of rows in the sprite sheet
+     * @param cols      The number of columns in the sprite sheet
+     * @param size      The number of frames in the sprite sheet
+     *
+     * @return true if the node is initialized properly, false otherwise.
+     */
+    bool initWithSheet(const std::shared_ptr<Texture>& texture, int rows, int cols, int size);
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated node with the given sprite sheet.
+     *
+     * This constructor assumes that the sprite sheet is rectangular, and that
+     * there are no unused frames. The node has no sprites.
+     *
+     * @param texture   The sprite sheet texture
+     * @param rows      The number of rows in the sprite sheet
+     * @param cols      The number of columns in the sprite sheet
+     *
+     * @return a newly allocated node with the given sprite sheet.
+     */
+    static std::shared_ptr<InstancedSpriteNode> alloc(const std::shared_ptr<Texture>& texture,
+                                                      int rows, int cols) {
+        std::shared_ptr<InstancedSpriteNode> node = std::make_shared<InstancedSpriteNode>();
+        return (node->initWithSheet(texture,rows,cols) ? node : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given sprite sheet.
+     *
+     * The parameter size is to indicate that there are unused frames in the
+     * sprite sheet.  The value size must be less than or equal to rows*cols,
+     * or this constructor will raise an error. The node has no sprites.
+     *
+     * @param texture   The sprite sheet texture
+     * @param rows      The number of rows in the sprite sheet
+     * @param cols      The number of columns in the sprite sheet
+     * @param size      The number of frames in the sprite sheet
+     *
+     * @return a newly allocated node with the given sprite sheet.
+     */
+    static std::shared_ptr<InstancedSpriteNode> alloc(const std::shared_ptr<Texture>& texture,
+                                                      int rows, int cols, int size) {
+        std::shared_ptr<InstancedSpriteNode> node = std::make_shared<InstancedSpriteNode>();
+        return (node->initWithSheet(texture,rows,cols,size) ? node : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Sprite Sheet
+    /**
+     * Returns the sprite sheet texture.
+     *
+     * @return the sprite sheet texture.
+     */
+    const std::shared_ptr<Texture>& getTexture() const { return _texture; }
+
+    /**
+     * Returns the number of frames in the sprite sheet.
+     *
+     * @return the number of frames in the sprite sheet.
+     */
+    int getFrameCount() const { return _size; }
+
+    /**
+     * Returns the size of a single frame.
+     *
+     * @return the size of a single frame.
+     */
+    const Size& getFrameSize() const { return _frameSize; }
+
+    /**
+     * Returns the texture region of the given frame.
+     *
+     * The region is (minS, minT, maxS, maxT), relative to the root texture.
+     *
+     * @param frame The frame index
+     *
+     * @return the texture region of the given frame.
+     */
+    const Vec4& getFrameRegion(int frame) const {
+        CUAssertLog(frame >= 0 && frame < _size, "Invalid animation frame %d", frame);
+        return _frames[frame];
+    }
+
+#pragma mark -
+#pragma mark Sprites
+    /**
+     * Returns the identifier of a new sprite at the given position.
+     *
+     * The sprite has unit scale, no rotation, a white color and is not
+     * animated. The identifier of a removed sprite may be reused.
+     *
+     * @param position  The position of the sprite center in node space
+     * @param frame     The initial frame of the sprite
+     *
+     * @return the identifier of a new sprite at the given position.
+     */
+    size_t addSprite(const Vec2 position, int frame = 0);
+
+    /**
+     * Removes the sprite with the given identifier.
+     *
+     * The identifier may be reused by a later call to {@link #addSprite}.
+     *
+     * @param sprite    The sprite identifier
+     */
+    void removeSprite(size_t sprite);
+
+    /**
+     * Removes all of the sprites of this node.
+     */
+    void clearSprites();
+
+    /**
+     * Returns the number of sprites in this node.
+     *
+     * @return the number of sprites in this node.
+     */
+    size_t getSpriteCount() const { return _sprites.size()-_free.size(); }
+
+    /**
+     * Returns true if the given identifier is an active sprite.
+     *
+     * @param sprite    The sprite identifier
+     *
+     * @return true if the given identifier is an active sprite.
+     */
+    bool hasSprite(size_t sprite) const {
+        return sprite < _sprites.size() && _sprites[sprite].active;
+    }
+
+    /**
+     * Returns the position of the given sprite in node space.
+     *
+     * @param sprite    The sprite identifier
+     *
+     * @return the position of the given sprite in node space.
+     */
+    const Vec2& getSpritePosition(size_t sprite) const {
+        return _sprites[sprite].position;
+    }
+
+    /**
+     * Sets the position of the given sprite in node space.
+     *
+     * @param sprite    The sprite identifier
+     * @param position  The position of the sprite center
+     */
+    void setSpritePosition(size_t sprite, const Vec2 position);
+
+    /**
+     * Sets the scale of the given sprite.
+     *
+     * @param sprite    The sprite identifier
+     * @param scale     The scale of the sprite
+     */
+    void setSpriteScale(size_t sprite, const Vec2 scale);
+
+    /**
+     * Sets the counter-clockwise rotation of the given sprite in radians.
+     *
+     * @param sprite    The sprite identifier
+     * @param angle     The rotation of the sprite
+     */
+    void setSpriteAngle(size_t sprite, float angle);
+
+    /**
+     * Sets the color tint of the given sprite.
+     *
+     * @param sprite    The sprite identifier
+     * @param color     The color tint of the sprite
+     */
+    void setSpriteColor(size_t sprite, Color4 color);
+
+    /**
+     * Returns the active frame of the given sprite.
+     *
+     * @param sprite    The sprite identifier
+     *
+     * @return the active frame of the given sprite.
+     */
+    int getSpriteFrame(size_t sprite) const { return _sprites[sprite].frame; }
+
+    /**
+     * Sets the active frame of the given sprite.
+     *
+     * This does not stop any animation of the sprite.
+     *
+     * @param sprite    The sprite identifier
+     * @param frame     The active frame
+     */
+    void setSpriteFrame(size_t sprite, int frame);
+
+#pragma mark -
+#pragma mark Animation
+    /**
+     * Animates the given sprite over the frames first to last (inclusive).
+     *
+     * The sprite starts at frame first, and moves to the next frame every
+     * 1/fps seconds of {@link #update}. If loop is true, it returns to frame
+     * first after frame last. Otherwise it stays on the last frame, and the
+     * animation stops. A non-positive fps stops any animation.
+     *
+     * @param sprite    The sprite identifier
+     * @param first     The first frame of the animation
+     * @param last      The last frame of the animation
+     * @param fps       The number of frames per second
+     * @param loop      Whether to repeat the animation
+     */
+    void animateSprite(size_t sprite, int first, int last, float fps, bool loop = true);
+
+    /**
+     * Returns true if the given sprite is animating.
+     *
+     * @param sprite    The sprite identifier
+     *
+     * @return true if the given sprite is animating.
+     */
+    bool isAnimating(size_t sprite) const { return _sprites[sprite].rate > 0; }
+
+    /**
+     * Advances the animation of every sprite by dt seconds.
+     *
+     * @param dt    The number of seconds to animate
+     */
+    void update(float dt);
+
+#pragma mark -
+#pragma mark Drawing
+    /**
+     * Draws all of the sprites of this node with the given SpriteBatch.
+     *
+     * The sprites are drawn with a single call to
+     * {@link SpriteBatch#drawInstances}. This method does not recurse into
+     * the children.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    virtual void draw(const std::shared_ptr<SpriteBatch>& batch,
+                      const Affine2& transform, Color4 tint) override;
+    
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A command recorder can only record the sprites as regular quads,
+     * which loses the benefit of instancing. So this node is always drawn
+     * on the main thread, where it takes a single instanced draw call.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override { return false; }
+
+protected:
+    /**
+     * Returns the bounds of this node and all of its descendants.
+     *
+     * The bounds include every sprite (at any rotation) in addition to
+     * the content bounds and the children.
+     *
+     * @return the bounds of this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds() override;
+
+    /** This macro disables the copy constructor (not allowed on scene graphs) */
+    CU_DISALLOW_COPY_AND_ASSIGN(InstancedSpriteNode);
+};
+    }
+}
+
+#endif /* __CU_INSTANCED_SPRITE_NODE_H__ */
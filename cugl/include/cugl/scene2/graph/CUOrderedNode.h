@@ -47,6 +47,9 @@
 #define __CU_ORDERED_NODE_H__
 #include <cugl/scene2/graph/CUSceneNode.h>
 
+/** The maximum number of nodes that may share a deferred sprite batch layer */
+#define ORDERED_LAYER_LIMIT 64
+
 namespace cugl {
     namespace scene2 {
 /**
@@ -78,6 +81,16 @@ namespace cugl {
  * node. So it is impossible to interleave other descendants of the second
  * node with descendants of the first node.  This is necessary as the
  * two OrderedNodes may have incompatible orderings.
+ *
+ * A static node (see {@link SceneNode#setStatic}) is also a render barrier,
+ * as its subtree is drawn from a single retained batch.
+ *
+ * If the sprite batch is in deferred mode (see {@link SpriteBatch#setDeferred}),
+ * this node assigns increasing sprite batch layers as the priority changes.
+ * Nodes with different priorities stay in order. Nodes that share a priority
+ * may be merged into the same draw calls, but only if their world bounds do
+ * not overlap. Overlapping nodes of the same priority still draw in tree
+ * order. Use {@link #setDeferred} to turn on deferred mode for this node only.
  */
 class OrderedNode : public SceneNode {
 public:
@@ -185,8 +198,8 @@ protected:
         OrderedNode* parent;
         /** The node to be drawn at this step */
         std::shared_ptr<SceneNode> node;
-        /** The scissor value (possibly nullptr) */
-        std::shared_ptr<Scissor> scissor;
+        /** The index of the scissor value in the parent viewports (-1 for none) */
+        int scissor;
         /** The drawing transform */
         Affine2 transform;
         /** The tint color */
@@ -225,14 +238,37 @@ protected:
          * @return the value *a < *b
          */
         static bool sortCompare(Context* a, Context* b);
+
+        /**
+         * Returns true if a and b may share a sprite batch layer
+         *
+         * Two contexts may share a layer if the order between them is only
+         * decided by the canonical order (e.g. they have the same priority).
+         * In deferred mode the sprite batch is free to reorder shapes on the
+         * same layer, while the order between layers is preserved.
+         * So render also requires that the contexts on a layer do not
+         * overlap.
+         *
+         * @param a        The first (pointer) to compare
+         * @param b        The first (pointer) to compare
+         *
+         * @return true if a and b may share a sprite batch layer
+         */
+        static bool shareLayer(Context* a, Context* b);
     };
 
     /** The render queue (always use a deque for this functionality) */
     std::deque<Context*> _entries;
-    /** The global scissor context (necessary as sprite batches manage this normally) */
-    std::shared_ptr<Scissor> _viewport;
+    /** The scissor masks of the render queue (reused to avoid allocations) */
+    std::vector<Scissor> _viewports;
+    /** The index of the global scissor context in _viewports (-1 for none) */
+    int _viewport;
     /** The current render order */
     Order _order;
+    /** Whether to sort the draw calls of the render queue by texture */
+    bool _deferred;
+    /** The world bounds of the nodes on the current deferred layer */
+    std::vector<Rect> _layerBounds;
     
     /**
      * Adds the given node ot the render queue.
@@ -240,7 +276,7 @@ protected:
      * This method replaces {@link #render} to provide a delayed render command
      * (via a queue of {@link Context} objects). This method is recursive.
      * However, it will stop when it encounters any other {@link OrderedNode}
-     * objects.
+     * objects or any static nodes.
      *
      * @param node      The descendant node to render.
      * @param transform The global transformation matrix.
@@ -328,6 +364,7 @@ public:
      * the following additional attributes:
      *
      *      "order":    The sort order of this node.
+     *      "deferred": Whether to sort the draw calls by texture.
      *
      * Sort orders are specified as lower case strings representing the names
      * of the enum with dashes in place of underscores (e.g. "pre-order",
@@ -543,6 +580,7 @@ public:
      * the following additional attributes:
      *
      *      "order":    The sort order of this node.
+     *      "deferred": Whether to sort the draw calls by texture.
      *
      * Sort orders are specified as lower case strings representing the names
      * of the enum with dashes in place of underscores (e.g. "pre-order",
@@ -588,6 +626,40 @@ public:
      * @param order The render order of this node
      */
     void setOrder(Order order) { _order = order; }
+    
+    /**
+     * Returns true if this node renders with a deferred sprite batch
+     *
+     * If this value is true, the sprite batch is put in deferred mode (see
+     * {@link SpriteBatch#setDeferred}) while the render queue is drawn. Each
+     * change of priority moves to a new sprite batch layer, so nodes with
+     * different priorities are still drawn in order. But nodes that share a
+     * priority and do not overlap are sorted by texture and merged into as
+     * few draw calls as possible. This has no effect if the order is
+     * {@link Order#PRE_ORDER}.
+     *
+     * The default value is false.
+     *
+     * @return true if this node renders with a deferred sprite batch
+     */
+    bool isDeferred() const { return _deferred; }
+    
+    /**
+     * Sets whether this node renders with a deferred sprite batch
+     *
+     * If this value is true, the sprite batch is put in deferred mode (see
+     * {@link SpriteBatch#setDeferred}) while the render queue is drawn. Each
+     * change of priority moves to a new sprite batch layer, so nodes with
+     * different priorities are still drawn in order. But nodes that share a
+     * priority and do not overlap are sorted by texture and merged into as
+     * few draw calls as possible. This has no effect if the order is
+     * {@link Order#PRE_ORDER}.
+     *
+     * The default value is false.
+     *
+     * @param value Whether this node renders with a deferred sprite batch
+     */
+    void setDeferred(bool value) { _deferred = value; }
 
     /**
      * Draws this node and all of its children with the given SpriteBatch.
@@ -674,6 +674,18 @@ public:
      * @param tint      The tint to blend with the Node color.
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) override;
+    
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A path node with a stencil is drawn on the main thread, as a
+     * recording cannot retain stencil effects.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override {
+        return !_stencil && TexturedNode::isRecordable();
+    }
 
 private:
     /**
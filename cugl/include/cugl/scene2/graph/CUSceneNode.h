@@ -47,8 +47,13 @@
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUScissor.h>
 #include <cugl/assets/CUJsonValue.h>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include <atomic>
+
+/** The number of consecutive frames with by-name lookups before a warning */
+#define NAME_LOOKUP_LIMIT  60
 
 namespace cugl {
 
@@ -182,10 +187,46 @@ protected:
     Scene2* _graph;
     /** A layout manager for complex scene graphs */
     std::shared_ptr<Layout> _layout;
+    /** Whether the layout manager of this node must be applied again */
+    bool _layoutDirty;
+    /** Whether a descendant of this node must be laid out again */
+    bool _layoutPending;
+    /** The number of layout manager passes since the last reset */
+    static Uint64 _layoutPasses;
 
     /** The (current) child offset of this node (-1 if root) */
     int _childOffset;
 
+    /** The bounds of this node and all of its descendants in node space */
+    Rect _subtreeBounds;
+    /** The world space bounds of the subtree from the last render pass */
+    Rect _worldBounds;
+    /** The cached node to world transform */
+    mutable Affine2 _worldTransform;
+    /** The transform applied to this node by render if it has no parent */
+    Affine2 _rootTransform;
+    /** Whether the node to world transform must be recomputed */
+    mutable bool _transformDirty;
+    /** Whether the subtree bounds must be recomputed */
+    bool _boundsDirty;
+    /** Whether the world bounds must be recomputed */
+    bool _worldDirty;
+    /** Whether this node may be skipped when outside of the camera view */
+    bool _cullable;
+    /** Whether this subtree has a node that may not be culled */
+    bool _uncullable;
+
+    /** Whether this subtree is drawn from a retained static batch */
+    bool _static;
+    /** Whether the static batch must be recorded again */
+    bool _staticDirty;
+    /** The retained vertices of this subtree (nullptr if not retained) */
+    std::shared_ptr<StaticBatch> _staticBatch;
+    /** The inverse of the node to world transform when the batch was recorded */
+    Affine2 _staticInverse;
+    /** The tint when the batch was recorded */
+    Color4 _staticTint;
+
     /**
      * An identifying tag.
      *
@@ -213,6 +254,19 @@ protected:
      */
     size_t _hashOfName;
 
+    /** Whether this node keeps a hashed index of its children by name */
+    bool _nameIndexed;
+    /** The children of this node keyed by the hash of their name (if indexed) */
+    std::unordered_multimap<size_t, SceneNode*> _nameIndex;
+    /** The number of by-name child lookups since the last reset */
+    static std::atomic<Uint64> _nameLookups;
+    /** The lookup count at the last call to {@link #checkNameLookups} */
+    static Uint64 _nameLookupMark;
+    /** The number of consecutive frames with a by-name lookup */
+    static Uint32 _nameLookupStreak;
+    /** The number of consecutive frames with lookups before a warning */
+    static Uint32 _nameLookupLimit;
+
     /** The class name for the specific subclass */
     std::string _classname;
 
@@ -608,10 +662,7 @@ public:
    *
    * @param name  A string that is used to identify the node.
    */
-  void setName(const std::string name) {
-      _name = name;
-      _hashOfName = std::hash<std::string>()(_name);
-  }
+  void setName(const std::string name);
 
     /**
      * Returns the class name of this node.
@@ -1028,7 +1079,7 @@ public:
      *
      * @param color the color tinting this node.
      */
-    virtual void setColor(Color4 color) { _tintColor = color; }
+    virtual void setColor(Color4 color) { _tintColor = color; invalidateBounds(); }
 
     /**
      * Returns the absolute color tinting this node.
@@ -1061,7 +1112,7 @@ public:
      *
      * @param visible   true if the node is visible.
      */
-    void setVisible(bool visible) { _isVisible = visible; }
+    void setVisible(bool visible) { _isVisible = visible; invalidateBounds(); }
     
     /**
      * Returns true if this node is tinted by its parent.
@@ -1217,6 +1268,7 @@ public:
     void setScale(float scale) {
         _scale.set(scale,scale);
         if (!_useTransform) updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
 
     /**
@@ -1232,6 +1284,7 @@ public:
     void setScale(const Vec2 vec) {
         _scale = vec;
         if (!_useTransform) updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
 
     /**
@@ -1248,6 +1301,7 @@ public:
     void setScale(float sx, float sy) {
         _scale.set(sx,sy);
         if (!_useTransform) updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
     
     /**
@@ -1273,6 +1327,7 @@ public:
     void setAngle(float angle) {
         _angle = angle;
         if (!_useTransform) updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
     
     /**
@@ -1320,6 +1375,7 @@ public:
     void setAlternateTransform(const Affine2& transform) {
         _transform = transform;
         updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
     
     /**
@@ -1354,6 +1410,7 @@ public:
      */
     void chooseAlternateTransform(bool active) {
         _useTransform = active; updateTransform();
+        if (_parent) { _parent->invalidateLayout(); }
     }
 
     /**
@@ -1385,9 +1442,14 @@ public:
      * It is the recursive (left-multiplied) node-to-parent transforms of all 
      * of its ancestors.
      *
+     * This matrix is cached, and is only recomputed when this node or one of
+     * its ancestors changes its transform. It is the same matrix used to
+     * render this node, so it includes the pane transform of any ancestor
+     * {@link ScrollPane}.
+     *
      * @return the matrix transforming node space to world space.
      */
-    Affine2 getNodeToWorldTransform() const;
+    const Affine2& getNodeToWorldTransform() const;
     
     /**
      * Returns the matrix transforming node space to world space.
@@ -1511,6 +1573,18 @@ public:
      */
     size_t getChildCount() const { return _children.size(); }
 
+    /**
+     * Reserves storage for the given number of children.
+     *
+     * The children of a node are stored contiguously. Reserving the storage
+     * before adding a known number of children (e.g. when building a scene
+     * graph from a file) replaces the incremental growth of this storage
+     * with a single allocation of the exact size.
+     *
+     * @param count The number of children to reserve storage for
+     */
+    void reserveChildren(size_t count) { _children.reserve(count); }
+
     /**
      * Returns the child at the given position.
      *
@@ -1637,6 +1711,86 @@ public:
         return std::dynamic_pointer_cast<T>(getChildByName(name));
     }
 
+    /**
+     * Sets whether this node keeps a hashed index of its children by name.
+     *
+     * By default, {@link #getChildByName} is a linear search over the
+     * children of this node. That is fine for small nodes, but it is slow
+     * for a node with many children, such as a HUD layer or a tile layer.
+     * An indexed node keys its children by the hash of their name, so that
+     * each lookup is (amortized) constant time. The index is updated as
+     * children are added, removed, or renamed.
+     *
+     * The index is not free. It costs an allocation per child, and every
+     * change to the children must update it. So it should only be enabled
+     * on nodes that are searched often. For a node searched every frame, it
+     * is still better to look the child up once and keep the pointer.
+     *
+     * @param value Whether this node keeps a hashed index of its children
+     */
+    void setNameIndexed(bool value);
+
+    /**
+     * Returns true if this node keeps a hashed index of its children by name.
+     *
+     * See {@link #setNameIndexed} for more information.
+     *
+     * @return true if this node keeps a hashed index of its children by name.
+     */
+    bool isNameIndexed() const { return _nameIndexed; }
+
+    /**
+     * Returns the number of by-name child lookups since the last reset.
+     *
+     * Each call to {@link #getChildByName} increments this counter, whether
+     * or not the node is indexed. It is useful for profiling.
+     *
+     * @return the number of by-name child lookups since the last reset.
+     */
+    static Uint64 getNameLookups() { return _nameLookups.load(); }
+
+    /**
+     * Resets the by-name lookup counter to zero.
+     *
+     * This also resets the frame streak of {@link #checkNameLookups}.
+     */
+    static void resetNameLookups();
+
+    /**
+     * Sets the number of consecutive frames with lookups before a warning.
+     *
+     * Looking up a child by name every frame is almost always a mistake, as
+     * the child could have been looked up once and cached. If this value is
+     * positive, {@link #checkNameLookups} logs a warning once by-name lookups
+     * have occurred on this many frames in a row. A value of 0 disables the
+     * warning. By default, this value is {@link NAME_LOOKUP_LIMIT}.
+     *
+     * @param frames    The number of consecutive frames before a warning
+     */
+    static void setNameLookupLimit(Uint32 frames) { _nameLookupLimit = frames; }
+
+    /**
+     * Returns the number of consecutive frames with lookups before a warning.
+     *
+     * See {@link #setNameLookupLimit} for more information.
+     *
+     * @return the number of consecutive frames with lookups before a warning.
+     */
+    static Uint32 getNameLookupLimit() { return _nameLookupLimit; }
+
+    /**
+     * Returns true if by-name lookups have occurred for too many frames.
+     *
+     * This method should be called once per frame, typically at the end of
+     * the application update. It checks whether there were any calls to
+     * {@link #getChildByName} since the last call to this method. If this is
+     * true for {@link #getNameLookupLimit} frames in a row, it logs a warning
+     * and returns true. The warning is only logged once per streak.
+     *
+     * @return true if by-name lookups have occurred for too many frames.
+     */
+    static bool checkNameLookups();
+
     /**
      * Returns the list of the node's children.
      *
@@ -1909,7 +2063,222 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {}
     
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A scene with recording threads (see {@link Scene2#setRecordingThreads})
+     * draws its children on worker threads. A node that cannot be drawn
+     * there (because it uses a scissor, gradient, blur or stencil effect,
+     * or a font) is skipped by the worker, and its subtree is drawn on the
+     * main thread at the same place in the draw order.
+     *
+     * By default, a node is recordable if it has no scissor. Subclasses
+     * that use other effects should override this method.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const { return _scissor == nullptr; }
+    
+    /**
+     * Returns true if drawing this node was deferred to the main thread.
+     *
+     * If the batch is a command recorder, and this node is static or not
+     * recordable (see {@link #isRecordable}), this node is handed back to
+     * the scene with the given render arguments. The scene draws it on
+     * the main thread, between the commands recorded before and after it.
+     * If subtree is true, the scene renders this node and its descendants
+     * (which keeps static subtrees retained). Otherwise, it only draws this
+     * node, as {@link OrderedNode} does.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     * @param subtree   Whether to render the descendants as well
+     *
+     * @return true if drawing this node was deferred to the main thread.
+     */
+    bool deferRender(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform,
+                     Color4 tint, bool subtree);
+    
+    
+#pragma mark -
+#pragma mark Static Batching
+    /**
+     * Returns true if this subtree is drawn from a retained static batch.
+     *
+     * A static subtree is recorded into a {@link StaticBatch} the first time
+     * it is rendered. Later passes replay that batch with a single call to
+     * {@link SpriteBatch#drawStatic}, without visiting the descendants at all.
+     * Moving, rotating or scaling this node does not require a new recording.
+     * However, any change to a descendant (or to the color of this node) that
+     * invalidates the subtree bounds will cause the subtree to be recorded
+     * again on the next render.
+     *
+     * This is intended for large subtrees that rarely change, such as the
+     * floors and walls of a level. Subtrees that use gradients, scissors or
+     * stencil effects cannot be retained, and are drawn normally.
+     *
+     * By default, no node is static.
+     *
+     * @return true if this subtree is drawn from a retained static batch.
+     */
+    bool isStatic() const { return _static; }
+
+    /**
+     * Sets whether this subtree is drawn from a retained static batch.
+     *
+     * A static subtree is recorded into a {@link StaticBatch} the first time
+     * it is rendered. Later passes replay that batch with a single call to
+     * {@link SpriteBatch#drawStatic}, without visiting the descendants at all.
+     * Moving, rotating or scaling this node does not require a new recording.
+     * However, any change to a descendant (or to the color of this node) that
+     * invalidates the subtree bounds will cause the subtree to be recorded
+     * again on the next render.
+     *
+     * This is intended for large subtrees that rarely change, such as the
+     * floors and walls of a level. Subtrees that use gradients, scissors or
+     * stencil effects cannot be retained, and are drawn normally.
+     *
+     * By default, no node is static.
+     *
+     * @param value Whether this subtree is drawn from a retained static batch.
+     */
+    void setStatic(bool value);
+    
     
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this node may be culled.
+     *
+     * If the scene has culling active, a node is not rendered when the world
+     * bounds of its subtree do not overlap the camera view. Culling assumes
+     * that the node draws inside of its content bounds. A node that draws
+     * outside of these bounds (such as a wide stroke or a drop shadow)
+     * should not be cullable.  Any ancestor of such a node is not culled
+     * either.
+     *
+     * By default, all nodes are cullable.
+     *
+     * @return true if this node may be culled.
+     */
+    bool isCullable() const { return _cullable; }
+
+    /**
+     * Sets whether this node may be culled.
+     *
+     * If the scene has culling active, a node is not rendered when the world
+     * bounds of its subtree do not overlap the camera view. Culling assumes
+     * that the node draws inside of its content bounds. A node that draws
+     * outside of these bounds (such as a wide stroke or a drop shadow)
+     * should not be cullable.  Any ancestor of such a node is not culled
+     * either.
+     *
+     * By default, all nodes are cullable.
+     *
+     * @param value Whether this node may be culled.
+     */
+    void setCullable(bool value) {
+        _cullable = value;
+        invalidateBounds();
+    }
+
+    /**
+     * Returns the bounds of this node and all of its descendants.
+     *
+     * The bounds are in node space.  They contain the content bounds of this
+     * node and the transformed subtree bounds of every child.  The value is
+     * cached, and is only recomputed when a node in the subtree has changed
+     * its transform or size.
+     *
+     * @return the bounds of this node and all of its descendants.
+     */
+    const Rect& getSubtreeBounds();
+
+    /**
+     * Returns the world space bounds of this subtree from the last render.
+     *
+     * This value is only computed when the scene has culling active.  It is
+     * cached, and is only recomputed when either the node to world transform
+     * or the subtree changes.
+     *
+     * @return the world space bounds of this subtree from the last render.
+     */
+    const Rect& getWorldBounds() const { return _worldBounds; }
+
+    /**
+     * Marks the cached world transform of this node and all of its
+     * descendants as dirty.
+     *
+     * The transform setters call this method automatically.  A subclass only
+     * needs to call it if it changes how its children are transformed (such
+     * as the pane transform of a {@link ScrollPane}).
+     */
+    void invalidateTransform();
+
+    /**
+     * Marks the cached bounds of this node and all of its ancestors as dirty.
+     *
+     * This also discards the static batch of any static ancestor. The
+     * transform, size, color and visibility setters call this method
+     * automatically.  A subclass only needs to call it if it changes what
+     * it draws without going through those setters.
+     */
+    void invalidateBounds();
+
+protected:
+    /**
+     * Returns the matrix transforming the space of the children to world space.
+     *
+     * This is the transform that render passes to the children of this node.
+     * By default it is the node to world transform.  A node that applies an
+     * extra transform to its children should override this method.
+     *
+     * @return the matrix transforming the space of the children to world space.
+     */
+    virtual Affine2 getChildToWorldTransform() const {
+        return getNodeToWorldTransform();
+    }
+
+    /**
+     * Returns the node to world transform for a render pass.
+     *
+     * If this node has a parent, the cached node to world transform is used
+     * as is.  Otherwise, the transform passed to render is treated as the
+     * world transform of the (missing) parent, and the cache of this subtree
+     * is invalidated if that transform has changed.
+     *
+     * @param transform The transform passed to render.
+     *
+     * @return the node to world transform for a render pass.
+     */
+    const Affine2& getRenderTransform(const Affine2& transform);
+
+    /**
+     * Returns the bounds of this node and all of its descendants.
+     *
+     * This method is called by {@link #getSubtreeBounds} when the cached
+     * value is dirty.  The default implementation merges the content bounds
+     * with the subtree bounds of every child. A node that applies an extra
+     * transform to its children should override this method.
+     *
+     * @return the bounds of this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds();
+
+    /**
+     * Returns true if this subtree should be skipped by render.
+     *
+     * This method records the node as visited in the scene statistics. If
+     * the scene has culling active, it compares the (cached) world bounds of
+     * this subtree against the camera view. If the node is not culled, it is
+     * recorded as drawn.
+     *
+     * @return true if this subtree should be skipped by render.
+     */
+    bool cull();
+
+public:
 #pragma mark -
 #pragma mark Layout Automation
     /**
@@ -1939,7 +2308,7 @@ public:
      *
      * @param layout	The layout manager for this node
      */
-    void setLayout(const std::shared_ptr<Layout>& layout) { _layout = layout; }
+    void setLayout(const std::shared_ptr<Layout>& layout);
     
     /**
      * Arranges the child of this node using the layout manager.
@@ -1947,9 +2316,55 @@ public:
      * This process occurs recursively and top-down. A layout manager may end
      * up resizing the children.  That is why the parent must finish its layout
      * before we can apply a layout manager to the children.
+     *
+     * Layout is incremental. The layout manager of a node is only applied if
+     * the node was invalidated (see {@link #invalidateLayout}) since its last
+     * layout, and the traversal only descends into subtrees that contain
+     * such a node. Hence calling this method on a large, unchanged scene
+     * graph is essentially free.
      */
     virtual void doLayout();
 
+    /**
+     * Marks this node as needing layout.
+     *
+     * The next call to {@link #doLayout} on this node or any of its ancestors
+     * will reapply the layout manager of this node (and visit its children).
+     * Nodes invalidate themselves automatically whenever their size, their
+     * children, their layout manager, or its layout information changes. A
+     * child also invalidates its parent when its name, size, anchor, or
+     * transform changes, as these are the inputs of the parent layout.
+     *
+     * You only need to call this method if the layout depends on some
+     * other state not tracked by the node.
+     */
+    void invalidateLayout();
+
+    /**
+     * Returns true if this node or any of its descendants needs layout.
+     *
+     * @return true if this node or any of its descendants needs layout.
+     */
+    bool needsLayout() const { return _layoutDirty || _layoutPending; }
+
+    /**
+     * Returns the number of layout manager passes since the last reset.
+     *
+     * Each time {@link #doLayout} applies the layout manager of a node, this
+     * counter is incremented. It is useful for profiling, to verify that a
+     * relayout only touches the parts of the scene graph that changed.
+     *
+     * @return the number of layout manager passes since the last reset.
+     */
+    static Uint64 getLayoutPasses() { return _layoutPasses; }
+
+    /**
+     * Resets the layout pass counter to zero.
+     *
+     * See {@link #getLayoutPasses} for more information.
+     */
+    static void resetLayoutPasses() { _layoutPasses = 0; }
+
 private:
 #pragma mark -
 #pragma mark Internal Helpers
@@ -1990,6 +2405,24 @@ private:
      * transform, and positional translation, in that order.
      */
     void updateTransform();
+
+    /**
+     * Adds the given child to the name index of this node.
+     *
+     * This method does nothing if this node is not indexed.
+     *
+     * @param child The child to index
+     */
+    void indexChild(SceneNode* child);
+
+    /**
+     * Removes the given child from the name index of this node.
+     *
+     * This method does nothing if this node is not indexed.
+     *
+     * @param child The child to remove from the index
+     */
+    void unindexChild(SceneNode* child);
     
     // Copying is only allowed via shared pointer.
     CU_DISALLOW_COPY_AND_ASSIGN(SceneNode);
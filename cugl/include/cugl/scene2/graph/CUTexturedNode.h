@@ -408,7 +408,7 @@ public:
      *
      * @param  flag whether to flip the coordinates horizontally
      */
-    void flipHorizontal(bool flag) { _flipHorizontal = flag; updateTextureCoords(); }
+    void flipHorizontal(bool flag) { _flipHorizontal = flag; updateTextureCoords(); invalidateBounds(); }
     
     /**
      * Returns true if the texture coordinates are flipped horizontally.
@@ -426,7 +426,7 @@ public:
      *
      * @param  flag whether to flip the coordinates vertically
      */
-    void flipVertical(bool flag) { _flipVertical = flag; updateTextureCoords(); }
+    void flipVertical(bool flag) { _flipVertical = flag; updateTextureCoords(); invalidateBounds(); }
     
     /**
      * Returns true if the texture coordinates are flipped vertically.
@@ -598,6 +598,18 @@ public:
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch,
                       const Affine2& transform, Color4 tint) override = 0;
     
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A textured node with a gradient is drawn on the main thread, as a
+     * recording cannot retain gradients.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override {
+        return _gradient == nullptr && SceneNode::isRecordable();
+    }
+    
     /**
      * Refreshes this node to restore the render data.
      */
@@ -220,6 +220,8 @@ protected:
 
     /** The priority ordering of this layout */
     std::vector<std::string> _priority;
+    /** Whether the priority ordering must be sorted again */
+    bool _unsorted;
     
     /** The map of keys to layout information */
     std::unordered_map<std::string,Entry> _entries;
@@ -257,6 +259,9 @@ protected:
      *
      * This method resorts the contents of the priority 
      * queue to match the current layout values.
+     *
+     * The queue is only sorted again if layout information was added
+     * since the last sort.
      */
     void prioritize();
 
@@ -353,7 +358,10 @@ public:
      *
      * @param value Whether the layout orientation is horizontal.
      */
-    void setHorizontal(bool value) { _horizontal = value; }
+    void setHorizontal(bool value) {
+        _horizontal = value;
+        invalidate();
+    }
     
     /**
      * Returns the alignment of this layout.
@@ -371,7 +379,10 @@ public:
      *
      * @param value The alignment of this layout.
      */
-    void setAlignment(Alignment value) { _alignment = value; }
+    void setAlignment(Alignment value) {
+        _alignment = value;
+        invalidate();
+    }
 
     /**
      * Assigns layout information for a given key.
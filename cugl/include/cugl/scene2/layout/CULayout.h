@@ -67,6 +67,17 @@ namespace  cugl {
  * in order to consolidate code.
  */
 class Layout {
+#pragma mark Values
+protected:
+    /**
+     * The scene graph nodes that use this layout manager.
+     *
+     * These are weak references maintained by {@link SceneNode#setLayout}.
+     * They allow a change in the layout information to mark exactly those
+     * nodes that must be laid out again.
+     */
+    std::vector<SceneNode*> _owners;
+
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -255,6 +266,34 @@ public:
      */
     static void reanchor(SceneNode* node, Anchor anchor);
 
+protected:
+    /**
+     * Marks every node using this layout manager as needing layout.
+     *
+     * Layout managers should call this method whenever their layout
+     * information changes. The next call to {@link SceneNode#doLayout}
+     * will then rearrange the owning nodes, and skip every other node
+     * whose layout is still valid.
+     */
+    void invalidate();
+
+private:
+    /**
+     * Registers the given node as a user of this layout manager.
+     *
+     * @param node  The node using this layout manager
+     */
+    void attach(SceneNode* node);
+
+    /**
+     * Unregisters the given node as a user of this layout manager.
+     *
+     * @param node  The node no longer using this layout manager
+     */
+    void detach(SceneNode* node);
+
+    /** Allow scene graph nodes to register themselves */
+    friend class SceneNode;
 };
     }
 }
@@ -623,7 +623,9 @@ public:
      * font, then the text will not display at all.
      *
      * Changing this value will regenerate the render data, and is potentially
-     * expensive, particularly if the font is using a fallback atlas.
+     * expensive, particularly if the font is using a fallback atlas. Setting
+     * the current text again (without resizing) does nothing, so it is safe
+     * to call this method every frame.
      *
      * @param text      The text for this label.
      * @param resize    Whether to resize the label to fit the new text.
@@ -1127,7 +1129,12 @@ public:
      *
      * @param color The foreground color of this label.
      */
-    void setForeground(Color4 color) { _foreground = color; updateColor(); }
+    void setForeground(Color4 color) {
+        if (_foreground != color) {
+            _foreground = color;
+            updateColor();
+        }
+    }
 
     /**
      * Returns the background color of this label.
@@ -1351,6 +1358,16 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) override;
     
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A label is always drawn on the main thread. Its font may add glyphs
+     * to an atlas as the text changes, and that creates OpenGL textures.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override { return false; }
+    
 protected:
     /**
      * Allocates the render data necessary to render this node.
@@ -1359,6 +1376,9 @@ protected:
     
     /**
      * Clears the render data, releasing all vertices and indices.
+     *
+     * The glyph runs are kept (though marked stale) so that the next call to
+     * {@link #generateRenderData} can reuse their meshes.
      */
     void clearRenderData();
     
@@ -1366,7 +1386,8 @@ protected:
      * Updates the color value for any other data that needs it.
      *
      * This method is used to synchronize the background and foreground
-     * colors.
+     * colors. It also discards the static batch of any static ancestor, as
+     * that batch was recorded with the old colors.
      */
     void updateColor();
 
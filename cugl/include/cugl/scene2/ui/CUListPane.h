@@ -0,0 +1,577 @@
+//
+//  CUListPane.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for a virtualized scroll pane. A list pane
+//  is a scroll pane for a (potentially very long) vertical list of rows of
+//  equal height. Instead of keeping a scene graph node for every row, it
+//  only keeps nodes for the rows that are visible (plus a small margin).
+//  As the user scrolls, the nodes that fall out of view are recycled and
+//  rebound to the rows that come into view. Hence the cost of layout and
+//  rendering is proportional to the size of the view, not the size of the
+//  list.
+//
+//  The contents of the rows come from a data source callback. This callback
+//  is given a row index and a recycled node (which may be nullptr), and
+//  returns the node to display for that row.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#ifndef __CU_LIST_PANE_H__
+#define __CU_LIST_PANE_H__
+#include <cugl/scene2/ui/CUScrollPane.h>
+#include <functional>
+#include <vector>
+
+namespace cugl {
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+/**
+ * This class is a scroll pane that virtualizes a vertical list.
+ *
+ * A list pane displays a list of {@link #getItemCount} rows, each of which
+ * is {@link #getItemHeight} tall and as wide as the content bounds. The
+ * first row is at the top of the pane. The interior bounds are managed by
+ * this class and are always large enough to hold every row. You should
+ * not call {@link #setInterior} on a list pane.
+ *
+ * Unlike a normal scroll pane, the rows are not permanent children of this
+ * node. Instead, the list pane only materializes the rows that intersect
+ * the content bounds, together with {@link #getItemMargin} extra rows on
+ * either side. When a row scrolls out of this range, its node is removed
+ * from the scene graph and put in a recycling pool. When a row scrolls
+ * into the range, a node from this pool is bound to it. Hence a list of
+ * thousands of entries only has as many nodes as fit on the screen, and
+ * layout, culling, and rendering only ever touch those nodes.
+ *
+ * The rows are bound by a {@link Binder}, which acts as the data source of
+ * this list. The binder is given the row index and a recycled node, which
+ * is nullptr if the pool is empty. It should update the recycled node to
+ * show the given row and return it, or allocate a new node if there is
+ * nothing to recycle. The list pane positions the node in the row so that
+ * the node anchor sits at the same relative position of the row rectangle.
+ * The binder should not position the node itself.
+ *
+ * Rows are materialized lazily when the pane is rendered. So panning the
+ * pane is no more expensive than for any other scroll pane, no matter how
+ * long the list. A row that stays in view is never rebound unless you call
+ * {@link #reloadItems}.
+ *
+ * You may add other children to a list pane (such as a header), and they
+ * will behave as in a normal scroll pane. However, a list pane should not
+ * have a layout manager, as it would fight with the row placement.
+ */
+class ListPane : public ScrollPane {
+public:
+    /**
+     * @typedef Binder
+     *
+     * This type represents the data source of a list pane.
+     *
+     * A binder is given the index of a row and a recycled node from an
+     * earlier row, which is nullptr if there is no node to recycle. The
+     * binder should return the node to display for the given row. It is
+     * free to return a different node than the one it was given (in which
+     * case the recycled node is returned to the pool). If it returns
+     * nullptr, then the row is left empty.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<std::shared_ptr<SceneNode>(size_t index,
+     *                                               const std::shared_ptr<SceneNode>& view)>
+     *
+     * @param index The index of the row to bind
+     * @param view  The recycled node (or nullptr if there is none)
+     *
+     * @return the node to display for the row
+     */
+    typedef std::function<std::shared_ptr<SceneNode>(size_t index, const std::shared_ptr<SceneNode>& view)> Binder;
+
+#pragma mark Values
+protected:
+    /** The number of rows in this list */
+    size_t _itemCount;
+    /** The height of a single row */
+    float _itemHeight;
+    /** The number of extra rows to materialize on either side of the view */
+    Uint32 _itemMargin;
+    /** The data source for the rows */
+    Binder _binder;
+
+    /** The index of the first materialized row */
+    size_t _first;
+    /** The index one past the last materialized row */
+    size_t _last;
+    /** The nodes of the materialized rows, starting with row _first */
+    std::vector<std::shared_ptr<SceneNode>> _items;
+    /** The pool of nodes available for recycling */
+    std::vector<std::shared_ptr<SceneNode>> _recycled;
+    /** Whether the materialized rows must be rebound */
+    bool _rebind;
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates an uninitialized node.
+     *
+     * You must initialize this Node before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+     * heap, use one of the static constructors instead.
+     */
+    ListPane();
+
+    /**
+     * Deletes this node, disposing all resources
+     */
+    ~ListPane() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this node.
+     *
+     * A disposed Node can be safely reinitialized. Any children owned by this
+     * node will be released.  They will be deleted if no other object owns them.
+     * This includes any nodes in the recycling pool.
+     *
+     * It is unsafe to call this on a Node that is still currently inside of
+     * a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Initializes a node with the given size.
+     *
+     * The size defines the content size. The bounding box of the node is
+     * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+     * The node is positioned at the origin in parent space.
+     *
+     * The list will start out empty, with the default row height. The
+     * pane is masked and constrained.
+     *
+     * @param size  The size of the node in parent space
+     *
+     * @return true if initialization was successful.
+     */
+    virtual bool initWithBounds(const Size size) override;
+
+    /**
+     * Initializes a node with the given bounds.
+     *
+     * The rectangle origin is the bottom left corner of the node in parent
+     * space, and corresponds to the origin of the Node space. The size
+     * defines its content width and height in node space. The node anchor
+     * is placed in the bottom left corner.
+     *
+     * The list will start out empty, with the default row height. The
+     * pane is masked and constrained.
+     *
+     * @param rect  The bounds of the node in parent space
+     *
+     * @return true if initialization was successful.
+     */
+    virtual bool initWithBounds(const Rect rect) override;
+
+    /**
+     * Initializes a node with the given size and list data.
+     *
+     * The size defines the content size. The bounding box of the node is
+     * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+     * The node is positioned at the origin in parent space.
+     *
+     * The list will have the given number of rows, bound by the given
+     * data source. No row is bound until the pane is first rendered.
+     * The pane is constrained, and starts with the first row at the top.
+     *
+     * @param size      The size of the node in parent space
+     * @param height    The height of a single row
+     * @param count     The number of rows
+     * @param binder    The data source for the rows
+     * @param mask      Whether to mask contents outside of node bounds
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithItems(const Size size, float height, size_t count,
+                       Binder binder, bool mask=true);
+
+    /**
+     * Initializes a node with the given bounds and list data.
+     *
+     * The rectangle origin is the bottom left corner of the node in parent
+     * space, and corresponds to the origin of the Node space. The size
+     * defines its content width and height in node space. The node anchor
+     * is placed in the bottom left corner.
+     *
+     * The list will have the given number of rows, bound by the given
+     * data source. No row is bound until the pane is first rendered.
+     * The pane is constrained, and starts with the first row at the top.
+     *
+     * @param bounds    The bounds of the node in parent space
+     * @param height    The height of a single row
+     * @param count     The number of rows
+     * @param binder    The data source for the rows
+     * @param mask      Whether to mask contents outside of node bounds
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithItems(const Rect bounds, float height, size_t count,
+                       Binder binder, bool mask=true);
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated node with the given size.
+     *
+     * The size defines the content size. The bounding box of the node is
+     * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+     * The node is positioned at the origin in parent space.
+     *
+     * The list will start out empty, with the default row height. The
+     * pane is masked and constrained.
+     *
+     * @param size  The size of the node in parent space
+     *
+     * @return a newly allocated node with the given size.
+     */
+    static std::shared_ptr<ListPane> allocWithBounds(const Size size) {
+        std::shared_ptr<ListPane> result = std::make_shared<ListPane>();
+        return (result->initWithBounds(size) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given bounds.
+     *
+     * The rectangle origin is the bottom left corner of the node in parent
+     * space, and corresponds to the origin of the Node space. The size
+     * defines its content width and height in node space. The node anchor
+     * is placed in the bottom left corner.
+     *
+     * The list will start out empty, with the default row height. The
+     * pane is masked and constrained.
+     *
+     * @param rect  The bounds of the node in parent space
+     *
+     * @return a newly allocated node with the given bounds.
+     */
+    static std::shared_ptr<ListPane> allocWithBounds(const Rect rect) {
+        std::shared_ptr<ListPane> result = std::make_shared<ListPane>();
+        return (result->initWithBounds(rect) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given size and list data.
+     *
+     * The size defines the content size. The bounding box of the node is
+     * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+     * The node is positioned at the origin in parent space.
+     *
+     * The list will have the given number of rows, bound by the given
+     * data source. No row is bound until the pane is first rendered.
+     * The pane is constrained, and starts with the first row at the top.
+     *
+     * @param size      The size of the node in parent space
+     * @param height    The height of a single row
+     * @param count     The number of rows
+     * @param binder    The data source for the rows
+     * @param mask      Whether to mask contents outside of node bounds
+     *
+     * @return a newly allocated node with the given size and list data.
+     */
+    static std::shared_ptr<ListPane> allocWithItems(const Size size, float height, size_t count,
+                                                    Binder binder, bool mask=true) {
+        std::shared_ptr<ListPane> result = std::make_shared<ListPane>();
+        return (result->initWithItems(size,height,count,binder,mask) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given bounds and list data.
+     *
+     * The rectangle origin is the bottom left corner of the node in parent
+     * space, and corresponds to the origin of the Node space. The size
+     * defines its content width and height in node space. The node anchor
+     * is placed in the bottom left corner.
+     *
+     * The list will have the given number of rows, bound by the given
+     * data source. No row is bound until the pane is first rendered.
+     * The pane is constrained, and starts with the first row at the top.
+     *
+     * @param bounds    The bounds of the node in parent space
+     * @param height    The height of a single row
+     * @param count     The number of rows
+     * @param binder    The data source for the rows
+     * @param mask      Whether to mask contents outside of node bounds
+     *
+     * @return a newly allocated node with the given bounds and list data.
+     */
+    static std::shared_ptr<ListPane> allocWithItems(const Rect bounds, float height, size_t count,
+                                                    Binder binder, bool mask=true) {
+        std::shared_ptr<ListPane> result = std::make_shared<ListPane>();
+        return (result->initWithItems(bounds,height,count,binder,mask) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Sets the content size of this node.
+     *
+     * The rows of a list pane are as wide as the content bounds, so this
+     * recomputes the interior bounds and rebinds the materialized rows.
+     *
+     * @param size  The untransformed size of the node.
+     */
+    virtual void setContentSize(const Size size) override;
+
+    /**
+     * Sets the content size of this node.
+     *
+     * The rows of a list pane are as wide as the content bounds, so this
+     * recomputes the interior bounds and rebinds the materialized rows.
+     *
+     * @param width     The untransformed width of the node.
+     * @param height    The untransformed height of the node.
+     */
+    virtual void setContentSize(float width, float height) override {
+        setContentSize(Size(width, height));
+    }
+
+    /**
+     * Returns the number of rows in this list.
+     *
+     * @return the number of rows in this list.
+     */
+    size_t getItemCount() const { return _itemCount; }
+
+    /**
+     * Sets the number of rows in this list.
+     *
+     * The interior grows or shrinks at the bottom, so the rows currently
+     * in view stay where they are (unless the list shrinks so much that
+     * they no longer exist). Rows that are already materialized are not
+     * rebound. If the underlying data has changed, you should also call
+     * {@link #reloadItems}.
+     *
+     * @param count The number of rows in this list.
+     */
+    void setItemCount(size_t count);
+
+    /**
+     * Returns the height of a single row.
+     *
+     * @return the height of a single row.
+     */
+    float getItemHeight() const { return _itemHeight; }
+
+    /**
+     * Sets the height of a single row.
+     *
+     * Changing the row height rebinds all of the materialized rows.
+     *
+     * @param height    The height of a single row.
+     */
+    void setItemHeight(float height);
+
+    /**
+     * Returns the number of extra rows materialized on either side of the view.
+     *
+     * A margin allows the binder to prepare rows shortly before they scroll
+     * into view, so that small pans do not rebind anything.
+     *
+     * @return the number of extra rows materialized on either side of the view.
+     */
+    Uint32 getItemMargin() const { return _itemMargin; }
+
+    /**
+     * Sets the number of extra rows materialized on either side of the view.
+     *
+     * A margin allows the binder to prepare rows shortly before they scroll
+     * into view, so that small pans do not rebind anything.
+     *
+     * @param margin    The number of extra rows materialized on either side of the view.
+     */
+    void setItemMargin(Uint32 margin) { _itemMargin = margin; }
+
+    /**
+     * Returns the data source for the rows of this list.
+     *
+     * @return the data source for the rows of this list.
+     */
+    const Binder& getBinder() const { return _binder; }
+
+    /**
+     * Sets the data source for the rows of this list.
+     *
+     * Changing the data source rebinds all of the materialized rows.
+     *
+     * @param binder    The data source for the rows of this list.
+     */
+    void setBinder(Binder binder);
+
+    /**
+     * Returns the node currently bound to the given row.
+     *
+     * This method returns nullptr if the row is not materialized, or if
+     * the binder left the row empty.
+     *
+     * @param index The row index
+     *
+     * @return the node currently bound to the given row.
+     */
+    std::shared_ptr<SceneNode> getItem(size_t index) const;
+
+    /**
+     * Returns the rectangle of the given row in the interior coordinates.
+     *
+     * This is the coordinate space of the children of this pane. The
+     * row need not be materialized.
+     *
+     * @param index The row index
+     *
+     * @return the rectangle of the given row in the interior coordinates.
+     */
+    Rect getItemBounds(size_t index) const;
+
+    /**
+     * Marks all materialized rows to be rebound.
+     *
+     * You should call this method whenever the underlying data changes.
+     * The rows are rebound the next time the pane is rendered.
+     */
+    void reloadItems() { _rebind = true; }
+
+#pragma mark -
+#pragma mark Navigation
+    /**
+     * Scrolls the pane so that the given row is at the top of the view.
+     *
+     * This method resets the pane (removing any spin or zoom) and then
+     * pans the interior. If the pane is constrained, the pan stops at
+     * the bottom of the list, so the last rows may never reach the top.
+     *
+     * @param index The row index
+     */
+    void scrollToItem(size_t index);
+
+#pragma mark -
+#pragma mark Rendering
+    /**
+     * Draws this Node and all of its children with the given SpriteBatch.
+     *
+     * This method materializes the visible rows before drawing the pane.
+     * Rows are only ever bound on the main thread, as a command recorder
+     * defers this pane before it binds anything (see {@link #isRecordable}).
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    virtual void render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) override;
+
+    /**
+     * Draws this Node and all of its children with the given SpriteBatch.
+     *
+     * This method materializes the visible rows before drawing the pane.
+     * Rows are only ever bound on the main thread, as a command recorder
+     * defers this pane before it binds anything (see {@link #isRecordable}).
+     *
+     * @param batch     The SpriteBatch to draw with.
+     */
+    virtual void render(const std::shared_ptr<SpriteBatch>& batch) override {
+        render(batch,Affine2::IDENTITY,Color4::WHITE);
+    }
+    
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * Binding a row calls user code, which may touch nodes or models that
+     * are not safe to use from a recording thread. So a pane with a binder
+     * is drawn on the main thread.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override {
+        return _binder == nullptr && ScrollPane::isRecordable();
+    }
+
+    /**
+     * Materializes the rows that intersect the view.
+     *
+     * This method is called automatically when the pane is rendered. You
+     * only need to call it if you want to access the nodes of the visible
+     * rows (via {@link #getItem}) before the next render.
+     *
+     * Rows that leave the view (plus margin) are recycled, and rows that
+     * enter it are bound from the recycling pool. Rows that stay in view
+     * are left alone unless {@link #reloadItems} was called.
+     */
+    void updateItems();
+
+private:
+    /**
+     * Resizes the interior to hold all of the rows.
+     *
+     * The top of the interior is always aligned with the top of the content
+     * bounds, so the interior only grows or shrinks at the bottom. If the
+     * current view no longer fits in a constrained interior, the pane is
+     * reset.
+     */
+    void resizeInterior();
+
+    /**
+     * Returns a node bound to the given row.
+     *
+     * The node is taken from the recycling pool if possible. It is placed
+     * in the row and added to this pane.
+     *
+     * @param index The row index
+     *
+     * @return a node bound to the given row.
+     */
+    std::shared_ptr<SceneNode> bindItem(size_t index);
+
+    /**
+     * Removes the given node from this pane and adds it to the recycling pool.
+     *
+     * @param view  The node to recycle
+     */
+    void recycleItem(const std::shared_ptr<SceneNode>& view);
+};
+    }
+}
+#endif /* __CU_LIST_PANE_H__ */
@@ -896,6 +896,42 @@ public:
     virtual void render(const std::shared_ptr<SpriteBatch>& batch) override {
         render(batch,Affine2::IDENTITY,Color4::WHITE);
     }
+    
+    /**
+     * Returns true if this node may be drawn by a command recorder.
+     *
+     * A masked scroll pane pushes a scissor for its children, which a
+     * recording cannot retain. So it is drawn on the main thread.
+     *
+     * @return true if this node may be drawn by a command recorder.
+     */
+    virtual bool isRecordable() const override {
+        return _panemask == nullptr && SceneNode::isRecordable();
+    }
+
+protected:
+    /**
+     * Returns the matrix transforming the space of the children to world space.
+     *
+     * The children of a scroll pane are drawn with the pane transform, so
+     * this is the pane transform followed by the node to world transform.
+     *
+     * @return the matrix transforming the space of the children to world space.
+     */
+    virtual Affine2 getChildToWorldTransform() const override {
+        return _panetrans*getNodeToWorldTransform();
+    }
+
+    /**
+     * Returns the bounds of this node and all of its descendants.
+     *
+     * The children of a scroll pane are drawn with the pane transform. If
+     * the pane is masked, nothing is drawn outside of the content bounds, so
+     * those are the subtree bounds.
+     *
+     * @return the bounds of this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds() override;
 };
     }
 }
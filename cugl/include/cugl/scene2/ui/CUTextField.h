@@ -778,7 +778,7 @@ public:
      *
      * @param color     The cursor color
      */
-    void setCursorColor(const Color4 color) { _cursorColor = color; }
+    void setCursorColor(const Color4 color) { _cursorColor = color; invalidateBounds(); }
     
     
 #pragma mark -
@@ -0,0 +1,298 @@
+//
+//  CUArena.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a memory arena and an allocator template for it. An
+//  arena is a region allocator. It carves objects out of large blocks, and
+//  never frees individual objects. Instead, all of the blocks are released
+//  at once when the arena is deleted. This is ideal for large object graphs
+//  that are created together and discarded together, such as the scene
+//  graph of a level. It replaces thousands of small heap allocations with a
+//  handful of large ones, and it keeps objects created together close
+//  together in memory.
+//
+//  The allocator template allows an arena to be used with the standard
+//  library. In particular, it can be used with std::allocate_shared to put
+//  both an object and its reference count in the arena. Each such allocator
+//  holds a reference to the arena, so the arena lives until the last object
+//  allocated from it is deleted.
+//
+//  Because of the allocator template, all of the code is in this header.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#ifndef __CU_ARENA_H__
+#define __CU_ARENA_H__
+#include "CUDebug.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <new>
+
+/** The default size of an arena block */
+#define ARENA_BLOCK 65536
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark Arena
+/**
+ * This class is a region (or arena) allocator.
+ *
+ * An arena hands out memory from large blocks. Allocation is a pointer bump,
+ * and deallocation does nothing. All of the memory is returned to the heap
+ * in one shot when the arena is disposed (or deleted). Hence an arena should
+ * only be used for objects that share a lifetime, like the nodes of a scene
+ * graph loaded from a single file. Memory for objects that die early is not
+ * reclaimed until the arena itself goes away.
+ *
+ * The arena never calls any destructors. The owner of an object must still
+ * destroy it. The easiest way to do this is to use {@link ArenaAllocator}
+ * with std::allocate_shared, which destroys the object as normal, but leaves
+ * the memory in the arena.
+ *
+ * An arena is not thread safe. Each thread should allocate from its own
+ * arena. However, objects in the arena may be deleted on any thread.
+ */
+class Arena {
+private:
+    /** The size of a standard block */
+    size_t _blocksize;
+    /** The blocks allocated so far (the last one is the active block) */
+    std::vector<void*> _blocks;
+    /** The size of the active block */
+    size_t _limit;
+    /** The offset of the next free byte in the active block */
+    size_t _offset;
+    /** The number of bytes handed out so far */
+    size_t _used;
+    /** The number of bytes in all blocks */
+    size_t _capacity;
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized arena.
+     *
+     * You must initialize this arena before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an arena on
+     * the heap, use one of the static constructors instead.
+     */
+    Arena() : _blocksize(0), _limit(0), _offset(0), _used(0), _capacity(0) {}
+
+    /**
+     * Deletes this arena, releasing all of its memory.
+     */
+    ~Arena() { dispose(); }
+
+    /**
+     * Releases all of the memory of this arena.
+     *
+     * Any object still in the arena is invalid after this call. A disposed
+     * arena can be safely reinitialized.
+     */
+    void dispose() {
+        for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+            ::operator delete(*it);
+        }
+        _blocks.clear();
+        _blocksize = 0;
+        _limit  = 0;
+        _offset = 0;
+        _used = 0;
+        _capacity = 0;
+    }
+
+    /**
+     * Initializes an arena with the given block size.
+     *
+     * No memory is allocated until the first call to {@link #allocate}.
+     * Requests larger than the block size get a block of their own.
+     *
+     * @param blocksize The size of a standard block in bytes
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t blocksize=ARENA_BLOCK) {
+        CUAssertLog(blocksize > 0, "The block size must be positive");
+        _blocksize = blocksize;
+        return true;
+    }
+
+    /**
+     * Returns a newly allocated arena with the given block size.
+     *
+     * No memory is allocated until the first call to {@link #allocate}.
+     * Requests larger than the block size get a block of their own.
+     *
+     * @param blocksize The size of a standard block in bytes
+     *
+     * @return a newly allocated arena with the given block size.
+     */
+    static std::shared_ptr<Arena> alloc(size_t blocksize=ARENA_BLOCK) {
+        std::shared_ptr<Arena> result = std::make_shared<Arena>();
+        return (result->init(blocksize) ? result : nullptr);
+    }
+
+#pragma mark Allocation
+    /**
+     * Returns a pointer to size bytes with the given alignment.
+     *
+     * The memory is uninitialized. It remains valid until this arena is
+     * disposed. The alignment must be a power of two, and no larger than
+     * that of std::max_align_t.
+     *
+     * @param size  The number of bytes to allocate
+     * @param align The alignment of the memory
+     *
+     * @return a pointer to size bytes with the given alignment.
+     */
+    void* allocate(size_t size, size_t align=alignof(std::max_align_t)) {
+        CUAssertLog(align <= alignof(std::max_align_t), "Alignment %zu is not supported", align);
+        size_t start = (_offset+align-1) & ~(align-1);
+        if (_blocks.empty() || start+size > _limit) {
+            _limit = (size > _blocksize ? size : _blocksize);
+            _blocks.push_back(::operator new(_limit));
+            _capacity += _limit;
+            start = 0;
+        }
+        _offset = start+size;
+        _used += size;
+        return static_cast<char*>(_blocks.back())+start;
+    }
+
+    /**
+     * Returns the number of bytes handed out by this arena.
+     *
+     * @return the number of bytes handed out by this arena.
+     */
+    size_t getUsed() const { return _used; }
+
+    /**
+     * Returns the number of bytes this arena has taken from the heap.
+     *
+     * @return the number of bytes this arena has taken from the heap.
+     */
+    size_t getCapacity() const { return _capacity; }
+
+    /**
+     * Returns the number of blocks this arena has taken from the heap.
+     *
+     * @return the number of blocks this arena has taken from the heap.
+     */
+    size_t getBlocks() const { return _blocks.size(); }
+};
+
+#pragma mark -
+#pragma mark ArenaAllocator Template
+/**
+ * Template for a standard library allocator backed by an {@link Arena}.
+ *
+ * This allocator allows the standard library containers and smart pointers
+ * to use an arena. In particular, std::allocate_shared will place both the
+ * object and its reference count in the arena. Deallocation is a no-op.
+ *
+ * Every allocator (and hence every shared pointer allocated with it) holds
+ * a reference to the arena. So the arena is released, all at once, when
+ * the last object allocated from it is deleted.
+ */
+template <class T>
+class ArenaAllocator {
+private:
+    /** The arena for this allocator */
+    std::shared_ptr<Arena> _arena;
+
+public:
+    /** The type allocated by this allocator */
+    typedef T value_type;
+
+    /**
+     * Creates an allocator for the given arena.
+     *
+     * @param arena The arena to allocate from
+     */
+    ArenaAllocator(const std::shared_ptr<Arena>& arena) : _arena(arena) {}
+
+    /**
+     * Creates a copy of an allocator for another type.
+     *
+     * @param other The allocator to copy
+     */
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.getArena()) {}
+
+    /**
+     * Returns the arena for this allocator.
+     *
+     * @return the arena for this allocator.
+     */
+    const std::shared_ptr<Arena>& getArena() const { return _arena; }
+
+    /**
+     * Returns uninitialized memory for n objects of type T.
+     *
+     * @param n The number of objects
+     *
+     * @return uninitialized memory for n objects of type T.
+     */
+    T* allocate(size_t n) {
+        return static_cast<T*>(_arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Deallocates the given memory.
+     *
+     * This method does nothing. The memory is released with the arena.
+     *
+     * @param p The memory to release
+     * @param n The number of objects
+     */
+    void deallocate(T* p, size_t n) {}
+
+    /**
+     * Returns true if the two allocators share an arena.
+     *
+     * @param other The allocator to compare
+     *
+     * @return true if the two allocators share an arena.
+     */
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return _arena == other.getArena();
+    }
+
+    /**
+     * Returns true if the two allocators do not share an arena.
+     *
+     * @param other The allocator to compare
+     *
+     * @return true if the two allocators do not share an arena.
+     */
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return _arena != other.getArena();
+    }
+};
+
+}
+#endif /* __CU_ARENA_H__ */
@@ -191,6 +191,16 @@ public:
      * @param  task     the task function to add to the thread pool
      */
     void addTask(const std::function<void()> &task);
+
+    /**
+     * Returns the number of worker threads in this thread pool.
+     *
+     * This is the number of tasks that may execute simultaneously. It is
+     * useful for splitting a job into just enough tasks to occupy the pool.
+     *
+     * @return the number of worker threads in this thread pool.
+     */
+    int getThreads() const { return (int)_workers.size(); }
     
     /**
      * Stop the thread pool, marking it for shut down.
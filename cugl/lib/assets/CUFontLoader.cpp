@@ -55,6 +55,8 @@ using namespace cugl;
 #define UNKNOWN_CHARS   ""
 /** The default character set (ASCII) */
 #define UNKNOWN_SIZE    12
+/** The point size of the distance field atlases shared across font sizes */
+#define DISTANCE_FONT_SIZE  48
 
 #pragma mark -
 #pragma mark Constructor
@@ -117,6 +119,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::string source, const std::s
  *      "size":         This font size (int)
  *      "charset":      The set of characters for the font atlas (string)
  *      "padding":      The atlas padding (to prevent blur bleedthrough)
+ *      "distance":     The distance field spread in pixels (0 for a bitmap atlas)
+ *      "lazy":         Whether to add glyphs to the atlas on first use (no prebuilt atlas)
  *      "hinting":      The rendering hints ("normal", "light", "mono", "none")
  *      "bold":         Whether to make the font an (ad hoc) bold
  *      "italic":       Whether to make the font an (ad hoc) italic
@@ -125,6 +129,11 @@ std::shared_ptr<Font> FontLoader::preload(const std::string source, const std::s
  *      "stretch":      The font stretch limit
  *      "shrink":       The font shrink limit
  *
+ * Distance field fonts do not get an atlas of their own. Instead, all
+ * entries with the same file, style, hinting, spread and character set
+ * share the atlases of a single font at a fixed base size, scaled to
+ * their own size. See {@link Font#setAtlasSource}.
+ *
  * @param json      The directory entry for the asset
  *
  * @return the font asset with no generated atlas
@@ -150,6 +159,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::shared_ptr<JsonValue>& json
     }
     
     Uint32 padding = json->getInt("padding",0);
+    Uint32 spread  = json->getInt("distance",0);
+    bool lazy = json->getBool("lazy",false);
     Uint32 stretch = json->getInt("stretch",0);
     Uint32 shrink  = json->getInt("shrink", 0);
 
@@ -160,10 +171,43 @@ std::shared_ptr<Font> FontLoader::preload(const std::shared_ptr<JsonValue>& json
     
     result->setStyle(style);
     result->setHinting(hinting);
-    result->setPadding(padding);
     result->setStretchLimit(stretch);
     result->setShrinkLimit(shrink);
-    if (charset.empty()) {
+    if (spread > 0 && !lazy) {
+        std::string key = source+"|"+std::to_string((int)style)+"|"+std::to_string((int)hinting);
+        key += "|"+std::to_string(spread)+"|"+std::to_string(padding)+"|"+charset;
+
+        // Build the shared atlas once, holding the lock so no one sees it half built
+        std::lock_guard<std::mutex> lock(_distanceMutex);
+        auto it = _distanceFonts.find(key);
+        std::shared_ptr<Font> base = nullptr;
+        if (it != _distanceFonts.end()) {
+            base = it->second;
+        } else {
+            base = Font::alloc(source.c_str(),DISTANCE_FONT_SIZE);
+            if (base == nullptr) {
+                return base;
+            }
+            base->setStyle(style);
+            base->setHinting(hinting);
+            base->setPadding(padding);
+            base->setDistanceSpread(spread);
+            if (charset.empty()) {
+                base->buildAtlasesAsync();
+            } else {
+                base->buildAtlasesAsync(charset);
+            }
+            _distanceFonts.emplace(key,base);
+        }
+        return result->setAtlasSource(base) ? result : nullptr;
+    }
+
+    result->setPadding(padding);
+    result->setDistanceSpread(spread);
+    result->setLazyAtlas(lazy);
+    if (lazy) {
+        return result;
+    } else if (charset.empty()) {
         result->buildAtlasesAsync();
     } else {
         result->buildAtlasesAsync(charset);
@@ -271,6 +315,8 @@ bool FontLoader::read(const std::string key, const std::string source, int size,
  *      "size":         This font size (int)
  *      "charset":      The set of characters for the font atlas (string)
  *      "padding":      The atlas padding (to prevent blur bleedthrough)
+ *      "distance":     The distance field spread in pixels (0 for a bitmap atlas)
+ *      "lazy":         Whether to add glyphs to the atlas on first use (no prebuilt atlas)
  *      "hinting":        The rendering hints ("normal", "light", "mono", "none")
  *      "bold":          Whether to make the font an (ad hoc) bold
  *      "italic":          Whether to make the font an (ad hoc) italic
@@ -45,7 +45,9 @@
 //
 #include <cugl/assets/CUTextureLoader.h>
 #include <cugl/base/CUApplication.h>
+#include <cugl/render/CUAtlasPacker.h>
 #include <SDL/SDL_image.h>
+#include <algorithm>
 
 using namespace cugl;
 
@@ -58,6 +60,10 @@ using namespace cugl;
 #define UNKNOWN_MAGFLT  "linear"
 /** The default wrap rule */
 #define UNKNOWN_WRAP    "clamp"
+/** The default page size of a texture pack */
+#define UNKNOWN_PAGE    2048
+/** The default padding of a texture pack */
+#define UNKNOWN_PADDING 1
 
 /**
  * Returns the OpenGL enum for the given min filter name
@@ -124,6 +130,34 @@ GLuint decodeWrap(const std::string& name) {
     return GL_CLAMP_TO_EDGE;
 }
 
+/**
+ * Copies an image into a page, extruding its border into the padding
+ *
+ * The image is copied so that its top left corner is at (x+pad,y+pad). The
+ * pixels in the padding repeat the nearest border pixel of the image. Both
+ * surfaces must have the same 32-bit pixel format.
+ *
+ * @param src   The image to copy
+ * @param dst   The page to copy into
+ * @param x     The left edge of the padded image
+ * @param y     The top edge of the padded image
+ * @param pad   The padding in pixels
+ */
+static void extrude_blit(SDL_Surface* src, SDL_Surface* dst, int x, int y, int pad) {
+    int bpp = src->format->BytesPerPixel;
+    size_t span = (size_t)src->w*bpp;
+    for(int row = -pad; row < src->h+pad; row++) {
+        int line = std::min(std::max(row,0),src->h-1);
+        const Uint8* spix = (const Uint8*)src->pixels+line*src->pitch;
+        Uint8* dpix = (Uint8*)dst->pixels+(y+pad+row)*dst->pitch+(x+pad)*bpp;
+        std::memcpy(dpix,spix,span);
+        for(int col = 1; col <= pad; col++) {
+            std::memcpy(dpix-col*bpp,spix,bpp);
+            std::memcpy(dpix+span+(col-1)*bpp,spix+span-bpp,bpp);
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark Constructor
 
@@ -282,6 +316,194 @@ void TextureLoader::materialize(const std::shared_ptr<JsonValue>& json, SDL_Surf
     _queue.erase(key);
 }
 
+/**
+ * Loads and packs the images of a texture pack outside the main thread.
+ *
+ * A texture pack directory entry has a "pack" object in place of a file.
+ * Each member of this object is either the path to an image, or a
+ * directory entry with a "file" and an optional "atlas". In addition,
+ * the pack entry has the following values
+ *
+ *      "size":         The maximum width and height of a page (int)
+ *      "padding":      The pixels to pad around each image (int)
+ *
+ * The images are packed from tallest to shortest using an {@link AtlasPacker}.
+ * Any image that is too big for a page is given a page of its own. The
+ * border pixels of each image are extruded into its padding, so that
+ * filtering never samples a neighboring image.
+ *
+ * Images that fail to load are logged and skipped. If a page cannot be
+ * allocated, the error is logged and no pages are returned, so that the
+ * pack fails to load.
+ *
+ * @param json      The asset directory entry
+ *
+ * @return the packed pages of this texture pack
+ */
+std::vector<TextureLoader::PackedPage> TextureLoader::preloadPack(const std::shared_ptr<JsonValue>& json) {
+    std::vector<PackedPage> result;
+    JsonValue* pack = json->get("pack").get();
+    int size = json->getInt("size",UNKNOWN_PAGE);
+    int padding = std::max(json->getInt("padding",UNKNOWN_PADDING),0);
+    
+    // Load the images
+    std::vector<std::string> keys;
+    std::vector<SDL_Surface*> images;
+    for(int ii = 0; ii < pack->size(); ii++) {
+        JsonValue* item = pack->get(ii).get();
+        std::string source = (item->isString() ? item->asString() : item->getString("file",UNKNOWN_SOURCE));
+        SDL_Surface* surface = preload(source);
+        if (surface == nullptr) {
+            CULogError("Texture pack '%s' could not load '%s'",json->key().c_str(),source.c_str());
+        } else {
+            keys.push_back(item->key());
+            images.push_back(surface);
+        }
+    }
+    if (images.empty()) {
+        return result;
+    }
+    
+    // Skyline packing works best from tallest to shortest
+    std::vector<size_t> order(images.size());
+    for(size_t ii = 0; ii < order.size(); ii++) {
+        order[ii] = ii;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return images[a]->h > images[b]->h;
+    });
+    
+    std::vector<std::shared_ptr<AtlasPacker>> packers;
+    std::vector<std::vector<size_t>> members;
+    Rect bounds;
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        int w = images[*it]->w+2*padding;
+        int h = images[*it]->h+2*padding;
+        size_t page = 0;
+        while (page < packers.size() && !packers[page]->pack(w,h,&bounds)) {
+            page++;
+        }
+        if (page == packers.size()) {
+            packers.push_back(AtlasPacker::alloc(std::max(w,size),std::max(h,size)));
+            packers.back()->pack(w,h,&bounds);
+            members.push_back(std::vector<size_t>());
+            result.push_back(PackedPage());
+        }
+        
+        // Store the bounds without the padding
+        bounds.origin.x += padding;
+        bounds.origin.y += padding;
+        bounds.size.width  -= 2*padding;
+        bounds.size.height -= 2*padding;
+        members[page].push_back(*it);
+        result[page].keys.push_back(keys[*it]);
+        result[page].bounds.push_back(bounds);
+    }
+    
+    // Assemble the pages, cropped to the packed area
+    Uint32 format = images[0]->format->format;
+    for(size_t ii = 0; ii < result.size(); ii++) {
+        PackedPage& page = result[ii];
+        page.surface = SDL_CreateRGBSurfaceWithFormat(0,packers[ii]->getUsedWidth(),
+                                                      packers[ii]->getUsedHeight(),32,format);
+        if (page.surface == nullptr) {
+            CULogError("Texture pack '%s' could not allocate a %dx%d page: %s",json->key().c_str(),
+                       packers[ii]->getUsedWidth(),packers[ii]->getUsedHeight(),SDL_GetError());
+            for(size_t jj = 0; jj < ii; jj++) {
+                SDL_FreeSurface(result[jj].surface);
+            }
+            result.clear();
+            break;
+        }
+        for(size_t jj = 0; jj < members[ii].size(); jj++) {
+            const Rect& rect = page.bounds[jj];
+            extrude_blit(images[members[ii][jj]], page.surface,
+                         (int)rect.origin.x-padding, (int)rect.origin.y-padding, padding);
+        }
+    }
+    
+    for(auto it = images.begin(); it != images.end(); ++it) {
+        SDL_FreeSurface(*it);
+    }
+    return result;
+}
+
+/**
+ * Creates the OpenGL textures for a texture pack according to the directory entry.
+ *
+ * This method finishes the asset loading started in {@link preloadPack}.
+ * This step is not safe to be done in a separate thread.  Instead, it
+ * takes place in the main CUGL thread via {@link Application#schedule}.
+ *
+ * The first page is assigned the key of the JSON directory entry. Any
+ * later pages have the same key with the suffix _1, _2, and so on. Each
+ * image in the pack is assigned a subtexture of its page, using the key
+ * of its member in the "pack" object. Every page shares the filter, wrap,
+ * and mipmap settings of the directory entry.
+ *
+ * This method supports an optional callback function which reports whether
+ * the asset was successfully materialized.
+ *
+ * @param json      The asset directory entry
+ * @param pages     The pages created by {@link preloadPack}
+ * @param callback  An optional callback for asynchronous loading
+ */
+void TextureLoader::materializePack(const std::shared_ptr<JsonValue>& json, const std::vector<PackedPage>& pages,
+                                    LoaderCallback callback) {
+    std::string key = json->key();
+    JsonValue* pack = json->get("pack").get();
+    GLuint minflt = decodeMinFilter(json->getString("minfilter",UNKNOWN_MINFLT));
+    GLuint magflt = decodeMagFilter(json->getString("magfilter",UNKNOWN_MAGFLT));
+    GLuint wrapS = decodeWrap(json->getString("wrapS",UNKNOWN_WRAP));
+    GLuint wrapT = decodeWrap(json->getString("wrapT",UNKNOWN_WRAP));
+    bool mipmaps = json->getBool("mipmaps",false);
+    
+    bool success = !pages.empty();
+    size_t count = 0;
+    for(size_t ii = 0; ii < pages.size(); ii++) {
+        const PackedPage& page = pages[ii];
+        std::shared_ptr<Texture> texture = nullptr;
+        if (page.surface != nullptr) {
+            texture = Texture::allocWithData(page.surface->pixels, page.surface->w, page.surface->h);
+            SDL_FreeSurface(page.surface);
+        }
+        if (texture == nullptr) {
+            success = false;
+            continue;
+        }
+        
+        texture->bind();
+        if (mipmaps) { texture->buildMipMaps(); }
+        texture->setMinFilter(minflt);
+        texture->setMagFilter(magflt);
+        texture->setWrapS(wrapS);
+        texture->setWrapT(wrapT);
+        texture->unbind();
+        _assets[ii == 0 ? key : key+"_"+std::to_string(ii)] = texture;
+        
+        float w = (float)texture->getWidth();
+        float h = (float)texture->getHeight();
+        for(size_t jj = 0; jj < page.keys.size(); jj++) {
+            const Rect& rect = page.bounds[jj];
+            std::shared_ptr<Texture> image = texture->getSubTexture(rect.getMinX()/w, rect.getMaxX()/w,
+                                                                    rect.getMinY()/h, rect.getMaxY()/h);
+            _assets[page.keys[jj]] = image;
+            
+            std::shared_ptr<JsonValue> item = pack->get(page.keys[jj]);
+            if (item->isObject()) {
+                parseAtlas(item,image);
+            }
+            count++;
+        }
+    }
+    success = success && count == pack->size();
+    
+    if (callback != nullptr) {
+        callback(key,success);
+    }
+    _queue.erase(key);
+}
+
 /**
  * Internal method to support asset loading.
  *
@@ -361,6 +583,9 @@ bool TextureLoader::read(const std::string key, const std::string source, Loader
  *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
  *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
  *
+ * If the entry has a "pack" object instead of a "file", it is loaded as a
+ * texture pack. See {@link preloadPack} for the format.
+ *
  * @param json      The directory entry for the asset
  * @param callback  An optional callback for asynchronous loading
  * @param async     Whether the asset was loaded asynchronously
@@ -374,6 +599,23 @@ bool TextureLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback
     }
     _queue.emplace(key);
     
+    if (json->has("pack")) {
+        bool success = false;
+        if (_loader == nullptr || !async) {
+            materializePack(json,preloadPack(json),nullptr);
+            success = (_assets.find(key) != _assets.end());
+        } else {
+            _loader->addTask([=](void) {
+                std::vector<PackedPage> pages = this->preloadPack(json);
+                Application::get()->schedule([=](void){
+                    this->materializePack(json,pages,callback);
+                    return false;
+                });
+            });
+        }
+        return success;
+    }
+    
     std::string source = json->getString("file",UNKNOWN_SOURCE);
     bool success = false;
     if (_loader == nullptr || !async) {
@@ -439,17 +681,22 @@ bool TextureLoader::purge(const std::shared_ptr<JsonValue>& json) {
     }
     _assets.erase(it);
     
-    JsonValue* child = json->get("atlas").get();
-    bool success = true;
-    if (child) {
-        for(int ii = 0; ii < child->size(); ii++) {
-            JsonValue* item = child->get(ii).get();
-            std::string name = key+"_"+item->key();
-            auto jt = _assets.find(name);
+    bool success = purgeAtlas(json);
+    JsonValue* pack = json->get("pack").get();
+    if (pack) {
+        for(int ii = 1; (it = _assets.find(key+"_"+std::to_string(ii))) != _assets.end(); ii++) {
+            _assets.erase(it);
+        }
+        for(int ii = 0; ii < pack->size(); ii++) {
+            std::shared_ptr<JsonValue> item = pack->get(ii);
+            auto jt = _assets.find(item->key());
             success = (jt != _assets.end()) && success;
             if (jt != _assets.end()) {
                 _assets.erase(jt);
             }
+            if (item->isObject()) {
+                success = purgeAtlas(item) && success;
+            }
         }
     }
     
@@ -466,6 +713,9 @@ bool TextureLoader::purge(const std::shared_ptr<JsonValue>& json) {
  * the subtexture, respectively.  Each subtexture will have the key of the
  * main texture as the prefix (together with an underscore _) of its key.
  *
+ * The pixels are relative to the given texture, which may itself be a
+ * subtexture (e.g. an image in a texture pack).
+ *
  * @param json      The asset directory entry
  * @param texture   The texture loaded for this asset
  */
@@ -474,14 +724,45 @@ void TextureLoader::parseAtlas(const std::shared_ptr<JsonValue>& json, const std
     JsonValue* child = json->get("atlas").get();
     Size size = texture->getSize();
     if (child) {
+        // Subtexture coordinates are relative to the root texture
+        float ds = (texture->getMaxS()-texture->getMinS())/size.width;
+        float dt = (texture->getMaxT()-texture->getMinT())/size.height;
         for(int ii = 0; ii < child->size(); ii++) {
             JsonValue* item = child->get(ii).get();
             std::string name = key+"_"+item->key();
             std::vector<int> values = item->asIntArray();
             CUAssertLog(values.size() == 4, "Atlas dimensions are incorrect: %d",(Uint32)values.size());
-            _assets[name] = texture->getSubTexture(values[0]/size.width, values[2]/size.width,
-                                                   values[1]/size.height,values[3]/size.height);
+            _assets[name] = texture->getSubTexture(texture->getMinS()+values[0]*ds, texture->getMinS()+values[2]*ds,
+                                                   texture->getMinT()+values[1]*dt, texture->getMinT()+values[3]*dt);
         }
     }
 }
 
+/**
+ * Removes any subtextures specified in an atlas
+ *
+ * This method is the inverse of {@link parseAtlas}. It returns false if any
+ * of the subtextures in the atlas were missing.
+ *
+ * @param json      The asset directory entry
+ *
+ * @return true if all of the subtextures were removed
+ */
+bool TextureLoader::purgeAtlas(const std::shared_ptr<JsonValue>& json) {
+    std::string key = json->key();
+    JsonValue* child = json->get("atlas").get();
+    bool success = true;
+    if (child) {
+        for(int ii = 0; ii < child->size(); ii++) {
+            JsonValue* item = child->get(ii).get();
+            std::string name = key+"_"+item->key();
+            auto jt = _assets.find(name);
+            success = (jt != _assets.end()) && success;
+            if (jt != _assets.end()) {
+                _assets.erase(jt);
+            }
+        }
+    }
+    return success;
+}
+
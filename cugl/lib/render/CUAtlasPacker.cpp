@@ -0,0 +1,195 @@
+//
+//  CUAtlasPacker.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a class for packing rectangles into a texture atlas
+//  page. It uses the skyline bottom-left heuristic, which is fast enough to
+//  run at load time and wastes little space on sprite-sized images. The
+//  class is purely geometric; it does not touch any pixels. That is up to
+//  the caller (e.g. the TextureLoader).
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#include <cugl/render/CUAtlasPacker.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+
+using namespace cugl;
+
+#pragma mark Constructors
+/**
+ * Deletes the packer and resets all attributes.
+ *
+ * You must reinitialize the packer to use it.
+ */
+void AtlasPacker::dispose() {
+    _skyline.clear();
+    _width = 0;
+    _height = 0;
+    _usedWidth = 0;
+    _usedHeight = 0;
+    _usedArea = 0;
+}
+
+/**
+ * Initializes an empty packer for a page of the given size.
+ *
+ * @param width     The page width in pixels
+ * @param height    The page height in pixels
+ *
+ * @return true if initialization was successful.
+ */
+bool AtlasPacker::init(int width, int height) {
+    if (_width > 0) {
+        CUAssertLog(false, "Packer is already initialized");
+        return false; // If asserts are turned off.
+    } else if (width <= 0 || height <= 0) {
+        CUAssertLog(false, "Page size %dx%d is invalid", width, height);
+        return false; // If asserts are turned off.
+    }
+    _width = width;
+    _height = height;
+    reset();
+    return true;
+}
+
+#pragma mark -
+#pragma mark Packing
+/**
+ * Removes all rectangles from the page.
+ */
+void AtlasPacker::reset() {
+    _skyline.clear();
+    _skyline.push_back({0, 0, _width});
+    _usedWidth = 0;
+    _usedHeight = 0;
+    _usedArea = 0;
+}
+
+/**
+ * Returns the lowest position for a rectangle starting at a segment.
+ *
+ * The rectangle is placed with its left edge at the given segment. If it
+ * does not fit there, this method returns -1.
+ *
+ * @param index     The skyline segment
+ * @param width     The rectangle width
+ * @param height    The rectangle height
+ *
+ * @return the lowest position for a rectangle starting at a segment.
+ */
+int AtlasPacker::fit(size_t index, int width, int height) const {
+    int x = _skyline[index].x;
+    if (x+width > _width) {
+        return -1;
+    }
+    
+    // The rectangle rests on the highest segment beneath it
+    int y = 0;
+    int remain = width;
+    for(size_t ii = index; remain > 0; ii++) {
+        y = std::max(y, _skyline[ii].y);
+        if (y+height > _height) {
+            return -1;
+        }
+        remain -= _skyline[ii].width;
+    }
+    return y;
+}
+
+/**
+ * Returns true if a rectangle of the given size was added to the page.
+ *
+ * If the rectangle fits, its position on the page is stored in dst. The
+ * origin of dst is the top left corner of the rectangle. If it does not
+ * fit, dst is unchanged.
+ *
+ * @param width     The rectangle width in pixels
+ * @param height    The rectangle height in pixels
+ * @param dst       The rectangle to store the position
+ *
+ * @return true if a rectangle of the given size was added to the page.
+ */
+bool AtlasPacker::pack(int width, int height, Rect* dst) {
+    CUAssertLog(width > 0 && height > 0, "Rectangle size %dx%d is invalid", width, height);
+    
+    // Find the lowest bottom edge, breaking ties on the narrowest segment
+    int bestIndex = -1;
+    int bestBottom = _height+1;
+    int bestWidth  = _width+1;
+    int bestY = 0;
+    for(size_t ii = 0; ii < _skyline.size(); ii++) {
+        int y = fit(ii, width, height);
+        if (y >= 0 && (y+height < bestBottom ||
+                       (y+height == bestBottom && _skyline[ii].width < bestWidth))) {
+            bestIndex = (int)ii;
+            bestBottom = y+height;
+            bestWidth = _skyline[ii].width;
+            bestY = y;
+        }
+    }
+    if (bestIndex < 0) {
+        return false;
+    }
+    
+    // Raise the skyline under the new rectangle
+    int x = _skyline[bestIndex].x;
+    _skyline.insert(_skyline.begin()+bestIndex, {x, bestBottom, width});
+    size_t ii = bestIndex+1;
+    while (ii < _skyline.size() && _skyline[ii].x < x+width) {
+        int shrink = x+width-_skyline[ii].x;
+        if (shrink < _skyline[ii].width) {
+            _skyline[ii].x += shrink;
+            _skyline[ii].width -= shrink;
+            break;
+        }
+        _skyline.erase(_skyline.begin()+ii);
+    }
+    
+    // Merge neighbors at the same height
+    for(ii = 0; ii+1 < _skyline.size(); ) {
+        if (_skyline[ii].y == _skyline[ii+1].y) {
+            _skyline[ii].width += _skyline[ii+1].width;
+            _skyline.erase(_skyline.begin()+ii+1);
+        } else {
+            ii++;
+        }
+    }
+    
+    _usedWidth  = std::max(_usedWidth, x+width);
+    _usedHeight = std::max(_usedHeight, bestBottom);
+    _usedArea += (size_t)width*(size_t)height;
+    dst->set((float)x, (float)bestY, (float)width, (float)height);
+    return true;
+}
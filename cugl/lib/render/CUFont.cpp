@@ -45,10 +45,15 @@
 
 #include <deque>
 #include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <condition_variable>
 #include <utf8/utf8.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
 #include <cugl/util/CUStrings.h>
+#include <cugl/util/CUThreadPool.h>
+#include <cugl/base/CUApplication.h>
 #include <cugl/render/CUTexture.h>
 #include <cugl/render/CUFont.h>
 
@@ -60,6 +65,11 @@ using namespace cugl;
 /** The maximum size of an individual atlas texture */
 #define MAX_ATLAS_SIZE  512
 
+/** The minimum number of glyphs for each rasterization task */
+#define RASTER_GRAIN    16
+/** The default number of lazy glyphs to upload each frame */
+#define UPLOAD_LIMIT    8
+
 /** The value of a tab character (becomes four spaces) */
 #define TAB_CHAR        9
 /** The value of an ASCII space character */
@@ -93,6 +103,130 @@ static bool is_whitespace(Uint32 thechar) {
             (0x001c <= thechar && thechar <= 0x001f) || thechar == 0x085);
 }
 
+/** The offset to the nearest pixel of interest in a distance transform */
+typedef struct {
+    /** The x offset to the nearest pixel */
+    int dx;
+    /** The y offset to the nearest pixel */
+    int dy;
+} field_offset;
+
+/** The offset for pixels with nothing of interest nearby */
+#define FIELD_FAR   4096
+
+/**
+ * Propagates the offset of a neighbor in a distance transform
+ *
+ * @param grid  The offsets for every pixel
+ * @param w     The grid width
+ * @param h     The grid height
+ * @param x     The x-coordinate of the pixel to update
+ * @param y     The y-coordinate of the pixel to update
+ * @param ox    The x-offset of the neighbor
+ * @param oy    The y-offset of the neighbor
+ */
+static void field_compare(std::vector<field_offset>& grid, int w, int h, int x, int y, int ox, int oy) {
+    int nx = x+ox;
+    int ny = y+oy;
+    if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+        return;
+    }
+    field_offset other = grid[ny*w+nx];
+    other.dx += ox;
+    other.dy += oy;
+    field_offset& self = grid[y*w+x];
+    if (other.dx*other.dx+other.dy*other.dy < self.dx*self.dx+self.dy*self.dy) {
+        self = other;
+    }
+}
+
+/**
+ * Computes a Euclidean distance transform in place
+ *
+ * This is the 8-point sequential algorithm (8SSEDT). It makes one pass
+ * down and one pass up the grid, so it is linear in the grid size. The
+ * result is exact up to a fraction of a pixel, which is all a glyph needs.
+ *
+ * @param grid  The offsets for every pixel (0 for the pixels of interest)
+ * @param w     The grid width
+ * @param h     The grid height
+ */
+static void field_sweep(std::vector<field_offset>& grid, int w, int h) {
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            field_compare(grid, w, h, x, y, -1,  0);
+            field_compare(grid, w, h, x, y,  0, -1);
+            field_compare(grid, w, h, x, y, -1, -1);
+            field_compare(grid, w, h, x, y,  1, -1);
+        }
+        for(int x = w-1; x >= 0; x--) {
+            field_compare(grid, w, h, x, y, 1, 0);
+        }
+    }
+    for(int y = h-1; y >= 0; y--) {
+        for(int x = w-1; x >= 0; x--) {
+            field_compare(grid, w, h, x, y,  1, 0);
+            field_compare(grid, w, h, x, y,  0, 1);
+            field_compare(grid, w, h, x, y, -1, 1);
+            field_compare(grid, w, h, x, y,  1, 1);
+        }
+        for(int x = 0; x < w; x++) {
+            field_compare(grid, w, h, x, y, -1, 0);
+        }
+    }
+}
+
+/**
+ * Converts a glyph box of an atlas surface into a signed distance field
+ *
+ * A pixel is inside the glyph if its alpha is at least half. Afterwards,
+ * the alpha of each pixel is the signed distance to the glyph edge, mapped
+ * so that 0.5 is on the edge and the spread reaches 0 (outside) or 1
+ * (inside). The color of each pixel is white.
+ *
+ * The surface must be 32-bit RGBA (in byte order).
+ *
+ * @param surface   The atlas surface
+ * @param rect      The glyph box (including padding)
+ * @param spread    The distance in pixels to reach 0 or 1
+ */
+static void distance_field(SDL_Surface* surface, const SDL_Rect& rect, float spread) {
+    int w = rect.w;
+    int h = rect.h;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    
+    // Distances to the nearest inside pixel and to the nearest outside pixel
+    std::vector<field_offset> inside(w*h);
+    std::vector<field_offset> outside(w*h);
+    Uint8* pixels = (Uint8*)surface->pixels;
+    for(int y = 0; y < h; y++) {
+        Uint8* row = pixels+(rect.y+y)*surface->pitch+rect.x*4;
+        for(int x = 0; x < w; x++) {
+            bool in = row[4*x+3] >= 128;
+            inside[y*w+x]  = in ? field_offset{0,0} : field_offset{FIELD_FAR,FIELD_FAR};
+            outside[y*w+x] = in ? field_offset{FIELD_FAR,FIELD_FAR} : field_offset{0,0};
+        }
+    }
+    field_sweep(inside, w, h);
+    field_sweep(outside, w, h);
+    
+    for(int y = 0; y < h; y++) {
+        Uint8* row = pixels+(rect.y+y)*surface->pitch+rect.x*4;
+        for(int x = 0; x < w; x++) {
+            const field_offset& in  = inside[y*w+x];
+            const field_offset& out = outside[y*w+x];
+            float d = sqrtf((float)(in.dx*in.dx+in.dy*in.dy))-sqrtf((float)(out.dx*out.dx+out.dy*out.dy));
+            float a = std::min(std::max(0.5f-d/(2*spread),0.0f),1.0f);
+            row[4*x  ] = 255;
+            row[4*x+1] = 255;
+            row[4*x+2] = 255;
+            row[4*x+3] = (Uint8)(a*255+0.5f);
+        }
+    }
+}
+
 
 #pragma mark -
 #pragma mark Atlas
@@ -105,6 +239,7 @@ static bool is_whitespace(Uint32 thechar) {
 Font::Atlas::Atlas() :
 _parent(nullptr),
 _surface(nullptr),
+_growable(false),
 texture(nullptr) {
 }
 
@@ -121,6 +256,8 @@ void Font::Atlas::dispose() {
 	}
 	_parent = nullptr;
 	_size = Size::ZERO;
+    _growable = false;
+    _shelves.clear();
     texture = nullptr;
 	glyphmap.clear();
 }
@@ -153,6 +290,50 @@ bool Font::Atlas::init(Font* parent, std::deque<Uint32>& glyphset)  {
     return glyphmap.size() > 0;
 }
 
+/**
+ * Initializes an empty, growable atlas for the given font
+ *
+ * A growable atlas is a fixed size page that starts with no glyphs.
+ * Glyphs are added one at a time with {@link #reserve}, and are
+ * uploaded to the texture with {@link #upload}. The page never changes
+ * size, as that would invalidate the texture coordinates of existing
+ * glyph runs. Instead, the font starts a new page when it is full.
+ *
+ * This initializer creates the SDL surface for the page, but not the
+ * texture. The surface is kept after {@link #materialize} so that new
+ * glyphs can be rasterized into it.
+ *
+ * @param parent    The parent font of this atlas
+ *
+ * @return true if the atlas was successfully initialized
+ */
+bool Font::Atlas::initGrowable(Font* parent) {
+    this->_parent = parent;
+    _size = Size(MAX_ATLAS_SIZE,MAX_ATLAS_SIZE);
+    
+    float padding = _parent->_atlasPadding;
+    int nrows = (int)(_size.height/(_parent->_fontHeight+GLYPH_BORDER+2*padding));
+    if (nrows == 0) {
+        return false;
+    }
+    
+    _surface = allocSurface(_size.width, _size.height);
+    if (_surface == nullptr) {
+        return false;
+    }
+    
+    // Add a 2 patch at the beginning
+    SDL_Rect patch;
+    patch.x = patch.y = 0;
+    patch.w = patch.h = 2;
+    SDL_FillRect(_surface,&patch,SDL_MapRGBA(_surface->format, 255, 255, 255, 255));
+    
+    _growable = true;
+    _shelves.resize(nrows,0);
+    _shelves[0] = 2;
+    return true;
+}
+
 /**
  * Returns true if this font has a glyph for the given (UNICODE) character.
  *
@@ -225,12 +406,17 @@ bool Font::Atlas::hasGlyphs(const std::vector<Uint32>& glyphs) const {
  * The quad is adjusted so that all of the vertices fit in the provided
  * rectangle.  This may mean that no quad is generated at all.
  *
+ * If the size differs from that of the font owning this atlas, the
+ * quad is scaled to match. This is how fonts share a distance field
+ * atlas (see {@link Font#setAtlasSource}).
+ *
  * @param thechar   The character to convert to render data
  * @param offset    The (unkerned) starting position of the quad
- * @param rect      The bounding box for the quad
  * @param mesh      The mesh to store the vertices
+ * @param rect      The bounding box for the quad
+ * @param size      The point size of the font drawing the quad
  */
-bool Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, const Rect rect) const {
+bool Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, const Rect rect, Uint32 size) const {
     CUAssertLog(mesh.command == GL_TRIANGLES, "The mesh is not formatted for triangles");
 
     // Technically, this answer is correct
@@ -241,81 +427,40 @@ bool Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mes
     // Expand tabs
     if (thechar == TAB_CHAR) {
         for(int ii = 0; ii < TAB_SPACE; ii++) {
-            if (!getQuad(SPACE_CHAR, offset, mesh, rect)) {
+            if (!getQuad(SPACE_CHAR, offset, mesh, rect, size)) {
                 return false;
             }
         }
         return true;
     }
     
+    // Bounds are in atlas pixels, while the quad is in font pixels
+    float scale = (float)size/(float)_parent->_fontSize;
     Rect bounds = glyphmap.at(thechar);
-    Rect quad(offset,bounds.size);
+    Rect quad(offset,bounds.size*scale);
 
     // Skip over glyph, but recognize we may have later glyphs
     if (!rect.doesIntersect(quad)) {
-        offset.x += bounds.size.width;
+        offset.x += quad.size.width;
         return quad.getMaxX() <= rect.getMaxX();
     }
     
     // Compute intersection and adjust cookie cutter
+    float width = quad.size.width;
+    float height = quad.size.height;
     quad.intersect(rect);
     bool result = quad.getMaxX() <= rect.getMaxX();
     
     // REMEMBER! Bounds and rect have different y-orientations.
-    bounds.origin.x += quad.origin.x-offset.x;
-    bounds.origin.y -= quad.origin.y+quad.size.height-offset.y-bounds.size.height;
+    bounds.origin.x += (quad.origin.x-offset.x)/scale;
+    bounds.origin.y -= (quad.origin.y+quad.size.height-offset.y-height)/scale;
     
-    float padding = _parent->_atlasPadding;
-    offset.x += bounds.size.width-2*padding;
+    float padding = _parent->_atlasPadding*scale;
+    offset.x += width-2*padding;
     quad.origin.x -= padding;
     quad.origin.y -= padding;
-    bounds.size = quad.size;
-    
-    int width  = texture->getWidth();
-    int height = texture->getHeight();
-
-    SpriteVertex2 temp;
-    GLuint size = (GLuint)mesh.vertices.size();
-    
-    // Bottom left
-    GLuint white = Color4::WHITE.getPacked();
-    temp.position = quad.origin;
-    temp.color = white;
-    temp.texcoord.x = bounds.origin.x/(float)width;
-    temp.texcoord.y = (bounds.origin.y+bounds.size.height)/(float)height;
-    mesh.vertices.push_back(temp);
-    
-    // Bottom right
-    temp.position = quad.origin;
-    temp.position.x += bounds.size.width;
-    temp.color = white;
-    temp.texcoord.x = (bounds.origin.x+bounds.size.width)/(float)width;
-    temp.texcoord.y = (bounds.origin.y+bounds.size.height)/(float)height;
-    mesh.vertices.push_back(temp);
-    
-    // Top right
-    temp.position = quad.origin+bounds.size;
-    temp.color = white;
-    temp.texcoord.x = (bounds.origin.x+bounds.size.width)/(float)width;
-    temp.texcoord.y = bounds.origin.y/(float)height;
-    mesh.vertices.push_back(temp);
-    
-    // Top left
-    temp.position = quad.origin;
-    temp.position.y += bounds.size.height;
-    temp.color = white;
-    temp.texcoord.x = bounds.origin.x/(float)width;
-    temp.texcoord.y = bounds.origin.y/(float)height;
-    mesh.vertices.push_back(temp);
-    
-    // Add the quad indices
-    mesh.indices.push_back(size);
-    mesh.indices.push_back(size+1);
-    mesh.indices.push_back(size+2);
-    mesh.indices.push_back(size+2);
-    mesh.indices.push_back(size+3);
-    mesh.indices.push_back(size);
-    
+    bounds.size = quad.size/scale;
+    appendQuad(quad, bounds, mesh);
     return result;
 }
 
@@ -328,34 +473,50 @@ bool Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mes
  * character. This method will not generate anything if the character is
  * not supported by this atlas.
  *
+ * If the size differs from that of the font owning this atlas, the
+ * quad is scaled to match. This is how fonts share a distance field
+ * atlas (see {@link Font#setAtlasSource}).
+ *
  * @param thechar   The character to convert to render data
  * @param offset    The (unkerned) starting position of the quad
  * @param mesh      The mesh to store the vertices
+ * @param size      The point size of the font drawing the quad
  */
-void Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh) const {
+void Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mesh, Uint32 size) const {
     CUAssertLog(mesh.command == GL_TRIANGLES, "The mesh is not formatted for triangles");
 
     // Expand tabs
     if (thechar == TAB_CHAR) {
         for(int ii = 0; ii < TAB_SPACE; ii++) {
-            getQuad(SPACE_CHAR, offset, mesh);
+            getQuad(SPACE_CHAR, offset, mesh, size);
         }
         return;
     }
     
+    // Bounds are in atlas pixels, while the quad is in font pixels
+    float scale = (float)size/(float)_parent->_fontSize;
     Rect bounds = glyphmap.at(thechar);
-    Rect quad(offset,bounds.size);
+    Rect quad(offset,bounds.size*scale);
 
-    // REMEMBER! Bounds and rect have different y-orientations.
-    bounds.origin.x += quad.origin.x-offset.x;
-    bounds.origin.y -= quad.origin.y+quad.size.height-offset.y-bounds.size.height;
-    
-    float padding = _parent->_atlasPadding;
-    offset.x += bounds.size.width-2*padding;
+    float padding = _parent->_atlasPadding*scale;
+    offset.x += quad.size.width-2*padding;
     quad.origin.x -= padding;
     quad.origin.y -= padding;
-    bounds.size = quad.size;
-    
+    appendQuad(quad, bounds, mesh);
+}
+
+/**
+ * Appends a textured quad to the given mesh
+ *
+ * The quad is given in font coordinates, while the texture region is
+ * given in the pixel coordinates of this atlas. The two need not have
+ * the same size.
+ *
+ * @param quad      The quad to append
+ * @param bounds    The texture region of the quad
+ * @param mesh      The mesh to store the vertices
+ */
+void Font::Atlas::appendQuad(const Rect quad, const Rect bounds, Mesh<SpriteVertex2>& mesh) const {
     int width  = texture->getWidth();
     int height = texture->getHeight();
 
@@ -372,14 +533,14 @@ void Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mes
     
     // Bottom right
     temp.position = quad.origin;
-    temp.position.x += bounds.size.width;
+    temp.position.x += quad.size.width;
     temp.color = white;
     temp.texcoord.x = (bounds.origin.x+bounds.size.width)/(float)width;
     temp.texcoord.y = (bounds.origin.y+bounds.size.height)/(float)height;
     mesh.vertices.push_back(temp);
     
     // Top right
-    temp.position = quad.origin+bounds.size;
+    temp.position = quad.origin+quad.size;
     temp.color = white;
     temp.texcoord.x = (bounds.origin.x+bounds.size.width)/(float)width;
     temp.texcoord.y = bounds.origin.y/(float)height;
@@ -387,7 +548,7 @@ void Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mes
     
     // Top left
     temp.position = quad.origin;
-    temp.position.y += bounds.size.height;
+    temp.position.y += quad.size.height;
     temp.color = white;
     temp.texcoord.x = bounds.origin.x/(float)width;
     temp.texcoord.y = bounds.origin.y/(float)height;
@@ -419,44 +580,73 @@ bool Font::Atlas::build() {
         return false;
     }
     
-    SDL_Rect srcrect, dstrect;
-    SDL_Color color;
-    color.r = color.g = color.b = color.a = 255;
-    SDL_Color bkgrd;
-    bkgrd.r = bkgrd.g = bkgrd.b = bkgrd.a = 0;
-    
     // Add a 2 patch at the beginning
-    srcrect.x = srcrect.y = 0;
-    srcrect.w = srcrect.h = 2;
-    SDL_FillRect(_surface,&srcrect,SDL_MapRGBA(_surface->format, 255, 255, 255, 255));
+    SDL_Rect patch;
+    patch.x = patch.y = 0;
+    patch.w = patch.h = 2;
+    SDL_FillRect(_surface,&patch,SDL_MapRGBA(_surface->format, 255, 255, 255, 255));
     
+    std::vector<Uint32> glyphs;
+    glyphs.reserve(glyphmap.size());
     for(auto it = glyphmap.begin(); it != glyphmap.end(); ++it) {
-        SDL_Surface* temp = TTF_RenderGlyph_Blended(_parent->_data, it->first, color);
-        if (temp == nullptr) {
-            return false;
-        }
-        
         // Resize the boundary now that spacing is safe.
         it->second.origin.x += GLYPH_BORDER/2;
         it->second.origin.y += GLYPH_BORDER/2;
         it->second.size.width  -= GLYPH_BORDER;
         it->second.size.height -= GLYPH_BORDER;
-        
-        // Convert to SDL rects
-        float padding = _parent->_atlasPadding;
-        dstrect.x = (int)it->second.origin.x+padding;
-        dstrect.y = (int)it->second.origin.y+padding;
-        srcrect.x = srcrect.y = 0;
-        dstrect.w = srcrect.w = (int)it->second.size.width-2*padding;
-        dstrect.h = srcrect.h = (int)it->second.size.height-2*padding;
-        
-        // Blit on to atlas
-        SDL_SetSurfaceBlendMode(temp, SDL_BLENDMODE_NONE);
-        SDL_BlitSurface(temp,&srcrect,_surface,&dstrect);
-        SDL_FreeSurface(temp);
+        glyphs.push_back(it->first);
     }
     
-    return true;
+    // Font faces may only be opened and closed on one thread at a time
+    std::shared_ptr<ThreadPool> threads = _parent->_rasterThreads;
+    std::vector<TTF_Font*> faces;
+    if (threads != nullptr) {
+        size_t tasks = std::min((size_t)threads->getThreads(), glyphs.size()/RASTER_GRAIN);
+        for(size_t ii = 0; tasks > 1 && ii < tasks; ii++) {
+            TTF_Font* face = _parent->openFace();
+            if (face != nullptr) {
+                faces.push_back(face);
+            }
+        }
+    }
+    
+    if (faces.empty()) {
+        for(auto it = glyphs.begin(); it != glyphs.end(); ++it) {
+            if (!blit(_parent->_data, *it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending = faces.size();
+    bool success = true;
+    for(size_t ii = 0; ii < faces.size(); ii++) {
+        threads->addTask([&, ii]() {
+            // Interleave the glyphs so each task gets a mix of widths
+            bool result = true;
+            for(size_t jj = ii; result && jj < glyphs.size(); jj += faces.size()) {
+                result = blit(faces[ii], glyphs[jj]);
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            success = success && result;
+            pending--;
+            done.notify_one();
+        });
+    }
+    
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return pending == 0; });
+    }
+    
+    for(auto it = faces.begin(); it != faces.end(); ++it) {
+        TTF_CloseFont(*it);
+    }
+    return success;
 }
 
 /**
@@ -468,17 +658,83 @@ bool Font::Atlas::build() {
  * @return true if texture creation was successful.
  */
 bool Font::Atlas::materialize() {
-    if (_surface != nullptr) {
+    if (_surface != nullptr && texture == nullptr) {
         texture = Texture::allocWithData(_surface->pixels, _surface->w, _surface->h);
         texture->bind();
         texture->buildMipMaps();
         texture->unbind();
-        SDL_FreeSurface(_surface);
-        _surface = nullptr;
+        // A growable atlas still needs its surface for new glyphs
+        if (!_growable) {
+            SDL_FreeSurface(_surface);
+            _surface = nullptr;
+        }
     }
     return texture != nullptr;
 }
 
+/**
+ * Adds a glyph to this growable atlas, rasterizing it immediately
+ *
+ * The glyph is placed in the first row with room for it, and then
+ * rendered into the atlas surface. It is not visible in the texture
+ * until it is uploaded with {@link #upload}. This method returns
+ * false if the atlas is not growable or if there is no room left
+ * for the glyph.
+ *
+ * @param thechar   The glyph to add
+ *
+ * @return true if the glyph was added to this atlas
+ */
+bool Font::Atlas::reserve(Uint32 thechar) {
+    if (!_growable || _surface == nullptr) {
+        return false;
+    }
+    
+    float padding = _parent->_atlasPadding;
+    float w = _parent->getMetrics(thechar).advance+GLYPH_BORDER+2*padding;
+    float h = _parent->_fontHeight+GLYPH_BORDER+2*padding;
+    for(size_t line = 0; line < _shelves.size(); line++) {
+        if (w < _size.width-_shelves[line]) {
+            Rect bounds(_shelves[line],line*h,w,h);
+            _shelves[line] += w;
+            
+            // Resize the boundary now that spacing is safe.
+            bounds.origin.x += GLYPH_BORDER/2;
+            bounds.origin.y += GLYPH_BORDER/2;
+            bounds.size.width  -= GLYPH_BORDER;
+            bounds.size.height -= GLYPH_BORDER;
+            glyphmap.emplace(thechar,bounds);
+            return blit(_parent->_data, thechar);
+        }
+    }
+    return false;
+}
+
+/**
+ * Uploads the rows of the atlas surface containing the given glyph
+ *
+ * This method only works on a growable atlas that has been
+ * materialized. It does not rebuild the texture mipmaps. This method
+ * must be called on the main thread.
+ *
+ * @param thechar   The glyph to upload
+ *
+ * @return true if the glyph was successfully uploaded
+ */
+bool Font::Atlas::upload(Uint32 thechar) {
+    auto it = glyphmap.find(thechar);
+    if (_surface == nullptr || texture == nullptr || it == glyphmap.end()) {
+        return false;
+    }
+    
+    int row    = (int)it->second.origin.y;
+    int height = std::min((int)std::ceil(it->second.size.height), _surface->h-row);
+    texture->bind();
+    texture->set((Uint8*)_surface->pixels+row*_surface->pitch, row, height);
+    texture->unbind();
+    return true;
+}
+
 /**
  * Lays out the glyphs in reasonably efficient packing.
  *
@@ -597,6 +853,57 @@ SDL_Surface* Font::Atlas::allocSurface(int width, int height) {
     return result;
 }
 
+/**
+ * Rasterizes a single glyph into the atlas surface.
+ *
+ * The glyph must already be laid out in the glyph map, with the
+ * glyph border removed from its bounds. The glyph is rendered with
+ * the given font face, which need not be the face of the parent font.
+ * This method only writes to the pixels inside the glyph bounds, so
+ * it is safe to rasterize glyphs of the same atlas in parallel, as
+ * long as each thread has its own face.
+ *
+ * @param face      The font face to render the glyph
+ * @param thechar   The glyph to rasterize
+ *
+ * @return true if the glyph was successfully rasterized
+ */
+bool Font::Atlas::blit(TTF_Font* face, Uint32 thechar) {
+    SDL_Color color;
+    color.r = color.g = color.b = color.a = 255;
+    SDL_Surface* temp = TTF_RenderGlyph_Blended(face, thechar, color);
+    if (temp == nullptr) {
+        return false;
+    }
+    
+    const Rect& bounds = glyphmap.at(thechar);
+    int padding = _parent->_atlasPadding;
+    int x = (int)bounds.origin.x+padding;
+    int y = (int)bounds.origin.y+padding;
+    int w = std::min((int)bounds.size.width-2*padding, temp->w);
+    int h = std::min((int)bounds.size.height-2*padding, temp->h);
+    
+    // Convert in place; a surface blit shares state between the surfaces
+    bool success = true;
+    if (w > 0 && h > 0) {
+        Uint8* pixels = (Uint8*)_surface->pixels+y*_surface->pitch+x*_surface->format->BytesPerPixel;
+        success = SDL_ConvertPixels(w, h, temp->format->format, temp->pixels, temp->pitch,
+                                    _surface->format->format, pixels, _surface->pitch) == 0;
+    }
+    SDL_FreeSurface(temp);
+    
+    // The distance field spreads into the padding
+    if (success && _parent->_distanceSpread > 0) {
+        SDL_Rect box;
+        box.x = (int)bounds.origin.x;
+        box.y = (int)bounds.origin.y;
+        box.w = (int)bounds.size.width;
+        box.h = (int)bounds.size.height;
+        distance_field(_surface, box, (float)_parent->_distanceSpread);
+    }
+    return success;
+}
+
 
 #pragma mark -
 #pragma mark Font
@@ -616,6 +923,11 @@ _fontAscent(0),
 _fontDescent(0),
 _fontLineSkip(0),
 _atlasPadding(0),
+_distanceSpread(0),
+_lazy(false),
+_uploadLimit(UPLOAD_LIMIT),
+_uploadid(0),
+_uploading(false),
 _shrinkLimit(0),
 _stretchLimit(0),
 _fallback(false),
@@ -630,6 +942,12 @@ _hints(Hinting::NORMAL){ }
  * You must reinitialize the font to use it.
  */
 void Font::dispose() {
+    if (_uploading && Application::get() != nullptr) {
+        Application::get()->unschedule(_uploadid);
+    }
+    _uploading = false;
+    _uploads.clear();
+    
     if (_data != nullptr) {
         TTF_CloseFont(_data);
         _data = nullptr;
@@ -643,6 +961,8 @@ void Font::dispose() {
     _fontDescent = 0;
     _fontLineSkip = 0;
     _atlasPadding = 0;
+    _distanceSpread = 0;
+    _atlasSource = nullptr;
     _fixedWidth = false;
     _useKerning = true;
     _style  = Style::NORMAL;
@@ -651,6 +971,10 @@ void Font::dispose() {
     _kernmap.clear();
     _atlases.clear();
     _atlasmap.clear();
+    _source = "";
+    _rasterThreads = nullptr;
+    _lazy = false;
+    _uploadLimit = UPLOAD_LIMIT;
 }
 
 /**
@@ -677,6 +1001,7 @@ bool Font::init(const std::string file, Uint32 size) {
         return false;
     }
     _fontSize = size;
+    _source = fullpath;
     char* strng = TTF_FontFaceFamilyName(_data);
     _name = std::string(strng);
 
@@ -824,12 +1149,101 @@ void Font::setHinting(Hinting hinting) {
  * @param padding   The additional atlas padding
  */
 void Font::setPadding(Uint32 padding) {
+    padding = std::max(padding,_distanceSpread);
     if (_atlasPadding != padding) {
         _atlasPadding = padding;
         clearAtlases();
     }
 }
 
+/**
+ * Sets the spread of the signed distance field atlases
+ *
+ * If this value is 0 (the default), the atlases store bitmap glyphs,
+ * which only look crisp when drawn at their native size. Otherwise,
+ * the alpha of each atlas pixel is the distance to the nearest glyph
+ * edge, where 0.5 is on the edge and the spread is the distance (in
+ * pixels) to reach 0 or 1. A distance field atlas stays crisp at any
+ * scale, but it must be drawn with {@link SpriteBatch#setDistanceField}.
+ * The text drawing methods of {@link SpriteBatch} (and labels) do this
+ * automatically.
+ *
+ * The distance field is stored in the atlas padding, so the padding
+ * is raised to at least the spread. Reseting this value will clear any
+ * existing atlas collection.
+ *
+ * @param spread    The spread of the signed distance field atlases
+ */
+void Font::setDistanceSpread(Uint32 spread) {
+    if (_distanceSpread != spread) {
+        _distanceSpread = spread;
+        _atlasPadding = std::max(_atlasPadding,spread);
+        clearAtlases();
+    }
+}
+
+/**
+ * Sets the distance field font whose atlases this font draws from.
+ *
+ * A distance field atlas stays crisp at any scale, so fonts of the same
+ * face at different sizes do not each need an atlas. Once this value is
+ * set, this font draws its glyphs from the atlases of the source, scaled
+ * by the ratio of the two font sizes. The glyph metrics and kerning of
+ * the source are scaled the same way, so that the layout agrees with the
+ * glyphs. The source should have the same face and style as this font,
+ * and its atlases must already be built (or at least prepared with
+ * {@link #buildAtlasesAsync}).
+ *
+ * Setting this value clears any existing atlas collection of this font.
+ * Setting it to nullptr detaches this font, so that any atlases built
+ * afterwards measure its own glyphs.
+ *
+ * @param source    The distance field font whose atlases this font draws from
+ *
+ * @return true if the atlases of the source could be shared
+ */
+bool Font::setAtlasSource(const std::shared_ptr<Font>& source) {
+    clearAtlases();
+    _glyphsize.clear();
+    _kernmap.clear();
+    _atlasSource = nullptr;
+    if (source == nullptr) {
+        return true;
+    }
+    
+    CUAssertLog(source.get() != this, "A font cannot share its own atlases");
+    if (!source->isDistanceField() || source->_fontSize <= 0) {
+        CULogError("Font '%s' is not a distance field font",source->_name.c_str());
+        return false;
+    }
+    
+    float scale = (float)_fontSize/(float)source->_fontSize;
+    _atlasSource = source;
+    _distanceSpread = source->_distanceSpread;
+    _atlasPadding = (Uint32)std::ceil(source->_atlasPadding*scale);
+    _atlases  = source->_atlases;
+    _atlasmap = source->_atlasmap;
+    
+    for(auto it = source->_glyphsize.begin(); it != source->_glyphsize.end(); ++it) {
+        Metrics metrics;
+        metrics.minx = (int)std::lround(it->second.minx*scale);
+        metrics.maxx = (int)std::lround(it->second.maxx*scale);
+        metrics.miny = (int)std::lround(it->second.miny*scale);
+        metrics.maxy = (int)std::lround(it->second.maxy*scale);
+        metrics.advance = (int)std::lround(it->second.advance*scale);
+        _glyphsize.emplace(it->first,metrics);
+    }
+    
+    // Kerning is stored unsigned, but may be negative
+    for(auto it = source->_kernmap.begin(); it != source->_kernmap.end(); ++it) {
+        std::unordered_map<Uint32, Uint32>& kerning = _kernmap[it->first];
+        for(auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
+            kerning.emplace(jt->first,(Uint32)std::lround((int)jt->second*scale));
+        }
+    }
+    return true;
+}
+
 #pragma mark -
 #pragma mark Measurements
 /**
@@ -1298,6 +1712,8 @@ std::vector<int> Font::getTracking(const char* substr, const char* end, float wi
  */
 void Font::clearAtlases() {
     _atlases.clear();
+    _atlasmap.clear();
+    _uploads.clear();
 }
 
 /**
@@ -1551,6 +1967,42 @@ bool Font::storeAtlases() {
     
     return success;
 }
+
+/**
+ * Uploads the pending glyphs of a lazy atlas to their textures.
+ *
+ * This method uploads at most {@link #getUploadLimit} glyphs, in the
+ * order that they were added. It is called automatically at the start
+ * of each animation frame while there are glyphs pending, so it is
+ * rarely necessary to call it directly. This method must be called on
+ * the main thread.
+ *
+ * @return the number of glyphs still waiting to be uploaded
+ */
+size_t Font::updateAtlases() {
+    std::vector<size_t> touched;
+    Uint32 count = 0;
+    while (!_uploads.empty() && (_uploadLimit == 0 || count < _uploadLimit)) {
+        Uint32 thechar = _uploads.front();
+        _uploads.pop_front();
+        auto it = _atlasmap.find(thechar);
+        if (it != _atlasmap.end() && _atlases[it->second]->upload(thechar)) {
+            if (std::find(touched.begin(), touched.end(), it->second) == touched.end()) {
+                touched.push_back(it->second);
+            }
+            count++;
+        }
+    }
+    
+    for(auto it = touched.begin(); it != touched.end(); ++it) {
+        std::shared_ptr<Texture> texture = _atlases[*it]->texture;
+        texture->bind();
+        texture->buildMipMaps();
+        texture->unbind();
+    }
+    return _uploads.size();
+}
+
 /**
  * Returns the OpenGL textures for the associated atlas collection.
  *
@@ -2070,6 +2522,21 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
         adjusts = getTracking(substr, end, track);
     }
     size_t total = 0;
+    if (_lazy) {
+        // Add the missing characters to the atlases
+        std::vector<Uint32> missing;
+        while (begin != end) {
+            Uint32 thechar = utf8::next(begin,end);
+            if (_atlasmap.find(thechar) == _atlasmap.end()) {
+                missing.push_back(thechar);
+            }
+        }
+        if (missing.size() > 0) {
+            reserveGlyphs(missing);
+        }
+        begin = substr;
+    }
+    
     if (_fallback) {
         // See which any characters are missing
         std::vector<Uint32> missing;
@@ -2130,7 +2597,7 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
                 found = true;
             }
      
-            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
+            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds,_fontSize)) {
                 grun->contents.emplace(thechar);
                 total++;
             }
@@ -2168,7 +2635,7 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
                 found = true;
             }
      
-            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
+            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds,_fontSize)) {
                 grun->contents.emplace(thechar);
                 total++;
             }
@@ -2212,11 +2679,14 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
  */
 std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
     std::shared_ptr<GlyphRun> grun = nullptr;
+    if (_lazy && _atlasmap.find(thechar) == _atlasmap.end()) {
+        reserveGlyphs(std::vector<Uint32>(1,thechar));
+    }
     if (_atlasmap.find(thechar) != _atlasmap.end()) {
         std::shared_ptr<Atlas> atlas = _atlases[_atlasmap[thechar]];
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
-        atlas->getQuad(thechar, offset, grun->mesh);
+        atlas->getQuad(thechar, offset, grun->mesh, _fontSize);
     } else if (_fallback) {
         std::vector<Uint32> charset;
         charset.push_back(thechar);
@@ -2225,7 +2695,7 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
-        atlas->getQuad(thechar, offset, grun->mesh);
+        atlas->getQuad(thechar, offset, grun->mesh, _fontSize);
     }
     
     return grun;
@@ -2269,11 +2739,14 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
  */
 std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset, const Rect rect) {
     std::shared_ptr<GlyphRun> grun = nullptr;
+    if (_lazy && _atlasmap.find(thechar) == _atlasmap.end()) {
+        reserveGlyphs(std::vector<Uint32>(1,thechar));
+    }
     if (_atlasmap.find(thechar) != _atlasmap.end()) {
         std::shared_ptr<Atlas> atlas = _atlases[_atlasmap[thechar]];
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
-        atlas->getQuad(thechar, offset, grun->mesh, rect);
+        atlas->getQuad(thechar, offset, grun->mesh, rect, _fontSize);
     } else if (_fallback) {
         std::vector<Uint32> charset;
         charset.push_back(thechar);
@@ -2282,7 +2755,7 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset, const Rec
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
-        atlas->getQuad(thechar, offset, grun->mesh, rect);
+        atlas->getQuad(thechar, offset, grun->mesh, rect, _fontSize);
     }
     
     return grun;
@@ -2862,8 +3335,12 @@ void Font::gatherKerning(const std::deque<Uint32>& glyphs) {
         if (_kernmap.find(it->first) == _kernmap.end()) {
             _kernmap.emplace(it->first, std::unordered_map<Uint32, Uint32>());
         }
+        // Only measure the new pairs
+        std::unordered_map<Uint32, Uint32>& kerning = _kernmap[it->first];
         for(auto jt = _glyphsize.begin(); jt != _glyphsize.end(); ++jt) {
-            _kernmap[it->first].emplace(jt->first, computeKerning(it->first, jt->first));
+            if (kerning.find(jt->first) == kerning.end()) {
+                kerning.emplace(jt->first, computeKerning(it->first, jt->first));
+            }
         }
     }
 }
@@ -2985,6 +3462,92 @@ bool Font::buildLocalAtlases(const std::vector<Uint32>& charset,
     return success;
 }
 
+/**
+ * Adds the missing glyphs of the character set to the lazy atlases.
+ *
+ * Each glyph supported by the font, but not yet in an atlas, is
+ * rasterized into the last growable atlas page, starting a new page
+ * when that one is full. The glyphs are queued for upload, and an
+ * upload callback is scheduled if necessary.
+ *
+ * The character set should be all UNICODE values.
+ *
+ * WARNING: This method is not thread safe. It generates an OpenGL texture,
+ * which means that it may only be called in the main thread.
+ *
+ * @param charset   The characters to add
+ */
+void Font::reserveGlyphs(const std::vector<Uint32>& charset) {
+    std::deque<Uint32> glyphs = gatherGlyphs(charset);
+    if (glyphs.empty()) {
+        return;
+    }
+    
+    gatherKerning(glyphs);
+    std::shared_ptr<Atlas> page = nullptr;
+    // Never grow a page shared with the atlas source
+    if (!_atlases.empty() && _atlases.back()->isGrowable() &&
+        (_atlasSource == nullptr || _atlases.size() > _atlasSource->_atlases.size())) {
+        page = _atlases.back();
+    }
+    
+    for(auto it = glyphs.begin(); it != glyphs.end(); ++it) {
+        if (page != nullptr && page->reserve(*it)) {
+            _uploads.push_back(*it);
+        } else {
+            // A new page uploads its glyphs as it is materialized
+            std::shared_ptr<Atlas> fresh = Atlas::allocGrowable(this);
+            if (fresh == nullptr || !fresh->reserve(*it) || !fresh->materialize()) {
+                continue;
+            }
+            page = fresh;
+            _atlases.push_back(page);
+        }
+        
+        size_t pos = _atlases.size()-1;
+        _atlasmap.emplace(*it,pos);
+        if (*it == SPACE_CHAR) {
+            _atlasmap.emplace(TAB_CHAR,pos);
+        }
+    }
+    
+    if (_uploads.empty() || _uploading) {
+        return;
+    } else if (Application::get() == nullptr) {
+        while (updateAtlases() > 0) {}
+        return;
+    }
+    
+    _uploading = true;
+    _uploadid = Application::get()->schedule([this](void) {
+        _uploading = updateAtlases() > 0;
+        return _uploading;
+    });
+}
+
+/**
+ * Returns a new font face matching the settings of this font.
+ *
+ * The face is opened from the same source file, with the same size,
+ * style, hinting, and kerning. It is used to rasterize glyphs on other
+ * threads, as a font face may only be used by one thread at a time.
+ * The caller must close the face with TTF_CloseFont.
+ *
+ * Opening and closing font faces is not thread safe. This method should
+ * only be called on the thread that builds the atlases.
+ *
+ * @return a new font face matching the settings of this font.
+ */
+TTF_Font* Font::openFace() const {
+    TTF_Font* face = TTF_OpenFont(_source.c_str(), _fontSize);
+    if (face != nullptr) {
+        TTF_SetFontStyle(face, (int)_style);
+        TTF_SetFontHinting(face, (int)_hints);
+        TTF_SetFontKerning(face, _useKerning);
+    }
+    return face;
+}
+
 /**
  * Creates a quad outline of this character and stores it in mesh
  *
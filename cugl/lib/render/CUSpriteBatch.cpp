@@ -54,6 +54,7 @@
 #include <cugl/render/CUFont.h>
 #include <cugl/render/CUGlyphRun.h>
 #include <cugl/render/CUTextLayout.h>
+#include "cuSprite128.inl"
 
 /**
  * Default fragment shader
@@ -79,6 +80,16 @@ const std::string oglShaderVert =
 #include "shaders/SpriteShader.vert"
 ;
 
+/**
+ * Instanced vertex shader
+ *
+ * This shader is paired with the default fragment shader to draw instanced
+ * sprites. See {@link SpriteBatch#drawInstances}.
+ */
+const std::string oglInstanceVert =
+#include "shaders/SpriteInstance.vert"
+;
+
 using namespace cugl;
 
 
@@ -92,6 +103,8 @@ using namespace cugl;
 #define TYPE_SCISSOR    4
 /** The drawing type for a (simple) texture blur */
 #define TYPE_GAUSSBLUR  8
+/** The drawing type for a signed distance field texture */
+#define TYPE_DISTANCE   16
 
 /** The drawing command has changed */
 #define DIRTY_COMMAND           0x001
@@ -200,6 +213,7 @@ public:
         blockptr = -1;
         zDepth = 0;
         blur = 0;
+        layer = 0;
         type = 0;
         dirty = 0;
     }
@@ -226,6 +240,7 @@ public:
         blockptr = copy->blockptr;
         zDepth = copy->zDepth;
         blur  = copy->blur;
+        layer = copy->layer;
         dirty = 0;
     }
     
@@ -248,6 +263,7 @@ public:
         blockptr = -1;
         zDepth = 0;
         blur = 0;
+        layer = 0;
         type = 0;
     }
     
@@ -275,6 +291,7 @@ public:
         blockptr = -1;
         zDepth = 0;
         blur = 0;
+        layer = 0;
         type = 0;
         dirty = 0;
     }
@@ -309,12 +326,29 @@ public:
     GLfloat zDepth;
     /** The radius for our blur function */
     GLfloat blur;
+    /** The sort layer (deferred mode only) */
+    Uint32 layer;
     /** The stored block offset for gradient and scissor */
     GLsizei blockptr;
     /** The dirty bits relative to the previous set of uniforms */
     GLuint dirty;
 };
 
+#pragma mark -
+#pragma mark Static Batches
+/**
+ * Deletes the static batch, releasing all resources.
+ */
+void StaticBatch::dispose() {
+    _vertbuff = nullptr;
+    _segments.clear();
+    _vertices.clear();
+    _indices.clear();
+    _indxSize = 0;
+    _valid = false;
+    _sealed = 0;
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -327,6 +361,7 @@ _initialized(false),
 _active(false),
 _inflight(false),
 _vertData(nullptr),
+_vertLocal(nullptr),
 _indxData(nullptr),
 _color(Color4f::WHITE),
 _context(nullptr),
@@ -334,13 +369,20 @@ _vertMax(0),
 _vertSize(0),
 _indxMax(0),
 _indxSize(0),
+_scissored(false),
 _vertTotal(0),
-_callTotal(0) {
+_callTotal(0),
+_deferred(false),
+_streaming(false),
+_streamFlushes(0),
+_streamSegments(STREAM_MIN_SEGMENTS),
+_recorder(false),
+_cmdsource(nullptr) {
     _shader = nullptr;
     _vertbuff = nullptr;
     _unifbuff = nullptr;
     _gradient = nullptr;
-    _scissor  = nullptr;
+    _recording = nullptr;
 }
 
 /**
@@ -349,9 +391,10 @@ _callTotal(0) {
  * You must reinitialize the sprite batch to use it.
  */
 void SpriteBatch::dispose() {
-    if (_vertData) {
-        delete[] _vertData; _vertData = nullptr;
+    if (_vertLocal) {
+        delete[] _vertLocal; _vertLocal = nullptr;
     }
+    _vertData = nullptr;
     if (_indxData) {
         delete[] _indxData; _indxData = nullptr;
     }
@@ -362,7 +405,9 @@ void SpriteBatch::dispose() {
     _vertbuff = nullptr;
     _unifbuff = nullptr;
     _gradient = nullptr;
-    _scissor  = nullptr;
+    _scissored = false;
+    _scissorStack.clear();
+    _recording = nullptr;
     
     _vertMax  = 0;
     _vertSize = 0;
@@ -376,6 +421,20 @@ void SpriteBatch::dispose() {
     _initialized = false;
     _inflight = false;
     _active = false;
+    _deferred = false;
+    _sortKeys.clear();
+    _sortOrder.clear();
+    _sortScratch.clear();
+    _sortBlends.clear();
+    _sortIndx.clear();
+    _streaming = false;
+    _streamFlushes = 0;
+    _streamSegments = STREAM_MIN_SEGMENTS;
+    _instShader = nullptr;
+    _instBuffer = nullptr;
+    _recorder = false;
+    _cmdbuff = nullptr;
+    _cmdsource = nullptr;
 }
 
 /**
@@ -472,7 +531,8 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     
     // Set up data arrays;
     _vertMax = capacity;
-    _vertData = new SpriteVertex2[_vertMax];
+    _vertLocal = new SpriteVertex2[_vertMax];
+    _vertData = _vertLocal;
     _indxMax = capacity*3;
     _indxData = new GLuint[_indxMax];
     
@@ -497,6 +557,49 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     return true;
 }
 
+/**
+ * Initializes a command recorder with the given vertex capacity.
+ *
+ * A command recorder is a sprite batch that never touches OpenGL. It
+ * has no shader or buffers of its own. Instead, every flush appends the
+ * pending vertices and draw calls to a {@link StaticBatch} (see
+ * {@link #getRecording}), which is later replayed on the rendering
+ * thread with {@link #drawRecording}. Because of this, a recorder may
+ * be created and drawn to on any thread.
+ *
+ * A recorder has the same limitations as a static batch. If anything
+ * drawn in a pass uses a gradient, scissor, blur or stencil effect, the
+ * recording for that pass is discarded.
+ * In addition, a recorder may not draw text (see {@link #drawText}).
+ * In deferred mode (see {@link #setDeferred}), each flush is recorded in
+ * sorted order, so the replay merges draw calls just as a deferred
+ * sprite batch would. However, instanced sprites (see
+ * {@link #drawInstances}) are recorded as regular quads.
+ *
+ * @param capacity The vertex capacity of this recorder
+ *
+ * @return true if initialization was successful.
+ */
+bool SpriteBatch::initRecorder(unsigned int capacity) {
+    if (_initialized) {
+        CUAssertLog(false, "SpriteBatch is already initialized");
+        return false; // If asserts are turned off.
+    }
+    
+    _recorder = true;
+    _vertMax = capacity;
+    _vertLocal = new SpriteVertex2[_vertMax];
+    _vertData = _vertLocal;
+    _indxMax = capacity*3;
+    _indxData = new GLuint[_indxMax];
+    
+    // A recorder is always recording
+    _recording = std::make_shared<StaticBatch>();
+    _context = new Context();
+    _context->dirty = DIRTY_ALL_VALS;
+    return true;
+}
+
 
 #pragma mark -
 #pragma mark Attributes
@@ -698,8 +801,10 @@ void SpriteBatch::setGradient(const std::shared_ptr<Gradient>& gradient) {
  * @return The active scissor mask for this sprite batch
  */
 std::shared_ptr<Scissor> SpriteBatch::getScissor() const {
-    if (_scissor != nullptr) {
-        return Scissor::alloc(_scissor);
+    if (_scissored) {
+        std::shared_ptr<Scissor> result = std::make_shared<Scissor>();
+        result->set(_scissor);
+        return result;
     }
     return nullptr;
 }
@@ -720,21 +825,47 @@ std::shared_ptr<Scissor> SpriteBatch::getScissor() const {
  * @param scissor   The active scissor mask for this sprite batch
  */
 void SpriteBatch::setScissor(const std::shared_ptr<Scissor>& scissor) {
-    if (scissor == _scissor) {
-        return;
-    }
-    
-    if (_inflight) { record(); }
-    if (scissor == nullptr) {
-        // Active gradient is not null
-        _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
-        _context->type = _context->type & ~TYPE_SCISSOR;
-        _scissor = nullptr;
-    } else {
-        _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
-        _context->type = _context->type | TYPE_SCISSOR;
-        _scissor = Scissor::alloc(scissor);
+    applyScissor(scissor.get());
+}
+
+/**
+ * Pushes a scissor mask onto the scissor stack of this sprite batch
+ *
+ * The new active scissor mask is the given mask, transformed by the
+ * given matrix and intersected with the current scissor mask (if any).
+ * The previous mask is restored by a matching call to {@link #popScissor}.
+ * This is the preferred way for a scene graph to nest scissors, as it
+ * does not allocate any scissor objects on the heap. In addition, if
+ * the new mask is the same as the current one (such as when a child
+ * scissor contains its parent), the drawing state is left unchanged.
+ *
+ * Every call to this method must be matched by a call to
+ * {@link #popScissor} before the end of the drawing pass.
+ *
+ * @param mask      The scissor mask to push
+ * @param transform The transform to apply to the scissor mask
+ */
+void SpriteBatch::pushScissor(const Scissor& mask, const Affine2& transform) {
+    _scissorStack.emplace_back(_scissored, _scissor);
+    Scissor local(mask);
+    local.multiply(transform);
+    if (_scissored) {
+        local.intersect(_scissor);
     }
+    applyScissor(&local);
+}
+
+/**
+ * Restores the scissor mask active before the last {@link #pushScissor}
+ *
+ * The drawing state is only changed if the restored mask differs from
+ * the current one.
+ */
+void SpriteBatch::popScissor() {
+    CUAssertLog(!_scissorStack.empty(), "Scissor stack is empty");
+    const std::pair<bool,Scissor>& saved = _scissorStack.back();
+    applyScissor(saved.first ? &saved.second : nullptr);
+    _scissorStack.pop_back();
 }
 
 /**
@@ -941,6 +1072,104 @@ float SpriteBatch::getDepth() const {
     return _context->zDepth;
 }
 
+/**
+ * Sets whether this sprite batch sorts its draw calls before flushing.
+ *
+ * In deferred mode, the shapes drawn since the last flush are not drawn
+ * in the order submitted. Instead, every change of drawing state gets a
+ * sort key built from the layer, texture, blend state and drawing type.
+ * These keys are radix sorted and all shapes with the same key are merged
+ * into a single draw call. So interleaving two textures no longer costs
+ * a draw call for every switch.
+ *
+ * Shapes on the same layer may be drawn in any order, so use
+ * {@link #setLayer} to keep overlapping shapes in order. Draw calls with
+ * a gradient, scissor, blur or stencil effect cannot be reordered. If
+ * any such call is pending, the flush happens in submission order.
+ *
+ * Changing this value will cause the sprite batch to flush. This mode
+ * is off by default.
+ *
+ * @param deferred  Whether this sprite batch sorts its draw calls
+ */
+void SpriteBatch::setDeferred(bool deferred) {
+    if (_deferred != deferred) {
+        if (_active) { flush(); }
+        _deferred = deferred;
+    }
+}
+
+/**
+ * Sets the current layer of this sprite batch.
+ *
+ * The layer is only used in deferred mode (see {@link #setDeferred}).
+ * Shapes on a lower layer are always drawn before shapes on a higher
+ * layer. Shapes on the same layer are sorted to minimize draw calls.
+ * Only the lower 24 bits of the layer are used.
+ *
+ * The layer is reset to 0 at the end of each pass.
+ *
+ * @param layer The current layer of this sprite batch
+ */
+void SpriteBatch::setLayer(Uint32 layer) {
+    if (_context->layer != layer) {
+        // The layer is not a uniform, so it only splits the context if sorting
+        if (_inflight && _deferred) { record(); }
+        _context->layer = layer;
+    }
+}
+
+/**
+ * Returns the current layer of this sprite batch.
+ *
+ * The layer is only used in deferred mode (see {@link #setDeferred}).
+ * Shapes on a lower layer are always drawn before shapes on a higher
+ * layer. Shapes on the same layer are sorted to minimize draw calls.
+ * Only the lower 24 bits of the layer are used.
+ *
+ * @return the current layer of this sprite batch
+ */
+Uint32 SpriteBatch::getLayer() const {
+    return _context->layer;
+}
+
+/**
+ * Sets whether this sprite batch writes vertices directly to the GPU.
+ *
+ * By default, vertices are assembled in a CPU array and uploaded with
+ * glBufferData on every flush. That is an extra copy, and the driver
+ * may stall while it reallocates a buffer still in use. When streaming,
+ * the vertex buffer is a ring of segments (see {@link VertexBuffer#setupStream}),
+ * and the vertices are written straight into a mapped segment as they are
+ * drawn. A segment is only mapped once there is something to draw, and it
+ * is unmapped at the next flush. The ring starts with {@link STREAM_MIN_SEGMENTS}
+ * segments and grows at the end of a pass so that it can hold the flushes
+ * of {@link STREAM_FRAMES} frames, up to {@link STREAM_MAX_SEGMENTS}.
+ *
+ * If the stream cannot be set up or mapped, the sprite batch logs an
+ * error and falls back to the CPU array. Vertices are also assembled in
+ * the CPU array while recording a static batch, as the recording must
+ * read them back.
+ *
+ * Changing this value will cause the sprite batch to flush. This mode
+ * is off by default, and should stay off unless profiling shows that the
+ * uploads are a bottleneck.
+ *
+ * @param stream    Whether this sprite batch writes vertices directly to the GPU
+ */
+void SpriteBatch::setStreaming(bool stream) {
+    if (_streaming != stream) {
+        if (_active) {
+            flush();
+            unmapVertices();
+        }
+        _streaming = stream;
+        if (_active && !_streaming && _vertbuff->isStreaming()) {
+            _vertbuff->releaseStream();
+        }
+    }
+}
+
 /**
  * Sets the blur radius in pixels (0 if there is no blurring).
  *
@@ -1004,6 +1233,56 @@ GLfloat SpriteBatch::getBlur() const {
     return _context->blur;
 }
 
+/**
+ * Sets whether the active texture is a signed distance field.
+ *
+ * A distance field texture stores the distance to the nearest edge
+ * in its alpha channel, with the edge at 0.5. The shader turns this
+ * into coverage with a smooth step one screen pixel wide, so that
+ * glyphs stay sharp at any scale or rotation. This is the format
+ * of a {@link Font} atlas when {@link Font#isDistanceField} is true,
+ * and the text drawing methods set this value automatically.
+ *
+ * This setting is compatible with {@link #setBlur}, which widens the
+ * smooth step instead of sampling the texture several times. This
+ * value is false by default.
+ *
+ * @param value Whether the active texture is a signed distance field
+ */
+void SpriteBatch::setDistanceField(bool value) {
+    if (isDistanceField() == value) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE;
+    if (value) {
+        _context->type = _context->type | TYPE_DISTANCE;
+    } else {
+        _context->type = _context->type & ~TYPE_DISTANCE;
+    }
+}
+
+/**
+ * Returns true if the active texture is a signed distance field.
+ *
+ * A distance field texture stores the distance to the nearest edge
+ * in its alpha channel, with the edge at 0.5. The shader turns this
+ * into coverage with a smooth step one screen pixel wide, so that
+ * glyphs stay sharp at any scale or rotation. This is the format
+ * of a {@link Font} atlas when {@link Font#isDistanceField} is true,
+ * and the text drawing methods set this value automatically.
+ *
+ * This setting is compatible with {@link #setBlur}, which widens the
+ * smooth step instead of sampling the texture several times. This
+ * value is false by default.
+ *
+ * @return true if the active texture is a signed distance field
+ */
+bool SpriteBatch::isDistanceField() const {
+    return (_context->type & TYPE_DISTANCE) != 0;
+}
+
 /**
  * Sets the current stencil effect
  *
@@ -1090,6 +1369,16 @@ void SpriteBatch::clearHalfStencil(bool lower) {
  * Calling this method will reset the vertex and OpenGL call counters to 0.
  */
 void SpriteBatch::begin() {
+    if (_recorder) {
+        _recording->dispose();
+        _recording->_valid = true;
+        _recording->_perspective = *(_context->perspective);
+        _active = true;
+        _callTotal = 0;
+        _vertTotal = 0;
+        return;
+    }
+    
     glDisable(GL_CULL_FACE);
     glDepthMask(true);
     glEnable(GL_BLEND);
@@ -1099,9 +1388,14 @@ void SpriteBatch::begin() {
     _vertbuff->bind();
     _unifbuff->bind(false);
     _unifbuff->deactivate();
+    if (!_streaming && _vertbuff->isStreaming()) {
+        _vertbuff->releaseStream();
+    }
     _active = true;
     _callTotal = 0;
     _vertTotal = 0;
+    _streamFlushes = 0;
+    _cmdsource = nullptr;
 }
 
 /**
@@ -1112,9 +1406,21 @@ void SpriteBatch::begin() {
  */
 void SpriteBatch::end() {
     CUAssertLog(_active,"SpriteBatch is not active");
+    CUAssertLog(_scissorStack.empty(),"Unbalanced calls to pushScissor");
     flush();
+    unmapVertices();
+    if (_streaming) {
+        // Size the ring so that a full frame of flushes never waits on a fence
+        GLuint segments = std::min((GLuint)STREAM_MAX_SEGMENTS, _streamFlushes*STREAM_FRAMES);
+        _streamSegments = std::max(_streamSegments, segments);
+    }
+    _scissorStack.clear();
     _context->reset();
     _context->dirty = DIRTY_ALL_VALS;
+    if (_recorder) {
+        _active = false;
+        return;
+    }
 
     // Undo any active stencil effects
     glDisable(GL_STENCIL_TEST);
@@ -1144,8 +1450,33 @@ void SpriteBatch::flush() {
         record();
     }
     
+    if (_recording != nullptr) {
+        capture();
+    }
+    
+    if (_recorder) {
+        // Everything was captured, so there is nothing to draw
+        _vertTotal += _indxSize;
+        _vertSize = _indxSize = 0;
+        unwind();
+        _context->first = 0;
+        _context->last  = 0;
+        _context->blockptr = -1;
+        return;
+    }
+    
+    if (_deferred && flushSorted()) {
+        return;
+    }
+    
     // Load all the vertex data at once
-    _vertbuff->loadVertexData(_vertData, _vertSize);
+    if (_vertData != _vertLocal) {
+        _vertbuff->unmapStream(_vertSize);
+        _vertData = _vertLocal;
+        _streamFlushes++;
+    } else {
+        _vertbuff->loadVertexData(_vertData, _vertSize);
+    }
     _vertbuff->loadIndexData(_indxData, _indxSize);
     _unifbuff->activate();
     _unifbuff->flush();
@@ -1209,6 +1540,230 @@ void SpriteBatch::flush() {
     _context->blockptr = -1;
 }
 
+#pragma mark -
+#pragma mark Static Batching
+/**
+ * Starts recording a static batch.
+ *
+ * This method flushes the sprite batch. Everything drawn from now until
+ * the call to {@link #endStatic} is still drawn as normal, but it is also
+ * copied into a {@link StaticBatch}. That batch can be replayed in later
+ * passes with {@link #drawStatic} for the cost of one draw call per
+ * texture (or blend) change.
+ *
+ * Recordings cannot be nested, and this method may only be called while
+ * the sprite batch is drawing.
+ */
+void SpriteBatch::beginStatic() {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    CUAssertLog(_recording == nullptr, "A static batch is already being recorded");
+    flush();
+    _recording = std::make_shared<StaticBatch>();
+    _recording->_perspective = *(_context->perspective);
+    
+    // The recording reads the vertices back, so they cannot be streamed
+    unmapVertices();
+}
+
+/**
+ * Completes the recording of a static batch.
+ *
+ * This method flushes the sprite batch and uploads the recorded vertices
+ * to a retained {@link VertexBuffer}. If the recording was empty, or it
+ * used a gradient, scissor, blur or stencil effect, this method returns
+ * nullptr. The recorded shapes are drawn either way.
+ *
+ * @return the recorded static batch (or nullptr if it could not be retained)
+ */
+std::shared_ptr<StaticBatch> SpriteBatch::endStatic() {
+    CUAssertLog(_recording != nullptr, "No static batch is being recorded");
+    flush();
+    std::shared_ptr<StaticBatch> result = _recording;
+    _recording = nullptr;
+    if (!result->_valid || result->_indices.empty()) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<VertexBuffer> vertbuff = allocSegmentBuffer();
+    vertbuff->loadVertexData(result->_vertices.data(), (GLsizei)result->_vertices.size(), GL_STATIC_DRAW);
+    vertbuff->loadIndexData(result->_indices.data(), (GLsizei)result->_indices.size(), GL_STATIC_DRAW);
+    
+    // The CPU copy is no longer needed
+    result->_vertbuff = vertbuff;
+    result->_indxSize = (GLuint)result->_indices.size();
+    std::vector<SpriteVertex2>().swap(result->_vertices);
+    std::vector<GLuint>().swap(result->_indices);
+    
+    _vertbuff->bind();
+    return result;
+}
+
+/**
+ * Draws a static batch with the given transform.
+ *
+ * The transform is applied on top of the transforms in effect when the
+ * batch was recorded. So the identity transform redraws the batch exactly
+ * where it was recorded. The batch is drawn with the current perspective
+ * matrix. Any other state of this sprite batch (such as color, gradient,
+ * or scissor) is ignored.
+ *
+ * This method flushes the sprite batch, and may only be called while
+ * the sprite batch is drawing.
+ *
+ * @param batch     The static batch to draw
+ * @param transform The transform to apply to the recorded vertices
+ */
+void SpriteBatch::drawStatic(const std::shared_ptr<StaticBatch>& batch, const Affine2& transform) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    CUAssertLog(_recording == nullptr, "Cannot draw a static batch while recording");
+    CUAssertLog(batch != nullptr && batch->_vertbuff != nullptr, "Static batch is incomplete");
+    flush();
+    
+    Mat4 matrix(transform);
+    matrix = matrix*(*(_context->perspective));
+    drawSegments(batch.get(), batch->_vertbuff, matrix, 0, batch->_segments.size());
+}
+
+#pragma mark -
+#pragma mark Command Recording
+/**
+ * Returns the commands recorded in the last pass of this recorder.
+ *
+ * The recording is reused by the next pass, so it must be replayed
+ * (with {@link #drawRecording}) before this recorder begins again. This
+ * method returns nullptr if this sprite batch is not a recorder, or if
+ * the last pass used a gradient, scissor, blur or stencil effect.
+ *
+ * @return the commands recorded in the last pass of this recorder.
+ */
+std::shared_ptr<StaticBatch> SpriteBatch::getRecording() const {
+    if (_recorder && _recording->_valid) {
+        return _recording;
+    }
+    return nullptr;
+}
+
+/**
+ * Returns the number of draw calls recorded so far in this pass.
+ *
+ * This method flushes the recorder, and marks the current end of the
+ * recording. Draw calls recorded after the mark are never merged with
+ * those before it. So the recording can be replayed in pieces (with
+ * {@link #drawRecording}), and something else drawn in between.
+ *
+ * This method may only be called on a recorder that is drawing.
+ *
+ * @return the number of draw calls recorded so far in this pass.
+ */
+size_t SpriteBatch::markRecording() {
+    CUAssertLog(_recorder && _active, "Only an active recorder can be marked");
+    flush();
+    _recording->_sealed = _recording->_segments.size();
+    return _recording->_sealed;
+}
+
+/**
+ * Draws a range of the commands recorded by a command recorder.
+ *
+ * This method draws the draw calls in the range [first,last) of the
+ * recording. The range boundaries should come from {@link #markRecording},
+ * so that no draw call spans them. The recorded vertices are only
+ * uploaded the first time a recording is drawn in a pass, so drawing a
+ * recording in several pieces costs no more than drawing it at once.
+ *
+ * This method flushes the sprite batch, and may only be called while
+ * the sprite batch is drawing. It may not be called on a recorder.
+ *
+ * @param recording The recorded commands to draw
+ * @param first     The first draw call to replay
+ * @param last      The draw call after the last one to replay
+ */
+void SpriteBatch::drawRecording(const std::shared_ptr<StaticBatch>& recording, size_t first, size_t last) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    CUAssertLog(!_recorder, "Cannot draw a recording with a recorder");
+    CUAssertLog(_recording == nullptr, "Cannot draw a recording while recording");
+    if (recording == nullptr || recording->_indices.empty() || first >= last) {
+        return;
+    }
+    CUAssertLog(last <= recording->_segments.size(), "Draw call %zu is out of range", last);
+    flush();
+    
+    if (_cmdbuff == nullptr) {
+        _cmdbuff = allocSegmentBuffer();
+        _cmdsource = nullptr;
+    } else {
+        _cmdbuff->attach(_shader);
+    }
+    if (_cmdsource != recording.get()) {
+        _cmdbuff->loadVertexData(recording->_vertices.data(), (GLsizei)recording->_vertices.size());
+        _cmdbuff->loadIndexData(recording->_indices.data(), (GLsizei)recording->_indices.size());
+        _cmdsource = recording.get();
+    }
+    drawSegments(recording.get(), _cmdbuff, *(_context->perspective), first, last);
+}
+
+/**
+ * Returns a vertex buffer for retained or recorded vertices.
+ *
+ * The vertex buffer has the same layout as the main one, and is
+ * attached to the shader of this sprite batch.
+ *
+ * @return a vertex buffer for retained or recorded vertices.
+ */
+std::shared_ptr<VertexBuffer> SpriteBatch::allocSegmentBuffer() {
+    std::shared_ptr<VertexBuffer> vertbuff = VertexBuffer::alloc(sizeof(SpriteVertex2));
+    vertbuff->setupAttribute("aPosition", 2, GL_FLOAT, GL_FALSE,
+                             offsetof(cugl::SpriteVertex2,position));
+    vertbuff->setupAttribute("aColor",    4, GL_UNSIGNED_BYTE, GL_TRUE,
+                             offsetof(cugl::SpriteVertex2,color));
+    vertbuff->setupAttribute("aTexCoord", 2, GL_FLOAT, GL_FALSE,
+                             offsetof(cugl::SpriteVertex2,texcoord));
+    vertbuff->setupAttribute("aGradCoord",2, GL_FLOAT, GL_FALSE,
+                             offsetof(cugl::SpriteVertex2,gradcoord));
+    vertbuff->attach(_shader);
+    return vertbuff;
+}
+
+/**
+ * Draws the segments of a static batch from the given vertex buffer.
+ *
+ * Only the segments in the range [first,last) are drawn. The vertex
+ * buffer must already hold the vertices and indices of the static
+ * batch. This method restores the main vertex buffer when done.
+ *
+ * @param batch         The static batch to draw
+ * @param buffer        The vertex buffer with the batch data
+ * @param perspective   The perspective matrix for the segments
+ * @param first         The first segment to draw
+ * @param last          The segment after the last one to draw
+ */
+void SpriteBatch::drawSegments(const StaticBatch* batch, const std::shared_ptr<VertexBuffer>& buffer,
+                               const Mat4& perspective, size_t first, size_t last) {
+    buffer->attach(_shader);
+    _shader->setUniformMat4("uPerspective",perspective);
+    auto end = batch->_segments.begin()+last;
+    for(auto it = batch->_segments.begin()+first; it != end; ++it) {
+        glBlendEquation(it->blendEq);
+        if (it->srcRGB != it->srcAlpha || it->dstRGB != it->dstAlpha ) {
+            glBlendFuncSeparate(it->srcRGB, it->srcAlpha, it->dstRGB, it->dstAlpha);
+        } else {
+            glBlendFunc(it->srcRGB, it->dstRGB);
+        }
+        _shader->setUniform1i("uType", it->type);
+        if (it->texture != nullptr) {
+            it->texture->bind();
+        }
+        buffer->draw(it->command, it->count, it->first);
+        _callTotal++;
+        _vertTotal += it->count;
+    }
+    
+    // Restore our own pipeline for the next flush
+    _vertbuff->bind();
+    _context->dirty = _context->dirty | DIRTY_BLENDEQUATION | DIRTY_SRC_FUNCTION | DIRTY_DST_FUNCTION;
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE | DIRTY_PERSPECTIVE | DIRTY_TEXTURE;
+}
+
 
 #pragma mark -
 #pragma mark Solid Shapes
@@ -2444,6 +2999,110 @@ void SpriteBatch::drawMesh(const SpriteVertex2* vertices, size_t size, const Aff
     }
 }
 
+#pragma mark -
+#pragma mark Instanced Drawing
+/**
+ * Draws many copies of a textured quad with a single draw call.
+ *
+ * This method is intended for large sets of identical sprites, such as
+ * projectiles or tiles. Each {@link SpriteInstance} has its own position,
+ * scale, rotation, color and texture region. The quads are built on the
+ * GPU by an instanced vertex shader, so the CPU only uploads 40 bytes per
+ * sprite instead of four full vertices and six indices.
+ *
+ * The texture regions are in the coordinates of the root texture (as with
+ * {@link Texture#getSubTexture}). Each quad is the size of its region
+ * times its scale, and is positioned and rotated about the given anchor.
+ * The anchor is relative to the size of the quad, so the default places
+ * each instance position at the center of its sprite.
+ *
+ * The instances use their own colors, and ignore the active color. They
+ * use the current perspective, blending and stencil state. However, the
+ * instanced shader does not support gradients, scissors or blurs. If any
+ * of these are active (or a static batch is being recorded), the sprites
+ * are drawn as regular quads instead. In that case the texture becomes
+ * the active texture, just as with the other draw methods.
+ *
+ * This method flushes the sprite batch, and may only be called while
+ * the sprite batch is drawing.
+ *
+ * @param texture   The texture for every sprite
+ * @param instances The sprite instances
+ * @param size      The number of sprite instances
+ * @param anchor    The anchor of each sprite, relative to its size
+ */
+void SpriteBatch::drawInstances(const std::shared_ptr<Texture>& texture, const SpriteInstance* instances,
+                                size_t size, const Vec2 anchor) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    CUAssertLog(texture != nullptr, "Instanced sprites require a texture");
+    if (size == 0) {
+        return;
+    }
+    
+    // Texture regions are relative to the root texture
+    Vec2 tsize(texture->getWidth()/(texture->getMaxS()-texture->getMinS()),
+               texture->getHeight()/(texture->getMaxT()-texture->getMinT()));
+    
+    if (_gradient != nullptr || _scissored || _context->blur != 0 ||
+        (_context->type & TYPE_DISTANCE) || _recording != nullptr || (_instBuffer == nullptr && !initInstancing())) {
+        // Build the same quads as the shader on the CPU
+        setTexture(texture);
+        setCommand(GL_TRIANGLES);
+        SpriteVertex2 quad[4];
+        for(size_t ii = 0; ii < size; ii++) {
+            const SpriteInstance& inst = instances[ii];
+            Vec2 extent(std::abs(inst.texrect.z-inst.texrect.x)*tsize.x*inst.scale.x,
+                        std::abs(inst.texrect.w-inst.texrect.y)*tsize.y*inst.scale.y);
+            float c = cosf(inst.angle);
+            float s = sinf(inst.angle);
+            for(int kk = 0; kk < 4; kk++) {
+                float cx = (kk == 1 || kk == 2) ? 1.0f : 0.0f;
+                float cy = (kk >= 2) ? 1.0f : 0.0f;
+                float lx = (cx-anchor.x)*extent.x;
+                float ly = (cy-anchor.y)*extent.y;
+                quad[kk].position.set(c*lx-s*ly+inst.position.x, s*lx+c*ly+inst.position.y);
+                quad[kk].color = inst.color;
+                quad[kk].texcoord.set(inst.texrect.x+cx*(inst.texrect.z-inst.texrect.x),
+                                      inst.texrect.w+cy*(inst.texrect.y-inst.texrect.w));
+                quad[kk].gradcoord.set(cx,cy);
+            }
+            prepare(quad,4,Affine2::IDENTITY,false);
+        }
+        return;
+    }
+    
+    flush();
+    _instBuffer->attach(_instShader);
+    _instShader->setUniformMat4("uPerspective",*(_context->perspective));
+    _instShader->setUniformVec2("uTexSize",tsize);
+    _instShader->setUniformVec2("uAnchor",anchor);
+    _instShader->setUniform1i("uType",TYPE_TEXTURE);
+    glBlendEquation(_context->blendEq);
+    if (_context->srcRGB != _context->srcAlpha || _context->dstRGB != _context->dstAlpha ) {
+        glBlendFuncSeparate(_context->srcRGB, _context->srcAlpha, _context->dstRGB, _context->dstAlpha);
+    } else {
+        glBlendFunc(_context->srcRGB, _context->dstRGB);
+    }
+    if (texture->getBindPoint()) {
+        texture->setBindPoint(0);
+    }
+    texture->bind();
+    
+    // The instance buffer has the same capacity as the vertex buffer
+    for(size_t ii = 0; ii < size; ii += _vertMax) {
+        GLsizei amt = (GLsizei)std::min((size_t)_vertMax,size-ii);
+        _instBuffer->loadVertexData(instances+ii, amt);
+        _instBuffer->drawInstanced(GL_TRIANGLES, 6, amt);
+        _callTotal++;
+        _vertTotal += 6*amt;
+    }
+    
+    // Restore our own pipeline for the next flush
+    _vertbuff->bind();
+    _context->dirty = _context->dirty | DIRTY_BLENDEQUATION | DIRTY_SRC_FUNCTION | DIRTY_DST_FUNCTION;
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE | DIRTY_PERSPECTIVE | DIRTY_TEXTURE;
+}
+
 #pragma mark -
 #pragma mark Text Drawing
 /**
@@ -2460,17 +3119,24 @@ void SpriteBatch::drawMesh(const SpriteVertex2* vertices, size_t size, const Aff
  * If depth testing is on, the font glyphs will use the current sprite
  * batch depth.
  *
+ * This method may not be called on a command recorder, as a font may
+ * need to add glyphs to its atlases (which creates OpenGL textures).
+ *
  * @param text      The text to display
  * @param font      The font to render the text
  * @param position  The left edge of the text baseline
  */
 void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>& font, const Vec2 position) {
+    CUAssertLog(!_recorder, "Text may only be drawn on the main thread");
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     font->getGlyphs(runs, text, position);
+    bool field = isDistanceField();
+    setDistanceField(font->isDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,Vec2::ZERO);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2487,18 +3153,25 @@ void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>&
  * If depth testing is on, the font glyphs will use the current sprite
  * batch depth.
  *
+ * This method may not be called on a command recorder, as a font may
+ * need to add glyphs to its atlases (which creates OpenGL textures).
+ *
  * @param text      The text to display
  * @param font      The font to render the text
  * @param origin    The rotational origin relative to the baseline
  * @param transform The coordinate transform
  */
 void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>& font, const Vec2 origin, const Affine2& transform) {
+    CUAssertLog(!_recorder, "Text may only be drawn on the main thread");
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     font->getGlyphs(runs, text, -origin);
+    bool field = isDistanceField();
+    setDistanceField(font->isDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,transform);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2514,18 +3187,25 @@ void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>&
  * If depth testing is on, the font glyphs will use the current sprite
  * batch depth.
  *
+ * This method may not be called on a command recorder, as a font may
+ * need to add glyphs to its atlases (which creates OpenGL textures).
+ *
  * @param text      The text to display
  * @param font      The font to render the text
  * @param origin    The rotational origin relative to the baseline
  * @param transform The coordinate transform
  */
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Vec2 position) {
+    CUAssertLog(!_recorder, "Text may only be drawn on the main thread");
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     text->getGlyphs(runs);
+    bool field = isDistanceField();
+    setDistanceField(text->getFont() != nullptr && text->getFont()->isDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,position);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2540,22 +3220,77 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Vec2 p
  * If depth testing is on, the font glyphs will use the current sprite
  * batch depth.
  *
+ * This method may not be called on a command recorder, as a font may
+ * need to add glyphs to its atlases (which creates OpenGL textures).
+ *
  * @param text      The text to display
  * @param font      The font to render the text
  * @param origin    The rotational origin relative to the baseline
  * @param transform The coordinate transform
  */
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Affine2& transform) {
+    CUAssertLog(!_recorder, "Text may only be drawn on the main thread");
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     text->getGlyphs(runs);
+    bool field = isDistanceField();
+    setDistanceField(text->getFont() != nullptr && text->getFont()->isDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,transform);
     }
+    setDistanceField(field);
 }
 
 #pragma mark -
 #pragma mark Internal Helpers
+/**
+ * Sorts the given order on the given keys, using a stable LSD radix sort.
+ *
+ * The keys are sorted 8 bits at a time. Any digit that is the same for
+ * every key is skipped, which is most of them in a typical flush.
+ *
+ * @param keys      The sort key of each entry
+ * @param order     The entries to sort (modified in place)
+ * @param scratch   The scratch space for the sort
+ */
+static void radix_sort(const std::vector<Uint64>& keys, std::vector<Uint32>& order,
+                       std::vector<Uint32>& scratch) {
+    size_t size = order.size();
+    if (size < 2) {
+        return;
+    }
+    
+    Uint64 diff = 0;
+    for(size_t ii = 1; ii < size; ii++) {
+        diff |= keys[ii] ^ keys[0];
+    }
+    
+    Uint32 counts[256];
+    scratch.resize(size);
+    for(int shift = 0; shift < 64; shift += 8) {
+        if (((diff >> shift) & 0xFF) == 0) {
+            continue;
+        }
+        for(int jj = 0; jj < 256; jj++) {
+            counts[jj] = 0;
+        }
+        for(size_t ii = 0; ii < size; ii++) {
+            counts[(keys[order[ii]] >> shift) & 0xFF]++;
+        }
+        Uint32 total = 0;
+        for(int jj = 0; jj < 256; jj++) {
+            Uint32 count = counts[jj];
+            counts[jj] = total;
+            total += count;
+        }
+        for(size_t ii = 0; ii < size; ii++) {
+            Uint32 pos = order[ii];
+            scratch[counts[(keys[pos] >> shift) & 0xFF]++] = pos;
+        }
+        order.swap(scratch);
+    }
+}
+
 /**
  * Records the current set of uniforms, freezing them.
  *
@@ -2584,6 +3319,344 @@ void SpriteBatch::unwind() {
     _history.clear();
 }
 
+/**
+ * Flushes the current mesh in sorted order, returning true on success.
+ *
+ * This method is called by {@link #flush} in deferred mode. It sorts the
+ * recorded contexts and merges all contexts with the same sort key into
+ * a single draw call. If any recorded context uses state that cannot be
+ * reordered, this method does nothing and returns false.
+ *
+ * @return true if the mesh was flushed
+ */
+bool SpriteBatch::flushSorted() {
+    if (!sortHistory()) {
+        return false;
+    }
+    size_t size = _history.size();
+    Context* first = _history.front();
+    
+    // Rearrange the indices so that equal keys are contiguous
+    _sortIndx.resize(_indxSize);
+    GLuint offset = 0;
+    for(auto it = _sortOrder.begin(); it != _sortOrder.end(); ++it) {
+        Context* next = _history[*it];
+        GLuint amt = next->last-next->first;
+        std::memcpy(_sortIndx.data()+offset, _indxData+next->first, amt*sizeof(GLuint));
+        offset += amt;
+    }
+    
+    if (_vertData != _vertLocal) {
+        _vertbuff->unmapStream(_vertSize);
+        _vertData = _vertLocal;
+        _streamFlushes++;
+    } else {
+        _vertbuff->loadVertexData(_vertData, _vertSize);
+    }
+    _vertbuff->loadIndexData(_sortIndx.data(), _indxSize);
+    _shader->setUniformMat4("uPerspective",*(first->perspective.get()));
+    
+    // Draw each run of equal keys at once
+    Context* prev = nullptr;
+    GLuint start = 0;
+    GLuint amt = 0;
+    for(size_t ii = 0; ii < size; ii++) {
+        Uint32 pos = _sortOrder[ii];
+        Context* next = _history[pos];
+        amt += next->last-next->first;
+        if (ii+1 < size && _sortKeys[_sortOrder[ii+1]] == _sortKeys[pos]) {
+            continue;
+        } else if (amt == 0) {
+            continue;
+        }
+        
+        if (prev == nullptr || prev->blendEq != next->blendEq) {
+            glBlendEquation(next->blendEq);
+        }
+        if (prev == nullptr || prev->srcRGB != next->srcRGB || prev->srcAlpha != next->srcAlpha ||
+            prev->dstRGB != next->dstRGB || prev->dstAlpha != next->dstAlpha) {
+            if (next->srcRGB != next->srcAlpha || next->dstRGB != next->dstAlpha ) {
+                glBlendFuncSeparate(next->srcRGB, next->srcAlpha, next->dstRGB, next->dstAlpha);
+            } else {
+                glBlendFunc(next->srcRGB, next->dstRGB);
+            }
+        }
+        if (prev == nullptr || prev->type != next->type) {
+            _shader->setUniform1i("uType", next->type);
+        }
+        if (next->type & TYPE_TEXTURE && next->texture != nullptr) {
+            next->texture->bind();
+        }
+        _vertbuff->draw(next->command, amt, start);
+        _callTotal++;
+        
+        prev = next;
+        start += amt;
+        amt = 0;
+    }
+
+    // Increment the counters
+    _vertTotal += _indxSize;
+    
+    _vertSize = _indxSize = 0;
+    unwind();
+    _context->first = 0;
+    _context->last  = 0;
+    _context->blockptr = -1;
+    
+    // The next flush must restore the state of the active context
+    _context->dirty = _context->dirty | DIRTY_BLENDEQUATION | DIRTY_SRC_FUNCTION | DIRTY_DST_FUNCTION;
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE | DIRTY_PERSPECTIVE | DIRTY_TEXTURE;
+    return true;
+}
+
+/**
+ * Sorts the recorded contexts, returning true on success.
+ *
+ * The contexts are sorted by layer, texture, blend state and command.
+ * The sorted order is stored in _sortOrder, with the keys in _sortKeys.
+ * If any recorded context uses state that cannot be reordered, this
+ * method returns false.
+ *
+ * @return true if the recorded contexts were sorted
+ */
+bool SpriteBatch::sortHistory() {
+    // Key layout: layer (24) | texture (24) | blend (8) | command (4) | type (4)
+    size_t size = _history.size();
+    Context* first = _history.front();
+    _sortKeys.resize(size);
+    _sortOrder.resize(size);
+    _sortBlends.clear();
+    for(size_t ii = 0; ii < size; ii++) {
+        Context* next = _history[ii];
+        if (next->type & ~TYPE_TEXTURE || next->stencil != StencilEffect::NATIVE ||
+            next->cleared != STENCIL_NONE ||
+            (next->perspective != first->perspective && *(next->perspective) != *(first->perspective))) {
+            return false;
+        }
+        
+        Uint64 blend = 0;
+        while (blend < _sortBlends.size()) {
+            Context* prev = _sortBlends[blend];
+            if (prev->blendEq == next->blendEq &&
+                prev->srcRGB == next->srcRGB && prev->srcAlpha == next->srcAlpha &&
+                prev->dstRGB == next->dstRGB && prev->dstAlpha == next->dstAlpha) {
+                break;
+            }
+            blend++;
+        }
+        if (blend == _sortBlends.size()) {
+            if (blend == 256) {
+                return false;
+            }
+            _sortBlends.push_back(next);
+        }
+        
+        Uint64 texture = 0;
+        if (next->type & TYPE_TEXTURE && next->texture != nullptr) {
+            texture = next->texture->getBuffer();
+        }
+        _sortKeys[ii] = ((Uint64)(next->layer & 0xFFFFFF) << 40) | ((texture & 0xFFFFFF) << 16) |
+                        (blend << 8) | ((next->command & 0xF) << 4) | (next->type & 0xF);
+        _sortOrder[ii] = (Uint32)ii;
+    }
+    radix_sort(_sortKeys, _sortOrder, _sortScratch);
+    return true;
+}
+
+/**
+ * Copies the vertices about to be flushed into the active recording.
+ *
+ * This method is called by {@link #flush} when a static batch is being
+ * recorded. It invalidates the recording if any of the pending draw calls
+ * use state that cannot be retained. In deferred mode, the draw calls
+ * are captured in sorted order, so that a command recorder merges them
+ * just as {@link #flushSorted} would.
+ */
+void SpriteBatch::capture() {
+    StaticBatch* batch = _recording.get();
+    if (!batch->_valid) {
+        return;
+    }
+    
+    bool sorted = _deferred && sortHistory();
+    size_t size = _history.size();
+    GLuint base  = (GLuint)batch->_vertices.size();
+    GLuint start = (GLuint)batch->_indices.size();
+    GLuint offset = 0;
+    for(size_t ii = 0; ii < size; ii++) {
+        Context* next = _history[sorted ? _sortOrder[ii] : ii];
+        if (next->type & (TYPE_GRADIENT | TYPE_SCISSOR | TYPE_GAUSSBLUR | TYPE_DISTANCE) ||
+            next->stencil != StencilEffect::NATIVE || next->cleared != STENCIL_NONE ||
+            *(next->perspective) != batch->_perspective) {
+            batch->dispose();
+            return;
+        } else if (next->last == next->first) {
+            continue;
+        }
+        
+        // Merge with the previous draw call if nothing changed in between
+        GLuint first = start+offset;
+        GLuint count = next->last-next->first;
+        offset += count;
+        StaticBatch::Segment* prev = nullptr;
+        if (batch->_segments.size() > batch->_sealed) {
+            prev = &(batch->_segments.back());
+        }
+        if (prev != nullptr && prev->first+prev->count == first &&
+            prev->type == next->type && prev->command == next->command &&
+            prev->texture == next->texture && prev->blendEq == next->blendEq &&
+            prev->srcRGB == next->srcRGB && prev->srcAlpha == next->srcAlpha &&
+            prev->dstRGB == next->dstRGB && prev->dstAlpha == next->dstAlpha) {
+            prev->count += count;
+        } else {
+            StaticBatch::Segment segment;
+            segment.first = first;
+            segment.count = count;
+            segment.type  = next->type;
+            segment.command  = next->command;
+            segment.blendEq  = next->blendEq;
+            segment.srcRGB   = next->srcRGB;
+            segment.srcAlpha = next->srcAlpha;
+            segment.dstRGB   = next->dstRGB;
+            segment.dstAlpha = next->dstAlpha;
+            segment.texture  = next->texture;
+            batch->_segments.push_back(segment);
+        }
+    }
+    
+    batch->_vertices.insert(batch->_vertices.end(), _vertData, _vertData+_vertSize);
+    batch->_indices.reserve(start+_indxSize);
+    for(size_t ii = 0; ii < size; ii++) {
+        Context* next = _history[sorted ? _sortOrder[ii] : ii];
+        for(GLuint jj = next->first; jj < next->last; jj++) {
+            batch->_indices.push_back(_indxData[jj]+base);
+        }
+    }
+}
+
+/**
+ * Points the vertex mesh at the next segment of the vertex stream.
+ *
+ * This method does nothing unless this sprite batch is streaming and the
+ * vertex mesh is empty and unmapped. Hence it is safe to call it before
+ * every write to the vertex mesh; only the first write after a flush will
+ * map a segment. If the ring is smaller than the size requested at the end
+ * of the last pass, it is reallocated first.
+ *
+ * Vertices are never streamed while recording a static batch, as the
+ * recording must read them back.
+ */
+void SpriteBatch::mapVertices() {
+    if (!_streaming || _recorder || _recording != nullptr) {
+        return;
+    } else if (_vertData != _vertLocal || _vertSize > 0) {
+        return;
+    }
+    
+    if (!_vertbuff->isStreaming() || _vertbuff->getStreamSegments() < _streamSegments) {
+        if (!_vertbuff->setupStream(_vertMax,_streamSegments)) {
+            CULogError("Sprite batch could not stream vertices; using glBufferData instead");
+            _streaming = false;
+            return;
+        }
+    }
+    
+    void* segment = _vertbuff->mapStream();
+    if (segment == nullptr) {
+        CULogError("Sprite batch could not stream vertices; using glBufferData instead");
+        _vertbuff->releaseStream();
+        _streaming = false;
+        return;
+    }
+    _vertData = reinterpret_cast<SpriteVertex2*>(segment);
+}
+
+/**
+ * Points the vertex mesh back at the CPU array.
+ *
+ * If a segment of the vertex stream is mapped, it is unmapped without
+ * flushing any vertices.
+ */
+void SpriteBatch::unmapVertices() {
+    if (_vertData != _vertLocal) {
+        _vertbuff->unmapStream(0);
+        _vertData = _vertLocal;
+    }
+}
+
+/**
+ * Returns true if the instanced sprite pipeline was created.
+ *
+ * The pipeline is created the first time {@link #drawInstances} is called,
+ * so sprite batches that never draw instances pay nothing for it.
+ *
+ * @return true if the instanced sprite pipeline was created.
+ */
+bool SpriteBatch::initInstancing() {
+    _instShader = Shader::alloc(SHADER(oglInstanceVert),SHADER(oglShaderFrag));
+    if (_instShader == nullptr) {
+        CULogError("Sprite batch could not compile the instanced shader");
+        return false;
+    }
+    _instShader->setUniformBlock("uContext",_unifbuff);
+    
+    _instBuffer = VertexBuffer::alloc(sizeof(SpriteInstance));
+    _instBuffer->setupAttribute("iPosition", 2, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::SpriteInstance,position));
+    _instBuffer->setupAttribute("iScale",    2, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::SpriteInstance,scale));
+    _instBuffer->setupAttribute("iAngle",    1, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::SpriteInstance,angle));
+    _instBuffer->setupAttribute("iColor",    4, GL_UNSIGNED_BYTE, GL_TRUE,
+                                offsetof(cugl::SpriteInstance,color));
+    _instBuffer->setupAttribute("iTexRect",  4, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::SpriteInstance,texrect));
+    _instBuffer->setDivisor("iPosition", 1);
+    _instBuffer->setDivisor("iScale",    1);
+    _instBuffer->setDivisor("iAngle",    1);
+    _instBuffer->setDivisor("iColor",    1);
+    _instBuffer->setDivisor("iTexRect",  1);
+    _instBuffer->attach(_instShader);
+    
+    // The quad corners come from gl_VertexID, so only the indices are needed
+    GLuint indices[6] = { 0, 1, 2, 2, 3, 0 };
+    _instBuffer->loadIndexData(indices, 6, GL_STATIC_DRAW);
+    
+    _vertbuff->bind();
+    return true;
+}
+
+/**
+ * Sets the active scissor mask, skipping redundant state changes.
+ *
+ * The mask is copied into the sprite batch. If it is the same as the
+ * active mask, then nothing happens. Otherwise, the drawing context is
+ * marked dirty so the next vertices use the new mask.
+ *
+ * @param mask  The new scissor mask (nullptr for none)
+ */
+void SpriteBatch::applyScissor(const Scissor* mask) {
+    if (mask == nullptr) {
+        if (!_scissored) {
+            return;
+        }
+        if (_inflight) { record(); }
+        _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
+        _context->type = _context->type & ~TYPE_SCISSOR;
+        _scissored = false;
+        return;
+    } else if (_scissored && _scissor == *mask) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
+    _context->type = _context->type | TYPE_SCISSOR;
+    _scissor.set(*mask);
+    _scissored = true;
+}
+
 /**
  * Sets the active uniform block to agree with the gradient and stroke.
  *
@@ -2592,15 +3665,15 @@ void SpriteBatch::unwind() {
  * @param context   The current uniform context
  */
 void SpriteBatch::setUniformBlock(Context* context) {
-    if (!(_context->dirty & DIRTY_UNIBLOCK)) {
+    if (!(_context->dirty & DIRTY_UNIBLOCK) || _recorder) {
         return;
     }
     if (_context->blockptr+1 >= _unifbuff->getBlockCount()) {
         flush();
     }
     float data[40];
-    if (_scissor != nullptr) {
-        _scissor->getData(data);
+    if (_scissored) {
+        _scissor.getData(data);
     } else {
         std::memset(data,0,16*sizeof(float));
     }
@@ -3051,24 +4124,15 @@ unsigned int SpriteBatch::prepare(const Rect rect) {
     }
     
     setUniformBlock(_context);
+    mapVertices();
     Poly2 poly;
     makeRect(poly, rect, _context->command == GL_TRIANGLES);
     unsigned int vstart = _vertSize;
-    int ii = 0;
+    int ii = (int)poly.vertices.size();
     GLuint clr = _color.getPacked();
-    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
-        Vec2 point = *it;
-        _vertData[vstart+ii].position = point;
-        point.x = (point.x-rect.origin.x)/rect.size.width;
-        point.y = 1-(point.y-rect.origin.y)/rect.size.height;
-        _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
-        _vertData[vstart+ii].texcoord.y = point.y*ttmax+(1-point.y)*ttmin;
-        _vertData[vstart+ii].gradcoord.x = point.x+(1-point.x);
-        _vertData[vstart+ii].gradcoord.y = point.y+(1-point.y);
-        _vertData[vstart+ii].color = clr;
-        
-        ii++;
-    }
+    const float texrect[4] = { tsmin, tsmax, ttmin, ttmax };
+    cu_sprite_pack(_vertData+vstart, poly.vertices.data(), ii, Affine2::IDENTITY,
+                   rect.origin, rect.size, texrect, clr);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3120,25 +4184,16 @@ unsigned int SpriteBatch::prepare(const Rect rect, const Affine2& mat) {
     }
     
     setUniformBlock(_context);
+    mapVertices();
     Poly2 poly;
     makeRect(poly, rect, _context->command == GL_TRIANGLES);
 
     unsigned int vstart = _vertSize;
-    int ii = 0;
+    int ii = (int)poly.vertices.size();
     GLuint clr = _color.getPacked();
-    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
-        Vec2 point = *it;
-        _vertData[vstart+ii].position = point*mat;
-        point.x = (point.x-rect.origin.x)/rect.size.width;
-        point.y = 1-(point.y-rect.origin.y)/rect.size.height;
-        _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
-        _vertData[vstart+ii].texcoord.y = point.y*ttmax+(1-point.y)*ttmin;
-        _vertData[vstart+ii].gradcoord.x = point.x+(1-point.x);
-        _vertData[vstart+ii].gradcoord.y = point.y+(1-point.y);
-        _vertData[vstart+ii].color = clr;
-
-        ii++;
-    }
+    const float texrect[4] = { tsmin, tsmax, ttmin, ttmax };
+    cu_sprite_pack(_vertData+vstart, poly.vertices.data(), ii, mat,
+                   rect.origin, rect.size, texrect, clr);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3200,22 +4255,13 @@ unsigned int SpriteBatch::prepare(const Poly2& poly) {
     }
     
     setUniformBlock(_context);
+    mapVertices();
     unsigned int vstart = _vertSize;
-    int ii = 0;
+    int ii = (int)poly.vertices.size();
     GLuint clr = _color.getPacked();
-    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
-        Vec2 point = *it;
-        _vertData[vstart+ii].position = point;
-        point.x /= twidth;
-        point.y = 1-point.y/theight;
-        _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
-        _vertData[vstart+ii].texcoord.y = point.y*ttmax+(1-point.y)*ttmin;
-        _vertData[vstart+ii].gradcoord.x = point.x+(1-point.x);
-        _vertData[vstart+ii].gradcoord.y = point.y+(1-point.y);
-        _vertData[vstart+ii].color = clr;
-
-        ii++;
-    }
+    const float texrect[4] = { tsmin, tsmax, ttmin, ttmax };
+    cu_sprite_pack(_vertData+vstart, poly.vertices.data(), ii, Affine2::IDENTITY,
+                   Vec2::ZERO, Size(twidth,theight), texrect, clr);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3281,22 +4327,13 @@ unsigned int SpriteBatch::prepare(const Poly2& poly, const Vec2 off) {
     }
     
     setUniformBlock(_context);
+    mapVertices();
     unsigned int vstart = _vertSize;
-    int ii = 0;
+    int ii = (int)poly.vertices.size();
     GLuint clr = _color.getPacked();
-    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
-        Vec2 point = *it;
-        _vertData[vstart+ii].position = (*it)+off;
-        point.x /= twidth;
-        point.y = 1-point.y/theight;
-        _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
-        _vertData[vstart+ii].texcoord.y = point.y*ttmax+(1-point.y)*ttmin;
-        _vertData[vstart+ii].gradcoord.x = point.x+(1-point.x);
-        _vertData[vstart+ii].gradcoord.y = point.y+(1-point.y);
-        _vertData[vstart+ii].color = clr;
-
-        ii++;
-    }
+    const float texrect[4] = { tsmin, tsmax, ttmin, ttmax };
+    cu_sprite_pack(_vertData+vstart, poly.vertices.data(), ii, Affine2::createTranslation(off),
+                   Vec2::ZERO, Size(twidth,theight), texrect, clr);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3360,21 +4397,13 @@ unsigned int SpriteBatch::prepare(const Poly2& poly, const Affine2& mat) {
     }
     
     setUniformBlock(_context);
+    mapVertices();
     unsigned int vstart = _vertSize;
-    int ii = 0;
+    int ii = (int)poly.vertices.size();
     GLuint clr = _color.getPacked();
-    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
-        Vec2 point = *it;
-        _vertData[vstart+ii].position = point*mat;
-        point.x /= twidth;
-        point.y = 1-point.y/theight;
-        _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
-        _vertData[vstart+ii].texcoord.y = point.y*ttmax+(1-point.y)*ttmin;
-        _vertData[vstart+ii].gradcoord.x = point.x+(1-point.x);
-        _vertData[vstart+ii].gradcoord.y = point.y+(1-point.y);
-        _vertData[vstart+ii].color = clr;
-        ii++;
-    }
+    const float texrect[4] = { tsmin, tsmax, ttmin, ttmax };
+    cu_sprite_pack(_vertData+vstart, poly.vertices.data(), ii, mat,
+                   Vec2::ZERO, Size(twidth,theight), texrect, clr);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3413,6 +4442,7 @@ unsigned int SpriteBatch::chunkify(const Poly2& poly, const Affine2& mat) {
     const std::vector<Uint32>* indices = &(poly.indices);
     
     setUniformBlock(_context);
+    mapVertices();
     int chunksize = _context->command == GL_TRIANGLES ? 3 : 2;
     unsigned int start = _vertSize;
 
@@ -3438,6 +4468,7 @@ unsigned int SpriteBatch::chunkify(const Poly2& poly, const Affine2& mat) {
     for(int ii = 0;  ii < indices->size(); ii += chunksize) {
         if (_indxSize+chunksize >= _indxMax || _vertSize+chunksize >= _vertMax) {
             flush();
+            mapVertices();
             offsets.clear();
         }
         
@@ -3494,13 +4525,14 @@ unsigned int SpriteBatch::prepare(const Mesh<SpriteVertex2>& mesh, const Affine2
     }
     
     setUniformBlock(_context);
+    mapVertices();
     int ii = 0;
     tint = tint && _color != Color4::WHITE;
+    cu_sprite_transform(_vertData+_vertSize, mesh.vertices.data(), mesh.vertices.size(), mat);
     for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it) {
-        _vertData[_vertSize+ii] = *it;
-        _vertData[_vertSize+ii].position = it->position*mat;
         if (tint) {
-            Uint32 c = marshall(_vertData[_vertSize+ii].color);
+            // Read the source, as the destination may be write-only
+            Uint32 c = marshall(it->color);
             Uint32 r = round(_color.r*((c >> 24)/255.0f));
             Uint32 g = round(_color.g*(((c >> 16) & 0xff)/255.0f));
             Uint32 b = round(_color.b*(((c >> 8) & 0xff)/255.0f));
@@ -3540,12 +4572,14 @@ unsigned int SpriteBatch::chunkify(const Mesh<SpriteVertex2>& mesh, const Affine
     std::unordered_map<Uint32, Uint32> offsets;
     
     setUniformBlock(_context);
+    mapVertices();
     int chunksize = _context->command == GL_TRIANGLES ? 3 : 2;
     unsigned int start = _vertSize;
     
     for(int ii = 0;  ii < mesh.indices.size(); ii += chunksize) {
         if (_indxSize+chunksize >= _indxMax || _vertSize+chunksize >= _vertMax) {
             flush();
+            mapVertices();
             offsets.clear();
         }
         
@@ -3555,13 +4589,14 @@ unsigned int SpriteBatch::chunkify(const Mesh<SpriteVertex2>& mesh, const Affine
                 _indxData[_indxSize] = search->second;
             } else {
                 _indxData[_indxSize] = _vertSize;
-                _vertData[_vertSize] = mesh.vertices[ii+jj];
-                _vertData[_vertSize].position *= mat;
+                SpriteVertex2 vert = mesh.vertices[ii+jj];
+                vert.position *= mat;
                 if (tint) {
-                    Color4 shade(_vertData[_vertSize].color);
+                    Color4 shade(vert.color);
                     shade *= _color;
-                    _vertData[_vertSize].color = shade.getPacked();
+                    vert.color = shade.getPacked();
                 }
+                _vertData[_vertSize] = vert;
                 _vertSize++;
             }
             _indxSize++;
@@ -3604,13 +4639,14 @@ unsigned int SpriteBatch::prepare(const SpriteVertex2* vertices, size_t size, co
     }
     
     setUniformBlock(_context);
+    mapVertices();
     int ii = 0;
     tint = tint && _color != Color4::WHITE;
+    cu_sprite_transform(_vertData+_vertSize, vertices, size, mat);
     for(size_t kk = 0; kk < size; kk++) {
-        _vertData[_vertSize+ii] = vertices[kk];
-        _vertData[_vertSize+ii].position = vertices[kk].position*mat;
         if (tint) {
-            Uint32 c = marshall(_vertData[_vertSize+ii].color);
+            // Read the source, as the destination may be write-only
+            Uint32 c = marshall(vertices[kk].color);
             Uint32 r = round(_color.r*((c >> 24)/255.0f));
             Uint32 g = round(_color.g*(((c >> 16) & 0xff)/255.0f));
             Uint32 b = round(_color.b*(((c >> 8) & 0xff)/255.0f));
@@ -3654,6 +4690,7 @@ unsigned int SpriteBatch::prepare(const SpriteVertex2* vertices, size_t size, co
  */
 unsigned int SpriteBatch::chunkify(const SpriteVertex2* vertices, size_t size, const Affine2& mat, bool tint) {
     setUniformBlock(_context);
+    mapVertices();
 
     const int chunksize = 3;
     unsigned int start  = _vertSize;
@@ -3663,6 +4700,7 @@ unsigned int SpriteBatch::chunkify(const SpriteVertex2* vertices, size_t size, c
     for(int ii = 1;  ii < size; ii++) {
         if (_indxSize+chunksize > _indxMax || _vertSize+chunksize >= _vertMax) {
             flush();
+            mapVertices();
             fresh = true;
         }
         
@@ -238,6 +238,9 @@ bool TextLayout::initWithTextWidth(const std::string text, const std::shared_ptr
  * @param text  The text associated with this layout.
  */
 void TextLayout::setText(const std::string text) {
+    if (text == _text) {
+        return;
+    }
     invalidate();
     _text = text;
     std::string::iterator end_it = utf8::find_invalid(_text.begin(), _text.end());
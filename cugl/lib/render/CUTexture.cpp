@@ -373,6 +373,36 @@ const Texture& Texture::set(const void *data) {
     return *this;
 }
 
+/**
+ * Sets a horizontal band of this texture to the contents of the given buffer.
+ *
+ * The band is the given number of rows, starting at the given row, and
+ * spans the entire width of the texture. The buffer must have the correct
+ * data format. In addition, the buffer must be size width*height*bytesize,
+ * where height is the number of rows in the band. See {@link #getByteSize}
+ * for a description of the latter.
+ *
+ * This method does not rebuild the mipmaps. It is only successful if the
+ * texture is currently active.
+ *
+ * @param data      The buffer to read into the texture
+ * @param row       The first row of the band
+ * @param height    The number of rows in the band
+ *
+ * @return a reference to this (modified) texture for chaining.
+ */
+const Texture& Texture::set(const void *data, unsigned int row, unsigned int height) {
+    if (!isActive()) {
+        CUAssertLog(false,"Texture %s is not currently active.",_name.c_str());
+        return *this;
+    }
+    
+    CUAssertLog(row+height <= _height, "Rows [%d,%d) are out of bounds", row, row+height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, _width, height,
+                    (GLenum)_pixelFormat, GL_UNSIGNED_BYTE, data);
+    return *this;
+}
+
 
 #pragma mark -
 #pragma mark Attributes
@@ -563,9 +593,9 @@ std::shared_ptr<Texture> Texture::getSubTexture(GLfloat minS, GLfloat maxS,
     // Filters, wrap, and binding defer to parent.
     // These values can be left alone.
     
-    // Set the size information
-    result->_width  = (unsigned int)((maxS-minS)*source->_width);
-    result->_height = (unsigned int)((maxT-minT)*source->_height);
+    // Set the size information (rounded so pixel-aligned regions are exact)
+    result->_width  = (unsigned int)((maxS-minS)*source->_width+0.5f);
+    result->_height = (unsigned int)((maxT-minT)*source->_height+0.5f);
     result->_minS = minS;
     result->_maxS = maxS;
     result->_minT = minT;
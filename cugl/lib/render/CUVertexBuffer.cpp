@@ -36,6 +36,9 @@
 
 using namespace cugl;
 
+/** The nanoseconds to wait on a stream fence before checking again */
+#define STREAM_TIMEOUT  1000000
+
 #pragma mark Constructors
 /**
  * Creates an uninitialized vertex buffer.
@@ -46,6 +49,10 @@ VertexBuffer::VertexBuffer() :
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
+_streamSize(0),
+_streamSegment(0),
+_streamBase(0),
+_streamMapped(false),
 _stride(0) {
     _shader = nullptr;
 }
@@ -113,6 +120,14 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
+    for(auto it = _streamFences.begin(); it != _streamFences.end(); ++it) {
+        if (*it) { glDeleteSync(*it); }
+    }
+    _streamFences.clear();
+    _streamSize = 0;
+    _streamSegment = 0;
+    _streamBase = 0;
+    _streamMapped = false;
     glDeleteBuffers(1,&_indxBuffer);
     glDeleteBuffers(1,&_vertBuffer);
     glDeleteVertexArrays(1,&_vertArray);
@@ -192,7 +207,8 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
 				glEnableVertexAttribArray(pos);
 				glVertexAttribPointer(pos,it->second.size,it->second.type,
 									  it->second.norm,_stride,
-									  reinterpret_cast<void*>(it->second.offset));
+									  reinterpret_cast<void*>(it->second.offset+_streamBase));
+				glVertexAttribDivisor(pos,it->second.divisor);
 			} else {
 				glDisableVertexAttribArray(pos);
 			}
@@ -260,6 +276,17 @@ bool VertexBuffer::isBound() const {
  */
 void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
+    if (_streamSize > 0 && size > _streamSize) {
+        releaseStream();
+    } else if (_streamSize > 0) {
+        void* segment = mapStream();
+        if (segment != nullptr) {
+            std::memcpy(segment, data, (size_t)_stride*size);
+            unmapStream(size);
+            return;
+        }
+        releaseStream();
+    }
     glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
     
     GLenum error = glGetError();
@@ -360,6 +387,172 @@ void VertexBuffer::drawInstanced(GLenum mode, GLsizei count, GLsizei instance, G
 }
 
 
+#pragma mark -
+#pragma mark Streaming
+/**
+ * Sets up a streaming ring for the vertex data of this buffer.
+ *
+ * The ring consists of the given number of segments, each of which can
+ * hold capacity vertices. The storage for the ring is allocated once.
+ * From then on, each call to {@link mapStream} (or {@link loadVertexData})
+ * moves to the next segment and maps it with glMapBufferRange. The map is
+ * unsynchronized, so it never stalls on the driver. Instead, a fence is
+ * placed after the draws from each segment, and mapping a segment only
+ * waits if the GPU is still using it. With three or more segments, this
+ * should almost never happen.
+ *
+ * If streaming is already set up, this method will reallocate the ring.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param capacity  The number of vertices in each segment
+ * @param segments  The number of segments in the ring
+ *
+ * @return true if the streaming ring was successfully allocated
+ */
+bool VertexBuffer::setupStream(GLsizei capacity, GLuint segments) {
+    CUAssertLog(capacity > 0 && segments > 0, "Stream size %d x %d is invalid", capacity, segments);
+    releaseStream();
+    
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_stride*capacity*segments, nullptr, GL_STREAM_DRAW);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        CULogError("Could not allocate vertex stream. %s", gl_error_name(error).c_str());
+        return false;
+    }
+    
+    _streamSize = capacity;
+    _streamFences.resize(segments,0);
+    _streamSegment = segments-1; // So the first map is segment 0
+    return true;
+}
+
+/**
+ * Releases the streaming ring of this buffer.
+ *
+ * Vertex data will once again be loaded with glBufferData. If a segment
+ * is currently mapped, it will be unmapped.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ */
+void VertexBuffer::releaseStream() {
+    if (_streamSize == 0) {
+        return;
+    }
+    if (_streamMapped) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        _streamMapped = false;
+    }
+    for(auto it = _streamFences.begin(); it != _streamFences.end(); ++it) {
+        if (*it) { glDeleteSync(*it); }
+    }
+    _streamFences.clear();
+    _streamSize = 0;
+    _streamSegment = 0;
+    if (_streamBase != 0) {
+        _streamBase = 0;
+        rebaseAttributes();
+    }
+}
+
+/**
+ * Returns a pointer to the next segment of the streaming ring.
+ *
+ * The previous segment is fenced (as all draws from it must have been
+ * issued by now), and the next segment is mapped for writing. The memory
+ * is write-only: reading from it is undefined and may be very slow. The
+ * attributes of this buffer are pointed at the new segment, so draw
+ * commands use vertex positions relative to the segment start.
+ *
+ * The segment must be unmapped with {@link unmapStream} before drawing.
+ * This method returns nullptr if the segment could not be mapped.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @return a pointer to the next segment of the streaming ring.
+ */
+void* VertexBuffer::mapStream() {
+    CUAssertLog(_streamSize > 0, "Vertex buffer is not streaming");
+    CUAssertLog(!_streamMapped, "Vertex stream is already mapped");
+    
+    // Fence the segment we just drew from and move on
+    GLsync* fence = &_streamFences[_streamSegment];
+    if (*fence) { glDeleteSync(*fence); }
+    *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _streamSegment = (_streamSegment+1) % _streamFences.size();
+    
+    // Only wait if the GPU is still reading the next segment
+    fence = &_streamFences[_streamSegment];
+    if (*fence) {
+        GLenum status = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_TIMEOUT);
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(*fence, 0, STREAM_TIMEOUT);
+        }
+        glDeleteSync(*fence);
+        *fence = 0;
+    }
+    
+    GLsizeiptr bytes = (GLsizeiptr)_stride*_streamSize;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+    access |= GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+    void* result = glMapBufferRange(GL_ARRAY_BUFFER, bytes*_streamSegment, bytes, access);
+    if (result == nullptr) {
+        GLenum error = glGetError();
+        CULogError("Could not map vertex stream. %s", gl_error_name(error).c_str());
+        return nullptr;
+    }
+    
+    _streamMapped = true;
+    if (_streamBase != bytes*_streamSegment) {
+        _streamBase = bytes*_streamSegment;
+        rebaseAttributes();
+    }
+    return result;
+}
+
+/**
+ * Unmaps the active segment of the streaming ring.
+ *
+ * Only the first size vertices of the segment are flushed to the GPU.
+ * Once unmapped, the segment can be drawn from.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param size  The number of vertices written to the segment
+ */
+void VertexBuffer::unmapStream(GLsizei size) {
+    CUAssertLog(_streamMapped, "Vertex stream is not mapped");
+    CUAssertLog(size <= _streamSize, "Vertex stream overflow: %d > %d", size, _streamSize);
+    if (size > 0) {
+        glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)_stride*size);
+    }
+    if (!glUnmapBuffer(GL_ARRAY_BUFFER)) {
+        CUWarn("Vertex stream was corrupted while mapped");
+    }
+    _streamMapped = false;
+}
+
+/**
+ * Resets the attribute pointers of the attached shader.
+ *
+ * This method is used to point the attributes at the active segment of
+ * the streaming ring. It assumes that this buffer is bound.
+ */
+void VertexBuffer::rebaseAttributes() {
+    if (_shader == nullptr) {
+        return;
+    }
+    for(auto it = _attributes.begin(); it != _attributes.end(); ++it) {
+        GLint pos = glGetAttribLocation(_shader->getProgram(), it->first.c_str());
+        if (pos != -1 && _enabled[it->first]) {
+            glVertexAttribPointer(pos,it->second.size,it->second.type,
+                                  it->second.norm,_stride,
+                                  reinterpret_cast<void*>(it->second.offset+_streamBase));
+        }
+    }
+}
+
+
 #pragma mark -
 #pragma mark Attributes
 /**
@@ -387,6 +580,7 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
     data.norm = norm;
     data.type = type;
     data.offset = offset;
+    data.divisor = 0;
     _attributes[name] = data;
     _enabled[name] = true;
     
@@ -398,7 +592,7 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
         } else {
             glEnableVertexAttribArray(pos);
             glVertexAttribPointer(pos,data.size,data.type,data.norm,_stride,
-                                  reinterpret_cast<void*>(data.offset));
+                                  reinterpret_cast<void*>(data.offset+_streamBase));
         }
         
         GLenum error = glGetError();
@@ -449,3 +643,29 @@ void VertexBuffer::disableAttribute(const std::string name) {
 		}
 	}    
 }
+
+/**
+ * Sets the instance divisor of the given attribute
+ *
+ * By default, every attribute advances once per vertex (a divisor of 0).
+ * An attribute with a divisor of n instead advances once every n instances
+ * of a call to {@link drawInstanced}. A vertex buffer whose attributes all
+ * have divisor 1 holds per-instance data, not per-vertex data.
+ *
+ * Like all attribute settings, the divisor is cached and reapplied when
+ * a new shader is attached.
+ *
+ * @param name      The attribute to modify.
+ * @param divisor   The instance divisor of the attribute.
+ */
+void VertexBuffer::setDivisor(const std::string name, GLuint divisor) {
+    auto it = _attributes.find(name);
+    CUAssertLog(it != _attributes.end(), "Vertex buffer has no attribute %s", name.c_str());
+    it->second.divisor = divisor;
+    if (_shader != nullptr) {
+        GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+        if (pos != -1) {
+            glVertexAttribDivisor(pos,divisor);
+        }
+    }
+}
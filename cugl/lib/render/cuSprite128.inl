@@ -0,0 +1,375 @@
+//
+//  cuSprite128.inl
+//  Cornell University Game Library (CUGL)
+//
+//  This include file provides several static inline functions to vectorize
+//  the vertex preparation in SpriteBatch. Each kernel transforms a block of
+//  vertices, computes the texture and gradient coordinates, and packs the
+//  results into SpriteVertex2 structs. The vector paths process four vertices
+//  at a time and produce the same values as the scalar path, which is used
+//  for the remaining vertices and on platforms without vectorization.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+#include <cstring>
+
+#pragma mark Scalar Kernels
+/**
+ * Packs polygon vertices into sprite vertices (scalar version).
+ *
+ * Each vertex is transformed by mat. The texture coordinates are computed
+ * by normalizing the untransformed vertex to the rectangle with the given
+ * origin and extent (flipping the y-axis), and then mapping the result to
+ * the texture rectangle.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The polygon vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ * @param origin    The origin of the texture space rectangle
+ * @param extent    The size of the texture space rectangle
+ * @param texrect   The texture bounds as {minS, maxS, minT, maxT}
+ * @param color     The packed color of every vertex
+ */
+static inline void cu_sprite_pack_scalar(cugl::SpriteVertex2* dst, const cugl::Vec2* src,
+                                         size_t size, const cugl::Affine2& mat,
+                                         const cugl::Vec2 origin, const cugl::Size extent,
+                                         const float* texrect, GLuint color) {
+    const float* m = mat.m;
+    for(size_t ii = 0; ii < size; ii++) {
+        cugl::Vec2 point = src[ii];
+        dst[ii].position.x = m[0]*point.x+m[2]*point.y+m[4];
+        dst[ii].position.y = m[1]*point.x+m[3]*point.y+m[5];
+        point.x = (point.x-origin.x)/extent.width;
+        point.y = 1-(point.y-origin.y)/extent.height;
+        dst[ii].texcoord.x = point.x*texrect[1]+(1-point.x)*texrect[0];
+        dst[ii].texcoord.y = point.y*texrect[3]+(1-point.y)*texrect[2];
+        dst[ii].gradcoord.x = point.x+(1-point.x);
+        dst[ii].gradcoord.y = point.y+(1-point.y);
+        dst[ii].color = color;
+    }
+}
+
+/**
+ * Copies sprite vertices, transforming their positions (scalar version).
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The source sprite vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ */
+static inline void cu_sprite_transform_scalar(cugl::SpriteVertex2* dst, const cugl::SpriteVertex2* src,
+                                              size_t size, const cugl::Affine2& mat) {
+    const float* m = mat.m;
+    std::memcpy(dst, src, size*sizeof(cugl::SpriteVertex2));
+    for(size_t ii = 0; ii < size; ii++) {
+        cugl::Vec2 point = src[ii].position;
+        dst[ii].position.x = m[0]*point.x+m[2]*point.y+m[4];
+        dst[ii].position.y = m[1]*point.x+m[3]*point.y+m[5];
+    }
+}
+
+#pragma mark Vector Kernels
+#if defined (CU_MATH_VECTOR_SSE)
+/**
+ * Stores the interleaved lanes of two vectors as four Vec2 fields.
+ *
+ * The field of vertex i receives (a[i],b[i]).
+ *
+ * @param dst       The first destination vertex
+ * @param offset    The byte offset of the Vec2 field in SpriteVertex2
+ * @param a         The x-coordinates
+ * @param b         The y-coordinates
+ */
+static inline void _mm_sprite_store_ps(cugl::SpriteVertex2* dst, size_t offset, __m128 a, __m128 b) {
+    __m128 lo = _mm_unpacklo_ps(a,b);
+    __m128 hi = _mm_unpackhi_ps(a,b);
+    char* base = reinterpret_cast<char*>(dst)+offset;
+    _mm_storel_pi(reinterpret_cast<__m64*>(base), lo);
+    _mm_storeh_pi(reinterpret_cast<__m64*>(base+  sizeof(cugl::SpriteVertex2)), lo);
+    _mm_storel_pi(reinterpret_cast<__m64*>(base+2*sizeof(cugl::SpriteVertex2)), hi);
+    _mm_storeh_pi(reinterpret_cast<__m64*>(base+3*sizeof(cugl::SpriteVertex2)), hi);
+}
+
+/**
+ * Packs polygon vertices into sprite vertices.
+ *
+ * This function produces the same results as {@link cu_sprite_pack_scalar}.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The polygon vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ * @param origin    The origin of the texture space rectangle
+ * @param extent    The size of the texture space rectangle
+ * @param texrect   The texture bounds as {minS, maxS, minT, maxT}
+ * @param color     The packed color of every vertex
+ */
+static inline void cu_sprite_pack(cugl::SpriteVertex2* dst, const cugl::Vec2* src,
+                                  size_t size, const cugl::Affine2& mat,
+                                  const cugl::Vec2 origin, const cugl::Size extent,
+                                  const float* texrect, GLuint color) {
+    const float* m = mat.m;
+    const __m128 m0 = _mm_set1_ps(m[0]);
+    const __m128 m1 = _mm_set1_ps(m[1]);
+    const __m128 m2 = _mm_set1_ps(m[2]);
+    const __m128 m3 = _mm_set1_ps(m[3]);
+    const __m128 m4 = _mm_set1_ps(m[4]);
+    const __m128 m5 = _mm_set1_ps(m[5]);
+    const __m128 ox = _mm_set1_ps(origin.x);
+    const __m128 oy = _mm_set1_ps(origin.y);
+    const __m128 ow = _mm_set1_ps(extent.width);
+    const __m128 oh = _mm_set1_ps(extent.height);
+    const __m128 smin = _mm_set1_ps(texrect[0]);
+    const __m128 smax = _mm_set1_ps(texrect[1]);
+    const __m128 tmin = _mm_set1_ps(texrect[2]);
+    const __m128 tmax = _mm_set1_ps(texrect[3]);
+    const __m128 one  = _mm_set1_ps(1.0f);
+
+    size_t ii = 0;
+    for(; ii+4 <= size; ii += 4) {
+        const float* in = reinterpret_cast<const float*>(src+ii);
+        __m128 a  = _mm_loadu_ps(in);
+        __m128 b  = _mm_loadu_ps(in+4);
+        __m128 xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        __m128 ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+
+        __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0,xs),_mm_mul_ps(m2,ys)),m4);
+        __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1,xs),_mm_mul_ps(m3,ys)),m5);
+
+        __m128 nx = _mm_div_ps(_mm_sub_ps(xs,ox),ow);
+        __m128 ny = _mm_sub_ps(one,_mm_div_ps(_mm_sub_ps(ys,oy),oh));
+        __m128 rx = _mm_sub_ps(one,nx);
+        __m128 ry = _mm_sub_ps(one,ny);
+
+        __m128 ts = _mm_add_ps(_mm_mul_ps(nx,smax),_mm_mul_ps(rx,smin));
+        __m128 tt = _mm_add_ps(_mm_mul_ps(ny,tmax),_mm_mul_ps(ry,tmin));
+
+        _mm_sprite_store_ps(dst+ii, offsetof(cugl::SpriteVertex2,position),  px, py);
+        _mm_sprite_store_ps(dst+ii, offsetof(cugl::SpriteVertex2,texcoord),  ts, tt);
+        _mm_sprite_store_ps(dst+ii, offsetof(cugl::SpriteVertex2,gradcoord),
+                            _mm_add_ps(nx,rx), _mm_add_ps(ny,ry));
+        dst[ii  ].color = color;
+        dst[ii+1].color = color;
+        dst[ii+2].color = color;
+        dst[ii+3].color = color;
+    }
+    cu_sprite_pack_scalar(dst+ii, src+ii, size-ii, mat, origin, extent, texrect, color);
+}
+
+/**
+ * Copies sprite vertices, transforming their positions.
+ *
+ * This function produces the same results as {@link cu_sprite_transform_scalar}.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The source sprite vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ */
+static inline void cu_sprite_transform(cugl::SpriteVertex2* dst, const cugl::SpriteVertex2* src,
+                                       size_t size, const cugl::Affine2& mat) {
+    const float* m = mat.m;
+    const __m128 m0 = _mm_set1_ps(m[0]);
+    const __m128 m1 = _mm_set1_ps(m[1]);
+    const __m128 m2 = _mm_set1_ps(m[2]);
+    const __m128 m3 = _mm_set1_ps(m[3]);
+    const __m128 m4 = _mm_set1_ps(m[4]);
+    const __m128 m5 = _mm_set1_ps(m[5]);
+
+    std::memcpy(dst, src, size*sizeof(cugl::SpriteVertex2));
+    size_t ii = 0;
+    for(; ii+4 <= size; ii += 4) {
+        __m128 xs = _mm_setr_ps(src[ii].position.x,src[ii+1].position.x,
+                                src[ii+2].position.x,src[ii+3].position.x);
+        __m128 ys = _mm_setr_ps(src[ii].position.y,src[ii+1].position.y,
+                                src[ii+2].position.y,src[ii+3].position.y);
+        __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0,xs),_mm_mul_ps(m2,ys)),m4);
+        __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1,xs),_mm_mul_ps(m3,ys)),m5);
+        _mm_sprite_store_ps(dst+ii, offsetof(cugl::SpriteVertex2,position), px, py);
+    }
+    for(; ii < size; ii++) {
+        cugl::Vec2 point = src[ii].position;
+        dst[ii].position.x = m[0]*point.x+m[2]*point.y+m[4];
+        dst[ii].position.y = m[1]*point.x+m[3]*point.y+m[5];
+    }
+}
+
+#elif defined (CU_MATH_VECTOR_NEON64)
+/**
+ * Stores the interleaved lanes of two vectors as four Vec2 fields.
+ *
+ * The field of vertex i receives (a[i],b[i]).
+ *
+ * @param dst       The first destination vertex
+ * @param offset    The byte offset of the Vec2 field in SpriteVertex2
+ * @param a         The x-coordinates
+ * @param b         The y-coordinates
+ */
+static inline void vst1q_sprite_f32(cugl::SpriteVertex2* dst, size_t offset, float32x4_t a, float32x4_t b) {
+    float32x4x2_t zip = vzipq_f32(a,b);
+    char* base = reinterpret_cast<char*>(dst)+offset;
+    vst1_f32(reinterpret_cast<float*>(base), vget_low_f32(zip.val[0]));
+    vst1_f32(reinterpret_cast<float*>(base+  sizeof(cugl::SpriteVertex2)), vget_high_f32(zip.val[0]));
+    vst1_f32(reinterpret_cast<float*>(base+2*sizeof(cugl::SpriteVertex2)), vget_low_f32(zip.val[1]));
+    vst1_f32(reinterpret_cast<float*>(base+3*sizeof(cugl::SpriteVertex2)), vget_high_f32(zip.val[1]));
+}
+
+/**
+ * Packs polygon vertices into sprite vertices.
+ *
+ * This function produces the same results as {@link cu_sprite_pack_scalar}.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The polygon vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ * @param origin    The origin of the texture space rectangle
+ * @param extent    The size of the texture space rectangle
+ * @param texrect   The texture bounds as {minS, maxS, minT, maxT}
+ * @param color     The packed color of every vertex
+ */
+static inline void cu_sprite_pack(cugl::SpriteVertex2* dst, const cugl::Vec2* src,
+                                  size_t size, const cugl::Affine2& mat,
+                                  const cugl::Vec2 origin, const cugl::Size extent,
+                                  const float* texrect, GLuint color) {
+    const float* m = mat.m;
+    const float32x4_t m0 = vdupq_n_f32(m[0]);
+    const float32x4_t m1 = vdupq_n_f32(m[1]);
+    const float32x4_t m2 = vdupq_n_f32(m[2]);
+    const float32x4_t m3 = vdupq_n_f32(m[3]);
+    const float32x4_t m4 = vdupq_n_f32(m[4]);
+    const float32x4_t m5 = vdupq_n_f32(m[5]);
+    const float32x4_t ox = vdupq_n_f32(origin.x);
+    const float32x4_t oy = vdupq_n_f32(origin.y);
+    const float32x4_t ow = vdupq_n_f32(extent.width);
+    const float32x4_t oh = vdupq_n_f32(extent.height);
+    const float32x4_t smin = vdupq_n_f32(texrect[0]);
+    const float32x4_t smax = vdupq_n_f32(texrect[1]);
+    const float32x4_t tmin = vdupq_n_f32(texrect[2]);
+    const float32x4_t tmax = vdupq_n_f32(texrect[3]);
+    const float32x4_t one  = vdupq_n_f32(1.0f);
+
+    size_t ii = 0;
+    for(; ii+4 <= size; ii += 4) {
+        float32x4x2_t xy = vld2q_f32(reinterpret_cast<const float*>(src+ii));
+        float32x4_t xs = xy.val[0];
+        float32x4_t ys = xy.val[1];
+
+        float32x4_t px = vaddq_f32(vaddq_f32(vmulq_f32(m0,xs),vmulq_f32(m2,ys)),m4);
+        float32x4_t py = vaddq_f32(vaddq_f32(vmulq_f32(m1,xs),vmulq_f32(m3,ys)),m5);
+
+        float32x4_t nx = vdivq_f32(vsubq_f32(xs,ox),ow);
+        float32x4_t ny = vsubq_f32(one,vdivq_f32(vsubq_f32(ys,oy),oh));
+        float32x4_t rx = vsubq_f32(one,nx);
+        float32x4_t ry = vsubq_f32(one,ny);
+
+        float32x4_t ts = vaddq_f32(vmulq_f32(nx,smax),vmulq_f32(rx,smin));
+        float32x4_t tt = vaddq_f32(vmulq_f32(ny,tmax),vmulq_f32(ry,tmin));
+
+        vst1q_sprite_f32(dst+ii, offsetof(cugl::SpriteVertex2,position),  px, py);
+        vst1q_sprite_f32(dst+ii, offsetof(cugl::SpriteVertex2,texcoord),  ts, tt);
+        vst1q_sprite_f32(dst+ii, offsetof(cugl::SpriteVertex2,gradcoord),
+                         vaddq_f32(nx,rx), vaddq_f32(ny,ry));
+        dst[ii  ].color = color;
+        dst[ii+1].color = color;
+        dst[ii+2].color = color;
+        dst[ii+3].color = color;
+    }
+    cu_sprite_pack_scalar(dst+ii, src+ii, size-ii, mat, origin, extent, texrect, color);
+}
+
+/**
+ * Copies sprite vertices, transforming their positions.
+ *
+ * This function produces the same results as {@link cu_sprite_transform_scalar}.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The source sprite vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ */
+static inline void cu_sprite_transform(cugl::SpriteVertex2* dst, const cugl::SpriteVertex2* src,
+                                       size_t size, const cugl::Affine2& mat) {
+    const float* m = mat.m;
+    const float32x4_t m0 = vdupq_n_f32(m[0]);
+    const float32x4_t m1 = vdupq_n_f32(m[1]);
+    const float32x4_t m2 = vdupq_n_f32(m[2]);
+    const float32x4_t m3 = vdupq_n_f32(m[3]);
+    const float32x4_t m4 = vdupq_n_f32(m[4]);
+    const float32x4_t m5 = vdupq_n_f32(m[5]);
+
+    std::memcpy(dst, src, size*sizeof(cugl::SpriteVertex2));
+    size_t ii = 0;
+    for(; ii+4 <= size; ii += 4) {
+        float xv[4] = { src[ii].position.x, src[ii+1].position.x,
+                        src[ii+2].position.x, src[ii+3].position.x };
+        float yv[4] = { src[ii].position.y, src[ii+1].position.y,
+                        src[ii+2].position.y, src[ii+3].position.y };
+        float32x4_t xs = vld1q_f32(xv);
+        float32x4_t ys = vld1q_f32(yv);
+        float32x4_t px = vaddq_f32(vaddq_f32(vmulq_f32(m0,xs),vmulq_f32(m2,ys)),m4);
+        float32x4_t py = vaddq_f32(vaddq_f32(vmulq_f32(m1,xs),vmulq_f32(m3,ys)),m5);
+        vst1q_sprite_f32(dst+ii, offsetof(cugl::SpriteVertex2,position), px, py);
+    }
+    for(; ii < size; ii++) {
+        cugl::Vec2 point = src[ii].position;
+        dst[ii].position.x = m[0]*point.x+m[2]*point.y+m[4];
+        dst[ii].position.y = m[1]*point.x+m[3]*point.y+m[5];
+    }
+}
+
+#else
+/**
+ * Packs polygon vertices into sprite vertices.
+ *
+ * This platform has no vectorization, so this is the scalar version.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The polygon vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ * @param origin    The origin of the texture space rectangle
+ * @param extent    The size of the texture space rectangle
+ * @param texrect   The texture bounds as {minS, maxS, minT, maxT}
+ * @param color     The packed color of every vertex
+ */
+static inline void cu_sprite_pack(cugl::SpriteVertex2* dst, const cugl::Vec2* src,
+                                  size_t size, const cugl::Affine2& mat,
+                                  const cugl::Vec2 origin, const cugl::Size extent,
+                                  const float* texrect, GLuint color) {
+    cu_sprite_pack_scalar(dst, src, size, mat, origin, extent, texrect, color);
+}
+
+/**
+ * Copies sprite vertices, transforming their positions.
+ *
+ * This platform has no vectorization, so this is the scalar version.
+ *
+ * @param dst       The destination sprite vertices
+ * @param src       The source sprite vertices
+ * @param size      The number of vertices
+ * @param mat       The transform to apply to the vertices
+ */
+static inline void cu_sprite_transform(cugl::SpriteVertex2* dst, const cugl::SpriteVertex2* src,
+                                       size_t size, const cugl::Affine2& mat) {
+    cu_sprite_transform_scalar(dst, src, size, mat);
+}
+#endif
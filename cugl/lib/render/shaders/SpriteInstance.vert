@@ -0,0 +1,77 @@
+R"(////////// SHADER BEGIN /////////
+//  SpriteInstance.vert
+//  Cornell University Game Library (CUGL)
+//
+//  This is an instanced SpriteBatch vertex shader for both OpenGL and OpenGL ES.
+//  It draws the same textured quad many times. Each instance has its own
+//  position, scale, rotation, color and texture region, and the quad corners
+//  come from gl_VertexID, so no per-vertex data is needed at all. It produces
+//  the same outputs as SpriteShader.vert, and so is paired with SpriteShader.frag.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+
+// Instance position (of the anchor)
+in vec2 iPosition;
+// Instance scale (relative to the texture region size)
+in vec2 iScale;
+// Instance rotation (counter-clockwise, in radians)
+in float iAngle;
+// Instance color
+in vec4 iColor;
+// Instance texture region as (minS, minT, maxS, maxT)
+in vec4 iTexRect;
+
+out vec2 outPosition;
+out vec4 outColor;
+out vec2 outTexCoord;
+out vec2 outGradCoord;
+
+// Matrices
+uniform mat4 uPerspective;
+
+// The size of the (root) texture in pixels
+uniform vec2 uTexSize;
+
+// The anchor of each quad, relative to its size
+uniform vec2 uAnchor;
+
+// Build the quad corner and transform it
+void main(void) {
+    // Indices 0,1,2,3 are the corners (0,0), (1,0), (1,1), (0,1)
+    int vid = gl_VertexID;
+    vec2 corner = vec2(float(vid == 1 || vid == 2), float(vid >= 2));
+    
+    vec2 extent = abs(iTexRect.zw-iTexRect.xy)*uTexSize*iScale;
+    vec2 local = (corner-uAnchor)*extent;
+    float c = cos(iAngle);
+    float s = sin(iAngle);
+    vec2 position = vec2(c*local.x-s*local.y, s*local.x+c*local.y)+iPosition;
+    
+    gl_Position = uPerspective*vec4(position,0,1);
+    outPosition = position; // Need untransformed for scissor
+    outColor = iColor;
+    // Texture t-coordinates run top to bottom
+    outTexCoord = vec2(mix(iTexRect.x,iTexRect.z,corner.x), mix(iTexRect.w,iTexRect.y,corner.y));
+    outGradCoord = corner;
+}
+
+/////////// SHADER END //////////)"
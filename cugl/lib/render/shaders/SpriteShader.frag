@@ -7,7 +7,7 @@ R"(////////// SHADER BEGIN /////////
 //  (which can be used simulataneously with textures, but not with colors), as
 //  well as a scissor mask.  Gradients use the color inputs as their texture
 //  coordinates. Finally, there is support for very simple blur effects, which
-//  are used for font labels.
+//  are used for font labels, and for signed distance field font atlases.
 //
 //  This shader was inspired by nanovg by Mikko Mononen (memon@inside.org).
 //
@@ -157,7 +157,15 @@ void main(void) {
     
     if (mod(fType, 2.0) == 1.0) {
         // Include texture (tinted by color and/or gradient)
-        if (uType >= 8) {
+        if (fType >= 16.0) {
+            // Resolve a distance field, widening the edge for blur
+            float dist  = texture(uTexture, outTexCoord).w;
+            float width = fwidth(dist);
+            if (mod(fType, 16.0) >= 8.0) {
+                width += length(uBlur)*width/max(length(fwidth(outTexCoord)),1e-5);
+            }
+            result.w *= smoothstep(0.5-width, 0.5+width, dist);
+        } else if (mod(fType, 16.0) >= 8.0) {
             result *= blursample(outTexCoord);
         } else {
             result *= texture(uTexture, outTexCoord);
@@ -43,6 +43,8 @@
 #include <cugl/util/CUStrings.h>
 #include <sstream>
 #include <algorithm>
+#include <mutex>
+#include <condition_variable>
 
 using namespace cugl;
 
@@ -61,7 +63,10 @@ _color(Color4::WHITE),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
 _dstFactor(GL_ONE_MINUS_SRC_ALPHA),
-_active(false)
+_active(false),
+_culling(false),
+_nodesVisited(0),
+_nodesDrawn(0)
 {}
 
 /**
@@ -76,6 +81,13 @@ void Scene2::dispose() {
     _name = "";
     _color = Color4::WHITE;
     _active = false;
+    _culling = false;
+    _cullRect = Rect::ZERO;
+    _nodesVisited = 0;
+    _nodesDrawn = 0;
+    _recordThreads = nullptr;
+    _recorders.clear();
+    _deferrals.clear();
 }
 
 /**
@@ -363,17 +375,137 @@ void Scene2::removeAllChildren() {
  * To override this draw order, you should place an {@link OrderedNode}
  * in the scene graph to specify an alternative order.
  *
+ * If culling is active, any subtree whose bounds are outside of the camera
+ * view is skipped.  The number of nodes visited and drawn are recorded
+ * for each call.
+ *
+ * If this scene has recording threads, the children are recorded in
+ * parallel first (see {@link #setRecordingThreads}).
+ *
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2::render(const std::shared_ptr<SpriteBatch>& batch) {
+    _nodesVisited = 0;
+    _nodesDrawn = 0;
+    if (_culling) {
+        Mat4::transform(_camera->getInverseProjectView(), Rect(-1,-1,2,2), &_cullRect);
+    }
+
     batch->begin(_camera->getCombined());
     batch->setSrcBlendFunc(_srcFactor);
     batch->setDstBlendFunc(_dstFactor);
     batch->setBlendEquation(_blendEquation);
 
-    for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->render(batch, Affine2::IDENTITY, _color);
+    if (_recordThreads != nullptr && _children.size() > 1) {
+        recordChildren(_camera->getCombined());
+        for(size_t ii = 0; ii < _children.size(); ii++) {
+            std::shared_ptr<StaticBatch> recording = _recorders[ii]->getRecording();
+            if (recording == nullptr) {
+                _children[ii]->render(batch, Affine2::IDENTITY, _color);
+                continue;
+            }
+            
+            // Draw the skipped nodes in between the recorded commands
+            size_t first = 0;
+            for(auto it = _deferrals[ii].begin(); it != _deferrals[ii].end(); ++it) {
+                batch->drawRecording(recording, first, it->mark);
+                if (it->subtree) {
+                    it->node->render(batch, it->transform, it->tint);
+                } else {
+                    it->node->draw(batch, it->transform, it->tint);
+                }
+                first = it->mark;
+            }
+            batch->drawRecording(recording, first, recording->getSegmentCount());
+        }
+    } else {
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, Affine2::IDENTITY, _color);
+        }
     }
 
     batch->end();
 }
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Records the children of this scene on the recording threads.
+ *
+ * Each child that can be recorded is traversed by a separate task into
+ * its own command recorder. This method blocks until all of the tasks
+ * are complete. Afterwards, the recorder of a child has a recording
+ * if and only if that child was successfully recorded.
+ *
+ * @param perspective   The perspective matrix for the recordings
+ */
+void Scene2::recordChildren(const Mat4& perspective) {
+    while (_recorders.size() < _children.size()) {
+        _recorders.push_back(SpriteBatch::allocRecorder());
+    }
+    _deferrals.resize(_recorders.size());
+    for(auto it = _deferrals.begin(); it != _deferrals.end(); ++it) {
+        it->clear();
+    }
+    
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending = 0;
+    for(size_t ii = 0; ii < _children.size(); ii++) {
+        // Static subtrees keep their retained batches on this thread
+        std::shared_ptr<SpriteBatch> recorder = _recorders[ii];
+        std::shared_ptr<scene2::SceneNode> child = _children[ii];
+        recorder->begin(perspective);
+        if (child->isStatic() || !child->isVisible()) {
+            recorder->end();
+            recorder->getRecording()->dispose();
+            continue;
+        }
+        
+        pending++;
+        _recordThreads->addTask([&, recorder, child]() {
+            recorder->setSrcBlendFunc(_srcFactor);
+            recorder->setDstBlendFunc(_dstFactor);
+            recorder->setBlendEquation(_blendEquation);
+            child->render(recorder, Affine2::IDENTITY, _color);
+            recorder->end();
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            done.notify_one();
+        });
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return pending == 0; });
+}
+
+/**
+ * Defers a node skipped by a recorder to the main thread.
+ *
+ * The node is drawn after the commands recorded so far, and before any
+ * commands recorded later. This method is safe to call from a recording
+ * thread, as each recorder only touches its own list.
+ *
+ * @param recorder  The recorder that skipped the node
+ * @param node      The node to draw on the main thread
+ * @param transform The transform passed to the node
+ * @param tint      The tint passed to the node
+ * @param subtree   Whether to render the subtree, or only draw the node
+ */
+void Scene2::deferRender(SpriteBatch* recorder, scene2::SceneNode* node,
+                         const Affine2& transform, Color4 tint, bool subtree) {
+    for(size_t ii = 0; ii < _recorders.size(); ii++) {
+        if (_recorders[ii].get() == recorder) {
+            Deferral deferral;
+            deferral.mark = recorder->markRecording();
+            deferral.node = node;
+            deferral.transform = transform;
+            deferral.tint = tint;
+            deferral.subtree = subtree;
+            _deferrals[ii].push_back(deferral);
+            return;
+        }
+    }
+    CUAssertLog(false, "Recorder does not belong to this scene");
+}
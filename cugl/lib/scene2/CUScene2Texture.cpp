@@ -113,6 +113,12 @@ bool Scene2Texture::init(float x, float y, float width, float height) {
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2Texture::render(const std::shared_ptr<SpriteBatch>& batch) {
+    _nodesVisited = 0;
+    _nodesDrawn = 0;
+    if (_culling) {
+        Mat4::transform(_camera->getInverseProjectView(), Rect(-1,-1,2,2), &_cullRect);
+    }
+
     Affine2 matrix = _camera->getCombined();
     matrix.scale(1, -1); // Flip the y axis for texture write
     
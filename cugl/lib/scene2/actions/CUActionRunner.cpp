@@ -0,0 +1,558 @@
+//
+//  CUActionRunner.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a data-oriented alternative to the action manager.
+//  The action manager is general, but every animation costs a heap allocated
+//  instance, a string key, a hash lookup, and several virtual calls per frame.
+//  That is fine for a few dozen animations, but not for thousands of sprites.
+//
+//  The action runner only supports the built-in actions (move, rotate, scale,
+//  fade and animate). It unpacks each action into a plain record when it is
+//  activated, and stores the records of each kind in their own contiguous
+//  array. The update then steps each array in a tight loop. Easing functions
+//  are sampled once into a table, and animations are identified by integer
+//  handles instead of strings.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#include <cugl/scene2/actions/CUActionRunner.h>
+#include <cugl/scene2/actions/CUMoveAction.h>
+#include <cugl/scene2/actions/CURotateAction.h>
+#include <cugl/scene2/actions/CUScaleAction.h>
+#include <cugl/scene2/actions/CUFadeAction.h>
+#include <cugl/scene2/actions/CUAnimateAction.h>
+#include <cugl/scene2/graph/CUSpriteNode.h>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+#pragma mark Easing
+/**
+ * Returns the eased value of t in [0,1] from the given table.
+ *
+ * The table must have EASING_SAMPLES+1 entries. Values between samples are
+ * linearly interpolated. If the table is nullptr, the easing is linear.
+ *
+ * @param table The sampled easing function
+ * @param t     The (uneased) progress in [0,1]
+ *
+ * @return the eased value of t in [0,1] from the given table.
+ */
+static inline float sample(const float* table, float t) {
+    if (table == nullptr) {
+        return t;
+    }
+    float x = t*EASING_SAMPLES;
+    int pos = (int)x;
+    if (pos >= EASING_SAMPLES) {
+        return table[EASING_SAMPLES];
+    }
+    return table[pos]+(table[pos+1]-table[pos])*(x-pos);
+}
+
+/**
+ * Returns the change in eased progress after advancing the tween by dt.
+ *
+ * The progress is clamped to the duration, so an animation never moves
+ * past its end. A tween with no duration completes immediately.
+ *
+ * @param tween The animation record
+ * @param dt    The number of seconds to animate
+ *
+ * @return the change in eased progress after advancing the tween by dt.
+ */
+template <typename T>
+static inline float advance(T& tween, float dt) {
+    tween.elapsed += dt;
+    float t = 1.0f;
+    if (tween.duration > 0 && tween.elapsed < tween.duration) {
+        t = tween.elapsed/tween.duration;
+    }
+    float next = sample(tween.easing, t);
+    float step = next-tween.progress;
+    tween.progress = next;
+    return step;
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this action runner.
+ *
+ * A disposed action runner can be safely reinitialized. Any animations
+ * owned by this action runner will immediately stop and be released.
+ */
+void ActionRunner::dispose() {
+    _moves.clear();
+    _rotates.clear();
+    _scales.clear();
+    _fades.clear();
+    _animates.clear();
+    _slots.clear();
+    _free.clear();
+    for(int ii = 0; ii <= (int)EasingFunction::Type::ELASTIC_IN_OUT; ii++) {
+        _easings[ii].clear();
+    }
+}
+
+/**
+ * Initializes an action runner with space for the given animations.
+ *
+ * The capacity is a hint, and is split evenly across the animation
+ * kinds. The runner will grow as necessary.
+ *
+ * @param capacity  The expected number of simultaneous animations
+ *
+ * @return true if initialization was successful.
+ */
+bool ActionRunner::init(size_t capacity) {
+    size_t share = capacity/5+1;
+    _moves.reserve(share);
+    _rotates.reserve(share);
+    _scales.reserve(share);
+    _fades.reserve(share);
+    _animates.reserve(share);
+    _slots.reserve(capacity);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Action Management
+/**
+ * Returns a handle for a new animation of the target with the action.
+ *
+ * The action must be one of the built-in actions. Any state of the
+ * target needed by the action (such as its original position) is read
+ * immediately. If the action is not supported, or an {@link Animate}
+ * action is applied to a node that is not a {@link SpriteNode}, this
+ * method returns 0.
+ *
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing (interpolation) function type
+ *
+ * @return a handle for a new animation of the target with the action.
+ */
+ActionRunner::Handle ActionRunner::activate(const std::shared_ptr<Action>& action,
+                                            const std::shared_ptr<SceneNode>& target,
+                                            EasingFunction::Type easing) {
+    Action* base = action.get();
+    if (MoveBy* move = dynamic_cast<MoveBy*>(base)) {
+        MoveTween tween;
+        tween.delta = move->getDelta();
+        Handle result = acquire(Kind::MOVE, _moves.size(), action, target, easing, &tween);
+        _moves.push_back(tween);
+        return result;
+    } else if (MoveTo* move = dynamic_cast<MoveTo*>(base)) {
+        MoveTween tween;
+        tween.delta = move->getTarget()-target->getPosition();
+        Handle result = acquire(Kind::MOVE, _moves.size(), action, target, easing, &tween);
+        _moves.push_back(tween);
+        return result;
+    } else if (RotateBy* rotate = dynamic_cast<RotateBy*>(base)) {
+        RotateTween tween;
+        tween.delta = rotate->getDelta();
+        Handle result = acquire(Kind::ROTATE, _rotates.size(), action, target, easing, &tween);
+        _rotates.push_back(tween);
+        return result;
+    } else if (RotateTo* rotate = dynamic_cast<RotateTo*>(base)) {
+        RotateTween tween;
+        tween.delta = rotate->getAngle()-target->getAngle();
+        Handle result = acquire(Kind::ROTATE, _rotates.size(), action, target, easing, &tween);
+        _rotates.push_back(tween);
+        return result;
+    } else if (ScaleBy* scale = dynamic_cast<ScaleBy*>(base)) {
+        ScaleTween tween;
+        Vec2 orig = target->getScale();
+        tween.delta = orig*scale->getFactor()-orig;
+        Handle result = acquire(Kind::RESIZE, _scales.size(), action, target, easing, &tween);
+        _scales.push_back(tween);
+        return result;
+    } else if (ScaleTo* scale = dynamic_cast<ScaleTo*>(base)) {
+        ScaleTween tween;
+        tween.delta = scale->getScale()-target->getScale();
+        Handle result = acquire(Kind::RESIZE, _scales.size(), action, target, easing, &tween);
+        _scales.push_back(tween);
+        return result;
+    } else if (dynamic_cast<FadeOut*>(base) || dynamic_cast<FadeIn*>(base)) {
+        FadeTween tween;
+        tween.alpha = Color4f(target->getColor()).a;
+        tween.delta = (dynamic_cast<FadeIn*>(base) ? 1-tween.alpha : -tween.alpha);
+        Handle result = acquire(Kind::FADE, _fades.size(), action, target, easing, &tween);
+        _fades.push_back(tween);
+        return result;
+    } else if (Animate* animate = dynamic_cast<Animate*>(base)) {
+        SpriteNode* strip = dynamic_cast<SpriteNode*>(target.get());
+        if (strip == nullptr) {
+            CUAssertLog(false, "Attempt to animate a node other than a SpriteNode");
+            return 0;
+        }
+        AnimateTween tween;
+        tween.strip = strip;
+        tween.action = animate;
+        Handle result = acquire(Kind::ANIMATE, _animates.size(), action, target, easing, &tween);
+        _animates.push_back(tween);
+        return result;
+    }
+    return 0;
+}
+
+/**
+ * Removes the animation for the given handle.
+ *
+ * This act will immediately stop the animation.  The animated node will
+ * continue to have whatever state it had when the animation stopped.
+ *
+ * If there is no animation for the give handle (e.g. the animation is
+ * complete) this method will return false.
+ *
+ * @param handle    The animation handle
+ *
+ * @return true if the animation was successfully removed
+ */
+bool ActionRunner::remove(Handle handle) {
+    const Tween* tween = lookup(handle);
+    if (tween == nullptr) {
+        return false;
+    }
+    release(tween->slot);
+    return true;
+}
+
+/**
+ * Updates all non-paused animations by dt seconds
+ *
+ * Each animation is moved forward by dt second.  If this causes an
+ * animation to reach its duration, the animation is removed and its
+ * handle is no longer active.
+ *
+ * @param dt    The number of seconds to animate
+ */
+void ActionRunner::update(float dt) {
+    // Completed records are replaced by the last record, so only advance
+    // the position when the current record stays.
+    for(Uint32 ii = 0; ii < _moves.size(); ) {
+        MoveTween& tween = _moves[ii];
+        if (!tween.paused) {
+            float step = advance(tween, dt);
+            tween.target->setPosition(tween.target->getPosition()+tween.delta*step);
+            if (tween.elapsed >= tween.duration) {
+                release(tween.slot);
+                continue;
+            }
+        }
+        ii++;
+    }
+
+    for(Uint32 ii = 0; ii < _rotates.size(); ) {
+        RotateTween& tween = _rotates[ii];
+        if (!tween.paused) {
+            float step = advance(tween, dt);
+            tween.target->setAngle(tween.target->getAngle()+tween.delta*step);
+            if (tween.elapsed >= tween.duration) {
+                release(tween.slot);
+                continue;
+            }
+        }
+        ii++;
+    }
+
+    for(Uint32 ii = 0; ii < _scales.size(); ) {
+        ScaleTween& tween = _scales[ii];
+        if (!tween.paused) {
+            float step = advance(tween, dt);
+            tween.target->setScale(tween.target->getScale()+tween.delta*step);
+            if (tween.elapsed >= tween.duration) {
+                release(tween.slot);
+                continue;
+            }
+        }
+        ii++;
+    }
+
+    for(Uint32 ii = 0; ii < _fades.size(); ) {
+        FadeTween& tween = _fades[ii];
+        if (!tween.paused) {
+            tween.alpha += tween.delta*advance(tween, dt);
+            Color4f color = tween.target->getColor();
+            color.a = (tween.alpha < 0 ? 0.0f : tween.alpha > 1 ? 1.0f : tween.alpha);
+            tween.target->setColor(color);
+            if (tween.elapsed >= tween.duration) {
+                release(tween.slot);
+                continue;
+            }
+        }
+        ii++;
+    }
+
+    for(Uint32 ii = 0; ii < _animates.size(); ) {
+        AnimateTween& tween = _animates[ii];
+        if (!tween.paused) {
+            advance(tween, dt);
+            int frame = tween.action->getFrame(tween.progress);
+            if (tween.strip->getFrame() != frame) {
+                tween.strip->setFrame(frame);
+            }
+            if (tween.elapsed >= tween.duration) {
+                release(tween.slot);
+                continue;
+            }
+        }
+        ii++;
+    }
+}
+
+#pragma mark -
+#pragma mark Pausing
+/**
+ * Returns true if the animation for the given handle is paused
+ *
+ * This method will return false if there is no active animation with the
+ * given handle.
+ *
+ * @param handle    The animation handle
+ *
+ * @return true if the animation for the given handle is paused
+ */
+bool ActionRunner::isPaused(Handle handle) const {
+    const Tween* tween = lookup(handle);
+    return tween != nullptr && tween->paused;
+}
+
+/**
+ * Pauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is
+ * already paused, this method does nothing.
+ *
+ * @param handle    The animation handle
+ */
+void ActionRunner::pause(Handle handle) {
+    Tween* tween = lookup(handle);
+    if (tween != nullptr) {
+        tween->paused = true;
+    }
+}
+
+/**
+ * Unpauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is not
+ * currently paused, this method does nothing.
+ *
+ * @param handle    The animation handle
+ */
+void ActionRunner::unpause(Handle handle) {
+    Tween* tween = lookup(handle);
+    if (tween != nullptr) {
+        tween->paused = false;
+    }
+}
+
+#pragma mark -
+#pragma mark Node Management
+/**
+ * Removes all animations for the given target.
+ *
+ * If the target has no associated animations, this method does nothing.
+ * This method searches every active animation, so it should not be
+ * called every frame.
+ *
+ * @param target    The node to stop animating
+ */
+void ActionRunner::clearAllActions(const std::shared_ptr<SceneNode>& target) {
+    for(Uint32 ii = 0; ii < _slots.size(); ii++) {
+        if (_slots[ii].kind != Kind::NONE && _slots[ii].target == target) {
+            release(ii);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the record for the given handle (or nullptr if not active)
+ *
+ * @param handle    The animation handle
+ *
+ * @return the record for the given handle (or nullptr if not active)
+ */
+const ActionRunner::Tween* ActionRunner::lookup(Handle handle) const {
+    Uint32 slot = (Uint32)(handle & 0xffffffff);
+    Uint32 generation = (Uint32)(handle >> 32);
+    if (slot >= _slots.size() || _slots[slot].generation != generation) {
+        return nullptr;
+    }
+
+    const Slot& entry = _slots[slot];
+    switch (entry.kind) {
+        case Kind::MOVE:
+            return &_moves[entry.index];
+        case Kind::ROTATE:
+            return &_rotates[entry.index];
+        case Kind::RESIZE:
+            return &_scales[entry.index];
+        case Kind::FADE:
+            return &_fades[entry.index];
+        case Kind::ANIMATE:
+            return &_animates[entry.index];
+        case Kind::NONE:
+            break;
+    }
+    return nullptr;
+}
+
+/**
+ * Returns the sampled table for the given easing function.
+ *
+ * The table has {@link EASING_SAMPLES}+1 entries, and is computed the
+ * first time it is requested. This method returns nullptr for linear
+ * easing, as no table is necessary.
+ *
+ * @param type  The easing function type
+ *
+ * @return the sampled table for the given easing function.
+ */
+const float* ActionRunner::easing(EasingFunction::Type type) {
+    if (type == EasingFunction::Type::LINEAR) {
+        return nullptr;
+    }
+    std::vector<float>& table = _easings[(int)type];
+    if (table.empty()) {
+        std::function<float(float)> func = EasingFunction::alloc(type);
+        table.resize(EASING_SAMPLES+1);
+        for(int ii = 0; ii <= EASING_SAMPLES; ii++) {
+            table[ii] = func((float)ii/EASING_SAMPLES);
+        }
+    }
+    return table.data();
+}
+
+/**
+ * Returns a handle for a new record of the given kind.
+ *
+ * The record itself must be appended to its array by the caller. The
+ * tween is initialized with the common state of the record.
+ *
+ * @param kind      The kind of record
+ * @param index     The position of the record in its array
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param type      The easing (interpolation) function type
+ * @param tween     The common state to initialize
+ *
+ * @return a handle for a new record of the given kind.
+ */
+ActionRunner::Handle ActionRunner::acquire(Kind kind, size_t index,
+                                           const std::shared_ptr<Action>& action,
+                                           const std::shared_ptr<SceneNode>& target,
+                                           EasingFunction::Type type, Tween* tween) {
+    Uint32 slot;
+    if (_free.empty()) {
+        slot = (Uint32)_slots.size();
+        _slots.emplace_back();
+        _slots.back().generation = 1;
+    } else {
+        slot = _free.back();
+        _free.pop_back();
+    }
+
+    Slot& entry = _slots[slot];
+    entry.kind = kind;
+    entry.index = (Uint32)index;
+    entry.target = target;
+    entry.action = action;
+
+    tween->target = target.get();
+    tween->slot = slot;
+    tween->easing = easing(type);
+    tween->duration = action->getDuration();
+    tween->elapsed = 0;
+    tween->progress = sample(tween->easing, 0);
+    tween->paused = false;
+    return ((Handle)entry.generation << 32) | slot;
+}
+
+/**
+ * Removes the record at the given position in the array.
+ *
+ * The last record is moved into its place, so the array stays packed.
+ *
+ * @param tweens    The array of records
+ * @param index     The position of the record to remove
+ */
+template <typename T>
+void ActionRunner::erase(std::vector<T>& tweens, Uint32 index) {
+    if (index+1 < tweens.size()) {
+        tweens[index] = tweens.back();
+        _slots[tweens[index].slot].index = index;
+    }
+    tweens.pop_back();
+}
+
+/**
+ * Removes the record in the given slot from its array.
+ *
+ * The slot is returned to the free list, and any handle to it is no
+ * longer active.
+ *
+ * @param slot  The slot to release
+ */
+void ActionRunner::release(Uint32 slot) {
+    Slot& entry = _slots[slot];
+    switch (entry.kind) {
+        case Kind::MOVE:
+            erase(_moves, entry.index);
+            break;
+        case Kind::ROTATE:
+            erase(_rotates, entry.index);
+            break;
+        case Kind::RESIZE:
+            erase(_scales, entry.index);
+            break;
+        case Kind::FADE:
+            erase(_fades, entry.index);
+            break;
+        case Kind::ANIMATE:
+            erase(_animates, entry.index);
+            break;
+        case Kind::NONE:
+            return;
+    }
+
+    // Skip generation 0, so that 0 is never a valid handle
+    entry.kind = Kind::NONE;
+    entry.generation = (entry.generation == UINT32_MAX ? 1 : entry.generation+1);
+    entry.target = nullptr;
+    entry.action = nullptr;
+    _free.push_back(slot);
+}
@@ -385,9 +385,21 @@ enum CommandType {
      * will be clipped to the stencil buffer. There must be a previous use
      * of the STENCIL fill rule for this to have an effect.
      */
-    MASK_TEXT
+    MASK_TEXT,
+    /**
+     * A command for the merged geometry of a compiled page.
+     *
+     * This command is never created by a drawing method. It is the union
+     * of adjacent convex fills and normal text with the same render state,
+     * triangulated as a single mesh. Like those commands, it will erase any
+     * active stencil.
+     */
+    MERGED_FILL
 };
 
+/** The number of unchanged draws before a canvas page is compiled */
+#define COMPILE_DRAWS   2
+
 
 /**
  * A drawing command to send to the {@link SpriteBatch}
@@ -471,6 +483,70 @@ public:
         blendDstAlpha = GL_ONE_MINUS_SRC_ALPHA;
     }
     
+    /**
+     * Returns true if this command may be merged into a compiled page
+     *
+     * Only commands that erase the stencil buffer and then draw without
+     * it may be merged, as merging them cannot change how they blend
+     * with each other.
+     *
+     * @return true if this command may be merged into a compiled page
+     */
+    bool isMergeable() const {
+        return (type == CONVEX_FILL || type == NORMAL_TEXT || type == MERGED_FILL);
+    }
+    
+    /**
+     * Returns true if this command has the same render state as other
+     *
+     * @param other The command to compare
+     *
+     * @return true if this command has the same render state as other
+     */
+    bool hasState(const Command* other) const {
+        return (gradient == other->gradient && texture == other->texture &&
+                scissor  == other->scissor  && blurStep == other->blurStep &&
+                blendEquation == other->blendEquation &&
+                blendSrcRGB == other->blendSrcRGB && blendSrcAlpha == other->blendSrcAlpha &&
+                blendDstRGB == other->blendDstRGB && blendDstAlpha == other->blendDstAlpha);
+    }
+    
+    /**
+     * Appends the geometry of a mergeable command to this merged command
+     *
+     * The geometry is converted to a triangle list, in the order that the
+     * original command would draw it. This command should have type
+     * MERGED_FILL, while other should satisfy {@link #isMergeable}.
+     *
+     * @param other The command to append
+     */
+    void merge(const Command* other) {
+        Uint32 base = (Uint32)mesh.vertices.size();
+        mesh.vertices.insert(mesh.vertices.end(), other->mesh.vertices.begin(), other->mesh.vertices.end());
+        if (other->type == CONVEX_FILL) {
+            // Each index ends a triangle fan anchored at its first vertex
+            Uint32 start = 0;
+            for(auto it = other->mesh.indices.begin(); it != other->mesh.indices.end(); ++it) {
+                for(Uint32 ii = start+1; ii+1 < *it; ii++) {
+                    mesh.indices.push_back(base+start);
+                    mesh.indices.push_back(base+ii);
+                    mesh.indices.push_back(base+ii+1);
+                }
+                start = *it;
+            }
+        } else {
+            for(auto it = other->mesh.indices.begin(); it != other->mesh.indices.end(); ++it) {
+                mesh.indices.push_back(base+*it);
+            }
+        }
+        
+        base = (Uint32)mesh.vertices.size();
+        mesh.vertices.insert(mesh.vertices.end(), other->border.vertices.begin(), other->border.vertices.end());
+        for(auto it = other->border.indices.begin(); it != other->border.indices.end(); ++it) {
+            mesh.indices.push_back(base+*it);
+        }
+    }
+    
     /**
      * Applies the given paint to this drawing command
      *
@@ -785,6 +861,12 @@ public:
     TextLayout   layout;
     /** The text origin offset */
     Vec2 textorigin;
+    /** The commands to draw once compiled (merged or borrowed from commands) */
+    std::vector<Command*> compiled;
+    /** The merged commands owned by the compiled list */
+    std::vector<Command*> merged;
+    /** The number of times this page was drawn since its commands changed */
+    Uint32 stable;
 
     /**
      * Creates a new canvas page
@@ -792,7 +874,7 @@ public:
      * This initializes a single drawing context for immediate use.
      * No commands (or path objects) are yet created.
      */
-    Page(CanvasNode* node) : active(false) {
+    Page(CanvasNode* node) : active(false), stable(0) {
         this->node = node;
         contexts.push_back(new Context(node));
     }
@@ -879,6 +961,7 @@ public:
      * Drawing this page will now have no effect.
      */
     void clearCommands() {
+        clearCompiled();
         for(auto it = commands.begin(); it != commands.end(); ++it) {
             delete *it;
             *it = nullptr;
@@ -886,6 +969,63 @@ public:
         commands.clear();
     }
     
+    /**
+     * Removes the compiled form of the drawing commands.
+     *
+     * This method is called whenever the commands change. The page will
+     * be recompiled once it has been drawn COMPILE_DRAWS times
+     * without changes.
+     */
+    void clearCompiled() {
+        for(auto it = merged.begin(); it != merged.end(); ++it) {
+            delete *it;
+            *it = nullptr;
+        }
+        merged.clear();
+        compiled.clear();
+        stable = 0;
+    }
+    
+    /**
+     * Compiles the drawing commands for faster drawing.
+     *
+     * Adjacent commands that draw without the stencil buffer, and that have
+     * the same render state, are merged into a single triangle mesh. So a
+     * run of simple fills and text is submitted to the sprite batch with
+     * one state change and one draw. All other commands are drawn as is.
+     * The commands keep their order, so the result is the same as drawing
+     * the original commands.
+     */
+    void compile() {
+        clearCompiled();
+        Command* run = nullptr;
+        for(auto it = commands.begin(); it != commands.end(); ++it) {
+            Command* comm = *it;
+            if (!comm->isMergeable()) {
+                compiled.push_back(comm);
+                run = nullptr;
+            } else if (run != nullptr && run->hasState(comm)) {
+                run->merge(comm);
+            } else {
+                run = new Command();
+                run->type = MERGED_FILL;
+                run->mesh.command = GL_TRIANGLES;
+                run->gradient = comm->gradient;
+                run->texture  = comm->texture;
+                run->scissor  = comm->scissor;
+                run->blurStep = comm->blurStep;
+                run->blendEquation = comm->blendEquation;
+                run->blendSrcRGB   = comm->blendSrcRGB;
+                run->blendSrcAlpha = comm->blendSrcAlpha;
+                run->blendDstRGB   = comm->blendDstRGB;
+                run->blendDstAlpha = comm->blendDstAlpha;
+                run->merge(comm);
+                merged.push_back(run);
+                compiled.push_back(run);
+            }
+        }
+    }
+    
     /**
      * Commits the current subpath to the path list.
      *
@@ -966,6 +1106,7 @@ public:
      * @param ctype     The type of command to materialize
      */
     void materialize(CommandType ctype) {
+        clearCompiled();
         Context* state = getState();
         Command* packet = new Command();
         commands.push_back(packet);
@@ -1528,6 +1669,11 @@ void CanvasNode::clearAll() {
  * correct.  In addition, this method does not need to check for visibility,
  * as it is guaranteed to only be called when the node is visible.
  *
+ * A page is compiled once it has been drawn a few times without changes.
+ * Adjacent simple fills and text with the same render state are merged
+ * into a single mesh, so that they are submitted with one state change.
+ * Editing the page discards the compiled form.
+ *
  * @param batch     The SpriteBatch to draw with.
  * @param transform The global transformation matrix.
  * @param tint      The tint to blend with the Node color.
@@ -1538,10 +1684,13 @@ void CanvasNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
         return;
     }
     
-    std::shared_ptr<Scissor> origsciss = batch->getScissor();
-    bool changesciss = false;
+    // Only compile pages that have stopped changing
+    if (page->compiled.empty() && ++page->stable >= COMPILE_DRAWS) {
+        page->compile();
+    }
+    const std::vector<Command*>& commands = page->compiled.empty() ? page->commands : page->compiled;
     
-    Command* comm = page->commands.front();
+    Command* comm = commands.front();
     float blurStep  = comm->blurStep;
     GLenum blendEq  = comm->blendEquation;
     GLenum srcRGB   = comm->blendSrcRGB;
@@ -1556,21 +1705,14 @@ void CanvasNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     batch->setGradient(gradient);
     batch->setTexture(texture);
     if (scissor) {
-        std::shared_ptr<Scissor> local  = Scissor::alloc(scissor);
-        local->multiply(transform);
-        if (origsciss) {
-            local->intersect(origsciss);
-        }
-        batch->setScissor(local);
-        changesciss = true;
+        batch->pushScissor(*scissor, transform);
     }
-
     
     batch->setBlendEquation(blendEq);
     batch->setSrcBlendFunc(srcRGB, srcAlpha);
     batch->setDstBlendFunc(dstRGB, dstAlpha);
     batch->setBlur(blurStep);
-    for(auto it = page->commands.begin(); it != page->commands.end(); ++it) {
+    for(auto it = commands.begin(); it != commands.end(); ++it) {
         comm = *it;
         if (comm->blurStep != blurStep) {
             blurStep = comm->blurStep;
@@ -1600,16 +1742,11 @@ void CanvasNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
         }
         if (comm->scissor != scissor) {
             if (scissor) {
-                std::shared_ptr<Scissor> local  = Scissor::alloc(scissor);
-                local->multiply(transform);
-                if (origsciss) {
-                    local->intersect(origsciss);
-                }
-                batch->setScissor(local);
-                changesciss = true;
-            } else {
-                batch->setScissor(origsciss);
-                changesciss = false;
+                batch->popScissor();
+            }
+            scissor = comm->scissor;
+            if (scissor) {
+                batch->pushScissor(*scissor, transform);
             }
         }
 
@@ -1743,6 +1880,11 @@ void CanvasNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
                 }
                 batch->drawMesh(comm->mesh, transform);
                 break;
+            case CommandType::MERGED_FILL:
+                batch->clearStencil();
+                batch->setStencilEffect(StencilEffect::NONE);
+                batch->drawMesh(comm->mesh, transform);
+                break;
             case CommandType::TEXT:
             case CommandType::FILL:
             case CommandType::STROKE:
@@ -1755,8 +1897,8 @@ void CanvasNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     batch->setGradient(nullptr);
     batch->setTexture(nullptr);
     batch->setStencilEffect(StencilEffect::NATIVE);
-    if (changesciss) {
-        batch->setScissor(origsciss);
+    if (scissor) {
+        batch->popScissor();
     }
 }
 
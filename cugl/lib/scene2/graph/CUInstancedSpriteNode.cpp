@@ -0,0 +1,376 @@
+//
+//  CUInstancedSpriteNode.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for many sprites that share a
+//  sprite sheet, such as a wave of projectiles. A SpriteNode per sprite works,
+//  but every node recomputes its own frame polygon, is visited separately by
+//  render, and adds its own quad to the sprite batch. This node instead keeps
+//  the sprites as plain records. The texture region of every frame is computed
+//  once and shared by all of the sprites. Frame animation is advanced for all
+//  sprites in one pass, and all of the sprites are drawn with a single call to
+//  SpriteBatch::drawInstances.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#include <cugl/scene2/graph/CUInstancedSpriteNode.h>
+#include <cugl/render/CUSpriteBatch.h>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an uninitialized node.
+ *
+ * You must initialize this object before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+InstancedSpriteNode::InstancedSpriteNode() :
+_cols(0),
+_size(0) {
+    _classname = "InstancedSpriteNode";
+}
+
+/**
+ * Disposes all of the resources used by this node.
+ *
+ * A disposed node can be safely reinitialized. Any children owned by this
+ * node will be released. They will be deleted if no other object owns them.
+ *
+ * It is unsafe to call this on a node that is still currently inside of
+ * a scene graph.
+ */
+void InstancedSpriteNode::dispose() {
+    _texture = nullptr;
+    _cols = 0;
+    _size = 0;
+    _frameSize = Size::ZERO;
+    _frames.clear();
+    _sprites.clear();
+    _free.clear();
+    _instances.clear();
+    SceneNode::dispose();
+}
+
+/**
+ * Initializes the node with the given sprite sheet.
+ *
+ * The parameter size is to indicate that there are unused frames in the
+ * sprite sheet.  The value size must be less than or equal to rows*cols,
+ * or this initializer will raise an error. The node has no sprites.
+ *
+ * @param texture   The sprite sheet texture
+ * @param rows      The number of rows in the sprite sheet
+ * @param cols      The number of columns in the sprite sheet
+ * @param size      The number of frames in the sprite sheet
+ *
+ * @return true if the node is initialized properly, false otherwise.
+ */
+bool InstancedSpriteNode::initWithSheet(const std::shared_ptr<Texture>& texture,
+                                        int rows, int cols, int size) {
+    CUAssertLog(texture, "The sprite sheet texture cannot be null");
+    CUAssertLog(rows > 0 && cols > 0, "Invalid sprite sheet %dx%d", rows, cols);
+    CUAssertLog(size <= rows*cols, "Invalid sheet size for %dx%d", rows, cols);
+    if (!SceneNode::init()) {
+        return false;
+    }
+    
+    _texture = texture;
+    _cols = cols;
+    _size = size;
+    _frameSize = texture->getSize();
+    _frameSize.width  /= cols;
+    _frameSize.height /= rows;
+    
+    // Compute every frame region once. T increases going down the sheet.
+    float minS = texture->getMinS();
+    float minT = texture->getMinT();
+    float ds = (texture->getMaxS()-minS)/cols;
+    float dt = (texture->getMaxT()-minT)/rows;
+    _frames.resize(size);
+    for(int ii = 0; ii < size; ii++) {
+        float s = minS+(ii % cols)*ds;
+        float t = minT+(ii / cols)*dt;
+        _frames[ii].set(s,t,s+ds,t+dt);
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Sprites
+/**
+ * Returns the identifier of a new sprite at the given position.
+ *
+ * The sprite has unit scale, no rotation, a white color and is not
+ * animated. The identifier of a removed sprite may be reused.
+ *
+ * @param position  The position of the sprite center in node space
+ * @param frame     The initial frame of the sprite
+ *
+ * @return the identifier of a new sprite at the given position.
+ */
+size_t InstancedSpriteNode::addSprite(const Vec2 position, int frame) {
+    CUAssertLog(frame >= 0 && frame < _size, "Invalid animation frame %d", frame);
+    size_t result;
+    if (_free.empty()) {
+        result = _sprites.size();
+        _sprites.emplace_back();
+    } else {
+        result = _free.back();
+        _free.pop_back();
+    }
+    
+    Sprite& sprite = _sprites[result];
+    sprite.position = position;
+    sprite.scale = Vec2::ONE;
+    sprite.angle = 0;
+    sprite.color = Color4::WHITE;
+    sprite.frame = frame;
+    sprite.first = frame;
+    sprite.last  = frame;
+    sprite.rate = 0;
+    sprite.time = 0;
+    sprite.loop = false;
+    sprite.active = true;
+    invalidateBounds();
+    return result;
+}
+
+/**
+ * Removes the sprite with the given identifier.
+ *
+ * The identifier may be reused by a later call to {@link #addSprite}.
+ *
+ * @param sprite    The sprite identifier
+ */
+void InstancedSpriteNode::removeSprite(size_t sprite) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    _sprites[sprite].active = false;
+    _free.push_back(sprite);
+    invalidateBounds();
+}
+
+/**
+ * Removes all of the sprites of this node.
+ */
+void InstancedSpriteNode::clearSprites() {
+    _sprites.clear();
+    _free.clear();
+    invalidateBounds();
+}
+
+/**
+ * Sets the position of the given sprite in node space.
+ *
+ * @param sprite    The sprite identifier
+ * @param position  The position of the sprite center
+ */
+void InstancedSpriteNode::setSpritePosition(size_t sprite, const Vec2 position) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    _sprites[sprite].position = position;
+    invalidateBounds();
+}
+
+/**
+ * Sets the scale of the given sprite.
+ *
+ * @param sprite    The sprite identifier
+ * @param scale     The scale of the sprite
+ */
+void InstancedSpriteNode::setSpriteScale(size_t sprite, const Vec2 scale) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    _sprites[sprite].scale = scale;
+    invalidateBounds();
+}
+
+/**
+ * Sets the counter-clockwise rotation of the given sprite in radians.
+ *
+ * @param sprite    The sprite identifier
+ * @param angle     The rotation of the sprite
+ */
+void InstancedSpriteNode::setSpriteAngle(size_t sprite, float angle) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    _sprites[sprite].angle = angle;
+    invalidateBounds();
+}
+
+/**
+ * Sets the color tint of the given sprite.
+ *
+ * @param sprite    The sprite identifier
+ * @param color     The color tint of the sprite
+ */
+void InstancedSpriteNode::setSpriteColor(size_t sprite, Color4 color) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    _sprites[sprite].color = color;
+    invalidateBounds();
+}
+
+/**
+ * Sets the active frame of the given sprite.
+ *
+ * This does not stop any animation of the sprite.
+ *
+ * @param sprite    The sprite identifier
+ * @param frame     The active frame
+ */
+void InstancedSpriteNode::setSpriteFrame(size_t sprite, int frame) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    CUAssertLog(frame >= 0 && frame < _size, "Invalid animation frame %d", frame);
+    _sprites[sprite].frame = frame;
+    _sprites[sprite].time = 0;
+}
+
+#pragma mark -
+#pragma mark Animation
+/**
+ * Animates the given sprite over the frames first to last (inclusive).
+ *
+ * The sprite starts at frame first, and moves to the next frame every
+ * 1/fps seconds of {@link #update}. If loop is true, it returns to frame
+ * first after frame last. Otherwise it stays on the last frame, and the
+ * animation stops. A non-positive fps stops any animation.
+ *
+ * @param sprite    The sprite identifier
+ * @param first     The first frame of the animation
+ * @param last      The last frame of the animation
+ * @param fps       The number of frames per second
+ * @param loop      Whether to repeat the animation
+ */
+void InstancedSpriteNode::animateSprite(size_t sprite, int first, int last, float fps, bool loop) {
+    CUAssertLog(hasSprite(sprite), "Sprite %zu is not active", sprite);
+    CUAssertLog(first >= 0 && first < _size, "Invalid animation frame %d", first);
+    CUAssertLog(last >= first && last < _size, "Invalid animation frame %d", last);
+    Sprite& data = _sprites[sprite];
+    data.frame = first;
+    data.first = first;
+    data.last  = last;
+    data.rate = (fps > 0 ? 1.0f/fps : 0.0f);
+    data.time = 0;
+    data.loop = loop;
+}
+
+/**
+ * Advances the animation of every sprite by dt seconds.
+ *
+ * @param dt    The number of seconds to animate
+ */
+void InstancedSpriteNode::update(float dt) {
+    for(auto it = _sprites.begin(); it != _sprites.end(); ++it) {
+        if (!it->active || it->rate <= 0) {
+            continue;
+        }
+        it->time += dt;
+        while (it->time >= it->rate) {
+            it->time -= it->rate;
+            if (it->frame < it->last) {
+                it->frame++;
+            } else if (it->loop) {
+                it->frame = it->first;
+            } else {
+                it->rate = 0;
+                it->time = 0;
+                break;
+            }
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Drawing
+/**
+ * Draws all of the sprites of this node with the given SpriteBatch.
+ *
+ * The sprites are drawn with a single call to
+ * {@link SpriteBatch#drawInstances}. This method does not recurse into
+ * the children.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ */
+void InstancedSpriteNode::draw(const std::shared_ptr<SpriteBatch>& batch,
+                               const Affine2& transform, Color4 tint) {
+    if (_sprites.size() == _free.size()) {
+        return;
+    }
+    
+    // Instances ignore the batch transform, so we fold ours in here
+    Vec2 scale;
+    float angle;
+    Affine2::decompose(transform, &scale, &angle, nullptr);
+    
+    _instances.clear();
+    _instances.reserve(_sprites.size()-_free.size());
+    for(auto it = _sprites.begin(); it != _sprites.end(); ++it) {
+        if (!it->active) {
+            continue;
+        }
+        SpriteInstance instance;
+        instance.position = transform.transform(it->position);
+        instance.scale = it->scale*scale;
+        instance.angle = it->angle+angle;
+        instance.color = (it->color*tint).getPacked();
+        instance.texrect = _frames[it->frame];
+        _instances.push_back(instance);
+    }
+    batch->drawInstances(_texture, _instances);
+}
+
+/**
+ * Returns the bounds of this node and all of its descendants.
+ *
+ * The bounds include every sprite (at any rotation) in addition to
+ * the content bounds and the children.
+ *
+ * @return the bounds of this node and all of its descendants.
+ */
+Rect InstancedSpriteNode::computeSubtreeBounds() {
+    Rect result = SceneNode::computeSubtreeBounds();
+    Vec2 half = Vec2(_frameSize.width, _frameSize.height)/2;
+    for(auto it = _sprites.begin(); it != _sprites.end(); ++it) {
+        if (!it->active) {
+            continue;
+        }
+        // Pad by the half diagonal so that rotation never escapes the bounds
+        Vec2 extent = half*it->scale;
+        float radius = extent.length();
+        result.merge(Rect(it->position.x-radius, it->position.y-radius, 2*radius, 2*radius));
+    }
+    return result;
+}
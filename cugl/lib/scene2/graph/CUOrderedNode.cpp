@@ -57,7 +57,7 @@ using namespace cugl::scene2;
  */
 OrderedNode::Context::Context(OrderedNode* parent) :
 node(nullptr),
-scissor(nullptr),
+scissor(-1),
 canonical(0) {
     this->parent = parent;
     tint = Color4::WHITE;
@@ -82,7 +82,7 @@ OrderedNode::Context::Context(const Context& copy) {
  */
 OrderedNode::Context::~Context() {
     node = nullptr;
-    scissor = nullptr;
+    scissor = -1;
 }
 
 /**
@@ -132,6 +132,54 @@ bool OrderedNode::Context::sortCompare(Context* a, Context* b) {
     return false;
 }
 
+/**
+ * Returns true if the interiors of the two rectangles overlap
+ *
+ * Unlike {@link Rect#doesIntersect}, rectangles that only share an edge do
+ * not overlap. Hence adjacent tiles may still share a sprite batch layer.
+ *
+ * @param a        The first rectangle
+ * @param b        The second rectangle
+ *
+ * @return true if the interiors of the two rectangles overlap
+ */
+static bool overlaps(const Rect& a, const Rect& b) {
+    return (a.getMinX() < b.getMaxX() && b.getMinX() < a.getMaxX() &&
+            a.getMinY() < b.getMaxY() && b.getMinY() < a.getMaxY());
+}
+
+/**
+ * Returns true if a and b may share a sprite batch layer
+ *
+ * Two contexts may share a layer if the order between them is only
+ * decided by the canonical order (e.g. they have the same priority).
+ * In deferred mode the sprite batch is free to reorder shapes on the
+ * same layer, while the order between layers is preserved. So render
+ * also requires that the contexts on a layer do not overlap.
+ *
+ * @param a        The first (pointer) to compare
+ * @param b        The first (pointer) to compare
+ *
+ * @return true if a and b may share a sprite batch layer
+ */
+bool OrderedNode::Context::shareLayer(Context* a, Context* b) {
+    switch (a->parent->_order) {
+        case PRE_ORDER:
+        case POST_ORDER:
+            return false;
+        case ASCEND:
+        case DESCEND:
+            return a->node->getPriority() == b->node->getPriority();
+        case PRE_ASCEND:
+        case POST_ASCEND:
+        case PRE_DESCEND:
+        case POST_DESCEND:
+            return (a->node->getParent() == b->node->getParent() &&
+                    a->node->getPriority() == b->node->getPriority());
+    }
+    return false;
+}
+
 #pragma mark -
 #pragma mark Ordered Node
 /**
@@ -143,8 +191,9 @@ bool OrderedNode::Context::sortCompare(Context* a, Context* b) {
  * on the heap, use one of the static constructors instead.
  */
 OrderedNode::OrderedNode() :
-_viewport(nullptr),
-_order(PRE_ORDER) {
+_viewport(-1),
+_order(PRE_ORDER),
+_deferred(false) {
     _classname = "OrderedNode";
 }
 
@@ -163,7 +212,9 @@ void OrderedNode::dispose() {
         *it = nullptr;
     }
     _entries.clear();
-    _viewport = nullptr;
+    _viewports.clear();
+    _viewport = -1;
+    _deferred = false;
     SceneNode::dispose();
 }
 
@@ -236,6 +287,7 @@ bool OrderedNode::initWithOrder(Order order, Rect bounds) {
  * the following additional attributes:
  *
  *      "order":    The sort order of this node.
+ *      "deferred": Whether to sort the draw calls by texture.
  *
  * Sort orders are specified as lower case strings representing the names
  * of the enum with dashes in place of underscores (e.g. "pre-order",
@@ -270,6 +322,7 @@ bool OrderedNode::initWithData(const Scene2Loader* loader, const std::shared_ptr
                 _order = Order::POST_DESCEND;
             }
         }
+        _deferred = data->getBool("deferred", false);
         return true;
     }
     return false;
@@ -281,7 +334,7 @@ bool OrderedNode::initWithData(const Scene2Loader* loader, const std::shared_ptr
  * This method replaces {@link #render} to provide a delayed render command
  * (via a queue of {@link Context} objects). This method is recursive.
  * However, it will stop when it encounters any other {@link OrderedNode}
- * objects.
+ * objects or any static nodes.
  *
  * @param node      The descendant node to render.
  * @param transform The global transformation matrix.
@@ -298,20 +351,20 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     }
     
     // We need to capture the important sprite batch state
-    std::shared_ptr<Scissor> previous = _viewport;
-    std::shared_ptr<Scissor> current = nullptr;
+    int previous = _viewport;
     if (node->getScissor()) {
-        current = Scissor::alloc(node->getScissor());
-        current->setTransform(matrix);
-        if (previous) {
-            current->intersect(previous);
+        Scissor current(*node->getScissor());
+        current.setTransform(matrix);
+        if (previous >= 0) {
+            current.intersect(_viewports[previous]);
         }
-        _viewport = current;
+        _viewports.push_back(current);
+        _viewport = (int)_viewports.size()-1;
     }
     
     // Identify pre or post. Block at child ordered nodes
     bool ispost = (_order == POST_ORDER || _order == POST_ASCEND || _order == POST_DESCEND);
-    bool barrier = node->getClassName() == getClassName();
+    bool barrier = node->getClassName() == getClassName() || node->isStatic();
     if (ispost && !barrier) {
         auto children = node->getChildren();
         for(auto it = children.begin(); it != children.end(); ++it) {
@@ -350,6 +403,13 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
  * {@link SceneNode#draw}. This is why it is important for all custom
  * subclasses of SceneNode to override draw instead of render.
  *
+ * If the sprite batch is in deferred mode (or this node is deferred), each
+ * change of priority moves the sprite batch to a new layer, so that only
+ * nodes with the same priority can be merged. A node also starts a new
+ * layer if its world bounds overlap a node already on the layer (or if it
+ * is not cullable, so its bounds are unknown). Otherwise, the sprite batch
+ * could draw it in the wrong order relative to that node.
+ *
  * @param batch     The SpriteBatch to draw with.
  * @param transform The global transformation matrix.
  * @param tint      The tint to blend with the node color.
@@ -361,23 +421,31 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
         // Drop to standard for efficiency
         SceneNode::render(batch,transform,tint);
     } else {
-        Affine2 matrix;
-        Affine2::multiply(_combined,transform,&matrix);
+        if (deferRender(batch, transform, tint, true)) { return; }
+        Affine2 matrix = getRenderTransform(transform);
+        if (cull()) { return; }
         Color4 color = _tintColor;
         if (_hasParentColor) {
             color *= tint;
         }
         
-        // Capture sprite batch context
-        std::shared_ptr<Scissor> active = batch->getScissor();
-        _viewport = active;
+        // Capture sprite batch context (the first viewport is the active one)
+        const Scissor* active = batch->getActiveScissor();
+        _viewports.clear();
+        _viewport = -1;
+        if (active) {
+            _viewports.push_back(*active);
+            _viewport = 0;
+        }
+        bool outerscissor = active != nullptr;
         if (_scissor) {
-            std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
-            local->setTransform(matrix);
-            if (active) {
-                local->intersect(active);
+            Scissor local(*_scissor);
+            local.setTransform(matrix);
+            if (outerscissor) {
+                local.intersect(_viewports[0]);
             }
-            _viewport = local;
+            _viewports.push_back(local);
+            _viewport = (int)_viewports.size()-1;
         }
 
         // Build and sort
@@ -386,16 +454,57 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
         }
 
         std::sort(_entries.begin(), _entries.end(), Context::sortCompare);
+        bool outer = batch->isDeferred();
+        bool deferred = outer || _deferred;
+        batch->setDeferred(deferred);
+        Context* previous = nullptr;
+        bool wasalone = false;
         for(auto it = _entries.begin(); it != _entries.end(); ++it) {
             Context* context = *it;
-            batch->setScissor(context->scissor); // This is in render, so must be applied
-            if (context->node->getClassName() == getClassName()) {
-                // Render barrier at an ordered node
-                context->node->render(batch, context->transform, context->tint);
+            bool barrier = context->node->getClassName() == getClassName() || context->node->isStatic();
+            if (deferred) {
+                // A barrier or a node with unknown bounds gets its own layer
+                bool alone = barrier || !context->node->isCullable();
+                bool fresh = (previous == nullptr || alone || wasalone ||
+                              !Context::shareLayer(previous, context) ||
+                              _layerBounds.size() >= ORDERED_LAYER_LIMIT);
+                Rect bounds;
+                if (!alone) {
+                    Affine2::transform(context->transform, Rect(Vec2::ZERO, context->node->getContentSize()), &bounds);
+                    for(auto jt = _layerBounds.begin(); !fresh && jt != _layerBounds.end(); ++jt) {
+                        fresh = overlaps(*jt, bounds);
+                    }
+                }
+                if (fresh) {
+                    batch->setLayer(batch->getLayer()+1);
+                    _layerBounds.clear();
+                }
+                if (!alone) {
+                    _layerBounds.push_back(bounds);
+                }
+                wasalone = alone;
+            }
+            
+            // This is in render, so must be applied
+            if (context->scissor < 0) {
+                batch->setScissor(nullptr);
             } else {
+                batch->setScissor(_viewports[context->scissor]);
+            }
+            if (barrier) {
+                // Render barrier at an ordered or static node
+                context->node->render(batch, context->transform, context->tint);
+            } else if (!context->node->deferRender(batch, context->transform, context->tint, false)) {
                 context->node->draw(batch, context->transform, context->tint);
             }
+            previous = context;
+        }
+        
+        // Anything drawn after this node must be on top
+        if (deferred) {
+            batch->setLayer(batch->getLayer()+1);
         }
+        batch->setDeferred(outer);
 
         // Clean up and restore state
         for(auto it = _entries.begin(); it != _entries.end(); ++it) {
@@ -403,7 +512,13 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
             *it = nullptr;
         }
         _entries.clear();
-        _viewport = nullptr;
-        batch->setScissor(active);
+        _layerBounds.clear();
+        if (outerscissor) {
+            batch->setScissor(_viewports[0]);
+        } else {
+            batch->setScissor(nullptr);
+        }
+        _viewports.clear();
+        _viewport = -1;
     }
 }
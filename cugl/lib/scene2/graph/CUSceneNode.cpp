@@ -46,6 +46,13 @@
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** The number of layout manager passes since the last reset */
+Uint64 SceneNode::_layoutPasses = 0;
+std::atomic<Uint64> SceneNode::_nameLookups(0);
+Uint64 SceneNode::_nameLookupMark = 0;
+Uint32 SceneNode::_nameLookupStreak = 0;
+Uint32 SceneNode::_nameLookupLimit = NAME_LOOKUP_LIMIT;
+
 #pragma mark Constructors
 /**
  * Creates an uninitialized node.
@@ -68,7 +75,17 @@ _angle(0),
 _useTransform(false),
 _parent(nullptr),
 _graph(nullptr),
+_layoutDirty(true),
+_layoutPending(false),
 _childOffset(-2),
+_transformDirty(true),
+_boundsDirty(true),
+_worldDirty(true),
+_cullable(true),
+_uncullable(false),
+_static(false),
+_staticDirty(true),
+_nameIndexed(false),
 _priority(0) {
     _classname = "SceneNode";
 }
@@ -254,6 +271,9 @@ void SceneNode::dispose() {
         removeFromParent();
     }
     removeAllChildren();
+    setLayout(nullptr);
+    _layoutDirty = true;
+    _layoutPending = false;
     _position = Vec2::ZERO;
     _anchor   = Vec2::ANCHOR_CENTER;
     _contentSize = Size::ZERO;
@@ -268,9 +288,23 @@ void SceneNode::dispose() {
     _parent = nullptr;
     _graph = nullptr;
     _childOffset = -2;
+    _subtreeBounds = Rect::ZERO;
+    _worldBounds = Rect::ZERO;
+    _worldTransform = Affine2::IDENTITY;
+    _rootTransform = Affine2::IDENTITY;
+    _transformDirty = true;
+    _boundsDirty = true;
+    _worldDirty = true;
+    _cullable = true;
+    _uncullable = false;
+    _static = false;
+    _staticDirty = true;
+    _staticBatch = nullptr;
     _tag = 0;
     _name = "";
     _hashOfName = 0;
+    _nameIndexed = false;
+    _nameIndex.clear();
     _priority = 0.0f;
     _json = nullptr;
 }
@@ -298,9 +332,12 @@ std::shared_ptr<SceneNode> SceneNode::copy(const std::shared_ptr<SceneNode>& dst
     dst->_transform = _transform;
     dst->_useTransform = _useTransform;
     dst->_combined = _combined;
+    dst->_cullable = _cullable;
+    dst->setStatic(_static);
+    dst->invalidateTransform();
+    dst->invalidateBounds();
     dst->_tag = _tag;
-    dst->_name = _name;
-    dst->_hashOfName = _hashOfName;
+    dst->setName(_name);
     dst->_priority = _priority;
     dst->_json = _json;
     return dst;
@@ -308,6 +345,24 @@ std::shared_ptr<SceneNode> SceneNode::copy(const std::shared_ptr<SceneNode>& dst
 
 #pragma mark -
 #pragma mark Attributes
+/**
+ * Sets a string that is used to identify the node.
+ *
+ * This name is used to access a child node, since child position may
+ * change. In addition, the name is useful for debugging. To work properly,
+ * a name should be unique within a scene graph. It is empty if undefined.
+ *
+ * @param name  A string that is used to identify the node.
+ */
+void SceneNode::setName(const std::string name) {
+    if (_parent) { _parent->unindexChild(this); }
+    _name = name;
+    _hashOfName = std::hash<std::string>()(_name);
+    if (_parent) {
+        _parent->indexChild(this);
+        _parent->invalidateLayout();
+    }
+}
 
 /**
  * Sets the position of the node in its parent's coordinate system.
@@ -324,6 +379,8 @@ void SceneNode::setPosition(float x, float y) {
     _combined.m[4] += (x-_position.x);
     _combined.m[5] += (y-_position.y);
     _position.set(x,y);
+    invalidateTransform();
+    invalidateBounds();
 }
 
 /**
@@ -343,6 +400,11 @@ void SceneNode::setContentSize(const Size size) {
     _position += _anchor*(size-_contentSize);
     _contentSize.set(size);
     if (!_useTransform) updateTransform();
+    invalidateBounds();
+    invalidateLayout();
+    if (_parent) {
+        _parent->invalidateLayout();
+    }
     if (_layout) {
         doLayout();
     }
@@ -371,6 +433,9 @@ void SceneNode::setAnchor(const Vec2 anchor) {
     _position += (anchor-_anchor)*_contentSize;
     _anchor = anchor;
     if (!_useTransform) updateTransform();
+    if (_parent) {
+        _parent->invalidateLayout();
+    }
 }
 
 /**
@@ -423,15 +488,24 @@ Size SceneNode::getSize() const {
  * This matrix is used to convert node coordinates into OpenGL coordinates.
  * It is the recursive (left-multiplied) transforms of all of its descendents.
  *
+ * This matrix is cached, and is only recomputed when this node or one of
+ * its ancestors changes its transform. It is the same matrix used to
+ * render this node, so it includes the pane transform of any ancestor
+ * {@link ScrollPane}.
+ *
  * @return the matrix transforming node space to world space.
  */
-Affine2 SceneNode::getNodeToWorldTransform() const {
-    Affine2 result = _combined;
-    if (_parent) {
+const Affine2& SceneNode::getNodeToWorldTransform() const {
+    if (_transformDirty) {
         // Multiply on left
-        Affine2::multiply(result,_parent->getNodeToWorldTransform(),&result);
+        if (_parent) {
+            Affine2::multiply(_combined,_parent->getChildToWorldTransform(),&_worldTransform);
+        } else {
+            Affine2::multiply(_combined,_rootTransform,&_worldTransform);
+        }
+        _transformDirty = false;
     }
-    return result;
+    return _worldTransform;
 }
 
 /**
@@ -500,6 +574,8 @@ void SceneNode::updateTransform() {
         _combined.m[4] += _position.x-offset.x;
         _combined.m[5] += _position.y-offset.y;
      }
+    invalidateTransform();
+    invalidateBounds();
 }
 
 
@@ -575,6 +651,20 @@ std::shared_ptr<SceneNode> SceneNode::getChildByTag(unsigned int tag) const {
  * @return the (first) child with the given name.
  */
 std::shared_ptr<SceneNode> SceneNode::getChildByName(const std::string name) const {
+    _nameLookups++;
+    if (_nameIndexed) {
+        // Names may collide, so take the earliest child with this name
+        SceneNode* result = nullptr;
+        auto range = _nameIndex.equal_range(std::hash<std::string>()(name));
+        for(auto it = range.first; it != range.second; ++it) {
+            SceneNode* child = it->second;
+            if (child->_name == name && (result == nullptr || child->_childOffset < result->_childOffset)) {
+                result = child;
+            }
+        }
+        return (result == nullptr ? nullptr : _children[result->_childOffset]);
+    }
+    
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         if ((*it)->getName() == name) {
             return *it;
@@ -583,6 +673,71 @@ std::shared_ptr<SceneNode> SceneNode::getChildByName(const std::string name) con
     return nullptr;
 }
 
+/**
+ * Sets whether this node keeps a hashed index of its children by name.
+ *
+ * By default, {@link #getChildByName} is a linear search over the
+ * children of this node. That is fine for small nodes, but it is slow
+ * for a node with many children, such as a HUD layer or a tile layer.
+ * An indexed node keys its children by the hash of their name, so that
+ * each lookup is (amortized) constant time. The index is updated as
+ * children are added, removed, or renamed.
+ *
+ * The index is not free. It costs an allocation per child, and every
+ * change to the children must update it. So it should only be enabled
+ * on nodes that are searched often. For a node searched every frame, it
+ * is still better to look the child up once and keep the pointer.
+ *
+ * @param value Whether this node keeps a hashed index of its children
+ */
+void SceneNode::setNameIndexed(bool value) {
+    if (_nameIndexed == value) {
+        return;
+    }
+    _nameIndex.clear();
+    _nameIndexed = value;
+    if (value) {
+        _nameIndex.reserve(_children.size());
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            indexChild(it->get());
+        }
+    }
+}
+
+/**
+ * Resets the by-name lookup counter to zero.
+ *
+ * This also resets the frame streak of {@link #checkNameLookups}.
+ */
+void SceneNode::resetNameLookups() {
+    _nameLookups = 0;
+    _nameLookupMark = 0;
+    _nameLookupStreak = 0;
+}
+
+/**
+ * Returns true if by-name lookups have occurred for too many frames.
+ *
+ * This method should be called once per frame, typically at the end of
+ * the application update. It checks whether there were any calls to
+ * {@link #getChildByName} since the last call to this method. If this is
+ * true for {@link #getNameLookupLimit} frames in a row, it logs a warning
+ * and returns true. The warning is only logged once per streak.
+ *
+ * @return true if by-name lookups have occurred for too many frames.
+ */
+bool SceneNode::checkNameLookups() {
+    Uint64 total = _nameLookups.load();
+    _nameLookupStreak = (total > _nameLookupMark ? _nameLookupStreak+1 : 0);
+    _nameLookupMark = total;
+    if (_nameLookupLimit > 0 && _nameLookupStreak == _nameLookupLimit) {
+        CUWarn("Nodes were looked up by name on %u frames in a row. Cache the nodes instead.",
+               _nameLookupStreak);
+        return true;
+    }
+    return false;
+}
+
 /**
  * Adds a child to this node.
  *
@@ -601,8 +756,14 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child) {
     // Add the child
     _children.push_back(child);
     child->setParent(this);
+    indexChild(child.get());
     child->pushScene(_graph);
-    
+    child->invalidateTransform();
+    invalidateBounds();
+    invalidateLayout();
+    if (child->needsLayout()) {
+        _layoutPending = true;
+    }
 }
 
 /**
@@ -624,8 +785,12 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
     child2->_childOffset = child1->_childOffset;
     child2->setParent(this);
     child1->setParent(nullptr);
+    unindexChild(child1.get());
+    indexChild(child2.get());
     child2->pushScene(_graph);
     child1->pushScene(nullptr);
+    child2->invalidateTransform();
+    child1->invalidateTransform();
     
     // Check if we are dirty and/or inherit children
     if (inherit) {
@@ -635,6 +800,11 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
             child2->addChild(*it);
         }
     }
+    invalidateBounds();
+    invalidateLayout();
+    if (child2->needsLayout()) {
+        _layoutPending = true;
+    }
 }
 
 /**
@@ -648,14 +818,18 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
 void SceneNode::removeChild(unsigned int pos) {
     CUAssertLog(pos < _children.size(), "Position index out of bounds");
     std::shared_ptr<SceneNode> child = _children[pos];
+    unindexChild(child.get());
     child->setParent(nullptr);
     child->pushScene(nullptr);
     child->_childOffset = -1;
+    child->invalidateTransform();
     for(int ii = pos; ii < _children.size()-1; ii++) {
         _children[ii] = _children[ii+1];
         _children[ii]->_childOffset = ii;
     }
     _children.resize(_children.size()-1);
+    invalidateBounds();
+    invalidateLayout();
 }
 
 /**
@@ -717,8 +891,12 @@ void SceneNode::removeAllChildren() {
         (*it)->setParent(nullptr);
         (*it)->_childOffset = -1;
         (*it)->pushScene(nullptr);
+        (*it)->invalidateTransform();
     }
     _children.clear();
+    _nameIndex.clear();
+    invalidateBounds();
+    invalidateLayout();
 }
 
 /**
@@ -736,19 +914,115 @@ void SceneNode::pushScene(Scene2* scene) {
     }
 }
 
+/**
+ * Sets the layout manager for this node
+ *
+ * We had originally intended to completely decouple layout managers from
+ * nodes.  However, nodes (including layout assignemnts) are typically
+ * built bottom-up, while layout must happen top down to correctly resize
+ * elements.  Therefore, we do allow the addition of an optional layout
+ * manager.
+ *
+ * Changing the layout manager does not reperform layout.  You must call
+ * {@link doLayout()} to do this.
+ *
+ * @param layout	The layout manager for this node
+ */
+void SceneNode::setLayout(const std::shared_ptr<Layout>& layout) {
+    if (_layout == layout) {
+        return;
+    }
+    if (_layout) {
+        _layout->detach(this);
+    }
+    _layout = layout;
+    if (_layout) {
+        _layout->attach(this);
+    }
+    invalidateLayout();
+}
+
 /**
  * Arranges the child of this node using the layout manager.
  *
  * This process occurs recursively and top-down. A layout manager may end
  * up resizing the children.  That is why the parent must finish its layout
  * before we can apply a layout manager to the children.
+ *
+ * Layout is incremental. The layout manager of a node is only applied if
+ * the node was invalidated (see {@link #invalidateLayout}) since its last
+ * layout, and the traversal only descends into subtrees that contain
+ * such a node. Hence calling this method on a large, unchanged scene
+ * graph is essentially free.
  */
 void SceneNode::doLayout() {
-    if (_layout) {
+    if (_layoutDirty && _layout) {
         _layout->layout(this);
+        _layoutPasses++;
     }
+    // Placing the children invalidates this node, so clear afterwards
+    _layoutDirty = false;
     for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->doLayout();
+        if ((*it)->needsLayout()) {
+            (*it)->doLayout();
+        }
+    }
+    _layoutPending = false;
+}
+
+/**
+ * Marks this node as needing layout.
+ *
+ * The next call to {@link #doLayout} on this node or any of its ancestors
+ * will reapply the layout manager of this node (and visit its children).
+ * Nodes invalidate themselves automatically whenever their size, their
+ * children, their layout manager, or its layout information changes. A
+ * child also invalidates its parent when its name, size, anchor, or
+ * transform changes, as these are the inputs of the parent layout.
+ *
+ * You only need to call this method if the layout depends on some
+ * other state not tracked by the node.
+ */
+void SceneNode::invalidateLayout() {
+    _layoutDirty = true;
+    // A pending node always has pending ancestors, so we can stop early
+    SceneNode* node = _parent;
+    while (node != nullptr && !node->_layoutPending) {
+        node->_layoutPending = true;
+        node = node->_parent;
+    }
+}
+
+/**
+ * Adds the given child to the name index of this node.
+ *
+ * This method does nothing if this node is not indexed.
+ *
+ * @param child The child to index
+ */
+void SceneNode::indexChild(SceneNode* child) {
+    if (_nameIndexed) {
+        _nameIndex.emplace(child->_hashOfName, child);
+    }
+}
+
+/**
+ * Removes the given child from the name index of this node.
+ *
+ * This method does nothing if this node is not indexed.
+ *
+ * @param child The child to remove from the index
+ */
+void SceneNode::unindexChild(SceneNode* child) {
+    if (!_nameIndexed) {
+        return;
+    }
+    auto range = _nameIndex.equal_range(child->_hashOfName);
+    for(auto it = range.first; it != range.second; ++it) {
+        if (it->second == child) {
+            _nameIndex.erase(it);
+            return;
+        }
     }
 }
 
@@ -760,32 +1034,57 @@ void SceneNode::doLayout() {
  * If you create custom Nodes, you must override this method with your
  * own draw code.  The base method simply draws all children.
  *
+ * If the scene has culling active, this method skips the entire subtree
+ * when its world bounds are outside of the camera view.
+ *
+ * If this node is static, the subtree is recorded into a static batch the
+ * first time it is drawn (or after it changes), and that batch is replayed
+ * in place of the subtree afterwards.
+ *
  * The transformation matrix will be multiplied on the right by the parent
  * transform of this Node.  In addition, if hasRelativeColor() is true, it
  * will blend the Node color with the given tint.
  *
+ * The node to world transform is cached (see {@link #getRenderTransform}),
+ * so the transform is only read if this node has no parent.
+ *
  * @param batch     The SpriteBatch to draw with.
  * @param matrix    The global transformation matrix.
  * @param tint      The tint to blend with the Node color.
  */
 void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
     if (!_isVisible) { return; }
+    if (deferRender(batch, transform, tint, true)) { return; }
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    Affine2 matrix = getRenderTransform(transform);
+    if (cull()) { return; }
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
     }
     
-    std::shared_ptr<Scissor> active = batch->getScissor();
-    if (_scissor) {
-        std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
-        local->multiply(matrix);
-        if (active) {
-            local->intersect(active);
+    // Static subtrees cannot nest, as the outer recording includes the inner
+    bool retain = _static && !batch->isRecording();
+    if (retain && !_staticDirty && _staticTint == color) {
+        if (_staticBatch != nullptr) {
+            batch->drawStatic(_staticBatch, _staticInverse*matrix);
+            return;
         }
-        batch->setScissor(local);
+        retain = false; // The last recording could not be retained
+    }
+    
+    // Descendants must not be culled while recording
+    bool culling = false;
+    if (retain) {
+        if (_graph != nullptr) {
+            culling = _graph->_culling;
+            _graph->_culling = false;
+        }
+        batch->beginStatic();
+    }
+    
+    if (_scissor) {
+        batch->pushScissor(_scissor, matrix);
     }
 
     draw(batch,matrix,color);
@@ -794,7 +1093,20 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     }
 
     if (_scissor) {
-        batch->setScissor(active);
+        batch->popScissor();
+    }
+    
+    if (retain) {
+        _staticBatch = batch->endStatic();
+        _staticInverse = matrix.getInverse();
+        _staticTint = color;
+        _staticDirty = false;
+        if (_graph != nullptr) {
+            _graph->_culling = culling;
+        }
+        
+        // Clean the subtree bounds so that later changes reach this node
+        getSubtreeBounds();
     }
 }
 
@@ -815,3 +1127,194 @@ Color4 SceneNode::getAbsoluteColor() {
     return result;
 }
 
+#pragma mark -
+#pragma mark Static Batching
+/**
+ * Sets whether this subtree is drawn from a retained static batch.
+ *
+ * A static subtree is recorded into a {@link StaticBatch} the first time
+ * it is rendered. Later passes replay that batch with a single call to
+ * {@link SpriteBatch#drawStatic}, without visiting the descendants at all.
+ * Moving, rotating or scaling this node does not require a new recording.
+ * However, any change to a descendant (or to the color of this node) that
+ * invalidates the subtree bounds will cause the subtree to be recorded
+ * again on the next render.
+ *
+ * This is intended for large subtrees that rarely change, such as the
+ * floors and walls of a level. Subtrees that use gradients, scissors or
+ * stencil effects cannot be retained, and are drawn normally.
+ *
+ * By default, no node is static.
+ *
+ * @param value Whether this subtree is drawn from a retained static batch.
+ */
+void SceneNode::setStatic(bool value) {
+    _static = value;
+    _staticDirty = true;
+    _staticBatch = nullptr;
+}
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Returns the bounds of this node and all of its descendants.
+ *
+ * The bounds are in node space.  They contain the content bounds of this
+ * node and the transformed subtree bounds of every child.  The value is
+ * cached, and is only recomputed when a node in the subtree has changed
+ * its transform or size.
+ *
+ * @return the bounds of this node and all of its descendants.
+ */
+const Rect& SceneNode::getSubtreeBounds() {
+    if (_boundsDirty) {
+        _subtreeBounds = computeSubtreeBounds();
+        _uncullable = !_cullable;
+        for(auto it = _children.begin(); it != _children.end() && !_uncullable; ++it) {
+            _uncullable = (*it)->_uncullable;
+        }
+        _boundsDirty = false;
+    }
+    return _subtreeBounds;
+}
+
+/**
+ * Marks the cached world transform of this node and all of its
+ * descendants as dirty.
+ *
+ * The transform setters call this method automatically.  A subclass only
+ * needs to call it if it changes how its children are transformed (such
+ * as the pane transform of a {@link ScrollPane}).
+ */
+void SceneNode::invalidateTransform() {
+    // A dirty node always has dirty descendants, so we can stop early
+    if (_transformDirty) {
+        return;
+    }
+    _transformDirty = true;
+    _worldDirty = true;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->invalidateTransform();
+    }
+}
+
+/**
+ * Returns the node to world transform for a render pass.
+ *
+ * If this node has a parent, the cached node to world transform is used
+ * as is.  Otherwise, the transform passed to render is treated as the
+ * world transform of the (missing) parent, and the cache of this subtree
+ * is invalidated if that transform has changed.
+ *
+ * @param transform The transform passed to render.
+ *
+ * @return the node to world transform for a render pass.
+ */
+const Affine2& SceneNode::getRenderTransform(const Affine2& transform) {
+    if (_parent == nullptr && _rootTransform != transform) {
+        _rootTransform = transform;
+        invalidateTransform();
+    }
+    return getNodeToWorldTransform();
+}
+
+/**
+ * Marks the cached bounds of this node and all of its ancestors as dirty.
+ *
+ * This also discards the static batch of any static ancestor. The
+ * transform, size, color and visibility setters call this method
+ * automatically.  A subclass only needs to call it if it changes what
+ * it draws without going through those setters.
+ */
+void SceneNode::invalidateBounds() {
+    // A dirty node always has dirty ancestors, so we can stop early
+    SceneNode* node = this;
+    while (node != nullptr && !node->_boundsDirty) {
+        node->_boundsDirty = true;
+        node->_worldDirty = true;
+        node->_staticDirty = true;
+        node = node->_parent;
+    }
+}
+
+/**
+ * Returns the bounds of this node and all of its descendants.
+ *
+ * This method is called by {@link #getSubtreeBounds} when the cached
+ * value is dirty.  The default implementation merges the content bounds
+ * with the subtree bounds of every child. A node that applies an extra
+ * transform to its children should override this method.
+ *
+ * @return the bounds of this node and all of its descendants.
+ */
+Rect SceneNode::computeSubtreeBounds() {
+    Rect result(Vec2::ZERO,_contentSize);
+    Rect bounds;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        Affine2::transform((*it)->_combined, (*it)->getSubtreeBounds(), &bounds);
+        result.merge(bounds);
+    }
+    return result;
+}
+
+/**
+ * Returns true if this subtree should be skipped by render.
+ *
+ * This method records the node as visited in the scene statistics. If
+ * the scene has culling active, it compares the (cached) world bounds of
+ * this subtree against the camera view. If the node is not culled, it is
+ * recorded as drawn.
+ *
+ * @return true if this subtree should be skipped by render.
+ */
+bool SceneNode::cull() {
+    if (_graph == nullptr) {
+        return false;
+    }
+
+    _graph->_nodesVisited++;
+    if (_graph->_culling) {
+        const Rect& bounds = getSubtreeBounds();
+        if (!_uncullable) {
+            if (_worldDirty) {
+                Affine2::transform(getNodeToWorldTransform(), bounds, &_worldBounds);
+                _worldDirty = false;
+            }
+            if (!_worldBounds.doesIntersect(_graph->_cullRect)) {
+                return true;
+            }
+        }
+    }
+    _graph->_nodesDrawn++;
+    return false;
+}
+
+/**
+ * Returns true if drawing this node was deferred to the main thread.
+ *
+ * If the batch is a command recorder, and this node is static or not
+ * recordable (see {@link #isRecordable}), this node is handed back to
+ * the scene with the given render arguments. The scene draws it on
+ * the main thread, between the commands recorded before and after it.
+ * If subtree is true, the scene renders this node and its descendants
+ * (which keeps static subtrees retained). Otherwise, it only draws this
+ * node, as {@link OrderedNode} does.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ * @param subtree   Whether to render the descendants as well
+ *
+ * @return true if drawing this node was deferred to the main thread.
+ */
+bool SceneNode::deferRender(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform,
+                            Color4 tint, bool subtree) {
+    if (!batch->isRecorder() || _graph == nullptr) {
+        return false;
+    } else if (isRecordable() && !(subtree && _static)) {
+        return false;
+    }
+    _graph->deferRender(batch.get(), this, transform, tint, subtree);
+    return true;
+}
+
@@ -309,6 +309,7 @@ void TexturedNode::setTexture(const std::shared_ptr<Texture>& texture) {
     if (_texture != temp) {
         _texture = temp;
         updateTextureCoords();
+        invalidateBounds();
     }
 }
 
@@ -344,6 +345,7 @@ void TexturedNode::shiftTexture(float dx, float dy) {
     _offset.x += dx;
     _offset.y += dy;
     updateTextureCoords();
+    invalidateBounds();
 }
 
 /**
@@ -398,6 +400,7 @@ void TexturedNode::setContentSize(const Size size) {
 void TexturedNode::clearRenderData() {
     _mesh.clear();
     _rendered = false;
+    invalidateBounds();
 }
 
 
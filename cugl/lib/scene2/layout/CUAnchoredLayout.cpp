@@ -120,6 +120,7 @@ bool AnchoredLayout::addAbsolute(const std::string key, Anchor anchor, const Vec
     entry.y_offset = offset.y;
     entry.absolute = true;
     _entries[key] = entry;
+    invalidate();
     return true;
 }
 
@@ -153,6 +154,7 @@ bool AnchoredLayout::addRelative(const std::string key, Anchor anchor, const Vec
     entry.y_offset = offset.y;
     entry.absolute = false;
     _entries[key] = entry;
+    invalidate();
     return true;
 }
 
@@ -174,6 +176,7 @@ bool AnchoredLayout::remove(const std::string key) {
     auto entry = _entries.find(key);
     if (entry != _entries.end()) {
         _entries.erase(entry);
+        invalidate();
         return true;
     }
     return false;
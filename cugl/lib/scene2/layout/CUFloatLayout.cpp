@@ -58,8 +58,9 @@ using namespace cugl::scene2;
  * the heap, use one of the static constructors instead.
  */
 FloatLayout::FloatLayout() :
-_alignment(Alignment::TOP_LEFT),
-_horizontal(true) {
+_unsorted(false),
+_horizontal(true),
+_alignment(Alignment::TOP_LEFT) {
 }
 
 /**
@@ -122,6 +123,7 @@ bool FloatLayout::initWithData(const std::shared_ptr<JsonValue>& data) {
 void FloatLayout::dispose() {
     _entries.clear();
     _priority.clear();
+    _unsorted = false;
 }
 
 
@@ -176,6 +178,8 @@ bool FloatLayout::add(const std::string key, const std::shared_ptr<JsonValue>& d
     }
     _entries[key] = entry;
     _priority.push_back(key);
+    _unsorted = true;
+    invalidate();
     return true;
 }
 
@@ -203,6 +207,7 @@ bool FloatLayout::remove(const std::string key) {
     if (position != _priority.end()) {
         _priority.erase(position);
     }
+    invalidate();
     return true;
 }
 
@@ -606,8 +611,15 @@ void FloatLayout::layoutVertical(SceneNode* node) {
  *
  * This method resorts the contents of the priority
  * queue to match the current layout values.
+ *
+ * The queue is only sorted again if layout information was added
+ * since the last sort.
  */
 void FloatLayout::prioritize() {
+    if (!_unsorted) {
+        return;
+    }
+    
     auto sortrule = [this] (const std::string& s1, const std::string& s2) -> bool {
         auto a = _entries.find(s1);
         auto b = _entries.find(s2);
@@ -626,4 +638,5 @@ void FloatLayout::prioritize() {
     };
     
     std::sort(_priority.begin(),_priority.end(),sortrule);
+    _unsorted = false;
 }
@@ -30,6 +30,7 @@
 //  Version: 1/8/18
 //
 #include <cugl/scene2/layout/CULayout.h>
+#include <algorithm>
 
 using namespace cugl::scene2;
 /**
@@ -244,3 +245,39 @@ void Layout::reanchor(SceneNode* node, Anchor anchor) {
     
 }
 
+#pragma mark -
+#pragma mark Invalidation
+/**
+ * Marks every node using this layout manager as needing layout.
+ *
+ * Layout managers should call this method whenever their layout
+ * information changes. The next call to {@link SceneNode#doLayout}
+ * will then rearrange the owning nodes, and skip every other node
+ * whose layout is still valid.
+ */
+void Layout::invalidate() {
+    for(auto it = _owners.begin(); it != _owners.end(); ++it) {
+        (*it)->invalidateLayout();
+    }
+}
+
+/**
+ * Registers the given node as a user of this layout manager.
+ *
+ * @param node  The node using this layout manager
+ */
+void Layout::attach(SceneNode* node) {
+    _owners.push_back(node);
+}
+
+/**
+ * Unregisters the given node as a user of this layout manager.
+ *
+ * @param node  The node no longer using this layout manager
+ */
+void Layout::detach(SceneNode* node) {
+    auto it = std::find(_owners.begin(), _owners.end(), node);
+    if (it != _owners.end()) {
+        _owners.erase(it);
+    }
+}
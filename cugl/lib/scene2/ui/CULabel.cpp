@@ -92,6 +92,7 @@ _dstFactor(GL_ONE_MINUS_SRC_ALPHA) {
  */
 void Label::dispose() {
     clearRenderData();
+    _glyphrun.clear();
     _layout = nullptr;
     _font = nullptr;
     _foreground = Color4::BLACK;
@@ -502,12 +503,17 @@ const std::string& Label::getText() const {
  * font, then the text will not display at all.
  *
  * Changing this value will regenerate the render data, and is potentially
- * expensive, particularly if the font is using a fallback atlas.
+ * expensive, particularly if the font is using a fallback atlas. Setting
+ * the current text again (without resizing) does nothing, so it is safe
+ * to call this method every frame.
  *
  * @param text      The text for this label.
  * @param resize    Whether to resize the label to fit the new text.
  */
 void Label::setText(const std::string& text, bool resize) {
+    if (!resize && text == _layout->getText()) {
+        return;
+    }
     _layout->setText(text);
     _layout->layout();
     if (resize) {
@@ -974,6 +980,7 @@ void Label::setDropShadow(float x, float y) {
     if (!_dropShadow && !_dropOffset.isZero()) {
         _dropShadow = true;
     }
+    invalidateBounds();
 }
 
 /**
@@ -999,6 +1006,7 @@ void Label::setDropShadow(float x, float y) {
 void Label::setShadowBlur(float blur) {
     _dropBlur = blur;
     _dropShadow = blur > 0 || !_dropOffset.isZero();
+    invalidateBounds();
 }
 
 
@@ -1029,6 +1037,7 @@ void Label::setShadowBlur(float blur) {
  * @param tint      The tint to blend with the Node color.
  */
 void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
+    CUAssertLog(!batch->isRecorder(), "Labels may only be drawn on the main thread");
     if (!_rendered) {
         generateRenderData();
     }
@@ -1041,6 +1050,7 @@ void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& trans
         batch->setColor(tint*getBackground());
         batch->fill(_bounds,Vec2::ANCHOR_CENTER, transform);
     }
+    batch->setDistanceField(_font != nullptr && _font->isDistanceField());
     if (_dropShadow) {
         batch->setBlur(_dropBlur);
         batch->setColor(tint*DROP_COLOR);
@@ -1057,6 +1067,7 @@ void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& trans
         batch->setTexture(it->second->texture);
         batch->drawMesh(it->second->mesh, transform);
     }
+    batch->setDistanceField(false);
 }
 
 /**
@@ -1073,12 +1084,21 @@ void Label::generateRenderData() {
     // Confine glyphs to label interior
     Rect legal = _bounds;
     legal.origin -= _offset;
-    _layout->getGlyphs(_glyphrun,legal);
+    // Refill the glyph runs of the previous text to reuse their meshes
     for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+        it->second->clear();
+    }
+    _layout->getGlyphs(_glyphrun,legal);
+    for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ) {
+        if (it->second->mesh.vertices.empty()) {
+            it = _glyphrun.erase(it);
+            continue;
+        }
         for(auto jt = it->second->mesh.vertices.begin(); jt != it->second->mesh.vertices.end(); ++jt) {
             jt->position += _offset;
             jt->color = _foreground.getPacked();
         }
+        ++it;
     }
 
     _rendered = true;
@@ -1086,19 +1106,24 @@ void Label::generateRenderData() {
 
 /**
  * Clears the render data, releasing all vertices and indices.
+ *
+ * The glyph runs are kept (though marked stale) so that the next call to
+ * {@link #generateRenderData} can reuse their meshes.
  */
 void Label::clearRenderData() {
-    _glyphrun.clear();
     _rendered = false;
+    invalidateBounds();
 }
 
 /**
  * Updates the color value for any other data that needs it.
  *
  * This method is used to synchronize the background color and foreground
- * colors.
+ * colors. It also discards the static batch of any static ancestor, as
+ * that batch was recorded with the old colors.
  */
 void Label::updateColor() {
+    invalidateBounds();
     if (!_rendered) {
         return;
     }
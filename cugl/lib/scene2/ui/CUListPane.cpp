@@ -0,0 +1,463 @@
+//
+//  CUListPane.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for a virtualized scroll pane. A list pane
+//  is a scroll pane for a (potentially very long) vertical list of rows of
+//  equal height. Instead of keeping a scene graph node for every row, it
+//  only keeps nodes for the rows that are visible (plus a small margin).
+//  As the user scrolls, the nodes that fall out of view are recycled and
+//  rebound to the rows that come into view. Hence the cost of layout and
+//  rendering is proportional to the size of the view, not the size of the
+//  list.
+//
+//  The contents of the rows come from a data source callback. This callback
+//  is given a row index and a recycled node (which may be nullptr), and
+//  returns the node to display for that row.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/19/26
+//
+#include <cugl/scene2/ui/CUListPane.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** The default height of a single row */
+#define ITEM_HEIGHT 32.0f
+/** The default number of extra rows on either side of the view */
+#define ITEM_MARGIN 1
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an uninitialized node.
+ *
+ * You must initialize this Node before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+ * heap, use one of the static constructors instead.
+ */
+ListPane::ListPane() : ScrollPane(),
+_itemCount(0),
+_itemHeight(ITEM_HEIGHT),
+_itemMargin(ITEM_MARGIN),
+_binder(nullptr),
+_first(0),
+_last(0),
+_rebind(false) {
+    _classname = "ListPane";
+}
+
+/**
+ * Disposes all of the resources used by this node.
+ *
+ * A disposed Node can be safely reinitialized. Any children owned by this
+ * node will be released.  They will be deleted if no other object owns them.
+ * This includes any nodes in the recycling pool.
+ *
+ * It is unsafe to call this on a Node that is still currently inside of
+ * a scene graph.
+ */
+void ListPane::dispose() {
+    _itemCount = 0;
+    _itemHeight = ITEM_HEIGHT;
+    _itemMargin = ITEM_MARGIN;
+    _binder = nullptr;
+    _first = 0;
+    _last = 0;
+    _items.clear();
+    _recycled.clear();
+    _rebind = false;
+    ScrollPane::dispose();
+}
+
+/**
+ * Initializes a node with the given size.
+ *
+ * The size defines the content size. The bounding box of the node is
+ * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+ * The node is positioned at the origin in parent space.
+ *
+ * The list will start out empty, with the default row height. The
+ * pane is masked and constrained.
+ *
+ * @param size  The size of the node in parent space
+ *
+ * @return true if initialization was successful.
+ */
+bool ListPane::initWithBounds(const Size size) {
+    return initWithItems(size, ITEM_HEIGHT, 0, nullptr, true);
+}
+
+/**
+ * Initializes a node with the given bounds.
+ *
+ * The rectangle origin is the bottom left corner of the node in parent
+ * space, and corresponds to the origin of the Node space. The size
+ * defines its content width and height in node space. The node anchor
+ * is placed in the bottom left corner.
+ *
+ * The list will start out empty, with the default row height. The
+ * pane is masked and constrained.
+ *
+ * @param rect  The bounds of the node in parent space
+ *
+ * @return true if initialization was successful.
+ */
+bool ListPane::initWithBounds(const Rect rect) {
+    return initWithItems(rect, ITEM_HEIGHT, 0, nullptr, true);
+}
+
+/**
+ * Initializes a node with the given size and list data.
+ *
+ * The size defines the content size. The bounding box of the node is
+ * (0,0,width,height) and is anchored in the bottom left corner (0,0).
+ * The node is positioned at the origin in parent space.
+ *
+ * The list will have the given number of rows, bound by the given
+ * data source. No row is bound until the pane is first rendered.
+ * The pane is constrained, and starts with the first row at the top.
+ *
+ * @param size      The size of the node in parent space
+ * @param height    The height of a single row
+ * @param count     The number of rows
+ * @param binder    The data source for the rows
+ * @param mask      Whether to mask contents outside of node bounds
+ *
+ * @return true if initialization was successful.
+ */
+bool ListPane::initWithItems(const Size size, float height, size_t count,
+                             Binder binder, bool mask) {
+    return initWithItems(Rect(Vec2::ZERO,size), height, count, binder, mask);
+}
+
+/**
+ * Initializes a node with the given bounds and list data.
+ *
+ * The rectangle origin is the bottom left corner of the node in parent
+ * space, and corresponds to the origin of the Node space. The size
+ * defines its content width and height in node space. The node anchor
+ * is placed in the bottom left corner.
+ *
+ * The list will have the given number of rows, bound by the given
+ * data source. No row is bound until the pane is first rendered.
+ * The pane is constrained, and starts with the first row at the top.
+ *
+ * @param bounds    The bounds of the node in parent space
+ * @param height    The height of a single row
+ * @param count     The number of rows
+ * @param binder    The data source for the rows
+ * @param mask      Whether to mask contents outside of node bounds
+ *
+ * @return true if initialization was successful.
+ */
+bool ListPane::initWithItems(const Rect bounds, float height, size_t count,
+                             Binder binder, bool mask) {
+    CUAssertLog(height > 0, "The row height must be positive");
+    if (SceneNode::initWithBounds(bounds)) {
+        _itemHeight = height;
+        _itemCount  = count;
+        _binder = binder;
+        _constrained = true;
+        resizeInterior();
+        resetPane();
+        setMasked(mask);
+        return true;
+    }
+    return false;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Sets the content size of this node.
+ *
+ * The rows of a list pane are as wide as the content bounds, so this
+ * recomputes the interior bounds and rebinds the materialized rows.
+ *
+ * @param size  The untransformed size of the node.
+ */
+void ListPane::setContentSize(const Size size) {
+    SceneNode::setContentSize(size);
+    if (_panemask) {
+        setMasked(true);
+    }
+    resizeInterior();
+    _rebind = true;
+}
+
+/**
+ * Sets the number of rows in this list.
+ *
+ * The interior grows or shrinks at the bottom, so the rows currently
+ * in view stay where they are (unless the list shrinks so much that
+ * they no longer exist). Rows that are already materialized are not
+ * rebound. If the underlying data has changed, you should also call
+ * {@link #reloadItems}.
+ *
+ * @param count The number of rows in this list.
+ */
+void ListPane::setItemCount(size_t count) {
+    _itemCount = count;
+    resizeInterior();
+}
+
+/**
+ * Sets the height of a single row.
+ *
+ * Changing the row height rebinds all of the materialized rows.
+ *
+ * @param height    The height of a single row.
+ */
+void ListPane::setItemHeight(float height) {
+    CUAssertLog(height > 0, "The row height must be positive");
+    _itemHeight = height;
+    resizeInterior();
+    _rebind = true;
+}
+
+/**
+ * Sets the data source for the rows of this list.
+ *
+ * Changing the data source rebinds all of the materialized rows.
+ *
+ * @param binder    The data source for the rows of this list.
+ */
+void ListPane::setBinder(Binder binder) {
+    _binder = binder;
+    _rebind = true;
+}
+
+/**
+ * Returns the node currently bound to the given row.
+ *
+ * This method returns nullptr if the row is not materialized, or if
+ * the binder left the row empty.
+ *
+ * @param index The row index
+ *
+ * @return the node currently bound to the given row.
+ */
+std::shared_ptr<SceneNode> ListPane::getItem(size_t index) const {
+    if (index < _first || index >= _last) {
+        return nullptr;
+    }
+    return _items[index-_first];
+}
+
+/**
+ * Returns the rectangle of the given row in the interior coordinates.
+ *
+ * This is the coordinate space of the children of this pane. The
+ * row need not be materialized.
+ *
+ * @param index The row index
+ *
+ * @return the rectangle of the given row in the interior coordinates.
+ */
+Rect ListPane::getItemBounds(size_t index) const {
+    float top = _interior.origin.y+_interior.size.height;
+    return Rect(_interior.origin.x, top-(index+1)*_itemHeight,
+                _interior.size.width, _itemHeight);
+}
+
+#pragma mark -
+#pragma mark Navigation
+/**
+ * Scrolls the pane so that the given row is at the top of the view.
+ *
+ * This method resets the pane (removing any spin or zoom) and then
+ * pans the interior. If the pane is constrained, the pan stops at
+ * the bottom of the list, so the last rows may never reach the top.
+ *
+ * @param index The row index
+ */
+void ListPane::scrollToItem(size_t index) {
+    resetPane();
+    applyPan(0, std::min(index,_itemCount)*_itemHeight);
+}
+
+#pragma mark -
+#pragma mark Rendering
+/**
+ * Draws this Node and all of its children with the given SpriteBatch.
+ *
+ * This method materializes the visible rows before drawing the pane.
+ * Rows are only ever bound on the main thread, as a command recorder
+ * defers this pane before it binds anything (see {@link #isRecordable}).
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ */
+void ListPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
+    if (!_isVisible) { return; }
+    if (deferRender(batch, transform, tint, true)) { return; }
+    updateItems();
+    ScrollPane::render(batch, transform, tint);
+}
+
+/**
+ * Materializes the rows that intersect the view.
+ *
+ * This method is called automatically when the pane is rendered. You
+ * only need to call it if you want to access the nodes of the visible
+ * rows (via {@link #getItem}) before the next render.
+ *
+ * Rows that leave the view (plus margin) are recycled, and rows that
+ * enter it are bound from the recycling pool. Rows that stay in view
+ * are left alone unless {@link #reloadItems} was called.
+ */
+void ListPane::updateItems() {
+    size_t first = 0;
+    size_t last  = 0;
+    if (_binder != nullptr && _itemCount > 0) {
+        // Pull the view back into the interior coordinates
+        Rect view;
+        Affine2::transform(_panetrans.getInverse(), Rect(Vec2::ZERO,_contentSize), &view);
+        float top = _interior.origin.y+_interior.size.height;
+        float lo = std::floor((top-view.getMaxY())/_itemHeight)-_itemMargin;
+        float hi = std::ceil((top-view.getMinY())/_itemHeight)+_itemMargin;
+        first = (size_t)std::max(lo, 0.0f);
+        last  = (size_t)std::min(std::max(hi, 0.0f), (float)_itemCount);
+        first = std::min(first, last);
+    }
+
+    if (!_rebind && first == _first && last == _last) {
+        return;
+    }
+
+    // Recycle first, so that the new rows can reuse these nodes
+    for(size_t ii = _first; ii < _last; ii++) {
+        if (_rebind || ii < first || ii >= last) {
+            recycleItem(_items[ii-_first]);
+        }
+    }
+
+    std::vector<std::shared_ptr<SceneNode>> items;
+    items.reserve(last-first);
+    for(size_t ii = first; ii < last; ii++) {
+        if (!_rebind && ii >= _first && ii < _last) {
+            items.push_back(_items[ii-_first]);
+        } else {
+            items.push_back(bindItem(ii));
+        }
+    }
+
+    _items.swap(items);
+    _first = first;
+    _last  = last;
+    _rebind = false;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Resizes the interior to hold all of the rows.
+ *
+ * The top of the interior is always aligned with the top of the content
+ * bounds, so the interior only grows or shrinks at the bottom. If the
+ * current view no longer fits in a constrained interior, the pane is
+ * reset.
+ */
+void ListPane::resizeInterior() {
+    float height = std::max(_itemCount*_itemHeight, _contentSize.height);
+    Rect interior(0, _contentSize.height-height, _contentSize.width, height);
+    if (interior == _interior) {
+        return;
+    }
+
+    _interior = interior;
+    invalidateLayout();
+    if (_constrained) {
+        Rect view;
+        Affine2::transform(_panetrans.getInverse(), Rect(Vec2::ZERO,_contentSize), &view);
+        if (!_interior.contains(view)) {
+            resetPane();
+        }
+    }
+}
+
+/**
+ * Returns a node bound to the given row.
+ *
+ * The node is taken from the recycling pool if possible. It is placed
+ * in the row and added to this pane.
+ *
+ * @param index The row index
+ *
+ * @return a node bound to the given row.
+ */
+std::shared_ptr<SceneNode> ListPane::bindItem(size_t index) {
+    std::shared_ptr<SceneNode> view = nullptr;
+    if (!_recycled.empty()) {
+        view = _recycled.back();
+        _recycled.pop_back();
+    }
+
+    std::shared_ptr<SceneNode> result = _binder(index, view);
+    if (view != nullptr && result != view) {
+        _recycled.push_back(view);
+    }
+    if (result == nullptr) {
+        return nullptr;
+    }
+
+    // Put the node anchor at the same relative position of the row
+    Rect row = getItemBounds(index);
+    Vec2 anchor = result->getAnchor();
+    result->setPosition(row.origin.x+anchor.x*row.size.width,
+                        row.origin.y+anchor.y*row.size.height);
+    if (result->getParent() != this) {
+        addChild(result);
+    }
+    return result;
+}
+
+/**
+ * Removes the given node from this pane and adds it to the recycling pool.
+ *
+ * @param view  The node to recycle
+ */
+void ListPane::recycleItem(const std::shared_ptr<SceneNode>& view) {
+    if (view == nullptr) {
+        return;
+    }
+    if (view->getParent() == this) {
+        removeChild(view);
+    }
+    _recycled.push_back(view);
+}
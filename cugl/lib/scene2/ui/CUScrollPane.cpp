@@ -759,6 +759,7 @@ bool ScrollPane::initWithData(const Scene2Loader* loader, const std::shared_ptr<
  */
 void ScrollPane::setInterior(const Rect& bounds) {
     _interior = bounds;
+    invalidateLayout();
     if (_layout) {
         doLayout();
     }
@@ -816,6 +817,7 @@ void ScrollPane::setMasked(bool value) {
     } else {
         _panemask = nullptr;
     }
+    invalidateBounds();
 }
 
 /**
@@ -914,6 +916,8 @@ Vec2 ScrollPane::applyPan(const Vec2& delta) {
     } else {
         _panetrans.translate(delta);
     }
+    invalidateTransform();
+    invalidateBounds();
     return result;
 }
 
@@ -976,6 +980,8 @@ float ScrollPane::applySpin(float angle) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.rotate(angle);
     _panetrans.translate(center.x, center.y);
+    invalidateTransform();
+    invalidateBounds();
     return angle;
 }
 
@@ -1027,6 +1033,8 @@ float ScrollPane::applyZoom(float scale) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.scale(scale,scale);
     _panetrans.translate(center.x, center.y);
+    invalidateTransform();
+    invalidateBounds();
     return scale;
 }
 
@@ -1064,6 +1072,8 @@ void ScrollPane::resetPane() {
         
         _panetrans.translate(offset);
     }
+    invalidateTransform();
+    invalidateBounds();
 }
     
 #pragma mark -
@@ -1082,29 +1092,18 @@ void ScrollPane::resetPane() {
  */
 void ScrollPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
     if (!_isVisible) { return; }
+    if (deferRender(batch, transform, tint, true)) { return; }
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    Affine2 matrix = getRenderTransform(transform);
+    if (cull()) { return; }
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
     }
     
-    std::shared_ptr<Scissor> active = batch->getScissor();
-    if (_panemask) {
-        std::shared_ptr<Scissor> local = Scissor::alloc(_panemask);
-        local->multiply(matrix);
-        if (active) {
-            local->intersect(active);
-        }
-        batch->setScissor(local);
-    } else if (_scissor) {
-        std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
-        local->multiply(matrix);
-        if (active) {
-            local->intersect(active);
-        }
-        batch->setScissor(local);
+    std::shared_ptr<Scissor> mask = _panemask ? _panemask : _scissor;
+    if (mask) {
+        batch->pushScissor(mask, matrix);
     }
 
     draw(batch,matrix,color);
@@ -1113,7 +1112,30 @@ void ScrollPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2
         (*it)->render(batch, matrix, color);
     }
 
-    if (_scissor) {
-        batch->setScissor(active);
+    if (mask) {
+        batch->popScissor();
+    }
+}
+
+/**
+ * Returns the bounds of this node and all of its descendants.
+ *
+ * The children of a scroll pane are drawn with the pane transform. If
+ * the pane is masked, nothing is drawn outside of the content bounds, so
+ * those are the subtree bounds.
+ *
+ * @return the bounds of this node and all of its descendants.
+ */
+Rect ScrollPane::computeSubtreeBounds() {
+    Rect result(Vec2::ZERO,_contentSize);
+    Rect bounds;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        // Keep the children clean even if they cannot affect the result
+        Affine2::transform((*it)->getNodeToParentTransform()*_panetrans,
+                           (*it)->getSubtreeBounds(), &bounds);
+        if (!_panemask) {
+            result.merge(bounds);
+        }
     }
+    return result;
 }
@@ -596,6 +596,22 @@ void testNode() {
     CUAssertLog(test1.getChildByTag(4) == nullptr,          "Method removeChild() failed");
     CUAssertLog(test1.getChildByName("fred") == nullptr,    "Method removeChild() failed");
 
+    testptr1 = Node::allocWithPosition(Vec2(1,2));
+    test1.addChildWithName(testptr1,"fred");
+    testptr1 = Node::allocWithPosition(Vec2(3,4));
+    test1.addChildWithName(testptr1,"fred");
+    test1.setNameIndexed(true);
+    CUAssertLog(test1.isNameIndexed(),                                      "Method setNameIndexed() failed");
+    CUAssertLog(test1.getChildByName("fred")->getPosition() == Vec2(1,2),   "Method setNameIndexed() failed");
+    test1.getChild(0)->setName("barney");
+    CUAssertLog(test1.getChildByName("fred")->getPosition() == Vec2(3,4),   "Method setName() failed");
+    CUAssertLog(test1.getChildByName("barney")->getPosition() == Vec2(1,2), "Method setName() failed");
+    test1.removeChild(1);
+    CUAssertLog(test1.getChildByName("fred") == nullptr,                    "Method removeChild() failed");
+    test1.removeAllChildren();
+    CUAssertLog(test1.getChildByName("barney") == nullptr,                  "Method removeAllChildren() failed");
+    test1.setNameIndexed(false);
+
     // HERE WE GO!
     test1.setPosition(1,2);
     test1.setScale(2,3);
@@ -0,0 +1,217 @@
+//
+//  TCURenderTest.cpp
+//  CUGL
+//
+//  Copyright © 2016 Game Design Initiative at Cornell. All rights reserved.
+//
+
+#include "TCURenderTest.h"
+#include <cugl/cugl.h>
+#include <cinttypes>
+#include <cmath>
+#include <vector>
+#include "../render/cuSprite128.inl"
+
+/** The number of quads in the benchmark scene */
+#define SPRITE_QUADS    20000
+/** The number of times to repeat each kernel */
+#define SPRITE_PASSES   50
+/** The tolerance for comparing the scalar and vector kernels */
+#define SPRITE_EPSILON  0.001f
+/** The width and height of the streaming test target */
+#define STREAM_TARGET   128
+/** The vertex capacity of the streaming test batches (forces several flushes) */
+#define STREAM_CAPACITY 256
+/** The number of quads drawn in each streaming test frame */
+#define STREAM_QUADS    300
+/** The number of frames drawn by the streaming test */
+#define STREAM_PASSES   6
+
+namespace cugl {
+
+/**
+ * Returns true if the two vertices are the same up to rounding error
+ *
+ * @param a The first vertex
+ * @param b The second vertex
+ *
+ * @return true if the two vertices are the same up to rounding error
+ */
+static bool sameVertex(const SpriteVertex2& a, const SpriteVertex2& b) {
+    return (a.position.equals(b.position,SPRITE_EPSILON) &&
+            a.texcoord.equals(b.texcoord,SPRITE_EPSILON) &&
+            a.gradcoord.equals(b.gradcoord,SPRITE_EPSILON) &&
+            a.color == b.color);
+}
+
+#pragma mark -
+#pragma mark Sprite Kernels
+
+void testSpriteKernels() {
+    CULog("Running tests for sprite kernels.\n");
+
+    // A sprite heavy scene: many small quads with a rotated, scaled transform
+    std::vector<Vec2> points;
+    points.reserve(4*SPRITE_QUADS);
+    for(int ii = 0; ii < SPRITE_QUADS; ii++) {
+        float x = (float)(ii % 200)*16;
+        float y = (float)(ii / 200)*16;
+        points.push_back(Vec2(x,y));
+        points.push_back(Vec2(x+16,y));
+        points.push_back(Vec2(x+16,y+16));
+        points.push_back(Vec2(x,y+16));
+    }
+    // Exercise the scalar tail in the vector kernels
+    points.push_back(Vec2(1,2));
+    points.push_back(Vec2(3,5));
+    points.push_back(Vec2(7,11));
+
+    Affine2 mat;
+    Affine2::createRotation(0.3f, &mat);
+    mat.scale(1.5f);
+    mat.translate(20,-40);
+
+    Vec2 origin(0,0);
+    Size extent(3200,1600);
+    const float texrect[4] = { 0.25f, 0.75f, 0.1f, 0.9f };
+    GLuint color = Color4::RED.getPacked();
+
+    size_t size = points.size();
+    std::vector<SpriteVertex2> scalar(size);
+    std::vector<SpriteVertex2> vector(size);
+
+#pragma mark Correctness
+    cu_sprite_pack_scalar(scalar.data(), points.data(), size, mat, origin, extent, texrect, color);
+    cu_sprite_pack(vector.data(), points.data(), size, mat, origin, extent, texrect, color);
+    for(size_t ii = 0; ii < size; ii++) {
+        CUAssertLog(sameVertex(scalar[ii],vector[ii]), "Kernel cu_sprite_pack failed at %zu", ii);
+    }
+
+    std::vector<SpriteVertex2> source(scalar);
+    cu_sprite_transform_scalar(scalar.data(), source.data(), size, mat);
+    cu_sprite_transform(vector.data(), source.data(), size, mat);
+    for(size_t ii = 0; ii < size; ii++) {
+        CUAssertLog(sameVertex(scalar[ii],vector[ii]), "Kernel cu_sprite_transform failed at %zu", ii);
+    }
+
+#pragma mark Benchmark
+    Timestamp start;
+    Timestamp end;
+    for(int ii = 0; ii < SPRITE_PASSES; ii++) {
+        cu_sprite_pack_scalar(scalar.data(), points.data(), size, mat, origin, extent, texrect, color);
+    }
+    end.mark();
+    Uint64 packScalar = end.ellapsedMicros(start);
+
+    start.mark();
+    for(int ii = 0; ii < SPRITE_PASSES; ii++) {
+        cu_sprite_pack(vector.data(), points.data(), size, mat, origin, extent, texrect, color);
+    }
+    end.mark();
+    Uint64 packVector = end.ellapsedMicros(start);
+
+    start.mark();
+    for(int ii = 0; ii < SPRITE_PASSES; ii++) {
+        cu_sprite_transform_scalar(scalar.data(), source.data(), size, mat);
+    }
+    end.mark();
+    Uint64 xformScalar = end.ellapsedMicros(start);
+
+    start.mark();
+    for(int ii = 0; ii < SPRITE_PASSES; ii++) {
+        cu_sprite_transform(vector.data(), source.data(), size, mat);
+    }
+    end.mark();
+    Uint64 xformVector = end.ellapsedMicros(start);
+
+    CULog("%d quads x %d passes",SPRITE_QUADS,SPRITE_PASSES);
+    CULog("  cu_sprite_pack:      scalar %" PRIu64 " us, vector %" PRIu64 " us",packScalar,packVector);
+    CULog("  cu_sprite_transform: scalar %" PRIu64 " us, vector %" PRIu64 " us",xformScalar,xformVector);
+
+#pragma mark Complete
+    CULog("Sprite kernel tests complete.\n");
+}
+
+
+#pragma mark -
+#pragma mark Sprite Streaming
+
+/**
+ * Draws a single test frame into the target and returns its pixels
+ *
+ * The quads move with the frame number, so that a stale segment of the
+ * stream ring would show up as a difference between frames.
+ *
+ * @param batch     The sprite batch to draw with
+ * @param target    The render target to draw to
+ * @param frame     The frame number
+ * @param pixels    The buffer to store the RGBA pixels
+ */
+static void drawStreamFrame(const std::shared_ptr<SpriteBatch>& batch,
+                            const std::shared_ptr<RenderTarget>& target,
+                            int frame, std::vector<Uint8>& pixels) {
+    Mat4 proj;
+    Mat4::createOrthographicOffCenter(0, STREAM_TARGET, 0, STREAM_TARGET, -1, 1, &proj);
+    target->begin();
+    batch->begin(proj);
+    for(int ii = 0; ii < STREAM_QUADS; ii++) {
+        int pos = ii*7+frame*13;
+        float x = (float)(pos % STREAM_TARGET);
+        float y = (float)((pos / STREAM_TARGET)*5 % STREAM_TARGET);
+        batch->setColor(Color4((ii*37) & 0xff, (ii*91+frame) & 0xff, (ii*53) & 0xff, 0xff));
+        batch->fill(Rect(x,y,6,6));
+    }
+    batch->end();
+    
+    pixels.resize(4*STREAM_TARGET*STREAM_TARGET);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, STREAM_TARGET, STREAM_TARGET, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    target->end();
+}
+
+void testSpriteStreaming() {
+    CULog("Running tests for sprite streaming.\n");
+
+    std::shared_ptr<RenderTarget> target = RenderTarget::alloc(STREAM_TARGET, STREAM_TARGET);
+    std::shared_ptr<SpriteBatch> upload = SpriteBatch::alloc(STREAM_CAPACITY);
+    std::shared_ptr<SpriteBatch> stream = SpriteBatch::alloc(STREAM_CAPACITY);
+    CUAssertLog(target && upload && stream, "Could not allocate the streaming test");
+    stream->setStreaming(true);
+    CUAssertLog(stream->isStreaming(), "Method setStreaming() failed");
+    CUAssertLog(stream->getStreamSegments() == STREAM_MIN_SEGMENTS, "Stream ring has the wrong initial size");
+
+    // The first pass sizes the ring, so later passes map into a resized one
+    std::vector<Uint8> expected;
+    std::vector<Uint8> actual;
+    for(int frame = 0; frame < STREAM_PASSES; frame++) {
+        drawStreamFrame(upload, target, frame, expected);
+        drawStreamFrame(stream, target, frame, actual);
+        CUAssertLog(GL_NO_ERROR == glGetError(), "Streaming frame %d raised a GL error", frame);
+        size_t diff = 0;
+        for(size_t ii = 0; ii < expected.size(); ii++) {
+            diff += (expected[ii] != actual[ii]);
+        }
+        CUAssertLog(diff == 0, "Streaming frame %d differs at %zu bytes", frame, diff);
+    }
+    CUAssertLog(stream->getStreamSegments() > STREAM_MIN_SEGMENTS, "Stream ring did not grow");
+
+    // Turning streaming off must release the ring and still draw correctly
+    stream->setStreaming(false);
+    drawStreamFrame(upload, target, STREAM_PASSES, expected);
+    drawStreamFrame(stream, target, STREAM_PASSES, actual);
+    CUAssertLog(expected == actual, "Sprite batch failed after streaming was turned off");
+
+#pragma mark Complete
+    CULog("Sprite streaming tests complete.\n");
+}
+
+
+#pragma mark -
+#pragma mark Main
+
+void renderUnitTest() {
+    testSpriteKernels();
+    testSpriteStreaming();
+}
+
+}
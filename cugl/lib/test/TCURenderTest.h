@@ -0,0 +1,20 @@
+//
+//  TCURenderTest.h
+//  CUGL
+//
+//  Copyright © 2016 Game Design Initiative at Cornell. All rights reserved.
+//
+
+#ifndef __T_CU_RENDER_TEST_H__
+#define __T_CU_RENDER_TEST_H__
+
+namespace cugl {
+
+void testSpriteKernels();
+
+void testSpriteStreaming();
+
+void renderUnitTest();
+
+}
+#endif /* __T_CU_RENDER_TEST_H__ */
@@ -0,0 +1,185 @@
+//
+//  TCUSceneTest.cpp
+//  CUGL
+//
+//  Copyright © 2016 Game Design Initiative at Cornell. All rights reserved.
+//
+
+#include "TCUSceneTest.h"
+#include <cugl/cugl.h>
+#include <cugl/scene2/actions/cu_actions.h>
+
+/** The tolerance for comparing tween results */
+#define SCENE_EPSILON   0.001f
+
+namespace cugl {
+
+using namespace scene2;
+
+#pragma mark -
+#pragma mark Action Runner
+
+void testActionRunner() {
+    CULog("Running tests for ActionRunner.\n");
+    std::shared_ptr<ActionRunner> runner = ActionRunner::alloc(8);
+    
+#pragma mark Activate and Remove
+    std::shared_ptr<SceneNode> node = SceneNode::alloc();
+    std::shared_ptr<MoveBy> move = MoveBy::alloc(Vec2(10,0),1.0f);
+    ActionRunner::Handle first = runner->activate(move,node);
+    CUAssertLog(first != 0, "Method activate() failed");
+    CUAssertLog(runner->isActive(first), "Method isActive() failed");
+    CUAssertLog(runner->size() == 1, "Method size() failed");
+
+    runner->pause(first);
+    runner->update(0.5f);
+    CUAssertLog(runner->isPaused(first), "Method pause() failed");
+    CUAssertLog(node->getPosition().equals(Vec2::ZERO,SCENE_EPSILON), "Paused tween was updated");
+    runner->unpause(first);
+    runner->update(0.5f);
+    CUAssertLog(node->getPosition().equals(Vec2(5,0),SCENE_EPSILON), "Method update() failed");
+    
+    CUAssertLog(runner->remove(first), "Method remove() failed");
+    CUAssertLog(!runner->isActive(first), "Method remove() failed");
+    CUAssertLog(runner->size() == 0, "Method remove() failed");
+    CUAssertLog(!runner->remove(first), "Method remove() accepted a stale handle");
+    
+#pragma mark Handle Reuse
+    ActionRunner::Handle second = runner->activate(move,node);
+    CUAssertLog(second != first, "Released handle was reissued");
+    CUAssertLog((Uint32)second == (Uint32)first, "Released slot was not reused");
+    CUAssertLog(!runner->isActive(first), "Stale handle is active again");
+    CUAssertLog(runner->isActive(second), "Method activate() failed");
+    runner->pause(first);
+    CUAssertLog(!runner->isPaused(second), "Stale handle paused a new tween");
+
+    // Removing a record moves the last one into its place
+    std::shared_ptr<SceneNode> other = SceneNode::alloc();
+    ActionRunner::Handle third = runner->activate(move,other);
+    runner->remove(second);
+    CUAssertLog(runner->isActive(third), "Swap on remove lost a handle");
+    runner->update(1.0f);
+    CUAssertLog(other->getPosition().equals(Vec2(10,0),SCENE_EPSILON), "Swap on remove lost a tween");
+    CUAssertLog(!runner->isActive(third), "Completed tween is still active");
+
+#pragma mark Completion
+    std::shared_ptr<SceneNode> target = SceneNode::alloc();
+    target->setColor(Color4::WHITE);
+    ActionRunner::Handle handles[4];
+    handles[0] = runner->activate(MoveTo::alloc(Vec2(4,8),1.0f),target);
+    handles[1] = runner->activate(RotateBy::alloc(M_PI/2,0.5f),target);
+    handles[2] = runner->activate(ScaleTo::alloc(Vec2(2,3),1.0f),target,EasingFunction::Type::QUAD_IN_OUT);
+    handles[3] = runner->activate(FadeOut::alloc(0.25f),target);
+    CUAssertLog(runner->size() == 4, "Method activate() failed");
+    
+    for(int ii = 0; ii < 4; ii++) {
+        runner->update(0.3f);
+    }
+    for(int ii = 0; ii < 4; ii++) {
+        CUAssertLog(!runner->isActive(handles[ii]), "Tween %d did not complete", ii);
+    }
+    CUAssertLog(runner->size() == 0, "Completed tweens were not released");
+    CUAssertLog(target->getPosition().equals(Vec2(4,8),SCENE_EPSILON), "MoveTo did not complete");
+    CUAssertLog(std::fabs(target->getAngle()-M_PI/2) < SCENE_EPSILON, "RotateBy did not complete");
+    CUAssertLog(target->getScale().equals(Vec2(2,3),SCENE_EPSILON), "ScaleTo did not complete");
+    CUAssertLog(target->getColor().a == 0, "FadeOut did not complete");
+    
+    std::shared_ptr<Texture> sheet = Texture::alloc(64,64);
+    std::shared_ptr<SpriteNode> strip = SpriteNode::alloc(sheet,2,2);
+    ActionRunner::Handle animate = runner->activate(Animate::alloc(0,3,1.0f),strip);
+    runner->update(0.6f);
+    CUAssertLog(runner->isActive(animate), "Animate completed early");
+    CUAssertLog(strip->getFrame() == 2, "Animate failed at frame %d", strip->getFrame());
+    runner->update(0.6f);
+    CUAssertLog(!runner->isActive(animate), "Animate did not complete");
+    CUAssertLog(strip->getFrame() == 3, "Animate failed at frame %d", strip->getFrame());
+    
+    // Clearing a node removes every tween on it, but no others
+    runner->activate(move,target);
+    runner->activate(RotateBy::alloc(1.0f,1.0f),target);
+    ActionRunner::Handle kept = runner->activate(move,other);
+    runner->clearAllActions(target);
+    CUAssertLog(runner->size() == 1, "Method clearAllActions() failed");
+    CUAssertLog(runner->isActive(kept), "Method clearAllActions() removed the wrong tween");
+
+#pragma mark Complete
+    CULog("ActionRunner tests complete.\n");
+}
+
+
+#pragma mark -
+#pragma mark Instanced Sprites
+
+void testInstancedSprites() {
+    CULog("Running tests for InstancedSpriteNode.\n");
+    std::shared_ptr<Texture> sheet = Texture::alloc(64,64);
+    std::shared_ptr<InstancedSpriteNode> layer = InstancedSpriteNode::alloc(sheet,2,3,5);
+    CUAssertLog(layer->getFrameCount() == 5, "Method getFrameCount() failed");
+    CUAssertLog(layer->getFrameSize().equals(Size(64/3.0f,32)), "Method getFrameSize() failed");
+    
+#pragma mark Slot Reuse
+    size_t a = layer->addSprite(Vec2(1,2));
+    size_t b = layer->addSprite(Vec2(3,4),1);
+    size_t c = layer->addSprite(Vec2(5,6),2);
+    CUAssertLog(a == 0 && b == 1 && c == 2, "Method addSprite() failed");
+    CUAssertLog(layer->getSpriteCount() == 3, "Method getSpriteCount() failed");
+    
+    layer->removeSprite(b);
+    CUAssertLog(!layer->hasSprite(b), "Method removeSprite() failed");
+    CUAssertLog(layer->getSpriteCount() == 2, "Method removeSprite() failed");
+    CUAssertLog(layer->getSpritePosition(c).equals(Vec2(5,6)), "Method removeSprite() moved a sprite");
+    
+    // A removed slot is reused, with none of its old state
+    layer->setSpriteFrame(a,4);
+    layer->removeSprite(a);
+    size_t d = layer->addSprite(Vec2(7,8));
+    CUAssertLog(d == a, "Method addSprite() did not reuse a slot");
+    CUAssertLog(layer->getSpriteFrame(d) == 0, "Reused slot kept its frame");
+    CUAssertLog(layer->getSpritePosition(d).equals(Vec2(7,8)), "Reused slot kept its position");
+    CUAssertLog(layer->addSprite(Vec2::ZERO) == b, "Method addSprite() did not reuse a slot");
+    CUAssertLog(layer->addSprite(Vec2::ZERO) == 3, "Method addSprite() failed");
+    CUAssertLog(layer->getSpriteCount() == 4, "Method getSpriteCount() failed");
+    
+#pragma mark Frame Stepping
+    layer->clearSprites();
+    size_t loop = layer->addSprite(Vec2::ZERO);
+    size_t once = layer->addSprite(Vec2::ZERO);
+    size_t idle = layer->addSprite(Vec2::ZERO,3);
+    layer->animateSprite(loop,1,3,10);
+    layer->animateSprite(once,0,2,10,false);
+    CUAssertLog(layer->getSpriteFrame(loop) == 1, "Method animateSprite() failed");
+    
+    layer->update(0.05f);
+    CUAssertLog(layer->getSpriteFrame(loop) == 1, "Method update() stepped early");
+    layer->update(0.06f);
+    CUAssertLog(layer->getSpriteFrame(loop) == 2, "Method update() failed");
+    CUAssertLog(layer->getSpriteFrame(once) == 1, "Method update() failed");
+    
+    // A long step advances several frames, and loops back to the first
+    layer->update(0.2f);
+    CUAssertLog(layer->getSpriteFrame(loop) == 1, "Method update() did not loop");
+    CUAssertLog(layer->getSpriteFrame(once) == 2, "Method update() failed");
+    CUAssertLog(!layer->isAnimating(once), "One shot animation did not stop");
+    CUAssertLog(layer->isAnimating(loop), "Looping animation stopped");
+    CUAssertLog(layer->getSpriteFrame(idle) == 3, "Method update() moved an idle sprite");
+    
+    // Removed sprites are not stepped
+    layer->removeSprite(loop);
+    layer->update(1.0f);
+    size_t next = layer->addSprite(Vec2::ZERO,4);
+    CUAssertLog(next == loop && layer->getSpriteFrame(next) == 4, "Method update() stepped a removed sprite");
+
+#pragma mark Complete
+    CULog("InstancedSpriteNode tests complete.\n");
+}
+
+
+#pragma mark -
+#pragma mark Main
+
+void scene2UnitTest() {
+    testActionRunner();
+    testInstancedSprites();
+}
+
+}
@@ -0,0 +1,20 @@
+//
+//  TCUSceneTest.h
+//  CUGL
+//
+//  Copyright © 2016 Game Design Initiative at Cornell. All rights reserved.
+//
+
+#ifndef __T_CU_SCENE_TEST_H__
+#define __T_CU_SCENE_TEST_H__
+
+namespace cugl {
+
+void testActionRunner();
+
+void testInstancedSprites();
+
+void scene2UnitTest();
+
+}
+#endif /* __T_CU_SCENE_TEST_H__ */
@@ -14,6 +14,8 @@
 
 #include "TCUMathTest.h"
 #include "TCU2DTest.h"
+#include "TCURenderTest.h"
+#include "TCUSceneTest.h"
 
 #include <Accelerate/Accelerate.h>
 
@@ -198,6 +200,8 @@ int main(int argc, char * argv[]) {
     cugl::mathUnitTest();
 
     //cugl::sceneUnitTest();
+    cugl::renderUnitTest();
+    cugl::scene2UnitTest();
     //testBinary();
     //testFree();
     //testThread();
@@ -1,8 +1,16 @@
 #include "GameApp.h"
 
+#include "generators/LevelGeneratorBenchmark.h"
 #include "loaders/CustomScene2Loader.h"
 
 void GameApp::onStartup() {
+  if (!_level_benchmark_path.empty()) {
+    runLevelBenchmark();
+    quit();
+    cugl::Application::onStartup();
+    return;
+  }
+
   _assets = cugl::AssetManager::alloc();
   _batch = cugl::SpriteBatch::alloc();
   auto cam = cugl::OrthographicCamera::alloc(getDisplaySize());
@@ -23,8 +31,10 @@ void GameApp::onStartup() {
   _assets->attach<cugl::Font>(cugl::FontLoader::alloc()->getHook());
   _assets->attach<cugl::JsonValue>(cugl::JsonLoader::alloc()->getHook());
   _assets->attach<cugl::WidgetValue>(cugl::WidgetLoader::alloc()->getHook());
-  _assets->attach<cugl::scene2::SceneNode>(
-      cugl::CustomScene2Loader::alloc()->getHook());
+  // Each scene (e.g. a room) is carved out of its own arena.
+  auto scene_loader = cugl::CustomScene2Loader::alloc();
+  scene_loader->setArenaMode(true);
+  _assets->attach<cugl::scene2::SceneNode>(scene_loader->getHook());
 
   // Create a "loading" screen.
   _loaded = false;
@@ -37,6 +47,23 @@ void GameApp::onStartup() {
   cugl::Application::onStartup();  // YOU MUST END with call to parent.
 }
 
+void GameApp::runLevelBenchmark() {
+  std::string path = _level_benchmark_path;
+  if (!cugl::filetool::is_absolute(path)) {
+    path = cugl::filetool::join_path({getSaveDirectory(), path});
+  }
+
+  level_gen::LevelGeneratorBenchmark benchmark;
+  benchmark.addDefaultConfigs();
+  benchmark.addSeeds(0, _level_benchmark_seeds);
+  if (benchmark.run(path)) {
+    CULog("Wrote level generation statistics to %s", path.c_str());
+  } else {
+    CULogError("Could not write level generation statistics to %s",
+               path.c_str());
+  }
+}
+
 void GameApp::onShutdown() {
   _loading.dispose();
   _gameplay.dispose();
@@ -77,6 +104,8 @@ void GameApp::update(float timestep) {
       updateGameScene(timestep);
       break;
   }
+  // Warn if some scene keeps looking up its nodes by name every frame.
+  cugl::scene2::SceneNode::checkNameLookups();
 }
 
 void GameApp::draw() {
@@ -60,14 +60,33 @@ class GameApp : public cugl::Application {
   /** Whether or not we have finished loading the level */
   bool _level_loaded;
 
+  /** The CSV file to write level generation statistics to, if benchmarking. */
+  std::string _level_benchmark_path;
+
+  /** The number of seeds to generate per config when benchmarking. */
+  int _level_benchmark_seeds;
+
  public:
   GameApp()
       : cugl::Application(),
         _loaded(false),
         _level_loaded(false),
+        _level_benchmark_seeds(0),
         _scene(State::LOAD) {}
   ~GameApp() {}
 
+  /**
+   * Run the level generation benchmark instead of the game. The application
+   * generates the levels on startup, writes the statistics and quits.
+   *
+   * @param path The CSV file to write, relative to the save directory.
+   * @param seeds The number of seeds to generate per config.
+   */
+  void setLevelBenchmark(const std::string &path, int seeds) {
+    _level_benchmark_path = path;
+    _level_benchmark_seeds = seeds;
+  }
+
 #pragma mark Application State
   /**
    * The method called after OpenGL is initialized, but before running the
@@ -180,6 +199,12 @@ class GameApp : public cugl::Application {
    * @param timestep  The amount of time (in seconds) since the last frame
    */
   void updateGameScene(float timestep);
+
+  /**
+   * Generate the benchmark levels and write their statistics to the
+   * benchmark CSV file.
+   */
+  void runLevelBenchmark();
 };
 
 #endif /* GAMEAPP_H_ */
@@ -47,6 +47,7 @@ bool EnemyController::init(
   _world = world;
   _world_node = world_node;
   _debug_node = debug_node;
+  _projectile_layer = nullptr;
 
   return true;
 }
@@ -96,23 +97,31 @@ void EnemyController::update(float timestep, std::shared_ptr<EnemyModel> enemy,
 void EnemyController::updateProjectiles(float timestep,
                                         std::shared_ptr<EnemyModel> enemy) {
   auto proj = enemy->getProjectiles();
+  if (proj.empty()) return;
+
+  // All projectiles of this controller share one layer and one draw call
+  if (_projectile_layer == nullptr) {
+    _projectile_layer = cugl::scene2::InstancedSpriteNode::alloc(
+        _projectile_texture, 1, 1);
+  }
+  if (_projectile_layer->getParent() == nullptr) {
+    _world_node->addChild(_projectile_layer);
+  }
+
   auto it = proj.begin();
   while (it != proj.end()) {
     // Add to world if needed
-    if ((*it)->getNode() == nullptr) {
+    if (!(*it)->hasSprite()) {
       _world->addObstacle((*it));
-      auto proj_node =
-          cugl::scene2::SpriteNode::alloc(_projectile_texture, 1, 1);
-      proj_node->setPosition((*it)->getPosition());
-      (*it)->setNode(proj_node);
-      _world_node->addChild(proj_node);
+      size_t sprite = _projectile_layer->addSprite((*it)->getPosition());
+      (*it)->setSprite(_projectile_layer, sprite);
       (*it)->setDebugScene(_debug_node);
       (*it)->setDebugColor(cugl::Color4f::BLACK);
       (*it)->setInWorld(true);
     }
 
     (*it)->decrementFrame(1);
-    (*it)->getNode()->setPosition((*it)->getPosition());
+    (*it)->updateSprite();
     ++it;
   }
 }
@@ -12,6 +12,8 @@ class EnemyController {
  protected:
   /** The projectile texture. */
   std::shared_ptr<cugl::Texture> _projectile_texture;
+  /** The layer drawing every projectile of this controller in one batch. */
+  std::shared_ptr<cugl::scene2::InstancedSpriteNode> _projectile_layer;
   /** A reference to the world node. */
   std::shared_ptr<cugl::scene2::SceneNode> _world_node;
   /** A reference to the debug node. */
@@ -45,7 +47,10 @@ class EnemyController {
   /**
    * Disposes the controller.
    */
-  void dispose() { _projectile_texture = nullptr; }
+  void dispose() {
+    _projectile_texture = nullptr;
+    _projectile_layer = nullptr;
+  }
 
 #pragma mark Static Constructors
   /**
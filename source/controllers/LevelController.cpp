@@ -64,7 +64,7 @@ void LevelController::changeRoom(std::string &door_sensor_name) {
   cugl::Vec2 door_pos = current->getPosOfDestinationDoor(door_sensor_name);
 
   // Update the map SceneNodes.
-  for (std::shared_ptr<level_gen::Room> &room : _level_gen->getRooms()) {
+  for (const std::shared_ptr<level_gen::Room> &room : _level_gen->getRooms()) {
     if (room->_key == current->getKey()) {
       room->_node->setColor(room->getRoomNodeColor());
     }
@@ -141,6 +141,8 @@ void LevelController::populate() {
 
     _world_node->addChild(room_node);
   }
+
+  _level_model->buildGraph();
 }
 
 void LevelController::instantiateWorld() {
@@ -149,7 +151,7 @@ void LevelController::instantiateWorld() {
   cugl::Vec2 world_end;
 
   // Get Size of World.
-  for (std::shared_ptr<level_gen::Room> room : _level_gen->getRooms()) {
+  for (const std::shared_ptr<level_gen::Room> &room : _level_gen->getRooms()) {
     cugl::Vec2 pos = room->getRect().origin * (TILE_SIZE * TILE_SCALE);
     cugl::Vec2 size =
         ((cugl::Vec2)room->getRect().size) * (TILE_SIZE * TILE_SCALE);
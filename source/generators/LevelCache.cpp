@@ -0,0 +1,109 @@
+#include "LevelCache.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace level_gen {
+
+bool LevelCache::init(const std::string &directory, bool verify) {
+  _directory = directory;
+  _verify = verify;
+  if (cugl::filetool::is_dir(_directory)) return true;
+  return cugl::filetool::dir_create(_directory);
+}
+
+Uint64 LevelCache::getKey(const LevelGeneratorConfig &config, Uint64 seed) {
+  // Mix the seed and generator version into the config hash (FNV-1a, one
+  // byte at a time).
+  Uint64 key = config.getHash();
+  Uint64 version = LEVEL_GENERATOR_VERSION;
+  for (Uint64 value : {seed, version}) {
+    for (int i = 0; i < 8; i++) {
+      key ^= (value >> (8 * i)) & 0xFF;
+      key *= 1099511628211ULL;
+    }
+  }
+  return key;
+}
+
+bool LevelCache::load(const LevelGeneratorConfig &config, Uint64 seed,
+                      std::vector<uint8_t> &data) const {
+  std::string path = getPath(getKey(config, seed));
+  if (!cugl::filetool::file_exists(path)) return false;
+
+  size_t size = cugl::filetool::file_size(path);
+  std::shared_ptr<cugl::BinaryReader> reader = cugl::BinaryReader::alloc(path);
+  if (reader == nullptr || size == 0) return false;
+
+  data.resize(size);
+  size_t read = reader->read(data.data(), size);
+  reader->close();
+  if (read != size) {
+    data.clear();
+    return false;
+  }
+  return true;
+}
+
+bool LevelCache::save(const LevelGeneratorConfig &config, Uint64 seed,
+                      const LevelGenerator &generator) const {
+  std::vector<uint8_t> data = generator.serialize();
+  std::string path = getPath(getKey(config, seed));
+
+  std::shared_ptr<cugl::BinaryWriter> writer = cugl::BinaryWriter::alloc(path);
+  if (writer == nullptr) return false;
+  writer->write(data.data(), data.size());
+  writer->close();
+  prune();
+  return true;
+}
+
+bool LevelCache::verify(const LevelGeneratorConfig &config, Uint64 seed,
+                        const LevelGenerator &generator) const {
+  std::vector<uint8_t> cached;
+  if (!load(config, seed, cached)) {
+    save(config, seed, generator);
+    return true;
+  }
+
+  std::vector<uint8_t> generated = generator.serialize();
+  if (cached == generated) return true;
+
+  auto mismatch = std::mismatch(cached.begin(), cached.end(),
+                                generated.begin(), generated.end());
+  CULogError(
+      "Cached level %016" PRIx64 " differs from the generated level at byte "
+      "%zu (cached %zu bytes, generated %zu bytes)",
+      getKey(config, seed),
+      static_cast<size_t>(mismatch.first - cached.begin()), cached.size(),
+      generated.size());
+  return false;
+}
+
+std::string LevelCache::getPath(Uint64 key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016" PRIx64 ".level", key);
+  return cugl::filetool::join_path({_directory, name});
+}
+
+void LevelCache::prune() const {
+  std::vector<std::string> files = cugl::filetool::dir_contents(
+      _directory, [](const std::string file) {
+        const std::string suffix = ".level";
+        return file.size() >= suffix.size() &&
+               file.compare(file.size() - suffix.size(), suffix.size(),
+                            suffix) == 0;
+      });
+  if (files.size() <= MAX_CACHED_LEVELS) return;
+
+  std::vector<std::pair<Uint64, std::string>> dated;
+  for (const std::string &file : files) {
+    dated.emplace_back(cugl::filetool::file_timestamp(file), file);
+  }
+  std::sort(dated.begin(), dated.end());
+  for (size_t i = 0; i < dated.size() - MAX_CACHED_LEVELS; i++) {
+    cugl::filetool::file_delete(dated[i].second);
+  }
+}
+
+}  // namespace level_gen
@@ -0,0 +1,111 @@
+#ifndef GENERATORS_LEVEL_CACHE_H
+#define GENERATORS_LEVEL_CACHE_H
+#include <cugl/cugl.h>
+
+#include "LevelGenerator.h"
+#include "LevelGeneratorConfig.h"
+
+/** The maximum number of levels kept in the cache directory. */
+#define MAX_CACHED_LEVELS 32
+
+namespace level_gen {
+
+/**
+ * An on-disk cache of generated levels. Every client generates the same level
+ * from the shared seed, so a level that was generated once (e.g. in a
+ * rematch) can be loaded instead of generated again.
+ *
+ * Levels are keyed by the hash of the LevelGeneratorConfig, the seed and the
+ * LEVEL_GENERATOR_VERSION, and are stored in the format given by
+ * LevelGenerator::serialize(). Only the MAX_CACHED_LEVELS most recently saved
+ * levels are kept.
+ */
+class LevelCache {
+ private:
+  /** The directory where the cached levels are stored. */
+  std::string _directory;
+
+  /**
+   * If the cache is in verification mode. In this mode, levels are always
+   * generated and then compared against the cached version.
+   */
+  bool _verify;
+
+ public:
+  /** Construct an empty level cache. Must call init() before use. */
+  LevelCache() : _verify(false) {}
+
+  /**
+   * Initialize the cache in the given directory. The directory is created if
+   * it does not exist.
+   *
+   * @param directory The directory to store the cached levels in.
+   * @param verify If the cache should verify cached levels.
+   * @return false if the directory could not be created.
+   */
+  bool init(const std::string &directory, bool verify = false);
+
+  /**
+   * Returns the key of the level generated from the given config and seed.
+   *
+   * @param config The config used for generation.
+   * @param seed The seed used for generation.
+   * @return The key of the level.
+   */
+  static Uint64 getKey(const LevelGeneratorConfig &config, Uint64 seed);
+
+  /** @return If the cache is in verification mode. */
+  bool isVerifying() const { return _verify; }
+
+  /**
+   * Load the cached level for the given config and seed.
+   *
+   * @param config The config used for generation.
+   * @param seed The seed used for generation.
+   * @param data The vector to write the serialized level to.
+   * @return false if the level is not in the cache.
+   */
+  bool load(const LevelGeneratorConfig &config, Uint64 seed,
+            std::vector<uint8_t> &data) const;
+
+  /**
+   * Store the level generated from the given config and seed.
+   *
+   * @param config The config used for generation.
+   * @param seed The seed used for generation.
+   * @param generator A generator that is done generating.
+   * @return false if the level could not be written.
+   */
+  bool save(const LevelGeneratorConfig &config, Uint64 seed,
+            const LevelGenerator &generator) const;
+
+  /**
+   * Check that a freshly generated level is bit-identical to the cached one.
+   * Mismatches are logged. If the level is not in the cache, it is saved.
+   *
+   * @param config The config used for generation.
+   * @param seed The seed used for generation.
+   * @param generator A generator that is done generating.
+   * @return false if the cached level differs from the generated level.
+   */
+  bool verify(const LevelGeneratorConfig &config, Uint64 seed,
+              const LevelGenerator &generator) const;
+
+ private:
+  /**
+   * Returns the path to the cache file for the given key.
+   *
+   * @param key The key of the level.
+   * @return The path to the cache file.
+   */
+  std::string getPath(Uint64 key) const;
+
+  /**
+   * Deletes the oldest cached levels until at most MAX_CACHED_LEVELS remain.
+   */
+  void prune() const;
+};
+
+}  // namespace level_gen
+
+#endif /* GENERATORS_LEVEL_CACHE_H */
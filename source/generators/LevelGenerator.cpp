@@ -12,7 +12,31 @@
 
 namespace level_gen {
 
-LevelGenerator::LevelGenerator() : _active(false), _generator_step(nullptr) {}
+namespace {
+
+/** The version of the format written by LevelGenerator::serialize(). */
+constexpr Uint32 kSerialVersion = 1;
+
+/**
+ * Read the next value from the deserializer if it has the given type.
+ *
+ * @param deserializer The deserializer to read from.
+ * @param value The value to write the result to.
+ * @return false if the next value is missing or has a different type.
+ */
+template <typename T>
+bool readValue(cugl::NetworkDeserializer &deserializer, T &value) {
+  cugl::NetworkDeserializer::Message message = deserializer.read();
+  const T *result = std::get_if<T>(&message);
+  if (result == nullptr) return false;
+  value = *result;
+  return true;
+}
+
+}  // namespace
+
+LevelGenerator::LevelGenerator()
+    : _active(false), _stats(), _generator_step(nullptr) {}
 
 void LevelGenerator::init(LevelGeneratorConfig &config,
                           const std::shared_ptr<cugl::scene2::SceneNode> &map) {
@@ -21,6 +45,7 @@ void LevelGenerator::init(LevelGeneratorConfig &config,
 
   _config = config;
   _map = map;
+  _stats = Stats();
   _generator_step = [this]() { this->generateRooms(); };
   std::random_device my_random_device;
   unsigned seed = my_random_device();
@@ -35,6 +60,7 @@ void LevelGenerator::init(LevelGeneratorConfig &config,
 
   _config = config;
   _map = map;
+  _stats = Stats();
   _generator_step = [this]() { this->generateRooms(); };
   _generator = std::default_random_engine(seed);
 }
@@ -44,14 +70,153 @@ void LevelGenerator::dispose() {
   _active = false;
 
   _rooms.clear();
-  _inside_rooms.clear();
-  _middle_rooms.clear();
-  _outside_rooms.clear();
+  _inside.clear();
+  _middle.clear();
+  _outside.clear();
+  _edges.clear();
+  _stats = Stats();
   _spawn_room = nullptr;
   _map = nullptr;
   _generator_step = nullptr;
 }
 
+bool LevelGenerator::initWithData(
+    LevelGeneratorConfig &config,
+    const std::shared_ptr<cugl::scene2::SceneNode> &map,
+    const std::vector<uint8_t> &data) {
+  if (_active) return false;
+
+  cugl::NetworkDeserializer deserializer;
+  deserializer.receive(data);
+
+  Uint32 version, num_rooms, num_level_rooms, spawn_ii;
+  if (!readValue(deserializer, version) || version != kSerialVersion) {
+    return false;
+  }
+  if (!readValue(deserializer, num_rooms) ||
+      !readValue(deserializer, num_level_rooms) ||
+      !readValue(deserializer, spawn_ii)) {
+    return false;
+  }
+  if (num_level_rooms > num_rooms || spawn_ii >= num_level_rooms) return false;
+
+  std::vector<std::shared_ptr<Room>> rooms;
+  for (Uint32 i = 0; i < num_rooms; i++) {
+    default_rooms::RoomConfig room_config;
+    std::vector<float> shape;
+    Uint32 type, color;
+    bool fixed;
+    Sint32 num_players;
+    if (!readValue(deserializer, room_config.scene2_source) ||
+        !readValue(deserializer, shape) || !readValue(deserializer, type) ||
+        !readValue(deserializer, fixed) ||
+        !readValue(deserializer, num_players) ||
+        !readValue(deserializer, color)) {
+      return false;
+    }
+    if (shape.size() < 4 || shape.size() % 2 != 0) return false;
+
+    room_config.size.set(shape[2], shape[3]);
+    for (int j = 4; j < shape.size(); j += 2) {
+      room_config.doors.push_back(cugl::Vec2(shape[j], shape[j + 1]));
+    }
+
+    auto room = std::make_shared<Room>(room_config);
+    room->_type = static_cast<RoomType>(type);
+    room->_fixed = fixed;
+    room->_num_players_for_terminal = num_players;
+    room->_node->setAnchor(cugl::Vec2::ANCHOR_BOTTOM_LEFT);
+    room->_node->setPosition(shape[0], shape[1]);
+    room->_node->setColor(cugl::Color4(color));
+    rooms.push_back(room);
+  }
+
+  std::vector<Uint32> edges;
+  if (!readValue(deserializer, edges) || edges.size() % 4 != 0) return false;
+  for (int i = 0; i < edges.size(); i += 4) {
+    if (edges[i] >= num_rooms || edges[i + 1] >= num_rooms) return false;
+  }
+
+  _active = true;
+  _config = config;
+  _map = map;
+  _generator_step = nullptr;
+
+  _rooms.assign(rooms.begin(), rooms.begin() + num_level_rooms);
+  _spawn_room = rooms[spawn_ii];
+  for (std::shared_ptr<Room> &room : _rooms) {
+    _map->addChild(room->_node);
+  }
+
+  for (int i = 0; i < edges.size(); i += 4) {
+    auto edge = std::make_shared<Edge>(rooms[edges[i]], rooms[edges[i + 1]]);
+    edge->_active = (edges[i + 2] & 1) != 0;
+    edge->_node->setVisible((edges[i + 2] & 2) != 0);
+    edge->_node->setColor(cugl::Color4(edges[i + 3]));
+    edge->_source->addEdge(edge);
+    edge->_neighbor->addEdge(edge);
+    _map->addChild(edge->_node);
+    _edges.push_back(edge);
+  }
+
+  _map->doLayout();
+  return true;
+}
+
+std::vector<uint8_t> LevelGenerator::serialize() const {
+  // Rooms replaced by terminals are not part of the level, but may still be
+  // referenced by edges, so they are stored after the level rooms.
+  std::vector<std::shared_ptr<Room>> rooms(_rooms);
+  std::unordered_map<Room *, Uint32> room_to_index;
+  for (Uint32 i = 0; i < rooms.size(); i++) {
+    room_to_index[rooms[i].get()] = i;
+  }
+  for (const std::shared_ptr<Edge> &edge : _edges) {
+    for (const std::shared_ptr<Room> &room : {edge->_source, edge->_neighbor}) {
+      if (room_to_index.find(room.get()) == room_to_index.end()) {
+        room_to_index[room.get()] = static_cast<Uint32>(rooms.size());
+        rooms.push_back(room);
+      }
+    }
+  }
+
+  cugl::NetworkSerializer serializer;
+  serializer.writeUint32(kSerialVersion);
+  serializer.writeUint32(static_cast<Uint32>(rooms.size()));
+  serializer.writeUint32(static_cast<Uint32>(_rooms.size()));
+  auto spawn = room_to_index.find(_spawn_room.get());
+  serializer.writeUint32(spawn != room_to_index.end() ? spawn->second : 0);
+
+  for (const std::shared_ptr<Room> &room : rooms) {
+    serializer.writeString(room->_scene2_source);
+    std::vector<float> shape{room->_node->getPositionX(),
+                             room->_node->getPositionY(),
+                             room->_node->getContentWidth(),
+                             room->_node->getContentHeight()};
+    for (const cugl::Vec2 &door : room->_doors) {
+      shape.push_back(door.x);
+      shape.push_back(door.y);
+    }
+    serializer.writeFloatVector(shape);
+    serializer.writeUint32(static_cast<Uint32>(room->_type));
+    serializer.writeBool(room->_fixed);
+    serializer.writeSint32(room->_num_players_for_terminal);
+    serializer.writeUint32(room->_node->getColor().getRGBA());
+  }
+
+  std::vector<Uint32> edges;
+  for (const std::shared_ptr<Edge> &edge : _edges) {
+    edges.push_back(room_to_index[edge->_source.get()]);
+    edges.push_back(room_to_index[edge->_neighbor.get()]);
+    edges.push_back((edge->_active ? 1 : 0) |
+                    (edge->_node->isVisible() ? 2 : 0));
+    edges.push_back(edge->_node->getColor().getRGBA());
+  }
+  serializer.writeUint32Vector(edges);
+
+  return serializer.serialize();
+}
+
 bool LevelGenerator::update() {
   if (_generator_step != nullptr) {
     _generator_step();
@@ -61,6 +226,7 @@ bool LevelGenerator::update() {
 }
 
 void LevelGenerator::generateRooms() {
+  cugl::Timestamp start;
   _spawn_room = std::make_shared<Room>(default_rooms::kSpawn);
   _spawn_room->_type = RoomType::SPAWN;
   _spawn_room->_fixed = true;
@@ -68,7 +234,7 @@ void LevelGenerator::generateRooms() {
   _spawn_room->_node->setPosition(_spawn_room->_node->getContentSize() / -2.0f);
   _spawn_room->_node->setColor(_spawn_room->getRoomNodeColor());
   _rooms.push_back(_spawn_room);
-  _inside_rooms.push_back(_spawn_room);
+  _inside.rooms.push_back(_spawn_room);
   _map->addChild(_spawn_room->_node);
 
   float min_radius = _spawn_room->getRadius();
@@ -76,6 +242,8 @@ void LevelGenerator::generateRooms() {
   placeRegularRooms(_config.getNumRooms(), min_radius,
                     _config.getMiddleCircleRadius());
 
+  _stats.placement_micros += cugl::Timestamp().ellapsedMicros(start);
+
   _generator_step = [this]() {
     this->separateRooms([this]() { this->placeTerminals(); });
   };
@@ -116,10 +284,13 @@ void LevelGenerator::placeRegularRooms(int num_rooms, float min_radius,
 
 void LevelGenerator::separateRooms(
     std::function<void(void)> next_generator_step) {
+  cugl::Timestamp start;
   if (!anyRoomsOverlapping()) {
+    _stats.separation_micros += cugl::Timestamp().ellapsedMicros(start);
     _generator_step = next_generator_step;
     return;
   }
+  _stats.separation_iterations++;
   for (int i = 0; i < _rooms.size(); i++) {
     std::shared_ptr<Room> &room = _rooms[i];
     cugl::Rect room_rect = room->getRect();
@@ -139,6 +310,7 @@ void LevelGenerator::separateRooms(
       }
     }
   }
+  _stats.separation_micros += cugl::Timestamp().ellapsedMicros(start);
 }
 
 bool LevelGenerator::anyRoomsOverlapping() {
@@ -174,6 +346,7 @@ std::shared_ptr<Room> LevelGenerator::roomMostOverlappingWith(
 }
 
 void LevelGenerator::placeTerminals() {
+  cugl::Timestamp start;
   float min_radius = _spawn_room->getRadius();
 
   std::vector<std::shared_ptr<Room>> inner_terminals =
@@ -203,13 +376,14 @@ void LevelGenerator::placeTerminals() {
         outer_terminals_required_players(_generator);
   }
 
-  _inside_rooms.insert(_inside_rooms.end(), inner_terminals.begin(),
+  _inside.rooms.insert(_inside.rooms.end(), inner_terminals.begin(),
                        inner_terminals.end());
-  _middle_rooms.insert(_middle_rooms.end(), middle_terminals.begin(),
+  _middle.rooms.insert(_middle.rooms.end(), middle_terminals.begin(),
                        middle_terminals.end());
-  _outside_rooms.insert(_outside_rooms.end(), outer_terminals.begin(),
+  _outside.rooms.insert(_outside.rooms.end(), outer_terminals.begin(),
                         outer_terminals.end());
 
+  _stats.placement_micros += cugl::Timestamp().ellapsedMicros(start);
   _generator_step = [this]() {
     this->separateRooms([this]() { this->segregateLayers(); });
   };
@@ -269,6 +443,7 @@ std::vector<std::shared_ptr<Room>> LevelGenerator::placeTerminalRooms(
 }
 
 void LevelGenerator::segregateLayers() {
+  cugl::Timestamp start;
   std::vector<std::shared_ptr<Room>> inside_rooms;
   std::copy_if(_rooms.begin(), _rooms.end(), std::back_inserter(inside_rooms),
                [this](const std::shared_ptr<Room> &room) {
@@ -294,22 +469,22 @@ void LevelGenerator::segregateLayers() {
                             this->_config.getMiddleCircleRadius();
                });
 
-  _inside_rooms.insert(_inside_rooms.end(), inside_rooms.begin(),
+  _inside.rooms.insert(_inside.rooms.end(), inside_rooms.begin(),
                        inside_rooms.end());
-  _middle_rooms.insert(_middle_rooms.end(), middle_rooms.begin(),
+  _middle.rooms.insert(_middle.rooms.end(), middle_rooms.begin(),
                        middle_rooms.end());
-  _outside_rooms.insert(_outside_rooms.end(), outside_rooms.begin(),
+  _outside.rooms.insert(_outside.rooms.end(), outside_rooms.begin(),
                         outside_rooms.end());
 
   float inner_circle_expansion_factor = 1.2f;
 
-  for (std::shared_ptr<Room> &room : _inside_rooms) {
+  for (std::shared_ptr<Room> &room : _inside.rooms) {
     cugl::Vec2 pos = room->getMid() * inner_circle_expansion_factor;
     pos -= room->_node->getSize() / 2.0f;
     room->_node->setPosition(roundf(pos.x), roundf(pos.y));
   }
 
-  for (std::shared_ptr<Room> &room : _middle_rooms) {
+  for (std::shared_ptr<Room> &room : _middle.rooms) {
     cugl::Vec2 pos = room->getMid() * inner_circle_expansion_factor;
     pos += room->getMid().getNormalization() *
            _config.getSeparationBetweenLayers() * inner_circle_expansion_factor;
@@ -318,7 +493,7 @@ void LevelGenerator::segregateLayers() {
     room->_node->setPosition(roundf(pos.x), roundf(pos.y));
   }
 
-  for (std::shared_ptr<Room> &room : _outside_rooms) {
+  for (std::shared_ptr<Room> &room : _outside.rooms) {
     cugl::Vec2 pos = room->getMid() * inner_circle_expansion_factor;
     pos += room->getMid().getNormalization() *
            _config.getSeparationBetweenLayers() * 2.0f *
@@ -328,36 +503,62 @@ void LevelGenerator::segregateLayers() {
     room->_node->setPosition(roundf(pos.x), roundf(pos.y));
   }
 
+  _stats.segregation_micros += cugl::Timestamp().ellapsedMicros(start);
   _generator_step = [this]() {
     this->separateRooms([this]() { this->markAndFillHallways(); });
   };
 }
 
 void LevelGenerator::markAndFillHallways() {
-  calculateDelaunayTriangles(_inside_rooms, 0.0f);
-  calculateDelaunayTriangles(_middle_rooms, _config.getInnerCircleRadius());
-  calculateDelaunayTriangles(_outside_rooms, _config.getMiddleCircleRadius());
-
-  calculateMinimumSpanningTree(_inside_rooms);
-  calculateMinimumSpanningTree(_middle_rooms);
-  calculateMinimumSpanningTree(_outside_rooms);
-
-  addEdgesBackAndRemoveUnecessary(_inside_rooms);
-  addEdgesBackAndRemoveUnecessary(_middle_rooms);
-  addEdgesBackAndRemoveUnecessary(_outside_rooms);
+  cugl::Timestamp start;
+  calculateDelaunayTriangles(_inside, 0.0f);
+  calculateDelaunayTriangles(_middle, _config.getInnerCircleRadius());
+  calculateDelaunayTriangles(_outside, _config.getMiddleCircleRadius());
+
+  cugl::Timestamp end;
+  _stats.delaunay_micros += cugl::Timestamp::ellapsedMicros(start, end);
+  start = end;
+  calculateMinimumSpanningTree(_inside);
+  calculateMinimumSpanningTree(_middle);
+  calculateMinimumSpanningTree(_outside);
+
+  end.mark();
+  _stats.mst_micros += cugl::Timestamp::ellapsedMicros(start, end);
+  start = end;
+  addEdgesBackAndRemoveUnecessary(_inside);
+  addEdgesBackAndRemoveUnecessary(_middle);
+  addEdgesBackAndRemoveUnecessary(_outside);
+
+  end.mark();
+  _stats.add_edges_back_micros += cugl::Timestamp::ellapsedMicros(start, end);
+  start = end;
+  connectLayers(_inside, _middle, 2);
+  connectLayers(_middle, _outside, 3);
+
+  end.mark();
+  _stats.connect_layers_micros += cugl::Timestamp::ellapsedMicros(start, end);
+  start = end;
+  fillHallways();
 
-  connectLayers(_inside_rooms, _middle_rooms, 2);
-  connectLayers(_middle_rooms, _outside_rooms, 3);
+  end.mark();
+  _stats.hallways_micros += cugl::Timestamp::ellapsedMicros(start, end);
 
-  fillHallways();
+  _stats.num_rooms = static_cast<int>(_rooms.size());
+  _stats.num_edges = static_cast<int>(_edges.size());
+  _stats.num_active_edges = static_cast<int>(
+      std::count_if(_edges.begin(), _edges.end(),
+                    [](const std::shared_ptr<Edge> &e) { return e->_active; }));
 
   _generator_step = [this]() { this->establishGates(); };
 }
 
 void LevelGenerator::establishGates() { _generator_step = nullptr; }
 
-void LevelGenerator::calculateDelaunayTriangles(
-    std::vector<std::shared_ptr<Room>> &rooms, float min_r) {
+void LevelGenerator::calculateDelaunayTriangles(Layer &layer, float min_r) {
+  std::vector<std::shared_ptr<Room>> &rooms = layer.rooms;
+  layer.graph.init(static_cast<int>(rooms.size()));
+  layer.edges.clear();
+  layer.connections.assign(rooms.size(), 0);
   if (rooms.size() == 0) return;
 
   std::vector<double> coords;
@@ -373,13 +574,18 @@ void LevelGenerator::calculateDelaunayTriangles(
 
   for (std::size_t i = 0; i < d.triangles.size(); i++) {
     if (i < d.halfedges[i]) {
-      std::shared_ptr<Room> &node_0 = rooms[d.triangles[i]];
       std::size_t next_node_ii = (i % 3 == 2) ? i - 2 : i + 1;
-      std::shared_ptr<Room> &node_1 = rooms[d.triangles[next_node_ii]];
+      int node_0_ii = static_cast<int>(d.triangles[i]);
+      int node_1_ii = static_cast<int>(d.triangles[next_node_ii]);
+      std::shared_ptr<Room> &node_0 = rooms[node_0_ii];
+      std::shared_ptr<Room> &node_1 = rooms[node_1_ii];
 
       std::shared_ptr<Edge> edge_0_1 = std::make_shared<Edge>(node_0, node_1);
 
       if (min_r == 0.0f || !edge_0_1->doesIntersect(cugl::Vec2::ZERO, min_r)) {
+        layer.graph.addEdge(node_0_ii, node_1_ii, edge_0_1->_weight);
+        layer.edges.push_back(edge_0_1);
+        _edges.push_back(edge_0_1);
         _map->addChild(edge_0_1->_node);
         node_0->addEdge(edge_0_1);
         node_1->addEdge(edge_0_1);
@@ -390,152 +596,128 @@ void LevelGenerator::calculateDelaunayTriangles(
   _map->doLayout();
 }
 
-void LevelGenerator::calculateMinimumSpanningTree(
-    std::vector<std::shared_ptr<Room>> &rooms) {
-  int num_edges = 0;
-  std::vector<std::shared_ptr<Edge>> result;
-  // Reset tree to start Prim's algorithm.
-  for (std::shared_ptr<Room> &room : rooms) {
-    room->_visited = false;
-    for (std::shared_ptr<Edge> edge : room->_edges) {
-      edge->_node->setVisible(false);
-      edge->_active = false;
-    }
-  }
-  rooms[0]->_visited = true;
-
-  while (num_edges < rooms.size() - 1) {
-    std::shared_ptr<Edge> min_edge = nullptr;
-    std::shared_ptr<Room> min_neighbor = nullptr;
-    float min_weight = FLT_MAX;
-
-    for (std::shared_ptr<Room> &room : rooms) {
-      if (room->_visited) {
-        for (std::shared_ptr<Edge> edge : room->_edges) {
-          if (!edge->getOther(room)->_visited && edge->_weight < min_weight) {
-            min_edge = edge;
-            min_neighbor = edge->getOther(room);
-            min_weight = edge->_weight;
-          }
-        }
-      }
-    }
-
-    num_edges++;
-
-    if (min_edge) {
-      min_neighbor->_visited = true;
-      result.push_back(std::move(min_edge));
-    }
-  }
-
-  for (std::shared_ptr<Edge> &edge : result) {
-    edge->_node->setColor(cugl::Color4(255, 14, 14, 124));
-    edge->_node->setVisible(true);
-    edge->_active = true;
-  }
+void LevelGenerator::calculateMinimumSpanningTree(Layer &layer) {
+  layer.graph.calculateMinimumSpanningTree();
+  syncEdges(layer);
 }
 
-void LevelGenerator::addEdgesBackAndRemoveUnecessary(
-    std::vector<std::shared_ptr<Room>> &rooms) {
+void LevelGenerator::addEdgesBackAndRemoveUnecessary(Layer &layer) {
   std::uniform_real_distribution<float> rand(0.0f, 1.0f);
-  for (std::shared_ptr<Room> &room : rooms) {
-    for (std::shared_ptr<Edge> edge : room->_edges) {
-      bool add_back = edge->_weight < _config.getMaxHallwayLength();
+  RoomGraph &graph = layer.graph;
 
-      long num_edges_source = std::count_if(
-          edge->_source->_edges.begin(), edge->_source->_edges.end(),
-          [](const std::shared_ptr<Edge> &edge) { return edge->_active; });
-      long num_edges_neighbor = std::count_if(
-          edge->_neighbor->_edges.begin(), edge->_neighbor->_edges.end(),
-          [](const std::shared_ptr<Edge> &edge) { return edge->_active; });
+  // Every edge is visited once from each of its rooms, so it gets two chances
+  // to be added back.
+  for (int v = 0; v < graph.getNumVertices(); v++) {
+    const int *adjacent = graph.getAdjacentEdges(v);
+    int degree = graph.getDegree(v);
+    for (int i = 0; i < degree; i++) {
+      const RoomGraph::GraphEdge &edge = graph.getEdge(adjacent[i]);
+      bool add_back = edge.weight < _config.getMaxHallwayLength();
 
-      add_back &= num_edges_source < _config.getMaxNumEdges();
-      add_back &= num_edges_neighbor < _config.getMaxNumEdges();
+      add_back &= layer.getActiveDegree(edge.source) < _config.getMaxNumEdges();
+      add_back &=
+          layer.getActiveDegree(edge.neighbor) < _config.getMaxNumEdges();
 
       add_back &= rand(_generator) <= _config.getAddEdgesBackProb();
-      if (!edge->_active && add_back) {
-        edge->_node->setVisible(true);
-        edge->_active = true;
-        edge->_node->setColor(cugl::Color4(255, 14, 14, 124));
+      if (!edge.active && add_back) {
+        graph.setActive(adjacent[i], true);
       }
     }
   }
+
+  syncEdges(layer);
 }
 
-void LevelGenerator::connectLayers(std::vector<std::shared_ptr<Room>> &layer_a,
-                                   std::vector<std::shared_ptr<Room>> &layer_b,
+void LevelGenerator::connectLayers(Layer &layer_a, Layer &layer_b,
                                    int num_connections) {
-  std::vector<std::shared_ptr<Edge>> connections;
+  // Pairs of room indices (a, b) that have been chosen.
+  std::vector<std::pair<int, int>> connections;
 
   std::uniform_real_distribution<float> dis(0.0f, 1.0f);
   float min_angle = dis(_generator) * 2 * M_PI;
   float max_angle = fmod(min_angle + M_PI / num_connections, 2 * M_PI);
 
+  std::vector<float> a_angles;
+  for (std::shared_ptr<Room> &a_room : layer_a.rooms) {
+    float angle = a_room->getMid().getAngle();
+    angle += (angle < 0.0f) ? (2 * M_PI) : 0.0f;
+    a_angles.push_back(angle);
+  }
+
   for (int i = 0; i < num_connections; i++) {
-    std::shared_ptr<Edge> winner;
+    int winner_a = -1;
+    int winner_b = -1;
     float winner_dist = FLT_MAX;
 
-    for (std::shared_ptr<Room> &a_room : layer_a) {
-      float angle = a_room->getMid().getAngle();
-      angle += (angle < 0.0f) ? (2 * M_PI) : 0.0f;
+    for (int a = 0; a < layer_a.rooms.size(); a++) {
+      std::shared_ptr<Room> &a_room = layer_a.rooms[a];
+      float angle = a_angles[a];
 
       bool between_angles = (max_angle > min_angle)
                                 ? (angle >= min_angle && angle <= max_angle)
                                 : (angle >= min_angle || angle <= max_angle);
 
-      if (between_angles && a_room->_type == RoomType::STANDARD) {
-        for (std::shared_ptr<Room> &b_room : layer_b) {
-          if (b_room->_type == RoomType::STANDARD) {
-            // Find if this edge already been chosen.
-            auto curr = std::make_shared<Edge>(a_room, b_room);
-            auto res =
-                std::find_if(connections.begin(), connections.end(),
-                             [curr](const std::shared_ptr<Edge> &edge) {
-                               return *edge == *curr || edge->shareRoom(curr);
-                             });
-
-            long a_num_edges =
-                std::count_if(a_room->_edges.begin(), a_room->_edges.end(),
-                              [](const std::shared_ptr<Edge> &edge) {
-                                return edge->_active;
-                              });
-            long b_num_edges =
-                std::count_if(b_room->_edges.begin(), b_room->_edges.end(),
-                              [](const std::shared_ptr<Edge> &edge) {
-                                return edge->_active;
-                              });
-
-            bool under_limit = a_num_edges < _config.getMaxNumEdges();
-            under_limit &= b_num_edges < _config.getMaxNumEdges();
-
-            if (curr->_weight < winner_dist && under_limit &&
-                res == connections.end()) {
-              winner_dist = curr->_weight;
-              winner = std::move(curr);
-            }
-          }
+      if (!between_angles || a_room->_type != RoomType::STANDARD) continue;
+      if (layer_a.getActiveDegree(a) >= _config.getMaxNumEdges()) continue;
+
+      // Find if a room has already been chosen.
+      bool a_taken = std::any_of(
+          connections.begin(), connections.end(),
+          [a](const std::pair<int, int> &c) { return c.first == a; });
+      if (a_taken) continue;
+
+      cugl::Vec2 a_mid = a_room->getMid();
+      for (int b = 0; b < layer_b.rooms.size(); b++) {
+        std::shared_ptr<Room> &b_room = layer_b.rooms[b];
+        if (b_room->_type != RoomType::STANDARD) continue;
+        if (layer_b.getActiveDegree(b) >= _config.getMaxNumEdges()) continue;
+
+        float dist = (b_room->getMid() - a_mid).length();
+        if (dist >= winner_dist) continue;
+
+        bool b_taken = std::any_of(
+            connections.begin(), connections.end(),
+            [b](const std::pair<int, int> &c) { return c.second == b; });
+        if (!b_taken) {
+          winner_dist = dist;
+          winner_a = a;
+          winner_b = b;
         }
       }
     }
 
-    if (winner) {
-      connections.push_back(winner);
+    if (winner_a >= 0) {
+      connections.push_back(std::make_pair(winner_a, winner_b));
       min_angle = fmod(min_angle + 2 * M_PI / num_connections, 2 * M_PI);
       max_angle = fmod(min_angle + M_PI / num_connections, 2 * M_PI);
     }
   }
 
-  for (std::shared_ptr<Edge> &connection : connections) {
-    connection->_active = true;
-    connection->_source->addEdge(connection);
-    connection->_neighbor->addEdge(connection);
-    connection->_node->setColor(cugl::Color4(15, 15, 230, 147));
-    _map->addChild(connection->_node);
+  for (std::pair<int, int> &connection : connections) {
+    layer_a.connections[connection.first]++;
+    layer_b.connections[connection.second]++;
+
+    auto edge = std::make_shared<Edge>(layer_a.rooms[connection.first],
+                                       layer_b.rooms[connection.second]);
+    edge->_active = true;
+    edge->_source->addEdge(edge);
+    edge->_neighbor->addEdge(edge);
+    edge->_node->setColor(cugl::Color4(15, 15, 230, 147));
+    _map->addChild(edge->_node);
+    _edges.push_back(edge);
   }
   _map->doLayout();
 }
 
+void LevelGenerator::syncEdges(Layer &layer) {
+  for (int i = 0; i < layer.edges.size(); i++) {
+    std::shared_ptr<Edge> &edge = layer.edges[i];
+    edge->_active = layer.graph.getEdge(i).active;
+    edge->_node->setVisible(edge->_active);
+    if (edge->_active) edge->_node->setColor(cugl::Color4(255, 14, 14, 124));
+  }
+}
+
 void LevelGenerator::fillHallways() {
   // Resset state of all edges.
   for (std::shared_ptr<Room> &room : _rooms) {
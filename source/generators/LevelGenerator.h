@@ -4,12 +4,93 @@
 
 #include "../models/level_gen/Room.h"
 #include "LevelGeneratorConfig.h"
+#include "RoomGraph.h"
+
+/**
+ * The version of the generation algorithm. This must be incremented whenever
+ * a change to the generator or its serialization changes the level produced
+ * for a given config and seed, so that cached levels are not reused.
+ */
+#define LEVEL_GENERATOR_VERSION 1
 
 namespace level_gen {
 
 /** A level generator that creates a random level with hallway connections. */
 class LevelGenerator {
+ public:
+  /** Timing and size statistics of a level generation. */
+  struct Stats {
+    /** Time spent placing the regular and terminal rooms. */
+    Uint64 placement_micros;
+    /** Time spent separating overlapping rooms. */
+    Uint64 separation_micros;
+    /** Time spent moving the rings apart. */
+    Uint64 segregation_micros;
+    /** Time spent calculating the delaunay triangles of every layer. */
+    Uint64 delaunay_micros;
+    /** Time spent calculating the minimum spanning tree of every layer. */
+    Uint64 mst_micros;
+    /** Time spent adding edges back to every layer. */
+    Uint64 add_edges_back_micros;
+    /** Time spent connecting the layers. */
+    Uint64 connect_layers_micros;
+    /** Time spent filling the hallways. */
+    Uint64 hallways_micros;
+    /** The number of steps it took to separate the rooms. */
+    int separation_iterations;
+    /** The number of rooms in the level. */
+    int num_rooms;
+    /** The number of candidate edges in the level. */
+    int num_edges;
+    /** The number of edges that are hallways in the level. */
+    int num_active_edges;
+
+    /** @return The total generation time. */
+    Uint64 getTotalMicros() const {
+      return placement_micros + separation_micros + segregation_micros +
+             delaunay_micros + mst_micros + add_edges_back_micros +
+             connect_layers_micros + hallways_micros;
+    }
+  };
+
  private:
+  /**
+   * A ring of rooms in the level. Generation decisions are made on the index
+   * based graph, and the drawable edges are kept in parallel to it.
+   */
+  struct Layer {
+    /** The rooms in the layer. Room i is vertex i of the graph. */
+    std::vector<std::shared_ptr<Room>> rooms;
+
+    /** The graph of candidate hallways between the rooms of the layer. */
+    RoomGraph graph;
+
+    /** The drawable edge for each graph edge, indexed the same way. */
+    std::vector<std::shared_ptr<Edge>> edges;
+
+    /** The number of hallways from each room to a neighboring layer. */
+    std::vector<int> connections;
+
+    /**
+     * Returns the number of active hallways of the given room, including the
+     * ones to neighboring layers.
+     *
+     * @param v The index of the room in the layer.
+     * @return The number of active hallways.
+     */
+    int getActiveDegree(int v) const {
+      return graph.getActiveDegree(v) + connections[v];
+    }
+
+    /** Clear the layer. */
+    void clear() {
+      rooms.clear();
+      graph.dispose();
+      edges.clear();
+      connections.clear();
+    }
+  };
+
   /** A reference to the scene2 map for level drawing. */
   std::shared_ptr<cugl::scene2::SceneNode> _map;
 
@@ -19,14 +100,20 @@ class LevelGenerator {
   /** A list of all rooms in the level. */
   std::vector<std::shared_ptr<Room>> _rooms;
 
-  /** A list of all rooms in the inside circle of the level. */
-  std::vector<std::shared_ptr<Room>> _inside_rooms;
+  /** The rooms and hallway graph of the inside circle of the level. */
+  Layer _inside;
+
+  /** The rooms and hallway graph of the middle ring of the level. */
+  Layer _middle;
 
-  /** A list of all rooms in the middle ring of the level. */
-  std::vector<std::shared_ptr<Room>> _middle_rooms;
+  /** The rooms and hallway graph of the outside ring of the level. */
+  Layer _outside;
 
-  /** A list of all rooms in the outside ring of the level. */
-  std::vector<std::shared_ptr<Room>> _outside_rooms;
+  /** A list of all edges in the level, in the order they were created. */
+  std::vector<std::shared_ptr<Edge>> _edges;
+
+  /** The statistics of the current generation. */
+  Stats _stats;
 
   /** A reference to the spawn room of the level. */
   std::shared_ptr<Room> _spawn_room;
@@ -77,6 +164,30 @@ class LevelGenerator {
   void init(LevelGeneratorConfig &config,
             const std::shared_ptr<cugl::scene2::SceneNode> &map, Uint64 seed);
 
+  /**
+   * Initialize the generator with a level previously returned by serialize().
+   * No generation steps are run, so update() returns false immediately.
+   *
+   * @param config A LevelGeneratorConfig used for defining generation
+   * constants.
+   * @param map A reference to the scene2 map for drawing.
+   * @param data The serialized level.
+   * @return false if the data is not a valid serialized level.
+   */
+  bool initWithData(LevelGeneratorConfig &config,
+                    const std::shared_ptr<cugl::scene2::SceneNode> &map,
+                    const std::vector<uint8_t> &data);
+
+  /**
+   * Serialize the generated level into a compact byte array. This includes the
+   * room placements, the edges and the layout of the map. The encoding is
+   * platform independent, so two generators that produced the same level
+   * serialize to the same bytes.
+   *
+   * @return The serialized level.
+   */
+  std::vector<uint8_t> serialize() const;
+
   /**
    * Returns the pointer to the map SceneNode.
    *
@@ -100,11 +211,14 @@ class LevelGenerator {
 
 #pragma mark Attributes
   /** Get all Rooms in the level generator. */
-  std::vector<std::shared_ptr<Room>> getRooms() const { return _rooms; }
+  const std::vector<std::shared_ptr<Room>> &getRooms() const { return _rooms; }
 
   /** Get the spawn room in the level generator. */
   std::shared_ptr<Room> getSpawnRoom() const { return _spawn_room; }
 
+  /** Get the timing and size statistics of the current generation. */
+  const Stats &getStats() const { return _stats; }
+
  private:
 #pragma mark Main Generator Steps
   /**
@@ -183,40 +297,47 @@ class LevelGenerator {
    * given. Uses a third party implementation from:
    * https://github.com/abellgithub/delaunator-cpp.
    *
-   * @param rooms The rooms to create delaunay triangles with.
+   * The edges are added to the layer graph, and a drawable edge is created
+   * for each of them.
+   *
+   * @param layer The layer to create delaunay triangles with.
    * @param min_r The minimum radius of the ring layer.
    */
-  void calculateDelaunayTriangles(std::vector<std::shared_ptr<Room>> &rooms,
-                                  float min_r);
+  void calculateDelaunayTriangles(Layer &layer, float min_r);
 
   /**
-   * Create a minimum spanning tree between the rooms and their edges.
+   * Create a minimum spanning tree between the rooms and their edges. Uses
+   * Kruskal's algorithm on the layer graph, which is O(E log E).
    *
-   * @param rooms The rooms to create a minimum spanning tree with.
+   * @param layer The layer to create a minimum spanning tree with.
    */
-  void calculateMinimumSpanningTree(std::vector<std::shared_ptr<Room>> &rooms);
+  void calculateMinimumSpanningTree(Layer &layer);
 
   /**
    * Add some edges back within the room to make the tree a little easier to
    * traverse by the player. Remove the edges that aren't active and are not
    * added back.
    *
-   * @param rooms The rooms to add edges back to.
+   * @param layer The layer to add edges back to.
    */
-  void addEdgesBackAndRemoveUnecessary(
-      std::vector<std::shared_ptr<Room>> &rooms);
+  void addEdgesBackAndRemoveUnecessary(Layer &layer);
 
   /**
    * Connect two layers with some number of connections. Spaces the connections
    * evenly between the layers and at the closest points between them.
    *
-   * @param layer_a A vector of Rooms that makes up layer A.
-   * @param layer_b A vector of Rooms that makes up layer B.
+   * @param layer_a The rooms that make up layer A.
+   * @param layer_b The rooms that make up layer B.
    * @param num_connections The number of connections between the layers.
    */
-  void connectLayers(std::vector<std::shared_ptr<Room>> &layer_a,
-                     std::vector<std::shared_ptr<Room>> &layer_b,
-                     int num_connections);
+  void connectLayers(Layer &layer_a, Layer &layer_b, int num_connections);
+
+  /**
+   * Copy the active state of the layer graph to the drawable edges.
+   *
+   * @param layer The layer to synchronize.
+   */
+  void syncEdges(Layer &layer);
 
   /**
    * Fill the hallways between the rooms using the generator config constants.
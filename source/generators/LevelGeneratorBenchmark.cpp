@@ -0,0 +1,66 @@
+#include "LevelGeneratorBenchmark.h"
+
+namespace level_gen {
+
+void LevelGeneratorBenchmark::addDefaultConfigs() {
+  LevelGeneratorConfig base;
+  float base_radius = base.getMapRadius();
+  float base_rooms = base.getNumRooms();
+
+  for (int radius : {80, 120, 180, 240, 360}) {
+    LevelGeneratorConfig config;
+    float scale = radius / base_radius;
+    config.setMapRadius(radius);
+    config.setNumRooms(static_cast<int>(base_rooms * scale * scale));
+    _configs.push_back(config);
+  }
+}
+
+bool LevelGeneratorBenchmark::run(const std::string &path) const {
+  std::shared_ptr<cugl::TextWriter> writer = cugl::TextWriter::alloc(path);
+  if (writer == nullptr) return false;
+
+  writer->writeLine(
+      "map_radius,num_rooms_config,seed,placement_us,separation_us,"
+      "segregation_us,delaunay_us,mst_us,add_edges_back_us,connect_layers_us,"
+      "hallways_us,total_us,separation_iterations,num_rooms,num_edges,"
+      "num_active_edges");
+
+  for (const LevelGeneratorConfig &config : _configs) {
+    for (Uint64 seed : _seeds) {
+      LevelGenerator::Stats stats = generate(config, seed);
+
+      std::stringstream row;
+      row << config.getMapRadius() << "," << config.getNumRooms() << ","
+          << seed << "," << stats.placement_micros << ","
+          << stats.separation_micros << "," << stats.segregation_micros << ","
+          << stats.delaunay_micros << "," << stats.mst_micros << ","
+          << stats.add_edges_back_micros << ","
+          << stats.connect_layers_micros << "," << stats.hallways_micros
+          << "," << stats.getTotalMicros() << ","
+          << stats.separation_iterations << "," << stats.num_rooms << ","
+          << stats.num_edges << "," << stats.num_active_edges;
+      writer->writeLine(row.str());
+    }
+  }
+
+  writer->close();
+  return true;
+}
+
+LevelGenerator::Stats LevelGeneratorBenchmark::generate(
+    LevelGeneratorConfig config, Uint64 seed) {
+  std::shared_ptr<cugl::scene2::SceneNode> map =
+      cugl::scene2::SceneNode::alloc();
+
+  LevelGenerator generator;
+  generator.init(config, map, seed);
+  while (generator.update()) {
+  }
+
+  LevelGenerator::Stats stats = generator.getStats();
+  generator.dispose();
+  return stats;
+}
+
+}  // namespace level_gen
@@ -0,0 +1,78 @@
+#ifndef GENERATORS_LEVEL_GENERATOR_BENCHMARK_H
+#define GENERATORS_LEVEL_GENERATOR_BENCHMARK_H
+#include <cugl/cugl.h>
+
+#include "LevelGenerator.h"
+#include "LevelGeneratorConfig.h"
+
+namespace level_gen {
+
+/**
+ * A batch runner that generates many levels outside of the game loop and
+ * writes their statistics as CSV. Used to catch generation performance
+ * regressions and to tune configs for larger maps.
+ *
+ * Rooms own scene2 nodes, so the benchmark must run after the application has
+ * created its OpenGL context (e.g. in GameApp::onStartup).
+ */
+class LevelGeneratorBenchmark {
+ private:
+  /** The configs to sweep over. */
+  std::vector<LevelGeneratorConfig> _configs;
+
+  /** The seeds to generate for every config. */
+  std::vector<Uint64> _seeds;
+
+ public:
+  /** Construct a benchmark with no configs or seeds. */
+  LevelGeneratorBenchmark() {}
+
+  /**
+   * Add a config to the sweep.
+   *
+   * @param config The config to generate levels with.
+   */
+  void addConfig(const LevelGeneratorConfig &config) {
+    _configs.push_back(config);
+  }
+
+  /**
+   * Add the seeds [first, first + count) to the sweep.
+   *
+   * @param first The first seed.
+   * @param count The number of seeds.
+   */
+  void addSeeds(Uint64 first, int count) {
+    for (int i = 0; i < count; i++) _seeds.push_back(first + i);
+  }
+
+  /**
+   * Add a default sweep over map size, with the number of rooms scaled by the
+   * area of the map.
+   */
+  void addDefaultConfigs();
+
+  /**
+   * Generate a level for every config and seed, and write one CSV row per
+   * level to the given file.
+   *
+   * @param path The path of the CSV file.
+   * @return false if the file could not be written.
+   */
+  bool run(const std::string &path) const;
+
+ private:
+  /**
+   * Generate a level to completion and return its statistics.
+   *
+   * @param config The config to generate the level with.
+   * @param seed The seed to generate the level with.
+   * @return The statistics of the generation.
+   */
+  static LevelGenerator::Stats generate(LevelGeneratorConfig config,
+                                        Uint64 seed);
+};
+
+}  // namespace level_gen
+
+#endif /* GENERATORS_LEVEL_GENERATOR_BENCHMARK_H */
@@ -1,5 +1,7 @@
 #include "LevelGeneratorConfig.h"
 
+#include <cstring>
+
 namespace level_gen {
 
 LevelGeneratorConfig::LevelGeneratorConfig()
@@ -15,4 +17,33 @@ LevelGeneratorConfig::LevelGeneratorConfig()
   setNumTerminalRooms(7);
 }
 
+Uint64 LevelGeneratorConfig::getHash() const {
+  const float values[] = {_map_radius,
+                          _separation_between_layers,
+                          _inner_circle_radius,
+                          _inner_circle_frac,
+                          _middle_circle_radius,
+                          _middle_circle_frac,
+                          _max_hallway_length,
+                          _hallway_radius,
+                          _add_edges_back_prob,
+                          _num_rooms,
+                          _num_terminal_rooms,
+                          _num_terminal_rooms_inner,
+                          _num_terminal_rooms_middle,
+                          _num_terminal_rooms_outer,
+                          static_cast<float>(_max_num_of_edges)};
+
+  Uint64 hash = 14695981039346656037ULL;
+  for (float value : values) {
+    Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; i++) {
+      hash ^= (bits >> (8 * i)) & 0xFF;
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
 }  // namespace level_gen
\ No newline at end of file
@@ -187,6 +187,14 @@ class LevelGeneratorConfig {
   void setMaxNumEdges(int num) { _max_num_of_edges = num; }
   /** @return The max number of edges for a room. (i.e. max number of doors). */
   int getMaxNumEdges() const { return _max_num_of_edges; }
+
+  /**
+   * Returns a hash of all the generation constants. Two configs with the same
+   * hash generate the same level from the same seed.
+   *
+   * @return A 64 bit FNV-1a hash of the config.
+   */
+  Uint64 getHash() const;
 };
 
 }  // namespace level_gen
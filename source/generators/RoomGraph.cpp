@@ -0,0 +1,133 @@
+#include "RoomGraph.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace level_gen {
+
+namespace {
+
+/** A union-find over vertex indices with path halving and union by rank. */
+class DisjointSet {
+ private:
+  std::vector<int> _parent;
+  std::vector<int> _rank;
+
+ public:
+  explicit DisjointSet(int size) : _parent(size), _rank(size, 0) {
+    std::iota(_parent.begin(), _parent.end(), 0);
+  }
+
+  int find(int v) {
+    while (_parent[v] != v) {
+      _parent[v] = _parent[_parent[v]];
+      v = _parent[v];
+    }
+    return v;
+  }
+
+  bool unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return false;
+    if (_rank[a] < _rank[b]) std::swap(a, b);
+    _parent[b] = a;
+    if (_rank[a] == _rank[b]) _rank[a]++;
+    return true;
+  }
+};
+
+}  // namespace
+
+void RoomGraph::init(int num_vertices) {
+  _num_vertices = num_vertices;
+  _edges.clear();
+  _adj_offsets.assign(num_vertices + 1, 0);
+  _adj_edges.clear();
+  _adj_dirty = false;
+  _active_degree.assign(num_vertices, 0);
+}
+
+void RoomGraph::dispose() {
+  _num_vertices = 0;
+  _edges.clear();
+  _adj_offsets.clear();
+  _adj_edges.clear();
+  _adj_dirty = false;
+  _active_degree.clear();
+}
+
+int RoomGraph::addEdge(int source, int neighbor, float weight) {
+  _edges.push_back({source, neighbor, weight, false});
+  _adj_dirty = true;
+  return static_cast<int>(_edges.size()) - 1;
+}
+
+void RoomGraph::setActive(int edge, bool active) {
+  GraphEdge &e = _edges[edge];
+  if (e.active == active) return;
+  e.active = active;
+  int delta = active ? 1 : -1;
+  _active_degree[e.source] += delta;
+  _active_degree[e.neighbor] += delta;
+}
+
+void RoomGraph::clearActive() {
+  for (GraphEdge &e : _edges) e.active = false;
+  std::fill(_active_degree.begin(), _active_degree.end(), 0);
+}
+
+void RoomGraph::calculateMinimumSpanningTree() {
+  clearActive();
+  if (_num_vertices == 0) return;
+
+  std::vector<int> order(_edges.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](int l, int r) {
+    if (_edges[l].weight != _edges[r].weight) {
+      return _edges[l].weight < _edges[r].weight;
+    }
+    return l < r;
+  });
+
+  DisjointSet sets(_num_vertices);
+  int remaining = _num_vertices - 1;
+  for (size_t i = 0; i < order.size() && remaining > 0; i++) {
+    const GraphEdge &e = _edges[order[i]];
+    if (sets.unite(e.source, e.neighbor)) {
+      setActive(order[i], true);
+      remaining--;
+    }
+  }
+}
+
+const int *RoomGraph::getAdjacentEdges(int v) {
+  if (_adj_dirty) buildAdjacency();
+  return _adj_edges.data() + _adj_offsets[v];
+}
+
+int RoomGraph::getDegree(int v) {
+  if (_adj_dirty) buildAdjacency();
+  return _adj_offsets[v + 1] - _adj_offsets[v];
+}
+
+void RoomGraph::buildAdjacency() {
+  _adj_offsets.assign(_num_vertices + 1, 0);
+  for (const GraphEdge &e : _edges) {
+    _adj_offsets[e.source + 1]++;
+    _adj_offsets[e.neighbor + 1]++;
+  }
+  for (int v = 0; v < _num_vertices; v++) {
+    _adj_offsets[v + 1] += _adj_offsets[v];
+  }
+
+  _adj_edges.resize(_adj_offsets[_num_vertices]);
+  std::vector<int> fill(_adj_offsets.begin(), _adj_offsets.end() - 1);
+  for (size_t i = 0; i < _edges.size(); i++) {
+    _adj_edges[fill[_edges[i].source]++] = static_cast<int>(i);
+    _adj_edges[fill[_edges[i].neighbor]++] = static_cast<int>(i);
+  }
+  _adj_dirty = false;
+}
+
+}  // namespace level_gen
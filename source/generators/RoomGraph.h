@@ -0,0 +1,140 @@
+#ifndef GENERATORS_ROOM_GRAPH_H
+#define GENERATORS_ROOM_GRAPH_H
+#include <vector>
+
+namespace level_gen {
+
+/**
+ * A compact, index-based graph of rooms used during level generation.
+ *
+ * Vertices are the indices of the rooms in a layer and edges are stored in a
+ * flat array. The adjacency of each vertex is kept as a contiguous slice of a
+ * single array (compressed sparse rows), so that traversals never chase
+ * pointers. The graph holds no scene graph data; the drawable {@link Edge}
+ * objects are created from it once the generation decisions are made.
+ */
+class RoomGraph {
+ public:
+  /** A weighted, undirected edge between two vertices. */
+  struct GraphEdge {
+    /** The first vertex of the edge. */
+    int source;
+    /** The second vertex of the edge. */
+    int neighbor;
+    /** The weight (length) of the edge. */
+    float weight;
+    /** Whether the edge is part of the level. */
+    bool active;
+
+    /**
+     * Returns the vertex at the other end of this edge.
+     *
+     * @param v One of the vertices of the edge.
+     * @return The other vertex.
+     */
+    int getOther(int v) const { return v == source ? neighbor : source; }
+  };
+
+ private:
+  /** The number of vertices in the graph. */
+  int _num_vertices;
+
+  /** All edges of the graph, in insertion order. */
+  std::vector<GraphEdge> _edges;
+
+  /** The start of the adjacency slice of each vertex (size n+1). */
+  std::vector<int> _adj_offsets;
+
+  /** The edge indices incident to each vertex, grouped by vertex. */
+  std::vector<int> _adj_edges;
+
+  /** Whether the adjacency arrays must be rebuilt. */
+  bool _adj_dirty;
+
+  /** The number of active edges incident to each vertex. */
+  std::vector<int> _active_degree;
+
+ public:
+  /** Construct an empty graph. Must call init() before use. */
+  RoomGraph() : _num_vertices(0), _adj_dirty(false) {}
+
+  /**
+   * Initialize the graph with the given number of vertices and no edges.
+   *
+   * @param num_vertices The number of vertices (rooms) in the graph.
+   */
+  void init(int num_vertices);
+
+  /** Clear all the vertices and edges from the graph. */
+  void dispose();
+
+  /**
+   * Add an inactive edge between two vertices.
+   *
+   * @param source The first vertex.
+   * @param neighbor The second vertex.
+   * @param weight The weight of the edge.
+   * @return The index of the new edge.
+   */
+  int addEdge(int source, int neighbor, float weight);
+
+  /**
+   * Set whether the given edge is part of the level, updating the active
+   * degree of both of its vertices.
+   *
+   * @param edge The index of the edge.
+   * @param active Whether the edge is active.
+   */
+  void setActive(int edge, bool active);
+
+  /** Deactivate every edge in the graph. */
+  void clearActive();
+
+  /**
+   * Activate the edges of a minimum spanning tree (or forest, if the graph is
+   * disconnected) using Kruskal's algorithm with a union-find. Every other
+   * edge is deactivated. Ties are broken by edge index, so the result is the
+   * same on every platform.
+   */
+  void calculateMinimumSpanningTree();
+
+  /** @return The number of vertices in the graph. */
+  int getNumVertices() const { return _num_vertices; }
+
+  /** @return The number of edges in the graph. */
+  int getNumEdges() const { return static_cast<int>(_edges.size()); }
+
+  /** @return The edge with the given index. */
+  const GraphEdge &getEdge(int edge) const { return _edges[edge]; }
+
+  /** @return All edges of the graph, in insertion order. */
+  const std::vector<GraphEdge> &getEdges() const { return _edges; }
+
+  /** @return The number of active edges incident to the given vertex. */
+  int getActiveDegree(int v) const { return _active_degree[v]; }
+
+  /**
+   * Returns a pointer to the edge indices incident to the given vertex. The
+   * number of indices is given by getDegree().
+   *
+   * @param v The vertex.
+   * @return A pointer to the first incident edge index.
+   */
+  const int *getAdjacentEdges(int v);
+
+  /**
+   * Returns the number of edges incident to the given vertex.
+   *
+   * @param v The vertex.
+   * @return The number of incident edges.
+   */
+  int getDegree(int v);
+
+ private:
+  /** Rebuild the adjacency arrays from the edge list. */
+  void buildAdjacency();
+};
+
+}  // namespace level_gen
+
+#endif /* GENERATORS_ROOM_GRAPH_H */
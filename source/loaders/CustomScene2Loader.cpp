@@ -1,8 +1,11 @@
 #include "CustomScene2Loader.h"
 
+#include <algorithm>
+
 #include "../models/tiles/BasicTile.h"
 #include "../models/tiles/Door.h"
 #include "../models/tiles/Terminal.h"
+#include "../models/tiles/TilemapNode.h"
 #include "../models/tiles/Wall.h"
 
 namespace cugl {
@@ -65,6 +68,31 @@ bool CustomScene2Loader::init(const std::shared_ptr<ThreadPool>& threads) {
  */
 std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
     const std::string& key, const std::shared_ptr<JsonValue>& json) const {
+  std::shared_ptr<Arena> arena = (_arena_mode ? Arena::alloc() : nullptr);
+  return buildNode(key, json, arena);
+}
+
+/**
+ * Recursively builds the scene from the given JSON tree.
+ *
+ * This is the implementation of {@link #build}. Every node and layout
+ * of the scene is allocated from the given arena, unless it is null.
+ *
+ * If prebuilt is not null, it is used for the child of the same name
+ * instead of building that child again. This is how a grid cell reuses
+ * the tile that could not be absorbed into a tilemap.
+ *
+ * @param key       The key to access the scene after loading
+ * @param json      The JSON object defining the scene
+ * @param arena     The arena for the scene (may be nullptr)
+ * @param prebuilt  An already built child of this node (may be nullptr)
+ *
+ * @return the root node of the scene
+ */
+std::shared_ptr<scene2::SceneNode> CustomScene2Loader::buildNode(
+    const std::string& key, const std::shared_ptr<JsonValue>& json,
+    const std::shared_ptr<Arena>& arena,
+    const std::shared_ptr<scene2::SceneNode>& prebuilt) const {
   bool nonrelative = false;
   std::shared_ptr<JsonValue> data = json->get("data");
   std::shared_ptr<scene2::SceneNode> node = nullptr;
@@ -77,60 +105,60 @@ std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
       case Widget::GRUNT:
       case Widget::TURTLE:
       case Widget::TANK:
-        node = scene2::SceneNode::allocWithData(this, data);
+        node = allocNode<scene2::SceneNode>(data, arena);
         node->setType(strtool::tolower(type));
         break;
       case Widget::IMAGE:
-        node = scene2::PolygonNode::allocWithData(this, data);
+        node = allocNode<scene2::PolygonNode>(data, arena);
         break;
       case Widget::SOLID:
         // TODO: Replace with polygon as first child and sized to fill
         // That will keep us from breaking the tint abstraction
-        node = scene2::PolygonNode::allocWithData(this, data);
+        node = allocNode<scene2::PolygonNode>(data, arena);
         nonrelative = true;
         break;
       case Widget::ORDER:
-        node = scene2::OrderedNode::allocWithData(this, data);
+        node = allocNode<scene2::OrderedNode>(data, arena);
         break;
       case Widget::CANVAS:
-        node = scene2::CanvasNode::allocWithData(this, data);
+        node = allocNode<scene2::CanvasNode>(data, arena);
         break;
       case Widget::POLY:
-        node = scene2::PolygonNode::allocWithData(this, data);
+        node = allocNode<scene2::PolygonNode>(data, arena);
         break;
       case Widget::PATH:
-        node = scene2::PathNode::allocWithData(this, data);
+        node = allocNode<scene2::PathNode>(data, arena);
         break;
       case Widget::WIRE:
-        node = scene2::WireNode::allocWithData(this, data);
+        node = allocNode<scene2::WireNode>(data, arena);
         break;
       case Widget::ANIMATE:
-        node = scene2::SpriteNode::allocWithData(this, data);
+        node = allocNode<scene2::SpriteNode>(data, arena);
         break;
       case Widget::NINE:
-        node = scene2::NinePatch::allocWithData(this, data);
+        node = allocNode<scene2::NinePatch>(data, arena);
         break;
       case Widget::LABEL:
-        node = scene2::Label::allocWithData(this, data);
+        node = allocNode<scene2::Label>(data, arena);
         break;
       case Widget::BUTTON:
-        node = scene2::Button::allocWithData(this, data);
+        node = allocNode<scene2::Button>(data, arena);
         break;
       case Widget::PROGRESS:
-        node = scene2::ProgressBar::allocWithData(this, data);
+        node = allocNode<scene2::ProgressBar>(data, arena);
         break;
       case Widget::SLIDER:
-        node = scene2::Slider::allocWithData(this, data);
+        node = allocNode<scene2::Slider>(data, arena);
         break;
       case Widget::SCROLL:
-        node = scene2::ScrollPane::allocWithData(this, data);
+        node = allocNode<scene2::ScrollPane>(data, arena);
         break;
       case Widget::TEXTFIELD:
-        node = scene2::TextField::allocWithData(this, data);
+        node = allocNode<scene2::TextField>(data, arena);
         break;
       case Widget::EXTERNAL_IMPORT: {
         const std::shared_ptr<JsonValue> widgetJson = getWidgetJson(json);
-        return build(key, widgetJson);
+        return buildNode(key, widgetJson, arena);
       }
       case Widget::UNKNOWN:
         break;
@@ -141,16 +169,16 @@ std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
   if (kt != _tile_types.end()) {
     switch (kt->second) {
       case Tile::BASIC_TILE:
-        node = BasicTile::allocWithData(this, data);
+        node = allocNode<BasicTile>(data, arena);
         break;
       case Tile::WALL:
-        node = Wall::allocWithData(this, data);
+        node = allocNode<Wall>(data, arena);
         break;
       case Tile::DOOR:
-        node = Door::allocWithData(this, data);
+        node = allocNode<Door>(data, arena);
         break;
       case Tile::TERMINAL:
-        node = Terminal::allocWithData(this, data);
+        node = allocNode<Terminal>(data, arena);
         break;
       case Tile::UNKOWN:
         break;
@@ -175,13 +203,13 @@ std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
   if (jt != _forms.end()) {
     switch (jt->second) {
       case Form::ANCHORED:
-        layout = scene2::AnchoredLayout::allocWithData(form);
+        layout = allocLayout<scene2::AnchoredLayout>(form, arena);
         break;
       case Form::FLOAT:
-        layout = scene2::FloatLayout::allocWithData(form);
+        layout = allocLayout<scene2::FloatLayout>(form, arena);
         break;
       case Form::GRID:
-        layout = scene2::GridLayout::allocWithData(form);
+        layout = allocLayout<scene2::GridLayout>(form, arena);
         break;
       case Form::NONE:
       case Form::UNKNOWN:
@@ -190,18 +218,44 @@ std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
   }
   node->setLayout(layout);
 
+  // Static tiles in a grid are collapsed into tilemaps, one per priority.
+  bool is_grid =
+      std::dynamic_pointer_cast<scene2::GridLayout>(layout) != nullptr;
+  std::map<float, std::shared_ptr<TilemapNode>> tilemaps;
+
   std::shared_ptr<JsonValue> children = json->get("children");
   if (children != nullptr) {
+    // Grid cells are mostly absorbed, so only reserve for other nodes
+    if (!is_grid) node->reserveChildren(children->size());
     for (int ii = 0; ii < children->size(); ii++) {
       std::shared_ptr<JsonValue> item = children->get(ii);
       std::string key = item->key();
       if (key != "comment") {
+        // The tile of a cell is built once. If it cannot be absorbed, the
+        // cell is built around it rather than building the tile again.
+        std::shared_ptr<scene2::SceneNode> tile = nullptr;
+        if (is_grid) {
+          std::shared_ptr<JsonValue> tile_json = getStaticTileJson(item);
+          if (tile_json != nullptr) {
+            tile = buildNode(item->get("children")->get(0)->key(), tile_json,
+                             arena);
+            if (absorbTile(tile, item->get("layout"), node, tilemaps)) {
+              continue;
+            }
+          }
+        }
+
         // If this is a widget, use the loaded widget json instead
         if (item->has("type") && item->getString("type") == "Widget") {
           item = getWidgetJson(item);
         }
 
-        std::shared_ptr<scene2::SceneNode> kid = build(key, item);
+        std::shared_ptr<scene2::SceneNode> kid;
+        if (prebuilt != nullptr && prebuilt->getName() == key) {
+          kid = prebuilt;
+        } else {
+          kid = buildNode(key, item, arena, tile);
+        }
         if (nonrelative) {
           kid->setRelativeColor(false);
         }
@@ -215,11 +269,130 @@ std::shared_ptr<scene2::SceneNode> CustomScene2Loader::build(
     }
   }
 
+  int index = 0;
+  for (auto& it : tilemaps) {
+    node->addChildWithName(it.second, "tilemap-" + std::to_string(index++));
+  }
+
   // Do not perform layout yet.
   node->setName(key);
   return node;
 }
 
+/**
+ * Returns the JSON of the tile in a grid cell if it can be absorbed.
+ *
+ * A cell can be absorbed into a {@link TilemapNode} if it is a plain node
+ * wrapping a single childless BasicTile or Wall anchored to the bottom left
+ * of the cell. The wrapper may have an Anchored layout (as all cells in the
+ * room files do), since that only places the single tile. Doors and
+ * terminals always remain scene graph nodes.
+ *
+ * @param item  The JSON object defining the grid cell
+ *
+ * @return the JSON of the tile in a grid cell if it can be absorbed.
+ */
+std::shared_ptr<JsonValue> CustomScene2Loader::getStaticTileJson(
+    const std::shared_ptr<JsonValue>& item) const {
+  if (strtool::tolower(item->getString("type", UNKNOWN_STR)) != "node" ||
+      item->has("data") || !item->has("layout")) {
+    return nullptr;
+  }
+
+  std::shared_ptr<JsonValue> format = item->get("format");
+  if (format != nullptr &&
+      (format->size() != 1 ||
+       strtool::tolower(format->getString("type", UNKNOWN_STR)) != "anchored")) {
+    return nullptr;
+  }
+
+  std::shared_ptr<JsonValue> layout = item->get("layout");
+  if (!layout->has("x_index") || !layout->has("y_index") ||
+      layout->getString("x_anchor", "left") != "left" ||
+      layout->getString("y_anchor", "bottom") != "bottom") {
+    return nullptr;
+  }
+
+  std::shared_ptr<JsonValue> children = item->get("children");
+  if (children == nullptr || children->size() != 1) return nullptr;
+
+  std::shared_ptr<JsonValue> tile = children->get(0);
+  if (tile->getString("type", UNKNOWN_STR) == "Widget") {
+    tile = getWidgetJson(tile);
+  }
+  if (tile == nullptr || tile->has("children")) return nullptr;
+
+  auto it = _tile_types.find(strtool::tolower(tile->getString("type", "")));
+  if (it == _tile_types.end() ||
+      (it->second != Tile::BASIC_TILE && it->second != Tile::WALL)) {
+    return nullptr;
+  }
+
+  std::shared_ptr<JsonValue> posit = tile->get("layout");
+  if (posit != nullptr &&
+      (posit->getString("x_anchor", "left") != "left" ||
+       posit->getString("y_anchor", "bottom") != "bottom" ||
+       posit->getFloat("x_offset", 0.0f) != 0.0f ||
+       posit->getFloat("y_offset", 0.0f) != 0.0f)) {
+    return nullptr;
+  }
+  return tile;
+}
+
+/**
+ * Absorbs the given tile into the tilemap for its priority.
+ *
+ * Returns false if the tile has any attribute (tint, transform, flip, etc.)
+ * that a tilemap cannot reproduce. In that case it must remain a node.
+ *
+ * @param tile      The tile built from the cell JSON
+ * @param layout    The grid layout JSON of the cell
+ * @param parent    The grid node for the room tiles
+ * @param tilemaps  The tilemaps for the grid node, keyed by priority
+ *
+ * @return true if the tile was absorbed.
+ */
+bool CustomScene2Loader::absorbTile(
+    const std::shared_ptr<scene2::SceneNode>& tile,
+    const std::shared_ptr<JsonValue>& layout,
+    const std::shared_ptr<scene2::SceneNode>& parent,
+    std::map<float, std::shared_ptr<TilemapNode>>& tilemaps) const {
+  auto basic = std::dynamic_pointer_cast<BasicTile>(tile);
+  if (basic == nullptr || !basic->isVisible() || basic->getAngle() != 0 ||
+      basic->getAnchor() != Vec2::ANCHOR_BOTTOM_LEFT ||
+      basic->getScale() != Vec2::ONE || basic->getColor() != Color4::WHITE ||
+      basic->isFlipHorizontal() || basic->isFlipVertical() ||
+      basic->getGradient() != nullptr || basic->getTexture() == nullptr ||
+      basic->getPolygon().getBounds() !=
+          Rect(Vec2::ZERO, basic->getTexture()->getSize())) {
+    return false;
+  }
+
+  auto grid = std::dynamic_pointer_cast<scene2::GridLayout>(parent->getLayout());
+  int x = layout->getInt("x_index", 0);
+  int y = layout->getInt("y_index", 0);
+
+  std::shared_ptr<TilemapNode>& tilemap = tilemaps[basic->getPriority()];
+  if (tilemap == nullptr) {
+    Size dims = grid->getGridSize();
+    tilemap = TilemapNode::alloc(static_cast<int>(dims.width),
+                                 static_cast<int>(dims.height),
+                                 parent->getContentSize());
+    tilemap->setPriority(basic->getPriority());
+  }
+
+  int index =
+      tilemap->addAtlasEntry(basic->getTexture(), basic->getContentSize());
+  if (index == TilemapNode::EMPTY) return false;
+  tilemap->setTile(x, y, index);
+
+  auto wall = std::dynamic_pointer_cast<Wall>(basic);
+  if (wall != nullptr) {
+    tilemap->addObstacle(x, y, wall->getObstacleShape());
+  }
+  return true;
+}
+
 /**
  * Attaches all generate nodes to the asset dictionary.
  *
@@ -237,6 +410,11 @@ bool CustomScene2Loader::attach(
   _assets[key] = node;
 
   // Check if class is a tile.
+  auto tilemap = std::dynamic_pointer_cast<TilemapNode>(node);
+  if (tilemap != nullptr) {
+    _tilemaps.push_back(tilemap);
+  }
+
   auto it = _tile_types.find(strtool::tolower(node->getClassName()));
   if (it != _tile_types.end()) {
     _tile_box2d[strtool::tolower(node->getClassName())].push_back(
@@ -252,4 +430,56 @@ bool CustomScene2Loader::attach(
   return success;
 }
 
+/**
+ * Unloads the asset for the given key
+ *
+ * This removes the scene and all of its descendants (including any tiles
+ * and tilemaps) from this loader. An asset may still be available if it
+ * is referenced by a smart pointer. In arena mode, the memory of the
+ * whole scene is released in one shot once the last such reference is
+ * gone.
+ *
+ * @param key       The key of the asset
+ *
+ * @return true if the asset was successfully unloaded
+ */
+bool CustomScene2Loader::purge(const std::string key) {
+  auto it = _assets.find(key);
+  if (it == _assets.end()) return false;
+  std::shared_ptr<scene2::SceneNode> node = it->second;
+  detach(key, node);
+  return true;
+}
+
+/**
+ * Removes the given node and its descendants from the asset dictionary.
+ *
+ * This is the inverse of {@link #attach}, and uses the same naming
+ * scheme for the descendants.
+ *
+ * @param key       The key of the node
+ * @param node      The node to remove
+ */
+void CustomScene2Loader::detach(
+    const std::string& key, const std::shared_ptr<scene2::SceneNode>& node) {
+  _assets.erase(key);
+
+  auto tilemap = std::dynamic_pointer_cast<TilemapNode>(node);
+  if (tilemap != nullptr) {
+    _tilemaps.erase(std::remove(_tilemaps.begin(), _tilemaps.end(), tilemap),
+                    _tilemaps.end());
+  }
+
+  auto it = _tile_box2d.find(strtool::tolower(node->getClassName()));
+  if (it != _tile_box2d.end()) {
+    std::vector<std::shared_ptr<BasicTile>>& tiles = it->second;
+    tiles.erase(std::remove(tiles.begin(), tiles.end(), node), tiles.end());
+  }
+
+  for (size_t ii = 0; ii < node->getChildren().size(); ii++) {
+    std::shared_ptr<scene2::SceneNode> item = node->getChild(ii);
+    detach(key + "_" + item->getName(), item);
+  }
+}
+
 }  // namespace cugl
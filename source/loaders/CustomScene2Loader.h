@@ -2,9 +2,13 @@
 #define LOADERS_CUSTOM_SCENE_2_LOADER_H_
 #include <cugl/assets/CUScene2Loader.h>
 #include <cugl/physics2/cu_physics2.h>
+#include <cugl/util/CUArena.h>
+
+#include <map>
 
 #include "../models/tiles/BasicTile.h"
 #include "../models/tiles/Terminal.h"
+#include "../models/tiles/TilemapNode.h"
 
 namespace cugl {
 
@@ -44,6 +48,121 @@ class CustomScene2Loader : public Scene2Loader {
   std::unordered_map<std::string, std::vector<std::shared_ptr<BasicTile>>>
       _tile_box2d;
 
+  /** A list of all the tilemaps that absorbed static tiles. */
+  std::vector<std::shared_ptr<TilemapNode>> _tilemaps;
+
+  /** Whether each scene is allocated in its own arena. */
+  bool _arena_mode;
+
+  /**
+   * Returns a new node of type T initialized with the given JSON data.
+   *
+   * If the arena is not null, both the node and its reference count are
+   * placed in the arena. Otherwise the node is allocated on the heap.
+   *
+   * @param data  The JSON object specifying the node
+   * @param arena The arena for the scene (may be nullptr)
+   *
+   * @return a new node of type T initialized with the given JSON data.
+   */
+  template <typename T>
+  std::shared_ptr<scene2::SceneNode> allocNode(
+      const std::shared_ptr<JsonValue>& data,
+      const std::shared_ptr<Arena>& arena) const {
+    std::shared_ptr<T> node =
+        (arena == nullptr ? std::make_shared<T>()
+                          : std::allocate_shared<T>(ArenaAllocator<T>(arena)));
+    return (node->initWithData(this, data) ? node : nullptr);
+  }
+
+  /**
+   * Returns a new layout of type T initialized with the given JSON data.
+   *
+   * If the arena is not null, both the layout and its reference count are
+   * placed in the arena. Otherwise the layout is allocated on the heap.
+   *
+   * @param data  The JSON object specifying the layout
+   * @param arena The arena for the scene (may be nullptr)
+   *
+   * @return a new layout of type T initialized with the given JSON data.
+   */
+  template <typename T>
+  std::shared_ptr<scene2::Layout> allocLayout(
+      const std::shared_ptr<JsonValue>& data,
+      const std::shared_ptr<Arena>& arena) const {
+    std::shared_ptr<T> layout =
+        (arena == nullptr ? std::make_shared<T>()
+                          : std::allocate_shared<T>(ArenaAllocator<T>(arena)));
+    return (layout->initWithData(data) ? layout : nullptr);
+  }
+
+  /**
+   * Recursively builds the scene from the given JSON tree.
+   *
+   * This is the implementation of {@link #build}. Every node and layout
+   * of the scene is allocated from the given arena, unless it is null.
+   *
+   * If prebuilt is not null, it is used for the child of the same name
+   * instead of building that child again. This is how a grid cell reuses
+   * the tile that could not be absorbed into a tilemap.
+   *
+   * @param key       The key to access the scene after loading
+   * @param json      The JSON object defining the scene
+   * @param arena     The arena for the scene (may be nullptr)
+   * @param prebuilt  An already built child of this node (may be nullptr)
+   *
+   * @return the root node of the scene
+   */
+  std::shared_ptr<scene2::SceneNode> buildNode(
+      const std::string& key, const std::shared_ptr<JsonValue>& json,
+      const std::shared_ptr<Arena>& arena,
+      const std::shared_ptr<scene2::SceneNode>& prebuilt = nullptr) const;
+
+  /**
+   * Removes the given node and its descendants from the asset dictionary.
+   *
+   * This is the inverse of {@link #attach}, and uses the same naming
+   * scheme for the descendants.
+   *
+   * @param key       The key of the node
+   * @param node      The node to remove
+   */
+  void detach(const std::string& key,
+              const std::shared_ptr<scene2::SceneNode>& node);
+
+  /**
+   * Returns the JSON of the tile in a grid cell if it can be absorbed.
+   *
+   * A cell can be absorbed into a {@link TilemapNode} if it is a plain node
+   * wrapping a single childless BasicTile or Wall anchored to the bottom left
+   * of the cell. Doors and terminals always remain scene graph nodes.
+   *
+   * @param item  The JSON object defining the grid cell
+   *
+   * @return the JSON of the tile in a grid cell if it can be absorbed.
+   */
+  std::shared_ptr<JsonValue> getStaticTileJson(
+      const std::shared_ptr<JsonValue>& item) const;
+
+  /**
+   * Absorbs the given tile into the tilemap for its priority.
+   *
+   * Returns false if the tile has any attribute (tint, transform, flip, etc.)
+   * that a tilemap cannot reproduce. In that case it must remain a node.
+   *
+   * @param tile      The tile built from the cell JSON
+   * @param layout    The grid layout JSON of the cell
+   * @param parent    The grid node for the room tiles
+   * @param tilemaps  The tilemaps for the grid node, keyed by priority
+   *
+   * @return true if the tile was absorbed.
+   */
+  bool absorbTile(
+      const std::shared_ptr<scene2::SceneNode>& tile,
+      const std::shared_ptr<JsonValue>& layout,
+      const std::shared_ptr<scene2::SceneNode>& parent,
+      std::map<float, std::shared_ptr<TilemapNode>>& tilemaps) const;
+
   /**
    * Initializes a new asset loader.
    *
@@ -137,6 +256,21 @@ class CustomScene2Loader : public Scene2Loader {
     return Scene2Loader::read(json, callback, async);
   }
 
+  /**
+   * Unloads the asset for the given key
+   *
+   * This removes the scene and all of its descendants (including any tiles
+   * and tilemaps) from this loader. An asset may still be available if it
+   * is referenced by a smart pointer. In arena mode, the memory of the
+   * whole scene is released in one shot once the last such reference is
+   * gone.
+   *
+   * @param key       The key of the asset
+   *
+   * @return true if the asset was successfully unloaded
+   */
+  virtual bool purge(const std::string key) override;
+
   /**
    * Unloads the asset for the given directory entry
    *
@@ -154,7 +288,7 @@ class CustomScene2Loader : public Scene2Loader {
    * @return true if the asset was successfully unloaded
    */
   virtual bool purge(const std::shared_ptr<JsonValue>& json) override {
-    return Scene2Loader::purge(json);
+    return purge(json->key());
   }
 
   /**
@@ -181,7 +315,7 @@ class CustomScene2Loader : public Scene2Loader {
    * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a loader on
    * the heap, use one of the static constructors instead.
    */
-  CustomScene2Loader() {}
+  CustomScene2Loader() : _arena_mode(false) {}
 
   /**
    * Disposes all resources and assets of this loader
@@ -197,6 +331,7 @@ class CustomScene2Loader : public Scene2Loader {
   virtual void dispose() override {
     Scene2Loader::dispose();
     _tile_box2d.clear();
+    _tilemaps.clear();
     _tile_types.clear();
   }
 
@@ -269,13 +404,49 @@ class CustomScene2Loader : public Scene2Loader {
       const std::string& key,
       const std::shared_ptr<JsonValue>& json) const override;
 
+#pragma mark Arena Allocation
+  /**
+   * Returns true if each scene is allocated in its own arena.
+   *
+   * @return true if each scene is allocated in its own arena.
+   */
+  bool isArenaMode() const { return _arena_mode; }
+
+  /**
+   * Sets whether each scene is allocated in its own arena.
+   *
+   * In arena mode, all of the nodes and layouts of a scene (e.g. a room)
+   * are carved out of a few large blocks instead of being allocated one
+   * by one. This replaces thousands of small allocations with a handful,
+   * and keeps the nodes of a scene close together in memory. The blocks
+   * are released all at once when the last node of the scene is deleted.
+   *
+   * Nodes removed from an arena scene keep their memory until the whole
+   * scene is released. So this mode is best for scenes that are loaded
+   * and unloaded as a unit. It only affects scenes loaded afterwards.
+   *
+   * @param value Whether each scene is allocated in its own arena.
+   */
+  void setArenaMode(bool value) { _arena_mode = value; }
+
 #pragma mark CustomGetters
 
   /**
    * @return The list of box2d objects loaded in the scene2 graph.
    */
   std::vector<std::shared_ptr<BasicTile>> getTiles(std::string type) const {
-    return _tile_box2d.at(type);
+    auto it = _tile_box2d.find(type);
+    if (it == _tile_box2d.end()) {
+      return std::vector<std::shared_ptr<BasicTile>>();
+    }
+    return it->second;
+  }
+
+  /**
+   * @return The list of tilemaps holding the static tiles of the scene2 graph.
+   */
+  const std::vector<std::shared_ptr<TilemapNode>>& getTilemaps() const {
+    return _tilemaps;
   }
 };
 
@@ -17,6 +17,15 @@ int main(int argc, char *argv[]) {
   app.setFPS(60.0f);
   app.setHighDPI(true);
 
+  // Run the level generation benchmark instead of the game, e.g.
+  //   Luminance --level-benchmark levels.csv 20
+  for (int i = 1; i + 1 < argc; i++) {
+    if (std::string(argv[i]) == "--level-benchmark") {
+      int seeds = (i + 2 < argc) ? std::atoi(argv[i + 2]) : 10;
+      app.setLevelBenchmark(argv[i + 1], seeds);
+    }
+  }
+
   /// DO NOT MODIFY ANYTHING BELOW THIS LINE.
   if (!app.init()) {
     return 1;
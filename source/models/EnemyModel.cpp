@@ -62,7 +62,7 @@ void EnemyModel::deleteProjectile(
   while (itt != _projectiles.end()) {
     if ((*itt)->getFrames() <= 0) {
       (*itt)->deactivatePhysics(*_world->getWorld());
-      _world_node->removeChild((*itt)->getNode());
+      (*itt)->removeSprite();
       _world->removeObstacle((*itt).get());
       itt = _projectiles.erase(itt);
     } else {
@@ -77,7 +77,7 @@ void EnemyModel::deleteAllProjectiles(
   auto itt = _projectiles.begin();
   while (itt != _projectiles.end()) {
     (*itt)->deactivatePhysics(*_world->getWorld());
-    _world_node->removeChild((*itt)->getNode());
+    (*itt)->removeSprite();
     _world->removeObstacle((*itt).get());
     ++itt;
   }
@@ -0,0 +1,94 @@
+#include "LevelGraph.h"
+
+void LevelGraph::dispose() {
+  _index_to_key.clear();
+  _key_to_index.clear();
+  _adjacency.clear();
+  _distances.clear();
+  _next_hops.clear();
+}
+
+int LevelGraph::addRoom(int key) {
+  auto it = _key_to_index.find(key);
+  if (it != _key_to_index.end()) return it->second;
+
+  int index = getNumRooms();
+  _key_to_index[key] = index;
+  _index_to_key.push_back(key);
+  _adjacency.emplace_back();
+  return index;
+}
+
+void LevelGraph::addConnection(int key_a, int key_b) {
+  int a = getIndex(key_a);
+  int b = getIndex(key_b);
+  CUAssertLog(a != -1 && b != -1, "Rooms %d and %d must be in the graph",
+              key_a, key_b);
+  if (a == b) return;
+
+  if (std::find(_adjacency[a].begin(), _adjacency[a].end(), b) ==
+      _adjacency[a].end()) {
+    _adjacency[a].push_back(b);
+    _adjacency[b].push_back(a);
+  }
+}
+
+void LevelGraph::build() {
+  int n = getNumRooms();
+  _distances.assign(n * n, UNREACHABLE);
+  _next_hops.assign(n * n, -1);
+
+  // The graph is unweighted, so a breadth first search from every room gives
+  // all pairs shortest paths in O(V * (V + E)).
+  std::vector<int> queue(n);
+  for (int source = 0; source < n; source++) {
+    int* distances = &_distances[source * n];
+    int* next_hops = &_next_hops[source * n];
+
+    int head = 0;
+    int tail = 0;
+    distances[source] = 0;
+    next_hops[source] = source;
+    queue[tail++] = source;
+
+    while (head < tail) {
+      int room = queue[head++];
+      for (int neighbor : _adjacency[room]) {
+        if (distances[neighbor] != UNREACHABLE) continue;
+        distances[neighbor] = distances[room] + 1;
+        next_hops[neighbor] = (room == source) ? neighbor : next_hops[room];
+        queue[tail++] = neighbor;
+      }
+    }
+  }
+}
+
+int LevelGraph::getDistance(int from, int to) const {
+  int a = getIndex(from);
+  int b = getIndex(to);
+  if (a == -1 || b == -1 || _distances.empty()) return UNREACHABLE;
+  return _distances[a * getNumRooms() + b];
+}
+
+int LevelGraph::getNextRoom(int from, int to) const {
+  int a = getIndex(from);
+  int b = getIndex(to);
+  if (a == -1 || b == -1 || _next_hops.empty()) return -1;
+
+  int next = _next_hops[a * getNumRooms() + b];
+  return (next == -1) ? -1 : _index_to_key[next];
+}
+
+std::vector<int> LevelGraph::getRoomsWithin(int key, int max_distance) const {
+  std::vector<int> result;
+  int a = getIndex(key);
+  if (a == -1 || _distances.empty()) return result;
+
+  const int* distances = &_distances[a * getNumRooms()];
+  for (int i = 0; i < getNumRooms(); i++) {
+    if (distances[i] != UNREACHABLE && distances[i] <= max_distance) {
+      result.push_back(_index_to_key[i]);
+    }
+  }
+  return result;
+}
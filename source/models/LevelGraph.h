@@ -0,0 +1,121 @@
+#ifndef MODELS_LEVEL_GRAPH_H_
+#define MODELS_LEVEL_GRAPH_H_
+
+#include <cugl/cugl.h>
+
+/**
+ * The connectivity of all rooms in a level, built once after the level is
+ * populated.
+ *
+ * Rooms are given dense indices in the order they are added. The graph keeps
+ * an adjacency list and an all-pairs table of hop distances and next hops, so
+ * routing queries (AI reinforcements, the minimap, interest management) are
+ * O(1) lookups instead of searches over the door maps of every room.
+ */
+class LevelGraph {
+ public:
+  /** The distance between two rooms that are not connected. */
+  static const int UNREACHABLE = -1;
+
+ private:
+  /** The room key of each index. */
+  std::vector<int> _index_to_key;
+
+  /** The index of each room key. */
+  std::unordered_map<int, int> _key_to_index;
+
+  /** The indices of the rooms connected to each room. */
+  std::vector<std::vector<int>> _adjacency;
+
+  /** The number of hops between every pair of rooms, row major. */
+  std::vector<int> _distances;
+
+  /** The first room on a shortest path between every pair of rooms. */
+  std::vector<int> _next_hops;
+
+ public:
+  LevelGraph() {}
+  ~LevelGraph() { dispose(); }
+
+  /** Remove all the rooms and connections from the graph. */
+  void dispose();
+
+  /**
+   * Adds a room to the graph. Adding the same room twice does nothing.
+   *
+   * @param key The key of the room.
+   * @return The dense index of the room.
+   */
+  int addRoom(int key);
+
+  /**
+   * Connects two rooms in both directions. Both rooms must have been added.
+   *
+   * @param key_a The key of the first room.
+   * @param key_b The key of the second room.
+   */
+  void addConnection(int key_a, int key_b);
+
+  /**
+   * Computes the all-pairs distance and next hop tables. Must be called after
+   * all the rooms and connections are added, before any distance query.
+   */
+  void build();
+
+  /** @return The number of rooms in the graph. */
+  int getNumRooms() const { return static_cast<int>(_index_to_key.size()); }
+
+  /**
+   * @param key The key of a room.
+   * @return The dense index of the room, or -1 if it is not in the graph.
+   */
+  int getIndex(int key) const {
+    auto it = _key_to_index.find(key);
+    return (it == _key_to_index.end()) ? -1 : it->second;
+  }
+
+  /**
+   * @param index The dense index of a room.
+   * @return The key of the room.
+   */
+  int getKey(int index) const { return _index_to_key[index]; }
+
+  /**
+   * @param index The dense index of a room.
+   * @return The dense indices of the rooms connected to the room.
+   */
+  const std::vector<int>& getNeighbors(int index) const {
+    return _adjacency[index];
+  }
+
+  /**
+   * Returns the number of doors a player has to go through to get from one
+   * room to the other.
+   *
+   * @param from The key of the start room.
+   * @param to The key of the destination room.
+   * @return The distance in hops, or UNREACHABLE.
+   */
+  int getDistance(int from, int to) const;
+
+  /**
+   * Returns the room to go to next on a shortest path between two rooms.
+   *
+   * @param from The key of the start room.
+   * @param to The key of the destination room.
+   * @return The key of the next room, or -1 if there is no path.
+   */
+  int getNextRoom(int from, int to) const;
+
+  /**
+   * Returns the keys of all rooms within the given number of hops of a room,
+   * including the room itself.
+   *
+   * @param key The key of the room.
+   * @param max_distance The maximum number of hops.
+   * @return The keys of the nearby rooms.
+   */
+  std::vector<int> getRoomsWithin(int key, int max_distance) const;
+};
+
+#endif  // MODELS_LEVEL_GRAPH_H_
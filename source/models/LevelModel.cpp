@@ -6,4 +6,25 @@ void LevelModel::dispose() {
   _current_room = nullptr;
   _player = nullptr;
   _rooms.clear();
+  _graph.dispose();
+}
+
+void LevelModel::buildGraph() {
+  _graph.dispose();
+
+  // Add the rooms in key order so the dense indices do not depend on the
+  // iteration order of the map.
+  std::vector<int> keys;
+  for (auto& it : _rooms) keys.push_back(it.first);
+  std::sort(keys.begin(), keys.end());
+  for (int key : keys) _graph.addRoom(key);
+
+  for (int key : keys) {
+    for (auto& it : _rooms[key]->getAllConnectedRooms()) {
+      if (_graph.getIndex(it.second) != -1) {
+        _graph.addConnection(key, it.second);
+      }
+    }
+  }
+  _graph.build();
 }
\ No newline at end of file
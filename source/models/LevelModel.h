@@ -1,6 +1,7 @@
 #ifndef MODELS_LEVEL_MODEL_H_
 #define MODELS_LEVEL_MODEL_H_
 
+#include "LevelGraph.h"
 #include "Player.h"
 #include "RoomModel.h"
 
@@ -12,6 +13,9 @@ class LevelModel {
    * between rooms when passing through a door. */
   std::unordered_map<int, std::shared_ptr<RoomModel>> _rooms;
 
+  /** The connectivity of the rooms, built once the level is populated. */
+  LevelGraph _graph;
+
   /** A reference to the palyer model. */
   std::shared_ptr<Player> _player;
 
@@ -89,10 +93,19 @@ class LevelModel {
    *
    * @return An unordered map that maps room IDs to room objects.
    */
-  std::unordered_map<int, std::shared_ptr<RoomModel>> getRooms() const {
+  const std::unordered_map<int, std::shared_ptr<RoomModel>>& getRooms() const {
     return _rooms;
   }
 
+  /**
+   * Build the room graph from the door connections of every room. Must be
+   * called after all rooms and their connections are added.
+   */
+  void buildGraph();
+
+  /** @return The connectivity of the rooms in the level. */
+  const LevelGraph& getGraph() const { return _graph; }
+
   /**
    * Set the player model in the level model.
    *
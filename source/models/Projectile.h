@@ -18,12 +18,18 @@ class Projectile : public cugl::physics2::CapsuleObstacle {
   /** The scene graph node for the projectile. */
   std::shared_ptr<cugl::scene2::SpriteNode> _projectile_node;
 
+  /** The shared layer drawing this projectile (enemy projectiles only). */
+  std::shared_ptr<cugl::scene2::InstancedSpriteNode> _sprite_layer;
+
+  /** The sprite of this projectile in the shared layer. */
+  size_t _sprite;
+
  public:
 #pragma mark Constructors
   /**
    * Creates the sword.
    */
-  Projectile(void) : CapsuleObstacle() {}
+  Projectile(void) : CapsuleObstacle(), _sprite(0) {}
 
   /**
    * Disposes the sword.
@@ -42,7 +48,10 @@ class Projectile : public cugl::physics2::CapsuleObstacle {
   /**
    * Disposes the projectile.
    */
-  void dispose() { _projectile_node = nullptr; }
+  void dispose() {
+    removeSprite();
+    _projectile_node = nullptr;
+  }
 
 #pragma mark Static Constructors
   /**
@@ -127,6 +136,45 @@ class Projectile : public cugl::physics2::CapsuleObstacle {
   std::shared_ptr<cugl::scene2::SpriteNode>& getNode() {
     return _projectile_node;
   }
+
+  /**
+   * Sets the sprite representing this projectile in a shared layer.
+   *
+   * @param layer   The layer drawing all projectiles of one kind.
+   * @param sprite  The sprite of this projectile in the layer.
+   */
+  void setSprite(
+      const std::shared_ptr<cugl::scene2::InstancedSpriteNode>& layer,
+      size_t sprite) {
+    _sprite_layer = layer;
+    _sprite = sprite;
+  }
+
+  /**
+   * If the projectile has a sprite in a shared layer.
+   *
+   * @return if the projectile has a sprite in a shared layer.
+   */
+  bool hasSprite() const { return _sprite_layer != nullptr; }
+
+  /**
+   * Moves the sprite of this projectile to the projectile position.
+   */
+  void updateSprite() {
+    if (_sprite_layer != nullptr) {
+      _sprite_layer->setSpritePosition(_sprite, getPosition());
+    }
+  }
+
+  /**
+   * Removes the sprite of this projectile from its shared layer.
+   */
+  void removeSprite() {
+    if (_sprite_layer != nullptr) {
+      _sprite_layer->removeSprite(_sprite);
+      _sprite_layer = nullptr;
+    }
+  }
 };
 
 #endif /* Projectile.h */
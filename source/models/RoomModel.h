@@ -87,7 +87,7 @@ class RoomModel {
    *
    * @return An unordered map from the door sensor id to the room id.
    */
-  std::unordered_map<std::string, int> getAllConnectedRooms() const {
+  const std::unordered_map<std::string, int>& getAllConnectedRooms() const {
     return _door_sensor_id_to_room_id;
   }
 
@@ -148,7 +148,7 @@ void Room::initScene2(cugl::Size size) {
 #pragma mark Edge
 
 Edge::Edge(const std::shared_ptr<Room> &s, const std::shared_ptr<Room> &n)
-    : _weight(0), _calculated(false) {
+    : _weight(0), _calculated(false), _active(false) {
   _source = s;
   _neighbor = n;
 
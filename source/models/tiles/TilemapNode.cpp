@@ -0,0 +1,165 @@
+#include "TilemapNode.h"
+
+#include "Wall.h"
+
+void TilemapNode::dispose() {
+  _texture = nullptr;
+  _atlas.clear();
+  _tiles.clear();
+  _chunks.clear();
+  _dirty.clear();
+  _obstacles.clear();
+  _grid_width = 0;
+  _grid_height = 0;
+  _chunk_size = 0;
+  _chunks_wide = 0;
+  _chunks_high = 0;
+  SceneNode::dispose();
+}
+
+bool TilemapNode::initWithGrid(int width, int height, const cugl::Size& size,
+                               int chunk_size) {
+  CUAssertLog(width > 0 && height > 0, "Tilemap grid must be non-empty");
+  CUAssertLog(chunk_size > 0, "Tilemap chunks must be non-empty");
+  if (!SceneNode::initWithBounds(size)) return false;
+
+  _grid_width = width;
+  _grid_height = height;
+  _chunk_size = chunk_size;
+  _chunks_wide = (width + chunk_size - 1) / chunk_size;
+  _chunks_high = (height + chunk_size - 1) / chunk_size;
+
+  _tiles.assign(width * height, EMPTY);
+  _chunks.resize(_chunks_wide * _chunks_high);
+  _dirty.assign(_chunks.size(), true);
+  setStatic(true);
+  return true;
+}
+
+int TilemapNode::addAtlasEntry(const std::shared_ptr<cugl::Texture>& texture,
+                               const cugl::Size& size) {
+  if (!acceptsTexture(texture)) return EMPTY;
+
+  for (size_t ii = 0; ii < _atlas.size(); ii++) {
+    if (_atlas[ii].texture == texture && _atlas[ii].size == size) {
+      return static_cast<int>(ii);
+    }
+  }
+
+  if (_texture == nullptr) {
+    _texture = texture->isSubTexture() ? texture->getParent() : texture;
+  }
+  _atlas.push_back({texture, size});
+  invalidateBounds();
+  return static_cast<int>(_atlas.size()) - 1;
+}
+
+void TilemapNode::setTile(int x, int y, int index) {
+  CUAssertLog(x >= 0 && y >= 0 && x < _grid_width && y < _grid_height,
+              "Tile (%d, %d) is out of bounds", x, y);
+  CUAssertLog(index == EMPTY || index < static_cast<int>(_atlas.size()),
+              "Atlas index %d is out of bounds", index);
+  _tiles[y * _grid_width + x] = index;
+  _dirty[(y / _chunk_size) * _chunks_wide + x / _chunk_size] = true;
+  invalidateBounds();
+}
+
+std::vector<std::shared_ptr<cugl::physics2::PolygonObstacle>>
+TilemapNode::initBox2d() {
+  std::vector<std::shared_ptr<cugl::physics2::PolygonObstacle>> result;
+  cugl::Size cell = getCellSize();
+  for (CellObstacle& entry : _obstacles) {
+    // An absorbed wall sits at the origin of its cell wrapper, so this is
+    // the position Wall::initBox2d would have computed for it.
+    cugl::Vec2 origin(entry.x * cell.width, entry.y * cell.height);
+    auto obstacle = Wall::allocObstacle(entry.shape, nodeToWorldCoords(origin));
+    if (obstacle != nullptr) result.push_back(obstacle);
+  }
+  return result;
+}
+
+void TilemapNode::setContentSize(const cugl::Size size) {
+  SceneNode::setContentSize(size);
+  _dirty.assign(_chunks.size(), true);
+}
+
+cugl::Rect TilemapNode::computeSubtreeBounds() {
+  cugl::Rect result = SceneNode::computeSubtreeBounds();
+  cugl::Size cell = getCellSize();
+  for (const AtlasEntry& entry : _atlas) {
+    cugl::Size overhang(std::max(entry.size.width - cell.width, 0.0f),
+                        std::max(entry.size.height - cell.height, 0.0f));
+    result.merge(cugl::Rect(cugl::Vec2::ZERO, _contentSize + overhang));
+  }
+  return result;
+}
+
+void TilemapNode::draw(const std::shared_ptr<cugl::SpriteBatch>& batch,
+                       const cugl::Affine2& transform, cugl::Color4 tint) {
+  if (_texture == nullptr) return;
+
+  batch->setColor(tint);
+  batch->setTexture(_texture);
+  batch->setBlendEquation(GL_FUNC_ADD);
+  batch->setSrcBlendFunc(GL_SRC_ALPHA);
+  batch->setDstBlendFunc(GL_ONE_MINUS_SRC_ALPHA);
+  for (size_t ii = 0; ii < _chunks.size(); ii++) {
+    if (_dirty[ii]) buildChunk(static_cast<int>(ii));
+    if (!_chunks[ii].vertices.empty()) {
+      batch->drawMesh(_chunks[ii], transform);
+    }
+  }
+}
+
+void TilemapNode::buildChunk(int chunk) {
+  cugl::Mesh<cugl::SpriteVertex2>& mesh = _chunks[chunk];
+  mesh.clear();
+  mesh.command = GL_TRIANGLES;
+
+  cugl::Size cell = getCellSize();
+  GLuint color = cugl::Color4::WHITE.getPacked();
+  int startx = (chunk % _chunks_wide) * _chunk_size;
+  int starty = (chunk / _chunks_wide) * _chunk_size;
+  int endx = std::min(startx + _chunk_size, _grid_width);
+  int endy = std::min(starty + _chunk_size, _grid_height);
+
+  for (int y = starty; y < endy; y++) {
+    for (int x = startx; x < endx; x++) {
+      int index = _tiles[y * _grid_width + x];
+      if (index == EMPTY) continue;
+
+      const AtlasEntry& entry = _atlas[index];
+      cugl::Vec2 origin(x * cell.width, y * cell.height);
+      GLuint base = static_cast<GLuint>(mesh.vertices.size());
+
+      // Image space has its origin in the bottom left, but texture space
+      // has its origin in the top left (see PolygonNode).
+      cugl::SpriteVertex2 vert;
+      vert.color = color;
+      vert.position = origin;
+      vert.texcoord.set(entry.texture->getMinS(), entry.texture->getMaxT());
+      mesh.vertices.push_back(vert);
+
+      vert.position.set(origin.x + entry.size.width, origin.y);
+      vert.texcoord.set(entry.texture->getMaxS(), entry.texture->getMaxT());
+      mesh.vertices.push_back(vert);
+
+      vert.position.set(origin.x + entry.size.width,
+                        origin.y + entry.size.height);
+      vert.texcoord.set(entry.texture->getMaxS(), entry.texture->getMinT());
+      mesh.vertices.push_back(vert);
+
+      vert.position.set(origin.x, origin.y + entry.size.height);
+      vert.texcoord.set(entry.texture->getMinS(), entry.texture->getMinT());
+      mesh.vertices.push_back(vert);
+
+      mesh.indices.push_back(base);
+      mesh.indices.push_back(base + 1);
+      mesh.indices.push_back(base + 2);
+      mesh.indices.push_back(base + 2);
+      mesh.indices.push_back(base + 3);
+      mesh.indices.push_back(base);
+    }
+  }
+  _dirty[chunk] = false;
+}
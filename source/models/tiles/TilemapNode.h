@@ -0,0 +1,277 @@
+#ifndef MODELS_TILES_TILEMAP_NODE_H_
+#define MODELS_TILES_TILEMAP_NODE_H_
+
+#include <cugl/cugl.h>
+
+/**
+ * This class renders a whole layer of static tiles as a handful of meshes.
+ *
+ * Instead of one scene node per tile, the tilemap stores a dense grid of
+ * indices into a small atlas of tile textures. All of the atlas textures must
+ * share the same OpenGL texture (i.e. be subtextures of one tile set), so the
+ * tiles can be drawn without breaking the sprite batch. The grid is split
+ * into square chunks and each chunk is baked into a single mesh the first
+ * time it is drawn after a change. A tilemap is static by default (see
+ * SceneNode::setStatic), so the chunk meshes are only sent to the sprite
+ * batch when a tile changes; otherwise the retained vertices are redrawn.
+ *
+ * A tilemap is drawn as a single node, so every tile in it shares the same
+ * rendering priority. Rooms that need y-sorting (such as walls) should use one
+ * tilemap per priority. Dynamic tiles (doors, terminals) should remain their
+ * own scene graph nodes.
+ *
+ * The tilemap can also hold static collision shapes for its tiles, so that
+ * walls can be absorbed without losing their box2d obstacles.
+ */
+class TilemapNode : public cugl::scene2::SceneNode {
+ public:
+  /** The index of an empty cell in the tile grid. */
+  static const int EMPTY = -1;
+
+ protected:
+  /** An entry in the tile atlas. */
+  struct AtlasEntry {
+    /** The (sub)texture for this tile. */
+    std::shared_ptr<cugl::Texture> texture;
+    /** The untransformed size of the tile quad. */
+    cugl::Size size;
+  };
+
+  /** A static collision shape for a single cell. */
+  struct CellObstacle {
+    /** The grid column of the cell. */
+    int x;
+    /** The grid row of the cell. */
+    int y;
+    /** The obstacle shape relative to the bottom left corner of the cell. */
+    cugl::Poly2 shape;
+  };
+
+  /** The number of columns in the grid. */
+  int _grid_width;
+
+  /** The number of rows in the grid. */
+  int _grid_height;
+
+  /** The width and height (in cells) of a single chunk. */
+  int _chunk_size;
+
+  /** The number of chunk columns. */
+  int _chunks_wide;
+
+  /** The number of chunk rows. */
+  int _chunks_high;
+
+  /** The texture shared by all atlas entries. */
+  std::shared_ptr<cugl::Texture> _texture;
+
+  /** The distinct tiles referenced by this map. */
+  std::vector<AtlasEntry> _atlas;
+
+  /** The atlas index of each cell (row major from the bottom left). */
+  std::vector<int> _tiles;
+
+  /** The pre-built mesh for each chunk. */
+  std::vector<cugl::Mesh<cugl::SpriteVertex2>> _chunks;
+
+  /** Whether the mesh of each chunk must be rebuilt before drawing. */
+  std::vector<bool> _dirty;
+
+  /** The static collision shapes of the absorbed tiles. */
+  std::vector<CellObstacle> _obstacles;
+
+ public:
+  /**
+   * Creates an empty tilemap.
+   *
+   * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a node on the
+   * heap, use one of the static constructors instead.
+   */
+  TilemapNode()
+      : SceneNode(),
+        _grid_width(0),
+        _grid_height(0),
+        _chunk_size(0),
+        _chunks_wide(0),
+        _chunks_high(0) {
+    _classname = "TilemapNode";
+  }
+
+  /**
+   * Deletes this node, releasing all resources.
+   */
+  ~TilemapNode() { dispose(); }
+
+  /**
+   * Disposes all of the resources used by this node.
+   */
+  virtual void dispose() override;
+
+  /**
+   * Initializes an empty tilemap with the given grid.
+   *
+   * The content size is the size of the whole grid, so each cell has size
+   * size.width/width by size.height/height.
+   *
+   * @param width       The number of columns in the grid
+   * @param height      The number of rows in the grid
+   * @param size        The content size of the whole grid
+   * @param chunk_size  The width and height (in cells) of a mesh chunk
+   *
+   * @return true if initialization was successful.
+   */
+  bool initWithGrid(int width, int height, const cugl::Size& size,
+                    int chunk_size = 16);
+
+  /**
+   * Returns a newly allocated empty tilemap with the given grid.
+   *
+   * @param width       The number of columns in the grid
+   * @param height      The number of rows in the grid
+   * @param size        The content size of the whole grid
+   * @param chunk_size  The width and height (in cells) of a mesh chunk
+   *
+   * @return a newly allocated empty tilemap with the given grid.
+   */
+  static std::shared_ptr<TilemapNode> alloc(int width, int height,
+                                            const cugl::Size& size,
+                                            int chunk_size = 16) {
+    std::shared_ptr<TilemapNode> result = std::make_shared<TilemapNode>();
+    return (result->initWithGrid(width, height, size, chunk_size) ? result
+                                                                  : nullptr);
+  }
+
+  /**
+   * Returns the atlas index for the given tile, adding it if necessary.
+   *
+   * Returns EMPTY if the texture does not share the OpenGL texture of the
+   * tiles already in this map.
+   *
+   * @param texture The (sub)texture of the tile
+   * @param size    The untransformed size of the tile quad
+   *
+   * @return the atlas index for the given tile.
+   */
+  int addAtlasEntry(const std::shared_ptr<cugl::Texture>& texture,
+                    const cugl::Size& size);
+
+  /**
+   * Returns true if the given texture can be drawn by this tilemap.
+   *
+   * @param texture The (sub)texture to check
+   *
+   * @return true if the given texture can be drawn by this tilemap.
+   */
+  bool acceptsTexture(const std::shared_ptr<cugl::Texture>& texture) const {
+    return texture != nullptr &&
+           (_texture == nullptr || _texture->getBuffer() == texture->getBuffer());
+  }
+
+  /**
+   * Returns the atlas index at the given cell, or EMPTY.
+   *
+   * @param x The grid column
+   * @param y The grid row
+   *
+   * @return the atlas index at the given cell, or EMPTY.
+   */
+  int getTile(int x, int y) const {
+    if (x < 0 || y < 0 || x >= _grid_width || y >= _grid_height) return EMPTY;
+    return _tiles[y * _grid_width + x];
+  }
+
+  /**
+   * Sets the atlas index at the given cell.
+   *
+   * Only the chunk containing the cell is rebuilt on the next draw.
+   *
+   * @param x     The grid column
+   * @param y     The grid row
+   * @param index The atlas index (or EMPTY to clear the cell)
+   */
+  void setTile(int x, int y, int index);
+
+  /**
+   * Adds a static collision shape to the given cell.
+   *
+   * @param x     The grid column
+   * @param y     The grid row
+   * @param shape The obstacle shape relative to the cell origin
+   */
+  void addObstacle(int x, int y, const cugl::Poly2& shape) {
+    _obstacles.push_back({x, y, shape});
+  }
+
+  /**
+   * Returns the newly created static obstacles for the absorbed tiles.
+   *
+   * The obstacles are positioned in world space, so this should be called
+   * after the node has been laid out and placed in the world.
+   *
+   * @return the newly created static obstacles for the absorbed tiles.
+   */
+  std::vector<std::shared_ptr<cugl::physics2::PolygonObstacle>> initBox2d();
+
+  /**
+   * Returns the grid size of this tilemap.
+   *
+   * @return the grid size of this tilemap.
+   */
+  cugl::Size getGridSize() const {
+    return cugl::Size(_grid_width, _grid_height);
+  }
+
+  /**
+   * Returns the untransformed size of a single cell.
+   *
+   * @return the untransformed size of a single cell.
+   */
+  cugl::Size getCellSize() const {
+    return cugl::Size(_contentSize.width / _grid_width,
+                      _contentSize.height / _grid_height);
+  }
+
+  /**
+   * Sets the untransformed size of the node.
+   *
+   * Resizing the tilemap resizes the cells, so all chunks are rebuilt.
+   *
+   * @param size  The untransformed size of the node.
+   */
+  virtual void setContentSize(const cugl::Size size) override;
+
+  /**
+   * Draws every chunk of this tilemap via the given SpriteBatch.
+   *
+   * @param batch     The SpriteBatch to draw with.
+   * @param transform The global transformation matrix.
+   * @param tint      The tint to blend with the Node color.
+   */
+  virtual void draw(const std::shared_ptr<cugl::SpriteBatch>& batch,
+                    const cugl::Affine2& transform,
+                    cugl::Color4 tint) override;
+
+ protected:
+  /**
+   * Returns the bounds of this node and all of its descendants.
+   *
+   * An atlas entry may be larger than a cell, so tiles on the top and right
+   * edges can draw past the content bounds. The bounds include that overhang
+   * so that culling does not clip them.
+   *
+   * @return the bounds of this node and all of its descendants.
+   */
+  virtual cugl::Rect computeSubtreeBounds() override;
+
+  /**
+   * Rebuilds the mesh for the given chunk.
+   *
+   * @param chunk The chunk index
+   */
+  void buildChunk(int chunk);
+
+  /** This macro disables the copy constructor (not allowed on scene graphs) */
+  CU_DISALLOW_COPY_AND_ASSIGN(TilemapNode);
+};
+
+#endif  // MODELS_TILES_TILEMAP_NODE_H_
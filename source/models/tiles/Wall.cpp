@@ -35,16 +35,21 @@ bool Wall::initWithData(const cugl::Scene2Loader* loader,
 }
 
 std::shared_ptr<cugl::physics2::PolygonObstacle> Wall::initBox2d() {
-  _obstacle = cugl::physics2::PolygonObstacle::alloc(_obstacle_shape);
-
   cugl::Vec2 pos = BasicTile::getWorldPosition() - BasicTile::getPosition();
+  _obstacle = allocObstacle(_obstacle_shape, pos);
+  return _obstacle;
+}
 
-  if (_obstacle != nullptr) {
-    _obstacle->setPosition(pos);
-    _obstacle->setName(_classname.c_str());
+std::shared_ptr<cugl::physics2::PolygonObstacle> Wall::allocObstacle(
+    const cugl::Poly2& shape, const cugl::Vec2 pos) {
+  auto obstacle = cugl::physics2::PolygonObstacle::alloc(shape);
 
-    _obstacle->setBodyType(b2BodyType::b2_staticBody);
+  if (obstacle != nullptr) {
+    obstacle->setPosition(pos);
+    obstacle->setName("Wall");
+
+    obstacle->setBodyType(b2BodyType::b2_staticBody);
   }
 
-  return _obstacle;
+  return obstacle;
 }
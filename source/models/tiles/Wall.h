@@ -105,12 +105,31 @@ class Wall : public BasicTile {
    */
   virtual std::shared_ptr<cugl::physics2::PolygonObstacle> initBox2d();
 
+  /**
+   * Returns a new static wall obstacle with the given shape and position.
+   *
+   * This is shared by {@link #initBox2d} and the tilemaps that absorb walls,
+   * so that an absorbed wall collides exactly as the node would have.
+   *
+   * @param shape The obstacle shape relative to the tile origin.
+   * @param pos   The world position of the tile origin.
+   *
+   * @return A new static wall obstacle.
+   */
+  static std::shared_ptr<cugl::physics2::PolygonObstacle> allocObstacle(
+      const cugl::Poly2& shape, const cugl::Vec2 pos);
+
   /**
    * @return Returns the physics object for the tile.
    */
   std::shared_ptr<cugl::physics2::PolygonObstacle> getObstacle() {
     return _obstacle;
   }
+
+  /**
+   * @return Returns the obstacle shape relative to the tile origin.
+   */
+  const cugl::Poly2& getObstacleShape() const { return _obstacle_shape; }
 };
 
 #endif  // MODELS_TILES_WALL_H_
\ No newline at end of file
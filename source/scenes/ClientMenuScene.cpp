@@ -39,6 +39,8 @@ bool ClientMenuScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
   _startgame = std::dynamic_pointer_cast<cugl::scene2::Button>(
       _assets->get<cugl::scene2::SceneNode>(
           "client_center_content_info_start"));
+  _startlabel = std::dynamic_pointer_cast<cugl::scene2::Label>(
+      _startgame->getChildByName("up")->getChildByName("label"));
   _backout = std::dynamic_pointer_cast<cugl::scene2::Button>(
       _assets->get<cugl::scene2::SceneNode>("client_back"));
   _gameid = std::dynamic_pointer_cast<cugl::scene2::Label>(
@@ -151,8 +153,11 @@ void ClientMenuScene::setActive(bool value) {
 void ClientMenuScene::updateText(
     const std::shared_ptr<cugl::scene2::Button>& button,
     const std::string text) {
-  auto label = std::dynamic_pointer_cast<cugl::scene2::Label>(
-      button->getChildByName("up")->getChildByName("label"));
+  std::shared_ptr<cugl::scene2::Label> label = _startlabel;
+  if (button != _startgame) {
+    label = std::dynamic_pointer_cast<cugl::scene2::Label>(
+        button->getChildByName("up")->getChildByName("label"));
+  }
   label->setText(text);
 }
 
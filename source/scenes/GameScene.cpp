@@ -14,6 +14,14 @@
 
 #define SCENE_HEIGHT 720
 #define CAMERA_SMOOTH_SPEED 2.0f
+// Whether to log the scene nodes visited and drawn and the draw calls made
+// every frame.
+#define LOG_RENDER_STATS false
+// The number of threads that record the layers of the scene graph (0 to draw
+// every layer on the main thread instead).
+#define RENDER_THREADS 3
+// The number of doors away from a player that the host syncs enemies.
+#define ENEMY_SYNC_HOPS 1
 
 bool GameScene::init(
     const std::shared_ptr<cugl::AssetManager>& assets,
@@ -31,6 +39,20 @@ bool GameScene::init(
 
   _assets = assets;
 
+  // Rooms and the minimap have far more tiles than fit on screen, so skip
+  // any subtree that is outside of the camera view.
+  setCulling(true);
+
+  // The world, minimap and UI layers are independent subtrees, so record
+  // them in parallel and only submit the draw calls on the main thread.
+  // Static rooms, labels and instanced sprites are skipped by the workers
+  // and drawn in place on the main thread. The recorders keep the texture
+  // sort of the deferred world layer, so recording only moves the CPU work
+  // off the main thread and does not add draw calls.
+  if (RENDER_THREADS > 0) {
+    setRecordingThreads(cugl::ThreadPool::alloc(RENDER_THREADS));
+  }
+
   _world_node = _assets->get<cugl::scene2::SceneNode>("world-scene");
   _world_node->setContentSize(dim);
 
@@ -47,7 +69,7 @@ bool GameScene::init(
   _map->doLayout();
   _map->setVisible(false);
 
-  for (std::shared_ptr<level_gen::Room>& room : level_gen->getRooms()) {
+  for (const std::shared_ptr<level_gen::Room>& room : level_gen->getRooms()) {
     for (std::shared_ptr<level_gen::Edge> edge : room->_edges) {
       edge->_node->setVisible(false);
     }
@@ -113,47 +135,51 @@ bool GameScene::init(
   _health_bar = std::dynamic_pointer_cast<cugl::scene2::ProgressBar>(
       assets->get<cugl::scene2::SceneNode>("health_bar"));
 
-  auto win_layer = assets->get<cugl::scene2::SceneNode>("win-scene");
-  win_layer->setContentSize(dim);
-  win_layer->doLayout();
-  win_layer->setVisible(false);
+  _win_layer = assets->get<cugl::scene2::SceneNode>("win-scene");
+  _win_layer->setContentSize(dim);
+  _win_layer->doLayout();
+  _win_layer->setVisible(false);
+  _cooperator_win_text =
+      _win_layer->getChildByName<cugl::scene2::Label>("cooperator");
+  _betrayer_win_text =
+      _win_layer->getChildByName<cugl::scene2::Label>("betrayer");
 
-  auto timer_text = ui_layer->getChildByName<cugl::scene2::Label>("timer");
+  _timer_text = ui_layer->getChildByName<cugl::scene2::Label>("timer");
   std::string timer_msg = getTimerString();
-  timer_text->setText(timer_msg);
-  timer_text->setForeground(cugl::Color4::BLACK);
+  _timer_text->setText(timer_msg);
+  _timer_text->setForeground(cugl::Color4::BLACK);
 
   _num_terminals_activated = 0;
   _num_terminals_corrupted = 0;
-  auto activated_text =
+  _activated_text =
       ui_layer->getChildByName<cugl::scene2::Label>("activated_num");
   std::string activated_msg =
       cugl::strtool::format(std::to_string(_num_terminals_activated));
-  activated_text->setText(activated_msg);
-  activated_text->setForeground(cugl::Color4::BLACK);
+  _activated_text->setText(activated_msg);
+  _activated_text->setForeground(cugl::Color4::BLACK);
 
-  auto corrupted_text =
+  _corrupted_text =
       ui_layer->getChildByName<cugl::scene2::Label>("corrupted_num");
   std::string corrupted_msg =
       cugl::strtool::format(std::to_string(_num_terminals_corrupted));
-  corrupted_text->setText(corrupted_msg);
-  corrupted_text->setForeground(cugl::Color4::BLACK);
+  _corrupted_text->setText(corrupted_msg);
+  _corrupted_text->setForeground(cugl::Color4::BLACK);
 
-  auto name_text = ui_layer->getChildByName<cugl::scene2::Label>("name");
+  _name_text = ui_layer->getChildByName<cugl::scene2::Label>("name");
   std::string name_msg =  cugl::strtool::format("player %d", _my_player->getPlayerId());
-  name_text->setText(name_msg);
-  name_text->setForeground(cugl::Color4::BLACK);
+  _name_text->setText(name_msg);
+  _name_text->setForeground(cugl::Color4::BLACK);
 
-  auto role_text = ui_layer->getChildByName<cugl::scene2::Label>("role");
+  _role_text = ui_layer->getChildByName<cugl::scene2::Label>("role");
   std::string role_msg = "";
   if (_is_betrayer) {
     role_msg = "(B)";
-    role_text->setForeground(cugl::Color4::BLACK);
+    _role_text->setForeground(cugl::Color4::BLACK);
   } else {
     role_msg = "(C)";
-    role_text->setForeground(cugl::Color4::BLACK);
+    _role_text->setForeground(cugl::Color4::BLACK);
   }
-  role_text->setText(role_msg);
+  _role_text->setText(role_msg);
 
   cugl::Scene2::addChild(background_layer);
   cugl::Scene2::addChild(_world_node);
@@ -162,7 +188,7 @@ bool GameScene::init(
   cugl::Scene2::addChild(ui_layer);
   cugl::Scene2::addChild(betrayer_icons_layer);
   cugl::Scene2::addChild(terminal_voting_layer);
-  cugl::Scene2::addChild(win_layer);
+  cugl::Scene2::addChild(_win_layer);
   cugl::Scene2::addChild(_debug_node);
   _debug_node->setVisible(false);
 
@@ -176,6 +202,7 @@ bool GameScene::init(
 void GameScene::dispose() {
   if (!_active) return;
   InputController::get()->dispose();
+  setRecordingThreads(nullptr);
   _active = false;
   _health_bar->dispose();
 }
@@ -214,6 +241,19 @@ void GameScene::populate(cugl::Size dim) {
     wall->getObstacle()->setDebugScene(_debug_node);
   }
 
+  // Walls absorbed into tilemaps keep their obstacles in the tilemap. Every
+  // room has plain wall and floor cells, so an empty list means the loader
+  // stopped collapsing them.
+  CUAssertLog(!loader->getTilemaps().empty(),
+              "No room tiles were collapsed into tilemaps");
+  for (std::shared_ptr<TilemapNode> tilemap : loader->getTilemaps()) {
+    for (auto obstacle : tilemap->initBox2d()) {
+      _world->addObstacle(obstacle);
+      obstacle->setDebugColor(cugl::Color4::GREEN);
+      obstacle->setDebugScene(_debug_node);
+    }
+  }
+
   _num_terminals = 0;
   for (std::shared_ptr<BasicTile> tile : loader->getTiles("terminal")) {
     auto terminal = std::dynamic_pointer_cast<Terminal>(tile);
@@ -257,20 +297,16 @@ void GameScene::update(float timestep) {
 
   _health_bar->setProgress(static_cast<float>(_my_player->getHealth()) / 100);
 
-  if (checkCooperatorWin()) {
-    auto win_layer = _assets->get<cugl::scene2::SceneNode>("win-scene");
-    auto text = win_layer->getChildByName<cugl::scene2::Label>("cooperator");
-    std::string msg = cugl::strtool::format("Cooperators Win!");
-    text->setText(msg);
-    text->setForeground(cugl::Color4::GREEN);
-    win_layer->setVisible(true);
+  if (_win_layer->isVisible()) {
+    // The win screen is already up; its labels do not change
+  } else if (checkCooperatorWin()) {
+    _cooperator_win_text->setText("Cooperators Win!");
+    _cooperator_win_text->setForeground(cugl::Color4::GREEN);
+    _win_layer->setVisible(true);
   } else if (checkBetrayerWin()) {
-    auto win_layer = _assets->get<cugl::scene2::SceneNode>("win-scene");
-    auto text = win_layer->getChildByName<cugl::scene2::Label>("betrayer");
-    std::string msg = cugl::strtool::format("Betrayers Win!");
-    text->setText(msg);
-    text->setForeground(cugl::Color4::BLACK);
-    win_layer->setVisible(true);
+    _betrayer_win_text->setText("Betrayers Win!");
+    _betrayer_win_text->setForeground(cugl::Color4::BLACK);
+    _win_layer->setVisible(true);
   }
 
   cugl::Application::get()->setClearColor(cugl::Color4f::BLACK);
@@ -322,43 +358,19 @@ void GameScene::update(float timestep) {
   _world->update(timestep);
 
   // ===== POST-UPDATE =======
-  auto ui_layer = _assets->get<cugl::scene2::SceneNode>("ui-scene");
-
-  auto timer_text = ui_layer->getChildByName<cugl::scene2::Label>("timer");
-  std::string timer_msg = getTimerString();
-  timer_text->setText(timer_msg);
-  timer_text->setForeground(cugl::Color4::BLACK);
-
-  auto name_text = ui_layer->getChildByName<cugl::scene2::Label>("name");
-  std::string name_msg =
-      cugl::strtool::format("player %d", _my_player->getPlayerId());
-  name_text->setText(name_msg);
-  name_text->setForeground(cugl::Color4::BLACK);
+  // The labels are cached in init, as by-name lookups every frame are slow.
+  _timer_text->setText(getTimerString());
+  _name_text->setText(
+      cugl::strtool::format("player %d", _my_player->getPlayerId()));
 
   //  auto minimap =
   //  ui_layer->getChildByName<cugl::scene2::SceneNode>("minimap");
-  //  std::unordered_map<int, std::shared_ptr<RoomModel>> rooms =
+  //  const std::unordered_map<int, std::shared_ptr<RoomModel>>& rooms =
   //    _level_controller->getLevelModel()->getRooms();
 
-  auto activated_text = ui_layer->getChildByName<cugl::scene2::Label>("activated_num");
-  std::string activated_msg = cugl::strtool::format(std::to_string(_num_terminals_activated));
-  activated_text->setText(activated_msg);
-
-  auto corrupted_text = ui_layer->getChildByName<cugl::scene2::Label>("corrupted_num");
-  std::string corrupted_msg = cugl::strtool::format(std::to_string(_num_terminals_corrupted));
-  corrupted_text->setText(corrupted_msg);
-
-
-  auto role_text = ui_layer->getChildByName<cugl::scene2::Label>("role");
-  std::string role_msg = "";
-  if (_is_betrayer) {
-    role_msg = "(B)";
-    role_text->setForeground(cugl::Color4::BLACK);
-  } else {
-    role_msg = "(C)";
-    role_text->setForeground(cugl::Color4::BLACK);
-  }
-  role_text->setText(role_msg);
+  _activated_text->setText(std::to_string(_num_terminals_activated));
+  _corrupted_text->setText(std::to_string(_num_terminals_corrupted));
+  _role_text->setText(_is_betrayer ? "(B)" : "(C)");
 
   // POST-UPDATE
   // Check for disposal
@@ -392,6 +404,8 @@ void GameScene::sendNetworkInfo() {
     {
       std::vector<std::shared_ptr<cugl::JsonValue>> player_positions;
       std::set<int> rooms_checked_for_enemies;
+      const LevelGraph& graph =
+          _level_controller->getLevelModel()->getGraph();
 
       for (std::shared_ptr<Player> player : _players) {
         // get player info
@@ -425,52 +439,56 @@ void GameScene::sendNetworkInfo() {
           continue;
         }
 
-        // if room has already been checked, continue without adding enemies
-        if (rooms_checked_for_enemies.count(room_id) > 0) {
-          continue;
-        }
-        rooms_checked_for_enemies.insert(room_id);
-
-        // get enemy info only for the rooms that players are in
-        for (std::shared_ptr<EnemyModel> enemy : player_room->getEnemies()) {
-          std::shared_ptr<cugl::JsonValue> enemy_info =
-              cugl::JsonValue::allocObject();
-
-          std::shared_ptr<cugl::JsonValue> enemy_id =
-              cugl::JsonValue::alloc(static_cast<long>(enemy->getEnemyId()));
-          enemy_info->appendChild(enemy_id);
-          enemy_id->setKey("enemy_id");
-
-          std::shared_ptr<cugl::JsonValue> pos = cugl::JsonValue::allocArray();
-          std::shared_ptr<cugl::JsonValue> pos_x =
-              cugl::JsonValue::alloc(enemy->getPosition().x);
-          std::shared_ptr<cugl::JsonValue> pos_y =
-              cugl::JsonValue::alloc(enemy->getPosition().y);
-          pos->appendChild(pos_x);
-          pos->appendChild(pos_y);
-          enemy_info->appendChild(pos);
-          pos->setKey("position");
-
-          std::shared_ptr<cugl::JsonValue> enemy_health =
-              cugl::JsonValue::alloc(static_cast<long>(enemy->getHealth()));
-          enemy_info->appendChild(enemy_health);
-          enemy_health->setKey("enemy_health");
-
-          std::shared_ptr<cugl::JsonValue> enemy_room =
-              cugl::JsonValue::alloc(static_cast<long>(room_id));
-          enemy_info->appendChild(enemy_room);
-          enemy_room->setKey("enemy_room");
-
-          // TODO network enemy projectiles
-
-          // Serialize one enemy at a time to avoid reaching packet limit
-          _serializer.writeSint32(5);
-          _serializer.writeJson(enemy_info);
-
-          std::vector<uint8_t> msg2 = _serializer.serialize();
-
-          _serializer.reset();
-          _network->send(msg2);
+        // Sync the enemies of every room within ENEMY_SYNC_HOPS doors of a
+        // player, so that a room is up to date before anyone walks in.
+        for (int sync_room_id :
+             graph.getRoomsWithin(room_id, ENEMY_SYNC_HOPS)) {
+          if (!rooms_checked_for_enemies.insert(sync_room_id).second) {
+            continue;
+          }
+          std::shared_ptr<RoomModel> sync_room =
+              _level_controller->getLevelModel()->getRoom(sync_room_id);
+          for (std::shared_ptr<EnemyModel> enemy : sync_room->getEnemies()) {
+            std::shared_ptr<cugl::JsonValue> enemy_info =
+                cugl::JsonValue::allocObject();
+
+            std::shared_ptr<cugl::JsonValue> enemy_id =
+                cugl::JsonValue::alloc(static_cast<long>(enemy->getEnemyId()));
+            enemy_info->appendChild(enemy_id);
+            enemy_id->setKey("enemy_id");
+
+            std::shared_ptr<cugl::JsonValue> pos =
+                cugl::JsonValue::allocArray();
+            std::shared_ptr<cugl::JsonValue> pos_x =
+                cugl::JsonValue::alloc(enemy->getPosition().x);
+            std::shared_ptr<cugl::JsonValue> pos_y =
+                cugl::JsonValue::alloc(enemy->getPosition().y);
+            pos->appendChild(pos_x);
+            pos->appendChild(pos_y);
+            enemy_info->appendChild(pos);
+            pos->setKey("position");
+
+            std::shared_ptr<cugl::JsonValue> enemy_health =
+                cugl::JsonValue::alloc(static_cast<long>(enemy->getHealth()));
+            enemy_info->appendChild(enemy_health);
+            enemy_health->setKey("enemy_health");
+
+            std::shared_ptr<cugl::JsonValue> enemy_room =
+                cugl::JsonValue::alloc(static_cast<long>(sync_room_id));
+            enemy_info->appendChild(enemy_room);
+            enemy_room->setKey("enemy_room");
+
+            // TODO network enemy projectiles
+
+            // Serialize one enemy at a time to avoid reaching packet limit
+            _serializer.writeSint32(5);
+            _serializer.writeJson(enemy_info);
+
+            std::vector<uint8_t> msg2 = _serializer.serialize();
+
+            _serializer.reset();
+            _network->send(msg2);
+          }
         }
       }
 
@@ -925,6 +943,10 @@ void GameScene::beforeSolve(b2Contact* contact, const b2Manifold* oldManifold) {
 
 void GameScene::render(const std::shared_ptr<cugl::SpriteBatch>& batch) {
   Scene2::render(batch);
+  if (LOG_RENDER_STATS) {
+    CULog("Render: %u nodes visited, %u nodes drawn, %u draw calls",
+          getNodesVisited(), getNodesDrawn(), batch->getCallsMade());
+  }
 }
 
 void GameScene::updateCamera(float timestep) {
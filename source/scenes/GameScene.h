@@ -31,6 +31,18 @@ class GameScene : public cugl::Scene2 {
   /** The animated health bar */
   std::shared_ptr<cugl::scene2::ProgressBar> _health_bar;
 
+  /** The HUD labels, cached so that update does not look them up by name. */
+  std::shared_ptr<cugl::scene2::Label> _timer_text;
+  std::shared_ptr<cugl::scene2::Label> _name_text;
+  std::shared_ptr<cugl::scene2::Label> _activated_text;
+  std::shared_ptr<cugl::scene2::Label> _corrupted_text;
+  std::shared_ptr<cugl::scene2::Label> _role_text;
+
+  /** The win screen and its labels, cached for the per-frame win check. */
+  std::shared_ptr<cugl::scene2::SceneNode> _win_layer;
+  std::shared_ptr<cugl::scene2::Label> _cooperator_win_text;
+  std::shared_ptr<cugl::scene2::Label> _betrayer_win_text;
+
   /** The sword. */
   std::shared_ptr<Sword> _sword;
 
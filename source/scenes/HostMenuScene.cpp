@@ -35,6 +35,8 @@ bool HostMenuScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
 
   _startgame = std::dynamic_pointer_cast<cugl::scene2::Button>(
       _assets->get<cugl::scene2::SceneNode>("host_center_start"));
+  _startlabel = std::dynamic_pointer_cast<cugl::scene2::Label>(
+      _startgame->getChildByName("up")->getChildByName("label"));
   _backout = std::dynamic_pointer_cast<cugl::scene2::Button>(
       _assets->get<cugl::scene2::SceneNode>("host_back"));
   _gameid = std::dynamic_pointer_cast<cugl::scene2::Label>(
@@ -97,8 +99,11 @@ void HostMenuScene::setActive(bool value) {
 void HostMenuScene::updateText(
     const std::shared_ptr<cugl::scene2::Button>& button,
     const std::string text) {
-  auto label = std::dynamic_pointer_cast<cugl::scene2::Label>(
-      button->getChildByName("up")->getChildByName("label"));
+  std::shared_ptr<cugl::scene2::Label> label = _startlabel;
+  if (button != _startgame) {
+    label = std::dynamic_pointer_cast<cugl::scene2::Label>(
+        button->getChildByName("up")->getChildByName("label"));
+  }
   label->setText(text);
 }
 
@@ -6,6 +6,9 @@
 
 #define SCENE_HEIGHT 720
 
+/** Set to true to always generate levels and check them against the cache. */
+#define VERIFY_LEVEL_CACHE false
+
 bool LoadingLevelScene::init(const std::shared_ptr<cugl::AssetManager>& assets,
                              Uint64 seed) {
   if (_active) return false;
@@ -21,7 +24,18 @@ bool LoadingLevelScene::init(const std::shared_ptr<cugl::AssetManager>& assets,
   _map = cugl::scene2::SceneNode::alloc();
   _map->setPosition(dim / 2);
   _level_generator = std::make_shared<level_gen::LevelGenerator>();
-  _level_generator->init(_config, _map, seed);
+  _seed = seed;
+  _from_cache = false;
+
+  std::string cache_dir = cugl::Application::get()->getSaveDirectory();
+  cache_dir = cugl::filetool::join_path({cache_dir, "level_cache"});
+  if (_level_cache.init(cache_dir, VERIFY_LEVEL_CACHE) &&
+      !_level_cache.isVerifying()) {
+    std::vector<uint8_t> data;
+    _from_cache = _level_cache.load(_config, seed, data) &&
+                  _level_generator->initWithData(_config, _map, data);
+  }
+  if (!_from_cache) _level_generator->init(_config, _map, seed);
 
   _map->doLayout();
   cugl::Scene2::addChild(_map);
@@ -43,7 +57,13 @@ void LoadingLevelScene::update(float timestep) {
       if (!_level_generator->update()) {
         _loading_phase = LOAD_ROOM_SCENE2;
 
-        std::vector<std::shared_ptr<level_gen::Room>> rooms =
+        if (_level_cache.isVerifying()) {
+          _level_cache.verify(_config, _seed, *_level_generator);
+        } else if (!_from_cache) {
+          _level_cache.save(_config, _seed, *_level_generator);
+        }
+
+        const std::vector<std::shared_ptr<level_gen::Room>>& rooms =
             _level_generator->getRooms();
 
         for (int i = 0; i < rooms.size(); i++) {
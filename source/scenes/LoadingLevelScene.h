@@ -2,6 +2,7 @@
 #define SCENES_LEVEL_GENERATION_DEMO_SCENE_H
 #include <cugl/cugl.h>
 
+#include "../generators/LevelCache.h"
 #include "../generators/LevelGenerator.h"
 #include "../generators/LevelGeneratorConfig.h"
 #include "../models/level_gen/Room.h"
@@ -14,6 +15,15 @@ class LoadingLevelScene : public cugl::Scene2 {
   /** A level generator config for this scene. */
   level_gen::LevelGeneratorConfig _config;
 
+  /** The cache of previously generated levels. */
+  level_gen::LevelCache _level_cache;
+
+  /** The seed of the level being loaded. */
+  Uint64 _seed;
+
+  /** If the level was loaded from the cache instead of generated. */
+  bool _from_cache;
+
   /** A reference to the scene2 map for rendering. */
   std::shared_ptr<cugl::scene2::SceneNode> _map;
 
@@ -37,7 +47,11 @@ class LoadingLevelScene : public cugl::Scene2 {
 
  public:
   /** Initializes the level generation scene2. */
-  LoadingLevelScene() : cugl::Scene2(), _loading_phase(GENERATE_ROOMS) {}
+  LoadingLevelScene()
+      : cugl::Scene2(),
+        _seed(0),
+        _from_cache(false),
+        _loading_phase(GENERATE_ROOMS) {}
 
   /** Disposes of all resources allocated to this mode. */
   ~LoadingLevelScene() { dispose(); }
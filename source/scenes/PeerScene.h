@@ -34,6 +34,8 @@ class PeerScene : public cugl::Scene2 {
 
   /** The menu button for starting a game */
   std::shared_ptr<cugl::scene2::Button> _startgame;
+  /** The label of the start button (cached, as it is updated every frame) */
+  std::shared_ptr<cugl::scene2::Label> _startlabel;
   /** The back button for the menu scene */
   std::shared_ptr<cugl::scene2::Button> _backout;
   /** The players label (for updating) */
@@ -9,6 +9,8 @@ bool WaitForPlayersScene::init(
   _node = _assets->get<cugl::scene2::SceneNode>(
       "terminal-voting-scene_voting-background_wait-for-player");
   _node->setVisible(false);
+  _current_num_label = std::dynamic_pointer_cast<cugl::scene2::Label>(
+      _node->getChildByName("current-num"));
 
   _initialized = true;
   return true;
@@ -35,9 +37,6 @@ void WaitForPlayersScene::update() {
     return;
   }
 
-  auto current_num_label = std::dynamic_pointer_cast<cugl::scene2::Label>(
-      _node->getChildByName("current-num"));
-
-  current_num_label->setText(
+  _current_num_label->setText(
       "Current Number Of Players: " + std::to_string(_curr_num_players), true);
 }
\ No newline at end of file
@@ -21,6 +21,9 @@ class WaitForPlayersScene {
   /** A reference to the node for this scene. */
   std::shared_ptr<cugl::scene2::SceneNode> _node;
 
+  /** The label with the current number of players, updated every frame. */
+  std::shared_ptr<cugl::scene2::Label> _current_num_label;
+
   /** The number of people required to activate the terminal. */
   int _num_players_req;
 